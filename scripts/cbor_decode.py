@@ -0,0 +1,223 @@
+#!/usr/bin/env python3
+
+"""Decode CBOR-encoded data frames uploaded by the nRF9160 Logger.
+
+Reads a CBOR payload, as uploaded by the device when CONFIG_DATA_FORMAT_CBOR is
+selected, from a file or standard input. The payload may be a single data frame
+or a batch of data frames. Integer keys are translated back to the key names of
+the JSON encoding, and the result is printed as JSON. With --compare, the size
+of the CBOR payload is compared to that of the equivalent JSON payload as
+uploaded with CONFIG_DATA_FORMAT_JSON. With --compact, the payload is decoded
+according to the compact data frame layout of CONFIG_DATA_LAYOUT_COMPACT. With
+--delta, the payload is taken to be a batch delta-encoded as uploaded with
+CONFIG_DATA_CBOR_DELTA, and the complete data frames are reconstructed.
+"""
+
+import argparse
+import json
+import struct
+import sys
+
+# Key names of each data frame type, indexed by integer key. Nested maps are
+# given as (name, schema) tuples, and arrays of maps as (name, [schema]).
+
+LTE_SCHEMA = [
+    ("mode", ["valid", "mode"]),
+    ("cell", ["valid", "id", "tac"]),
+    ("psm", [
+        "valid",
+        ("tau", ["days", "hours", "minutes", "seconds"]),
+        ("at", ["hours", "minutes", "seconds"]),
+    ]),
+    ("edrx", [
+        "valid",
+        "mode",
+        ("edrx", ["hours", "minutes", "seconds", "milliseconds"]),
+        ("ptw", ["seconds", "milliseconds"]),
+    ]),
+    "seq",
+]
+
+GNSS_COORD_SCHEMA = ["direction", "degrees", "minutes", "seconds",
+                     "milliseconds"]
+
+GNSS_SCHEMA = [
+    ("location", [
+        "valid",
+        ("latitude", GNSS_COORD_SCHEMA),
+        ("longitude", GNSS_COORD_SCHEMA),
+    ]),
+    ("date", ["valid", "year", "month", "day"]),
+    ("time", ["valid", "hour", "minute", "second", "millisecond"]),
+    "seq",
+]
+
+PERF_SCHEMA = [
+    ("phases", [["phase", "count", "min", "max", "p50", "p95"]]),
+    "seq",
+]
+
+DUMMY_SCHEMA = ["field1", "field2", "field3", "field4", "seq"]
+
+SCHEMAS = {
+    "dummy": DUMMY_SCHEMA,
+    "lte": LTE_SCHEMA,
+    "gnss": GNSS_SCHEMA,
+    "perf": PERF_SCHEMA,
+}
+
+# Key names of the data frame types whose layout differs in the compact layout.
+
+COMPACT_SCHEMAS = dict(SCHEMAS, **{
+    "lte": [
+        ("mode", ["valid", "mode"]),
+        ("cell", ["valid", "id", "tac"]),
+        ("psm", ["valid", "tau_s", "at_s"]),
+        ("edrx", ["valid", "mode", "edrx_ms", "ptw_ms"]),
+        "seq",
+    ],
+    "gnss": [
+        ("location", ["valid", "latitude_udeg", "longitude_udeg"]),
+        ("date", ["valid", "year", "month", "day"]),
+        ("time", ["valid", "hour", "minute", "second", "millisecond"]),
+        "seq",
+    ],
+})
+
+BREAK = object()
+
+
+class Decoder:
+    """Minimal decoder for the subset of CBOR produced by the device."""
+
+    def __init__(self, data):
+        self.data = data
+        self.pos = 0
+
+    def _take(self, n):
+        if self.pos + n > len(self.data):
+            raise ValueError("truncated CBOR payload")
+        chunk = self.data[self.pos:self.pos + n]
+        self.pos += n
+        return chunk
+
+    def _arg(self, info):
+        if info < 24:
+            return info
+        if info == 24:
+            return self._take(1)[0]
+        if info == 25:
+            return struct.unpack(">H", self._take(2))[0]
+        if info == 26:
+            return struct.unpack(">I", self._take(4))[0]
+        if info == 27:
+            return struct.unpack(">Q", self._take(8))[0]
+        if info == 31:
+            return None
+        raise ValueError("invalid additional information %d" % info)
+
+    def decode(self):
+        head = self._take(1)[0]
+        major, info = head >> 5, head & 0x1f
+        if head == 0xff:
+            return BREAK
+        arg = self._arg(info)
+        if major == 0:
+            return arg
+        if major == 1:
+            return -1 - arg
+        if major == 3:
+            return self._take(arg).decode("utf-8")
+        if major == 4:
+            return self._items(arg, lambda: self.decode(), list)
+        if major == 5:
+            return self._items(arg, lambda: (self.decode(), self.decode()),
+                               dict)
+        if major == 7 and info in (20, 21):
+            return info == 21
+        if major == 7 and info == 22:
+            return None
+        raise ValueError("unsupported CBOR item 0x%02x" % head)
+
+    def _items(self, count, item, kind):
+        items = []
+        while count is None or len(items) < count:
+            if count is None and self.data[self.pos] == 0xff:
+                self.pos += 1
+                break
+            items.append(item())
+        return kind(items) if kind is dict else items
+
+
+def undelta(prev, delta):
+    """Reconstruct a data frame from the previous data frame and its delta."""
+    result = dict(prev)
+    for key, value in delta.items():
+        old = prev.get(key)
+        if isinstance(old, dict) and isinstance(value, dict):
+            result[key] = undelta(old, value)
+        elif type(old) is int and type(value) is int:
+            result[key] = old + value
+        else:
+            result[key] = value
+    return result
+
+
+def rename(value, schema):
+    """Translate integer keys of a decoded map according to a schema."""
+    if isinstance(schema, list) and len(schema) == 1 \
+            and isinstance(schema[0], list):
+        return [rename(item, schema[0]) for item in value]
+    result = {}
+    for key, item in value.items():
+        field = schema[key]
+        if isinstance(field, tuple):
+            result[field[0]] = rename(item, field[1])
+        else:
+            result[field] = item
+    return result
+
+
+def main():
+    parser = argparse.ArgumentParser(description=__doc__.splitlines()[0])
+    parser.add_argument("type", choices=sorted(SCHEMAS),
+                        help="data frame type")
+    parser.add_argument("file", nargs="?", help="CBOR payload (default: stdin)")
+    parser.add_argument("--compare", action="store_true",
+                        help="compare CBOR and JSON payload sizes")
+    parser.add_argument("--compact", action="store_true",
+                        help="decode compact data frame layout")
+    parser.add_argument("--delta", action="store_true",
+                        help="reconstruct delta-encoded batch")
+    args = parser.parse_args()
+
+    if args.file:
+        with open(args.file, "rb") as f:
+            data = f.read()
+    else:
+        data = sys.stdin.buffer.read()
+
+    value = Decoder(data).decode()
+    schema = (COMPACT_SCHEMAS if args.compact else SCHEMAS)[args.type]
+
+    if args.delta:
+        if not isinstance(value, list):
+            parser.error("delta encoding applies to batches only")
+        for i in range(1, len(value)):
+            value[i] = undelta(value[i - 1], value[i])
+
+    if isinstance(value, list):
+        frames = [rename(frame, schema) for frame in value]
+    else:
+        frames = rename(value, schema)
+
+    print(json.dumps(frames, indent=2))
+
+    if args.compare:
+        plain = len(json.dumps(frames, separators=(",", ":")))
+        print("CBOR: %d bytes, JSON: %d bytes, saving: %.0f%%" % (
+            len(data), plain, 100 * (1 - len(data) / plain)), file=sys.stderr)
+
+
+if __name__ == "__main__":
+    main()
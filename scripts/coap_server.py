@@ -0,0 +1,236 @@
+#!/usr/bin/env python3
+
+"""Stand-in CoAP server for uploads made by the nRF9160 Logger.
+
+Listens for confirmable CoAP requests, as sent by the device when a data frame
+type is uploaded over CoAP with CONFIG_REST_COAP, and acknowledges them the way
+a database server would. Block-wise POST requests are reassembled, answered
+with 2.31 Continue for every block but the last, and with 2.01 Created for the
+last one, after which the complete payload is printed. Retransmitted requests
+are answered with the response sent before, so that duplicates are not stored
+twice. With --loss, a share of incoming requests is dropped to exercise
+retransmission. With --separate, requests are first acknowledged empty, and
+answered with a separate response. With --code, the final response code can be
+changed, for instance to 4.00 to test how the device handles a rejection. With
+--save, every complete payload is also written to a file in the given
+directory. Plain CoAP over UDP is spoken, so the device must be configured with
+CONFIG_COAPC_USE_DTLS=n.
+"""
+
+import argparse
+import json
+import os
+import random
+import socket
+import struct
+import sys
+
+# Message types.
+CON, NON, ACK, RST = range(4)
+
+# Option numbers.
+URI_PATH = 11
+CONTENT_FORMAT = 12
+URI_QUERY = 15
+BLOCK1 = 27
+
+# Content formats.
+FORMATS = {50: "json", 60: "cbor"}
+
+
+def code(text):
+    """Parse a response code written as class.detail."""
+    cls, detail = text.split(".")
+    return int(cls) << 5 | int(detail)
+
+
+def code_str(value):
+    """Write a response code as class.detail."""
+    return "%d.%02d" % (value >> 5, value & 0x1f)
+
+
+def parse(data):
+    """Split a CoAP message into its header fields, options, and payload."""
+    if len(data) < 4 or data[0] >> 6 != 1:
+        raise ValueError("not a CoAP message")
+    kind = data[0] >> 4 & 3
+    tkl = data[0] & 0xf
+    msg_code = data[1]
+    (msg_id,) = struct.unpack(">H", data[2:4])
+    token = data[4:4 + tkl]
+    pos = 4 + tkl
+    options = []
+    number = 0
+    while pos < len(data) and data[pos] != 0xff:
+        delta, length = data[pos] >> 4, data[pos] & 0xf
+        pos += 1
+        values = []
+        for nibble in (delta, length):
+            if nibble == 13:
+                values.append(data[pos] + 13)
+                pos += 1
+            elif nibble == 14:
+                values.append(struct.unpack(">H", data[pos:pos + 2])[0] + 269)
+                pos += 2
+            elif nibble == 15:
+                raise ValueError("invalid option")
+            else:
+                values.append(nibble)
+        number += values[0]
+        options.append((number, data[pos:pos + values[1]]))
+        pos += values[1]
+    payload = data[pos + 1:] if pos < len(data) else b""
+    return kind, msg_code, msg_id, token, options, payload
+
+
+def nibble(value):
+    """Encode an option delta or length, with its extended bytes."""
+    if value < 13:
+        return value, b""
+    if value < 269:
+        return 13, bytes([value - 13])
+    return 14, struct.pack(">H", value - 269)
+
+
+def uint(value):
+    """Encode an unsigned integer option value in as few bytes as possible."""
+    return value.to_bytes((value.bit_length() + 7) // 8, "big")
+
+
+def build(kind, msg_code, msg_id, token=b"", options=(), payload=b""):
+    """Assemble a CoAP message."""
+    data = bytearray([0x40 | kind << 4 | len(token), msg_code])
+    data += struct.pack(">H", msg_id) + token
+    number = 0
+    for opt, value in sorted(options):
+        delta, delta_ext = nibble(opt - number)
+        length, length_ext = nibble(len(value))
+        data += bytes([delta << 4 | length]) + delta_ext + length_ext + value
+        number = opt
+    if payload:
+        data += b"\xff" + payload
+    return bytes(data)
+
+
+def show(path, fmt, payload):
+    """Print a complete payload."""
+    print("%s: %d bytes (%s)" % (path, len(payload), FORMATS.get(fmt, fmt)))
+    if FORMATS.get(fmt) == "json":
+        try:
+            print(json.dumps(json.loads(payload), indent=2))
+        except ValueError:
+            print(payload.decode("utf-8", "replace"))
+    sys.stdout.flush()
+
+
+def main():
+    parser = argparse.ArgumentParser(description=__doc__.splitlines()[0])
+    parser.add_argument("--host", default="0.0.0.0",
+                        help="address to listen on (default: 0.0.0.0)")
+    parser.add_argument("--port", type=int, default=5683,
+                        help="port to listen on (default: 5683)")
+    parser.add_argument("--code", type=code, default=code("2.01"),
+                        help="final response code (default: 2.01)")
+    parser.add_argument("--loss", type=float, default=0.0,
+                        help="share of requests to drop (default: 0)")
+    parser.add_argument("--separate", action="store_true",
+                        help="acknowledge first, then respond separately")
+    parser.add_argument("--save", metavar="DIR",
+                        help="write complete payloads to files in DIR")
+    args = parser.parse_args()
+
+    sock = socket.socket(socket.AF_INET, socket.SOCK_DGRAM)
+    sock.bind((args.host, args.port))
+    print("Listening on %s:%d" % (args.host, args.port), file=sys.stderr)
+
+    transfers = {}  # Payload collected so far, by client and path.
+    answered = {}   # Response sent, by client and message ID.
+    count = 0       # Number of complete payloads.
+    next_id = random.randrange(0x10000)
+
+    while True:
+        data, addr = sock.recvfrom(2048)
+        try:
+            kind, msg_code, msg_id, token, options, payload = parse(data)
+        except ValueError as err:
+            print("%s: %s" % (addr[0], err), file=sys.stderr)
+            continue
+
+        if kind not in (CON, NON) or msg_code == 0:
+            continue
+
+        if random.random() < args.loss:
+            print("Dropping message %d" % msg_id, file=sys.stderr)
+            continue
+
+        if (addr, msg_id) in answered:
+            # Answer duplicate with response sent before.
+            for reply in answered[(addr, msg_id)]:
+                sock.sendto(reply, addr)
+            continue
+
+        path = "/" + "/".join(
+            value.decode() for opt, value in options if opt == URI_PATH)
+        query = "&".join(
+            value.decode() for opt, value in options if opt == URI_QUERY)
+        if query:
+            path += "?" + query
+        fmt = next((int.from_bytes(value, "big")
+                    for opt, value in options if opt == CONTENT_FORMAT), None)
+        block = next((int.from_bytes(value, "big")
+                      for opt, value in options if opt == BLOCK1), None)
+
+        resp_options = []
+        if msg_code != 2:
+            # Accept uploads only.
+            resp_code = code("4.05")
+        elif block is None:
+            # Whole payload in a single request.
+            resp_code = args.code
+            complete = payload
+        else:
+            num, more, szx = block >> 4, block >> 3 & 1, block & 7
+            collected = transfers.get((addr, path), b"")
+            if num * (16 << szx) != len(collected):
+                # Block out of order.
+                resp_code = code("4.08")
+                transfers.pop((addr, path), None)
+            else:
+                collected += payload
+                resp_code = code("2.31") if more else args.code
+                transfers[(addr, path)] = collected
+                complete = collected if not more else None
+            resp_options.append((BLOCK1, uint(block)))
+
+        if resp_code == args.code:
+            transfers.pop((addr, path), None)
+            count += 1
+            show(path, fmt, complete)
+            if args.save:
+                name = os.path.join(args.save, "%04d.%s" % (
+                    count, FORMATS.get(fmt, "bin")))
+                with open(name, "wb") as f:
+                    f.write(complete)
+        elif resp_code != code("2.31"):
+            print("%s: %s" % (path, code_str(resp_code)), file=sys.stderr)
+
+        if args.separate and kind == CON:
+            # Acknowledge empty, then respond in a request of our own.
+            next_id = (next_id + 1) & 0xffff
+            replies = [
+                build(ACK, 0, msg_id),
+                build(CON, resp_code, next_id, token, resp_options),
+            ]
+        else:
+            replies = [build(ACK if kind == CON else NON, resp_code, msg_id,
+                             token, resp_options)]
+
+        answered[(addr, msg_id)] = replies
+        if len(answered) > 1024:
+            del answered[next(iter(answered))]
+        for reply in replies:
+            sock.sendto(reply, addr)
+
+
+if __name__ == "__main__":
+    main()
@@ -0,0 +1,151 @@
+#!/usr/bin/env python3
+
+"""Stand-in HTTP server for uploads made by the nRF9160 Logger.
+
+Accepts POST requests, as sent by the device when a data frame type is uploaded
+over HTTP, and acknowledges them the way a database server would. Payloads may
+be sent with a fixed length or chunked, and gzip-encoded payloads are
+decompressed, after which every payload is printed. Connections are kept open
+between requests. With --code, the response code can be changed, for instance
+to 400 to test how the device handles a rejection. With --save, every payload is
+also written to a file in the given directory. With --phase, the given phase is
+picked out of every performance data frame received in JSON format, and a
+summary over all of them is printed once the server is stopped, which allows
+the durations of a phase to be compared between two builds of the application.
+Plain HTTP is spoken, so the device must be configured with
+CONFIG_REST_USE_TLS=n.
+"""
+
+import argparse
+import gzip
+import http.server
+import json
+import os
+import sys
+
+# Content types.
+FORMATS = {"application/json": "json", "application/cbor": "cbor"}
+
+
+class Handler(http.server.BaseHTTPRequestHandler):
+    """Handler answering every upload with the configured response code."""
+
+    protocol_version = "HTTP/1.1"
+
+    def log_message(self, fmt, *args):
+        """Leave requests unlogged, as payloads are printed instead."""
+
+    def body(self):
+        """Read the payload, with a fixed length or chunked."""
+        if self.headers.get("Transfer-Encoding", "").lower() == "chunked":
+            data = b""
+            while True:
+                size = int(self.rfile.readline().split(b";")[0], 16)
+                if size == 0:
+                    # Skip trailer up to the final empty line.
+                    while self.rfile.readline().strip():
+                        pass
+                    return data
+                data += self.rfile.read(size)
+                self.rfile.readline()
+        return self.rfile.read(int(self.headers.get("Content-Length", 0)))
+
+    def do_POST(self):
+        server = self.server
+        payload = self.body()
+        size = len(payload)
+        if self.headers.get("Content-Encoding", "").lower() == "gzip":
+            payload = gzip.decompress(payload)
+        fmt = FORMATS.get(
+            self.headers.get("Content-Type", "").split(";")[0].strip())
+
+        server.count += 1
+        show(self.path, fmt, size, payload)
+        if server.save:
+            name = os.path.join(server.save, "%04d.%s" % (
+                server.count, fmt or "bin"))
+            with open(name, "wb") as f:
+                f.write(payload)
+        if server.phase and fmt == "json":
+            collect(server.phase, server.phases, payload)
+
+        self.send_response(server.code)
+        self.send_header("Content-Length", "0")
+        self.end_headers()
+
+
+def show(path, fmt, size, payload):
+    """Print a complete payload."""
+    print("%s: %d bytes (%s), %d bytes sent" % (
+        path, len(payload), fmt or "unknown", size))
+    if fmt == "json":
+        try:
+            print(json.dumps(json.loads(payload), indent=2))
+        except ValueError:
+            print(payload.decode("utf-8", "replace"))
+    sys.stdout.flush()
+
+
+def collect(phase, phases, payload):
+    """Pick the given phase out of the performance data frames of a batch."""
+    try:
+        frames = json.loads(payload)
+    except ValueError:
+        return
+    for frame in frames if isinstance(frames, list) else [frames]:
+        if not isinstance(frame, dict):
+            continue
+        for entry in frame.get("phases", []):
+            if entry.get("phase") == phase and entry.get("count", 0) > 0:
+                phases.append(entry)
+
+
+def summary(phase, phases):
+    """Print a summary of the given phase over all performance data frames."""
+    if not phases:
+        print("%s: no durations received" % phase)
+        return
+    count = sum(entry["count"] for entry in phases)
+    p50 = sum(entry["p50"] * entry["count"] for entry in phases) / count
+    p95 = sum(entry["p95"] * entry["count"] for entry in phases) / count
+    print("%s: %d durations in %d data frames, min %d ms, max %d ms, "
+          "p50 %.1f ms, p95 %.1f ms (weighted by count)" % (
+              phase, count, len(phases),
+              min(entry["min"] for entry in phases),
+              max(entry["max"] for entry in phases), p50, p95))
+
+
+def main():
+    parser = argparse.ArgumentParser(description=__doc__.splitlines()[0])
+    parser.add_argument("--host", default="0.0.0.0",
+                        help="address to listen on (default: 0.0.0.0)")
+    parser.add_argument("--port", type=int, default=8080,
+                        help="port to listen on (default: 8080)")
+    parser.add_argument("--code", type=int, default=201,
+                        help="response code (default: 201)")
+    parser.add_argument("--save", metavar="DIR",
+                        help="write complete payloads to files in DIR")
+    parser.add_argument("--phase", metavar="NAME",
+                        help="summarize phase NAME of performance data")
+    args = parser.parse_args()
+
+    server = http.server.ThreadingHTTPServer((args.host, args.port), Handler)
+    server.code = args.code
+    server.save = args.save
+    server.phase = args.phase
+    server.phases = []  # Entries of summarized phase received.
+    server.count = 0    # Number of complete payloads.
+    print("Listening on %s:%d" % (args.host, args.port), file=sys.stderr)
+
+    try:
+        server.serve_forever()
+    except KeyboardInterrupt:
+        pass
+    finally:
+        server.server_close()
+        if args.phase:
+            summary(args.phase, server.phases)
+
+
+if __name__ == "__main__":
+    main()
@@ -0,0 +1,530 @@
+#include <stdlib.h>
+#include <stdbool.h>
+#include <stdint.h>
+#include <stdio.h>
+#include <string.h>
+#include <errno.h>
+
+#include <zephyr/kernel.h>
+#include <zephyr/logging/log.h>
+#include <zephyr/sys/util.h>
+#include <zephyr/net/socket.h>
+#include <zephyr/net/tls_credentials.h>
+#include <zephyr/net/coap.h>
+
+#include "coapc.h"
+
+// Register module for logging.
+LOG_MODULE_REGISTER(coapc, CONFIG_COAPC_LOG_LEVEL);
+
+BUILD_ASSERT(
+    CONFIG_COAPC_BLOCK_SIZE >= 16 && CONFIG_COAPC_BLOCK_SIZE <= 1024
+    && (CONFIG_COAPC_BLOCK_SIZE & (CONFIG_COAPC_BLOCK_SIZE - 1)) == 0,
+    "CoAP block size must be a power of two from 16 to 1024"
+);
+
+// Room for the header and options of a request, which includes the path and
+// query of its URL.
+#define COAPC_HEAD_MAX  128
+
+// Size of datagram buffers, which hold a request carrying a full block, or a
+// response.
+#define COAPC_BUF_SIZE  (CONFIG_COAPC_BLOCK_SIZE + COAPC_HEAD_MAX)
+
+// Block size exponent, from which the block size is 2 ^ (exponent + 4).
+#define COAPC_BLOCK_SZX (find_lsb_set(CONFIG_COAPC_BLOCK_SIZE) - 5)
+
+// Socket connected to server, kept open between transfers, or -1 if no
+// connection is open.
+static int _coapc_sock = -1;
+
+// Transfer statistics. Mutex protects against concurrent access, as this is a
+// shared resource.
+static K_MUTEX_DEFINE(_coapc_stats_mutex);
+static coapc_stats_t _coapc_stats = {
+    .transfers = 0,
+    .blocks = 0,
+    .retransmits = 0,
+    .handshakes = 0,
+    .sent = 0
+};
+
+static void _coapc_count (uint32_t * counter, uint32_t value) {
+    // Add to statistics counter.
+    k_mutex_lock(&_coapc_stats_mutex, K_FOREVER);
+    *counter += value;
+    k_mutex_unlock(&_coapc_stats_mutex);
+}
+
+static int _coapc_connect (void) {
+    int status;                 // Return status for API calls.
+    int sock;                   // Socket descriptor.
+    char port[8];               // Port number as string.
+    struct addrinfo hints;      // Address lookup hints.
+    struct addrinfo * addr;     // Resolved server address.
+
+#if defined(CONFIG_COAPC_USE_DTLS)
+    sec_tag_t sec_tag = CONFIG_COAPC_SEC_TAG;   // DTLS security tag.
+    int verify = TLS_PEER_VERIFY_NONE;          // DTLS peer verification.
+#endif
+
+    /*
+     * Resolve server address, open socket, configure DTLS if used, and
+     * connect to server, which makes the DTLS handshake. If an error occurs in
+     * this process, close the socket and exit with failure.
+     */
+
+    memset(&hints, 0, sizeof(hints));
+    hints.ai_family = AF_INET;
+    hints.ai_socktype = SOCK_DGRAM;
+
+    snprintf(port, sizeof(port), "%d", CONFIG_COAPC_PORT_NUM);
+
+    // Resolve server address.
+    status = getaddrinfo(CONFIG_COAPC_HOST_NAME, port, &hints, &addr);
+    if (status != 0) {
+        // On error, exit with failure.
+        LOG_ERR("Failed to resolve server address (%d)", status);
+        return -1;
+    }
+
+    // Open socket.
+#if defined(CONFIG_COAPC_USE_DTLS)
+    sock = socket(addr->ai_family, SOCK_DGRAM, IPPROTO_DTLS_1_2);
+#else
+    sock = socket(addr->ai_family, SOCK_DGRAM, IPPROTO_UDP);
+#endif
+    if (sock < 0) {
+        // On error, exit with failure.
+        LOG_ERR("Failed to open socket (%s)", strerror(errno));
+        freeaddrinfo(addr);
+        return -1;
+    }
+
+#if defined(CONFIG_COAPC_USE_DTLS)
+    // Configure DTLS.
+    if (
+        setsockopt(
+            sock, SOL_TLS, TLS_SEC_TAG_LIST, &sec_tag, sizeof(sec_tag)
+        ) < 0
+        || setsockopt(
+            sock, SOL_TLS, TLS_PEER_VERIFY, &verify, sizeof(verify)
+        ) < 0
+        || setsockopt(
+            sock, SOL_TLS, TLS_HOSTNAME, CONFIG_COAPC_HOST_NAME,
+            strlen(CONFIG_COAPC_HOST_NAME)
+        ) < 0
+    ) {
+        // On error, close socket and exit with failure.
+        LOG_ERR("Failed to configure DTLS (%s)", strerror(errno));
+        close(sock);
+        freeaddrinfo(addr);
+        return -1;
+    }
+#endif
+
+    // Connect to server.
+    status = connect(sock, addr->ai_addr, addr->ai_addrlen);
+    freeaddrinfo(addr);
+    if (status < 0) {
+        // On error, close socket and exit with failure.
+        LOG_ERR("Failed to connect to server (%s)", strerror(errno));
+        close(sock);
+        return -1;
+    }
+
+    _coapc_count(&_coapc_stats.handshakes, 1);
+
+    return sock;
+}
+
+static int _coapc_options (coapc_xfer_t * xfer, struct coap_packet * pkt) {
+    const char * path;  // Remaining path of URL.
+    const char * query; // Query of URL, or NULL.
+    const char * end;   // End of path segment or query parameter.
+
+    /*
+     * Append path segments of URL as Uri-Path options, content format if the
+     * request carries a payload, and parameters of URL query as Uri-Query
+     * options, in the order of their option numbers.
+     */
+
+    path = xfer->url;
+    query = strchr(path, '?');
+
+    while (*path != '\0' && path != query) {
+        if (*path == '/') {
+            path++;
+            continue;
+        }
+        end = path + strcspn(path, "/?");
+        if (
+            coap_packet_append_option(
+                pkt, COAP_OPTION_URI_PATH, (const uint8_t *)path, end - path
+            ) < 0
+        ) {
+            return -1;
+        }
+        path = end;
+    }
+
+    if (
+        (xfer->method == COAP_METHOD_POST || xfer->method == COAP_METHOD_PUT)
+        && coap_append_option_int(
+            pkt, COAP_OPTION_CONTENT_FORMAT, CONFIG_COAPC_CONT_FORMAT
+        ) < 0
+    ) {
+        return -1;
+    }
+
+    while (query != NULL && *query != '\0') {
+        query++;
+        end = query + strcspn(query, "&");
+        if (
+            end > query
+            && coap_packet_append_option(
+                pkt, COAP_OPTION_URI_QUERY, (const uint8_t *)query,
+                end - query
+            ) < 0
+        ) {
+            return -1;
+        }
+        query = *end != '\0' ? end : NULL;
+    }
+
+    return 0;
+}
+
+static int _coapc_build (
+    coapc_xfer_t * xfer, struct coap_packet * pkt, uint8_t * buf, uint16_t id,
+    bool more
+) {
+    /*
+     * Build confirmable request carrying the contents of the block buffer.
+     * The Block1 option is added unless the whole payload fits in the first
+     * block.
+     */
+
+    if (
+        coap_packet_init(
+            pkt, buf, COAPC_BUF_SIZE, COAP_VERSION_1, COAP_TYPE_CON,
+            sizeof(xfer->token), xfer->token, xfer->method, id
+        ) < 0
+        || _coapc_options(xfer, pkt) < 0
+    ) {
+        return -1;
+    }
+
+    if (
+        (xfer->num > 0 || more)
+        && coap_append_option_int(
+            pkt, COAP_OPTION_BLOCK1,
+            xfer->num << 4 | (more ? 1 << 3 : 0) | COAPC_BLOCK_SZX
+        ) < 0
+    ) {
+        return -1;
+    }
+
+    if (
+        xfer->fill > 0
+        && (
+            coap_packet_append_payload_marker(pkt) < 0
+            || coap_packet_append_payload(pkt, xfer->block, xfer->fill) < 0
+        )
+    ) {
+        return -1;
+    }
+
+    return 0;
+}
+
+static void _coapc_response (coapc_xfer_t * xfer, struct coap_packet * pkt) {
+    const uint8_t * payload;    // Response payload.
+    uint16_t len;               // Length of response payload.
+
+    // Record response code, and copy payload into response buffer, if any,
+    // leaving room for the terminating null byte.
+
+    xfer->code = coap_header_get_code(pkt);
+
+    if (xfer->resp == NULL || xfer->size == 0) {
+        return;
+    }
+
+    payload = coap_packet_get_payload(pkt, &len);
+    if (payload == NULL) {
+        len = 0;
+    }
+
+    xfer->len = MIN(len, xfer->size - 1);
+    xfer->overflow = xfer->len < len;
+    memcpy(xfer->resp, payload, xfer->len);
+    xfer->resp[xfer->len] = '\0';
+}
+
+static int _coapc_await (
+    coapc_xfer_t * xfer, uint16_t id, int timeout, bool more
+) {
+    int status;                     // Return status for API calls.
+    uint8_t buf[COAPC_BUF_SIZE];    // Received datagram.
+    struct coap_packet pkt;         // Received message.
+    uint8_t ack_buf[4];             // Acknowledgement datagram.
+    struct coap_packet ack;         // Acknowledgement message.
+    uint8_t token[8];               // Token of received message.
+    uint8_t type;                   // Type of received message.
+    struct pollfd fds;              // Poll descriptor.
+    int64_t deadline;               // Time by which a message must arrive.
+    bool acked = false;             // Request acknowledged without response.
+    int remaining;                  // Time remaining until deadline.
+
+    /*
+     * Wait for the response to the request with the given message ID, which
+     * is either piggybacked on its acknowledgement, or, if the server
+     * acknowledges the request first, sent separately as a request of its own
+     * with the same token, which must itself be acknowledged. Messages that
+     * belong to neither are ignored. Return 1 once the response has been
+     * received, 0 if the request has not been acknowledged in time, and -1 on
+     * error, including a separate response not arriving in time.
+     */
+
+    deadline = k_uptime_get() + timeout;
+
+    fds.fd = _coapc_sock;
+    fds.events = POLLIN;
+
+    while (true) {
+        remaining = (int)CLAMP(deadline - k_uptime_get(), 0, INT32_MAX);
+        if (remaining == 0) {
+            return acked ? -1 : 0;
+        }
+
+        // Wait for datagram.
+        status = poll(&fds, 1, remaining);
+        if (status < 0) {
+            LOG_ERR("Failed to poll socket (%s)", strerror(errno));
+            return -1;
+        }
+        if (status == 0) {
+            continue;
+        }
+
+        status = recv(_coapc_sock, buf, sizeof(buf), MSG_DONTWAIT);
+        if (status < 0) {
+            if (errno == EAGAIN) {
+                continue;
+            }
+            LOG_ERR("Failed to receive response (%s)", strerror(errno));
+            return -1;
+        }
+
+        if (coap_packet_parse(&pkt, buf, status, NULL, 0) < 0) {
+            LOG_WRN("Ignoring malformed message");
+            continue;
+        }
+
+        type = coap_header_get_type(&pkt);
+
+        if (coap_header_get_id(&pkt) == id) {
+            if (type == COAP_TYPE_RESET) {
+                LOG_ERR("Request reset by server");
+                return -1;
+            }
+
+            if (type == COAP_TYPE_ACK && coap_header_get_code(&pkt) == 0) {
+                // Empty acknowledgement, so wait for separate response.
+                acked = true;
+                deadline = k_uptime_get() + 1000 * CONFIG_COAPC_RESP_TIMEOUT;
+                continue;
+            }
+
+            if (type == COAP_TYPE_ACK) {
+                break;
+            }
+        }
+
+        if (
+            acked && (type == COAP_TYPE_CON || type == COAP_TYPE_NON_CON)
+            && coap_header_get_token(&pkt, token) == sizeof(xfer->token)
+            && memcmp(token, xfer->token, sizeof(xfer->token)) == 0
+        ) {
+            if (
+                type == COAP_TYPE_CON
+                && coap_packet_init(
+                    &ack, ack_buf, sizeof(ack_buf), COAP_VERSION_1,
+                    COAP_TYPE_ACK, 0, NULL, COAP_CODE_EMPTY,
+                    coap_header_get_id(&pkt)
+                ) == 0
+            ) {
+                // Acknowledge separate response.
+                send(_coapc_sock, ack_buf, ack.offset, 0);
+            }
+            break;
+        }
+    }
+
+    // Keep response, unless it asks for the next block.
+    if (!more || coap_header_get_code(&pkt) != COAP_RESPONSE_CODE_CONTINUE) {
+        _coapc_response(xfer, &pkt);
+    }
+
+    return 1;
+}
+
+static int _coapc_send (coapc_xfer_t * xfer, bool more) {
+    int status;                     // Return status for API calls.
+    uint8_t buf[COAPC_BUF_SIZE];    // Request datagram.
+    struct coap_packet pkt;         // Request message.
+    uint16_t id;                    // Message ID.
+    int timeout;                    // Acknowledgement timeout.
+
+    /*
+     * Connect to server unless a connection is still open, send the block in
+     * the block buffer as a confirmable request, and wait for the response.
+     * The request is retransmitted each time its acknowledgement does not
+     * arrive in time, with the timeout doubling every time, until the number
+     * of retransmissions is exhausted. Retransmissions keep the message ID, so
+     * that the server can recognize duplicates. If an error occurs in this
+     * process, close the connection, so that the next transfer establishes a
+     * new one, and exit with failure.
+     */
+
+    if (_coapc_sock < 0) {
+        _coapc_sock = _coapc_connect();
+        if (_coapc_sock < 0) {
+            return -1;
+        }
+    }
+
+    id = coap_next_id();
+
+    if (_coapc_build(xfer, &pkt, buf, id, more) < 0) {
+        LOG_ERR("Failed to build request");
+        return -1;
+    }
+
+    timeout = CONFIG_COAPC_ACK_TIMEOUT;
+
+    for (int i = 0; i <= CONFIG_COAPC_MAX_RETRANSMIT; i++) {
+        if (i > 0) {
+            LOG_WRN(
+                "Retransmitting block %u (%d/%d)",
+                xfer->num, i, CONFIG_COAPC_MAX_RETRANSMIT
+            );
+            _coapc_count(&_coapc_stats.retransmits, 1);
+        }
+
+        status = send(_coapc_sock, buf, pkt.offset, 0);
+        if (status < 0) {
+            LOG_ERR("Failed to send request (%s)", strerror(errno));
+            break;
+        }
+
+        _coapc_count(&_coapc_stats.blocks, 1);
+        _coapc_count(&_coapc_stats.sent, pkt.offset);
+
+        status = _coapc_await(xfer, id, timeout, more);
+        if (status != 0) {
+            break;
+        }
+
+        timeout *= 2;
+    }
+
+    if (status <= 0) {
+        // On error, close connection and exit with failure.
+        LOG_ERR("No response to block %u", xfer->num);
+        coapc_close();
+        return -1;
+    }
+
+    return 0;
+}
+
+void coapc_begin (
+    coapc_xfer_t * xfer, uint8_t method, const char * url, char * resp,
+    size_t size
+) {
+    // Reset transfer state, and draw token shared by all of its requests.
+    xfer->method = method;
+    xfer->url = url;
+    xfer->resp = resp;
+    xfer->size = size;
+    xfer->code = 0;
+    xfer->len = 0;
+    xfer->overflow = false;
+    xfer->num = 0;
+    xfer->fill = 0;
+    memcpy(xfer->token, coap_next_token(), sizeof(xfer->token));
+}
+
+int coapc_write (coapc_xfer_t * xfer, const void * data, size_t len) {
+    size_t part;    // Length of part fitting in block buffer.
+
+    /*
+     * Collect data in block buffer. A full block is sent only once more data
+     * follows, so that the last block is always sent by coapc_finish(), and
+     * flagged as such. If the server ends the transfer early, exit with
+     * failure.
+     */
+
+    if (xfer->code != 0) {
+        return -1;
+    }
+
+    while (len > 0) {
+        if (xfer->fill == sizeof(xfer->block)) {
+            if (_coapc_send(xfer, true) < 0) {
+                return -1;
+            }
+            if (xfer->code != 0) {
+                LOG_ERR(
+                    "Transfer ended by server (Response code %u.%02u)",
+                    xfer->code >> 5, xfer->code & 0x1f
+                );
+                return -1;
+            }
+            xfer->num++;
+            xfer->fill = 0;
+        }
+
+        part = MIN(len, sizeof(xfer->block) - xfer->fill);
+        memcpy(&xfer->block[xfer->fill], data, part);
+        xfer->fill += part;
+        data = (const uint8_t *)data + part;
+        len -= part;
+    }
+
+    return 0;
+}
+
+int coapc_finish (coapc_xfer_t * xfer) {
+    // Send last block, unless server has ended transfer already.
+    if (xfer->code == 0 && _coapc_send(xfer, false) < 0) {
+        return -1;
+    }
+
+    LOG_DBG(
+        "Transfer of %u blocks complete (Response code %u.%02u)",
+        xfer->num + 1, xfer->code >> 5, xfer->code & 0x1f
+    );
+
+    _coapc_count(&_coapc_stats.transfers, 1);
+
+    return 0;
+}
+
+void coapc_close (void) {
+    // Close socket kept open, if any.
+    if (_coapc_sock >= 0) {
+        LOG_INF("Closing CoAP connection");
+        close(_coapc_sock);
+        _coapc_sock = -1;
+    }
+}
+
+void coapc_stats (coapc_stats_t * stats) {
+    // Copy statistics.
+    k_mutex_lock(&_coapc_stats_mutex, K_FOREVER);
+    *stats = _coapc_stats;
+    k_mutex_unlock(&_coapc_stats_mutex);
+}
@@ -0,0 +1,149 @@
+/** @defgroup   coapc CoAP client
+ *
+ *  @brief      CoAP requests over UDP.
+ *
+ *  This module makes confirmable CoAP requests to the configured server over
+ *  UDP, optionally secured with DTLS. It serves the REST module as a lighter
+ *  transport than HTTP, which needs no TCP handshake, sends compact binary
+ *  headers, and expects no more than an acknowledgement in return. A transfer
+ *  is started by calling coapc_begin(), its payload is written piece by piece
+ *  with coapc_write(), and it is completed by calling coapc_finish(). Payloads
+ *  longer than a single block are sent with block-wise transfer, one
+ *  confirmable request per block, so that only one block need be held in
+ *  memory. Requests that are not acknowledged are retransmitted with
+ *  exponential backoff. The socket, and with it the DTLS session, is kept open
+ *  between transfers until it is closed by calling coapc_close(). How many
+ *  blocks and retransmissions were sent can be obtained with coapc_stats().
+ */
+
+#ifndef __COAPC_H__
+#define __COAPC_H__
+
+#include <stdbool.h>
+#include <stddef.h>
+#include <stdint.h>
+
+/** @ingroup    coapc
+ *
+ *  @brief      Length of request tokens, in bytes.
+ */
+
+#define COAPC_TOKEN_LEN 4
+
+/** @ingroup    coapc
+ *
+ *  @brief      Transfer statistics.
+ *
+ *  This structure holds counters describing the traffic caused by transfers.
+ *  It is filled in by coapc_stats().
+ */
+
+typedef struct {
+    uint32_t transfers;     //!< Number of transfers completed.
+    uint32_t blocks;        //!< Number of requests sent, one per block.
+    uint32_t retransmits;   //!< Number of requests retransmitted.
+    uint32_t handshakes;    //!< Number of connections established.
+    uint32_t sent;          //!< Total number of bytes sent in datagrams.
+} coapc_stats_t;
+
+/** @ingroup    coapc
+ *
+ *  @brief      Transfer.
+ *
+ *  This structure holds the state of a transfer. It is initialized by
+ *  coapc_begin(), and must not be modified directly. The response members may
+ *  be read once the transfer has been completed, or once writing to it has
+ *  failed.
+ */
+
+typedef struct {
+    uint8_t method;                 //!< Request method code.
+    const char * url;               //!< URL of the requested resource.
+    char * resp;                    //!< Buffer for response payload, or NULL.
+    size_t size;                    //!< Size of response buffer.
+    uint8_t code;                   //!< Response code, or 0 if none received.
+    size_t len;                     //!< Length of response payload.
+    bool overflow;                  //!< Response payload did not fit.
+    uint8_t token[COAPC_TOKEN_LEN]; //!< Token of requests.
+    uint32_t num;                   //!< Number of current block.
+    size_t fill;                    //!< Number of bytes in block buffer.
+    uint8_t block[CONFIG_COAPC_BLOCK_SIZE]; //!< Block buffer.
+} coapc_xfer_t;
+
+/** @ingroup    coapc
+ *
+ *  @brief      Start transfer.
+ *
+ *  Prepares the given transfer of a request to the configured server. The URL
+ *  is split into the path and query options of the request. If a response
+ *  buffer is given, the payload of the final response and a terminating null
+ *  byte are written into it, and the payload is truncated if it does not fit.
+ *
+ *  @param      xfer    Pointer to transfer.
+ *  @param      method  Request method code.
+ *  @param      url     URL of the requested resource.
+ *  @param      resp    Pointer to buffer for response payload, or NULL.
+ *  @param      size    Size of buffer.
+ */
+
+void coapc_begin (
+    coapc_xfer_t * xfer, uint8_t method, const char * url, char * resp,
+    size_t size
+);
+
+/** @ingroup    coapc
+ *
+ *  @brief      Write request payload.
+ *
+ *  Appends the given data to the request payload. Each time the block buffer
+ *  is full and more data follows, the block is sent, and the acknowledgement
+ *  of the server awaited. If the server responds to a block with anything but
+ *  a request for the next one, the transfer ends, and the response is kept.
+ *
+ *  @param      xfer    Pointer to transfer.
+ *  @param      data    Pointer to data that must be written.
+ *  @param      len     Length of data.
+ *
+ *  @retval     0       Success.
+ *  @retval     -1      Failure. The transfer has ended.
+ */
+
+int coapc_write (coapc_xfer_t * xfer, const void * data, size_t len);
+
+/** @ingroup    coapc
+ *
+ *  @brief      Complete transfer.
+ *
+ *  Sends the last block of the request payload, and awaits the response of
+ *  the server.
+ *
+ *  @param      xfer    Pointer to transfer.
+ *
+ *  @retval     0       Success. A response was received.
+ *  @retval     -1      Failure. No response was received.
+ */
+
+int coapc_finish (coapc_xfer_t * xfer);
+
+/** @ingroup    coapc
+ *
+ *  @brief      Close connection.
+ *
+ *  Closes the socket kept open after the last transfer, if any. This must be
+ *  called before the network connection is lost. The next transfer
+ *  establishes a new connection.
+ */
+
+void coapc_close (void);
+
+/** @ingroup    coapc
+ *
+ *  @brief      Obtain transfer statistics.
+ *
+ *  @param      stats   Pointer to buffer into which statistics must be
+ *                      written.
+ */
+
+void coapc_stats (coapc_stats_t * stats);
+
+#endif
@@ -0,0 +1,333 @@
+#include <stdbool.h>
+#include <stddef.h>
+#include <stdint.h>
+#include <string.h>
+
+#include <zephyr/kernel.h>
+#include <zephyr/logging/log.h>
+#include <zephyr/sys/crc.h>
+#include <zephyr/sys/util.h>
+
+#include "compress.h"
+
+// Register module for logging.
+LOG_MODULE_REGISTER(compress, CONFIG_COMPRESS_LOG_LEVEL);
+
+// Size of sliding window. Back references reach at most twice this far, which
+// must stay within the 32 KiB limit of the deflate format, and every match
+// must fit in the window.
+#define COMPRESS_WINDOW     CONFIG_COMPRESS_WINDOW_SIZE
+
+BUILD_ASSERT(
+    COMPRESS_WINDOW >= 512 && COMPRESS_WINDOW <= 16384,
+    "Compression window size out of range"
+);
+
+// Shortest and longest matches encoded as back references.
+#define COMPRESS_MATCH_MIN  3
+#define COMPRESS_MATCH_MAX  258
+
+// Deflate symbol marking the end of a block.
+#define COMPRESS_END_BLOCK  256
+
+// Header of gzip stream, with deflate compression, no file name, no
+// modification time, and unknown operating system.
+static const uint8_t _compress_gzip_head [] = {
+    0x1f, 0x8b, 0x08, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0xff
+};
+
+// Base values and extra bit counts of deflate length codes 257 to 285.
+static const uint16_t _compress_len_base [] = {
+    3, 4, 5, 6, 7, 8, 9, 10, 11, 13, 15, 17, 19, 23, 27, 31, 35, 43, 51, 59,
+    67, 83, 99, 115, 131, 163, 195, 227, 258
+};
+static const uint8_t _compress_len_extra [] = {
+    0, 0, 0, 0, 0, 0, 0, 0, 1, 1, 1, 1, 2, 2, 2, 2, 3, 3, 3, 3, 4, 4, 4, 4,
+    5, 5, 5, 5, 0
+};
+
+// Base values and extra bit counts of deflate distance codes 0 to 29.
+static const uint16_t _compress_dist_base [] = {
+    1, 2, 3, 4, 5, 7, 9, 13, 17, 25, 33, 49, 65, 97, 129, 193, 257, 385, 513,
+    769, 1025, 1537, 2049, 3073, 4097, 6145, 8193, 12289, 16385, 24577
+};
+static const uint8_t _compress_dist_extra [] = {
+    0, 0, 0, 0, 1, 1, 2, 2, 3, 3, 4, 4, 5, 5, 6, 6, 7, 7, 8, 8, 9, 9, 10, 10,
+    11, 11, 12, 12, 13, 13
+};
+
+// Totals of completed streams. Mutex protects against concurrent access, as
+// this is a shared resource. Processor time is kept in microseconds.
+static K_MUTEX_DEFINE(_compress_stats_mutex);
+static compress_stats_t _compress_stats = {
+    .streams = 0,
+    .in = 0,
+    .out = 0,
+    .time_ms = 0
+};
+static uint64_t _compress_time_us = 0;
+
+static void _compress_flush (compress_t * comp) {
+    // Pass output buffer to output function, unless only counting.
+    if (
+        comp->write != NULL && !comp->failed && comp->olen > 0
+        && comp->write(comp->ctx, comp->obuf, comp->olen) < 0
+    ) {
+        comp->failed = true;
+    }
+    comp->olen = 0;
+}
+
+static void _compress_byte (compress_t * comp, uint8_t byte) {
+    // Append byte to output buffer, flushing it when full.
+    comp->obuf[comp->olen++] = byte;
+    comp->out++;
+    if (comp->olen == sizeof(comp->obuf)) {
+        _compress_flush(comp);
+    }
+}
+
+static void _compress_bits (compress_t * comp, uint32_t value, int count) {
+    // Append bits to output, least significant bit first.
+    comp->bits |= value << comp->nbits;
+    comp->nbits += count;
+    while (comp->nbits >= 8) {
+        _compress_byte(comp, comp->bits & 0xff);
+        comp->bits >>= 8;
+        comp->nbits -= 8;
+    }
+}
+
+static void _compress_code (compress_t * comp, uint32_t code, int count) {
+    uint32_t rev = 0;   // Code with bit order reversed.
+
+    // Append Huffman code, which is packed most significant bit first.
+    for (int i = 0; i < count; i++) {
+        rev = rev << 1 | (code >> i & 1);
+    }
+    _compress_bits(comp, rev, count);
+}
+
+static void _compress_symbol (compress_t * comp, int sym) {
+    // Append literal or length symbol with fixed Huffman code.
+    if (sym < 144) {
+        _compress_code(comp, 0x30 + sym, 8);
+    } else if (sym < 256) {
+        _compress_code(comp, 0x190 + sym - 144, 9);
+    } else if (sym < 280) {
+        _compress_code(comp, sym - 256, 7);
+    } else {
+        _compress_code(comp, 0xc0 + sym - 280, 8);
+    }
+}
+
+static void _compress_match (compress_t * comp, size_t len, size_t dist) {
+    int code;   // Length or distance code.
+
+    // Append back reference of given length and distance.
+
+    code = ARRAY_SIZE(_compress_len_base) - 1;
+    while (_compress_len_base[code] > len) {
+        code--;
+    }
+    _compress_symbol(comp, 257 + code);
+    _compress_bits(
+        comp, len - _compress_len_base[code], _compress_len_extra[code]
+    );
+
+    code = ARRAY_SIZE(_compress_dist_base) - 1;
+    while (_compress_dist_base[code] > dist) {
+        code--;
+    }
+    _compress_code(comp, code, 5);
+    _compress_bits(
+        comp, dist - _compress_dist_base[code], _compress_dist_extra[code]
+    );
+}
+
+static uint32_t _compress_hash (const uint8_t * data) {
+    // Hash the next three bytes into a hash table index.
+    return (((uint32_t)data[0] << 16 | data[1] << 8 | data[2]) * 2654435761u
+        >> 16) % COMPRESS_HASH_SIZE;
+}
+
+static void _compress_insert (compress_t * comp, size_t pos) {
+    // Record position as the latest occurrence of the three bytes it starts.
+    comp->head[_compress_hash(&comp->window[pos])] = pos + 1;
+}
+
+static void _compress_run (compress_t * comp, bool final) {
+    size_t avail;       // Number of bytes available from current position.
+    size_t cand = 0;    // Position of earlier occurrence of current bytes.
+    size_t len;         // Length of match.
+    size_t max;         // Maximum length of match.
+
+    /*
+     * Compress window contents from the current position. Unless the stream
+     * is being completed, stop while fewer bytes remain than the longest
+     * possible match, so that matches are not cut short at the end of the
+     * data written so far. At each position, look up the latest earlier
+     * occurrence of the next three bytes, and emit a back reference to it if
+     * it matches, or a literal byte otherwise.
+     */
+
+    while (
+        comp->pos < comp->fill
+        && (final || comp->fill - comp->pos >= COMPRESS_MATCH_MAX)
+    ) {
+        avail = comp->fill - comp->pos;
+        len = 0;
+
+        if (avail >= COMPRESS_MATCH_MIN) {
+            cand = comp->head[_compress_hash(&comp->window[comp->pos])];
+            _compress_insert(comp, comp->pos);
+
+            if (cand > 0) {
+                cand--;
+                max = MIN(avail, COMPRESS_MATCH_MAX);
+                while (
+                    len < max
+                    && comp->window[cand + len] == comp->window[comp->pos + len]
+                ) {
+                    len++;
+                }
+            }
+        }
+
+        if (len >= COMPRESS_MATCH_MIN) {
+            _compress_match(comp, len, comp->pos - cand);
+            // Record positions within the match, as far as their three bytes
+            // are available.
+            for (
+                size_t i = 1;
+                i < len && comp->pos + i + COMPRESS_MATCH_MIN <= comp->fill;
+                i++
+            ) {
+                _compress_insert(comp, comp->pos + i);
+            }
+            comp->pos += len;
+        } else {
+            _compress_symbol(comp, comp->window[comp->pos]);
+            comp->pos++;
+        }
+    }
+}
+
+static void _compress_slide (compress_t * comp) {
+    // Discard the older half of the window, and drop hash table entries that
+    // point into it.
+    memmove(comp->window, &comp->window[COMPRESS_WINDOW], COMPRESS_WINDOW);
+    comp->fill -= COMPRESS_WINDOW;
+    comp->pos -= COMPRESS_WINDOW;
+    for (size_t i = 0; i < ARRAY_SIZE(comp->head); i++) {
+        comp->head[i] = comp->head[i] > COMPRESS_WINDOW
+            ? comp->head[i] - COMPRESS_WINDOW : 0;
+    }
+}
+
+void compress_init (compress_t * comp, compress_write_t write, void * ctx) {
+    // Reset stream state.
+    comp->write = write;
+    comp->ctx = ctx;
+    comp->in = 0;
+    comp->out = 0;
+    comp->time_us = 0;
+    comp->crc = 0;
+    comp->bits = 0;
+    comp->nbits = 0;
+    comp->failed = false;
+    comp->fill = 0;
+    comp->pos = 0;
+    comp->olen = 0;
+    memset(comp->head, 0, sizeof(comp->head));
+
+    // Start gzip stream with a single final deflate block using fixed Huffman
+    // codes, which may be of any length.
+    for (size_t i = 0; i < sizeof(_compress_gzip_head); i++) {
+        _compress_byte(comp, _compress_gzip_head[i]);
+    }
+    _compress_bits(comp, 1, 1);
+    _compress_bits(comp, 1, 2);
+}
+
+int compress_write (compress_t * comp, const void * data, size_t len) {
+    uint32_t start; // Cycle count at start.
+    size_t part;    // Length of part fitting in window.
+
+    start = k_cycle_get_32();
+
+    comp->crc = crc32_ieee_update(comp->crc, data, len);
+    comp->in += len;
+
+    // Append data to window, compressing it as it accumulates, and sliding the
+    // window whenever it is full.
+
+    while (len > 0) {
+        if (comp->fill == sizeof(comp->window)) {
+            _compress_slide(comp);
+        }
+
+        part = MIN(len, sizeof(comp->window) - comp->fill);
+        memcpy(&comp->window[comp->fill], data, part);
+        comp->fill += part;
+        data = (const uint8_t *)data + part;
+        len -= part;
+
+        _compress_run(comp, false);
+    }
+
+    comp->time_us += k_cyc_to_us_floor32(k_cycle_get_32() - start);
+
+    return comp->failed ? -1 : 0;
+}
+
+int compress_finish (compress_t * comp) {
+    uint32_t start; // Cycle count at start.
+
+    start = k_cycle_get_32();
+
+    // Compress remaining data, end block, and pad to a byte boundary.
+    _compress_run(comp, true);
+    _compress_symbol(comp, COMPRESS_END_BLOCK);
+    _compress_bits(comp, 0, 7);
+    comp->nbits = 0;
+    comp->bits = 0;
+
+    // End gzip stream with CRC-32 and length of uncompressed data.
+    for (int i = 0; i < 32; i += 8) {
+        _compress_byte(comp, comp->crc >> i);
+    }
+    for (int i = 0; i < 32; i += 8) {
+        _compress_byte(comp, comp->in >> i);
+    }
+    _compress_flush(comp);
+
+    comp->time_us += k_cyc_to_us_floor32(k_cycle_get_32() - start);
+
+    if (comp->failed) {
+        return -1;
+    }
+
+    LOG_DBG(
+        "Compressed %u bytes to %u bytes in %u us",
+        comp->in, comp->out, comp->time_us
+    );
+
+    // Add stream to statistics.
+    k_mutex_lock(&_compress_stats_mutex, K_FOREVER);
+    _compress_stats.streams++;
+    _compress_stats.in += comp->in;
+    _compress_stats.out += comp->out;
+    _compress_time_us += comp->time_us;
+    _compress_stats.time_ms = _compress_time_us / 1000;
+    k_mutex_unlock(&_compress_stats_mutex);
+
+    return 0;
+}
+
+void compress_stats (compress_stats_t * stats) {
+    // Copy statistics.
+    k_mutex_lock(&_compress_stats_mutex, K_FOREVER);
+    *stats = _compress_stats;
+    k_mutex_unlock(&_compress_stats_mutex);
+}
@@ -0,0 +1,154 @@
+/** @defgroup   compress Compression
+ *
+ *  @brief      Streaming payload compression.
+ *
+ *  This module compresses data streams in gzip format, so that they can be
+ *  uploaded with a gzip content encoding. Compression is done with a small
+ *  sliding window and fixed Huffman codes, which keeps the memory footprint to
+ *  a few kilobytes and needs no heap, while still removing most of the
+ *  redundancy of batches of data frames, such as repeated key names. A stream
+ *  is started by calling compress_init() with an output function, data is
+ *  compressed piece by piece by calling compress_write(), and the stream is
+ *  completed by calling compress_finish(). The output function may be left
+ *  out to only determine how well the data compresses. Totals of all
+ *  completed streams, including the processor time spent on compression, can
+ *  be obtained with compress_stats().
+ */
+
+#ifndef __COMPRESS_H__
+#define __COMPRESS_H__
+
+#include <stdbool.h>
+#include <stddef.h>
+#include <stdint.h>
+
+/** @ingroup    compress
+ *
+ *  @brief      Number of hash table entries used to find repeated data.
+ */
+
+#define COMPRESS_HASH_SIZE  512
+
+/** @ingroup    compress
+ *
+ *  @brief      Size of output buffer, in bytes.
+ */
+
+#define COMPRESS_OBUF_SIZE  64
+
+/** @ingroup    compress
+ *
+ *  @brief      Output function for compressed data.
+ *
+ *  Function called by compress_write() and compress_finish() to write each
+ *  piece of compressed data.
+ *
+ *  @param      ctx     Context given along with the output function.
+ *  @param      data    Pointer to data that must be written.
+ *  @param      len     Length of data.
+ *
+ *  @retval     0       Success.
+ *  @retval     -1      Failure. Compression is aborted.
+ */
+
+typedef int (* compress_write_t) (void * ctx, const void * data, size_t len);
+
+/** @ingroup    compress
+ *
+ *  @brief      Compressed stream.
+ *
+ *  This structure holds the state of a compressed stream. It is initialized by
+ *  compress_init(), and must not be modified directly. The byte counts and
+ *  processor time may be read once the stream has been completed.
+ */
+
+typedef struct {
+    compress_write_t write;     //!< Output function, or NULL.
+    void * ctx;                 //!< Context of output function.
+    uint32_t in;                //!< Number of bytes compressed.
+    uint32_t out;               //!< Number of bytes output.
+    uint32_t time_us;           //!< Processor time in microseconds.
+    uint32_t crc;               //!< CRC-32 of bytes compressed.
+    uint32_t bits;              //!< Pending output bits.
+    uint8_t nbits;              //!< Number of pending output bits.
+    bool failed;                //!< Output function failed.
+    size_t fill;                //!< Number of bytes in window.
+    size_t pos;                 //!< Position of next byte to compress.
+    size_t olen;                //!< Number of bytes in output buffer.
+    uint8_t obuf[COMPRESS_OBUF_SIZE];   //!< Output buffer.
+    uint16_t head[COMPRESS_HASH_SIZE];  //!< Latest window positions by hash.
+    uint8_t window[2 * CONFIG_COMPRESS_WINDOW_SIZE];    //!< Sliding window.
+} compress_t;
+
+/** @ingroup    compress
+ *
+ *  @brief      Compression statistics.
+ *
+ *  This structure holds totals over all completed compressed streams. It is
+ *  filled in by compress_stats().
+ */
+
+typedef struct {
+    uint32_t streams;   //!< Number of completed streams.
+    uint32_t in;        //!< Total number of bytes compressed.
+    uint32_t out;       //!< Total number of bytes output.
+    uint32_t time_ms;   //!< Total processor time in milliseconds.
+} compress_stats_t;
+
+/** @ingroup    compress
+ *
+ *  @brief      Start compressed stream.
+ *
+ *  Prepares the given stream for compression. Compressed data is passed to
+ *  the given output function, or, if it is NULL, only counted.
+ *
+ *  @param      comp    Pointer to stream.
+ *  @param      write   Output function, or NULL.
+ *  @param      ctx     Context passed to output function.
+ */
+
+void compress_init (compress_t * comp, compress_write_t write, void * ctx);
+
+/** @ingroup    compress
+ *
+ *  @brief      Compress data.
+ *
+ *  Compresses the given data into the stream. Compressed data is passed to the
+ *  output function as it becomes available.
+ *
+ *  @param      comp    Pointer to stream.
+ *  @param      data    Pointer to data that must be compressed.
+ *  @param      len     Length of data.
+ *
+ *  @retval     0       Success.
+ *  @retval     -1      Failure. The output function failed.
+ */
+
+int compress_write (compress_t * comp, const void * data, size_t len);
+
+/** @ingroup    compress
+ *
+ *  @brief      Complete compressed stream.
+ *
+ *  Compresses any remaining data, writes the end of the stream to the output
+ *  function, and adds the stream to the statistics.
+ *
+ *  @param      comp    Pointer to stream.
+ *
+ *  @retval     0       Success.
+ *  @retval     -1      Failure. The output function failed.
+ */
+
+int compress_finish (compress_t * comp);
+
+/** @ingroup    compress
+ *
+ *  @brief      Obtain compression statistics.
+ *
+ *  @param      stats   Pointer to buffer into which statistics must be
+ *                      written.
+ */
+
+void compress_stats (compress_stats_t * stats);
+
+#endif
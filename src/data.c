@@ -1,318 +1,669 @@
+#include <stdbool.h>
 #include <stddef.h>
+#include <stdint.h>
+#include <stdlib.h>
+#include <string.h>
+#include <errno.h>
 
 #include <zephyr/kernel.h>
 #include <zephyr/logging/log.h>
 #include <zephyr/sys/util.h>
+
+#if defined(CONFIG_DATA_JSON_LIBRARY)
 #include <zephyr/data/json.h>
+#endif
+
+#if defined(CONFIG_DATA_FORMAT_CBOR)
+#include <zcbor_encode.h>
+#endif
 
 #include "data.h"
 
 // Register module for logging.
 LOG_MODULE_REGISTER(data, CONFIG_DATA_LOG_LEVEL);
 
-// JSON description for dummy_data_frame_t structures.
-static const struct json_obj_descr _dummy_data_frame_descr [] = {
-    JSON_OBJ_DESCR_PRIM_NAMED(
-        dummy_data_frame_t, "field1", field1,
-        JSON_TOK_STRING
-    ),
-    JSON_OBJ_DESCR_PRIM_NAMED(
-        dummy_data_frame_t, "field2", field2,
-        JSON_TOK_STRING
-    ),
-    JSON_OBJ_DESCR_PRIM_NAMED(
-        dummy_data_frame_t, "field3", field3,
-        JSON_TOK_STRING
-    ),
-    JSON_OBJ_DESCR_PRIM_NAMED(
-        dummy_data_frame_t, "field4", field4,
-        JSON_TOK_STRING
-    )
-};
-
-// JSON description for lte_data_frame_mode_t structures.
-static const struct json_obj_descr _lte_data_frame_mode_descr [] = {
-    JSON_OBJ_DESCR_PRIM_NAMED(
-        lte_data_frame_mode_t, "valid", valid,
-        JSON_TOK_TRUE
-    ),
-    JSON_OBJ_DESCR_PRIM_NAMED(
-        lte_data_frame_mode_t, "mode", mode,
-        JSON_TOK_STRING
-    )
-};
-
-// JSON description for lte_data_frame_cell_t structures.
-static const struct json_obj_descr _lte_data_frame_cell_descr [] = {
-    JSON_OBJ_DESCR_PRIM_NAMED(
-        lte_data_frame_cell_t, "valid", valid,
-        JSON_TOK_TRUE
-    ),
-    JSON_OBJ_DESCR_PRIM_NAMED(
-        lte_data_frame_cell_t, "id", id,
-        JSON_TOK_NUMBER
-    ),
-    JSON_OBJ_DESCR_PRIM_NAMED(
-        lte_data_frame_cell_t, "tac", tac,
-        JSON_TOK_NUMBER
-    )
-};
-
-// JSON description for lte_data_frame_psm_tau_t structures.
-static const struct json_obj_descr _lte_data_frame_psm_tau_descr [] = {
-    JSON_OBJ_DESCR_PRIM_NAMED(
-        lte_data_frame_psm_tau_t, "days", day,
-        JSON_TOK_NUMBER
-    ),
-    JSON_OBJ_DESCR_PRIM_NAMED(
-        lte_data_frame_psm_tau_t, "hours", hour,
-        JSON_TOK_NUMBER
-    ),
-    JSON_OBJ_DESCR_PRIM_NAMED(
-        lte_data_frame_psm_tau_t, "minutes", min,
-        JSON_TOK_NUMBER
-    ),
-    JSON_OBJ_DESCR_PRIM_NAMED(
-        lte_data_frame_psm_tau_t, "seconds", sec,
-        JSON_TOK_NUMBER
-    )
-};
-
-// JSON description for lte_data_frame_psm_at_t structures.
-static const struct json_obj_descr _lte_data_frame_psm_at_descr [] = {
-    JSON_OBJ_DESCR_PRIM_NAMED(
-        lte_data_frame_psm_at_t, "hours", hour,
-        JSON_TOK_NUMBER
-    ),
-    JSON_OBJ_DESCR_PRIM_NAMED(
-        lte_data_frame_psm_at_t, "minutes", min,
-        JSON_TOK_NUMBER
-    ),
-    JSON_OBJ_DESCR_PRIM_NAMED(
-        lte_data_frame_psm_at_t, "seconds", sec,
-        JSON_TOK_NUMBER
-    )
-};
-
-// JSON description for lte_data_frame_psm_t structures.
-static const struct json_obj_descr _lte_data_frame_psm_descr [] = {
-    JSON_OBJ_DESCR_PRIM_NAMED(
-        lte_data_frame_psm_t, "valid", valid,
-        JSON_TOK_TRUE
-    ),
-    JSON_OBJ_DESCR_OBJECT_NAMED(
-        lte_data_frame_psm_t, "tau", tau,
-        _lte_data_frame_psm_tau_descr
-    ),
-    JSON_OBJ_DESCR_OBJECT_NAMED(
-        lte_data_frame_psm_t, "at", at,
-        _lte_data_frame_psm_at_descr
-    )
-};
-
-// JSON description for lte_data_frame_edrx_edrx_t structures.
-static const struct json_obj_descr _lte_data_frame_edrx_edrx_descr [] = {
-    JSON_OBJ_DESCR_PRIM_NAMED(
-        lte_data_frame_edrx_edrx_t, "hours", hour,
-        JSON_TOK_NUMBER
-    ),
-    JSON_OBJ_DESCR_PRIM_NAMED(
-        lte_data_frame_edrx_edrx_t, "minutes", min,
-        JSON_TOK_NUMBER
-    ),
-    JSON_OBJ_DESCR_PRIM_NAMED(
-        lte_data_frame_edrx_edrx_t, "seconds", sec,
-        JSON_TOK_NUMBER
-    ),
-    JSON_OBJ_DESCR_PRIM_NAMED(
-        lte_data_frame_edrx_edrx_t, "milliseconds", msec,
-        JSON_TOK_NUMBER
-    )
-};
-
-// JSON description for lte_data_frame_edrx_ptw_t structures.
-static const struct json_obj_descr _lte_data_frame_edrx_ptw_descr [] = {
-    JSON_OBJ_DESCR_PRIM_NAMED(
-        lte_data_frame_edrx_ptw_t, "seconds", sec,
-        JSON_TOK_NUMBER
-    ),
-    JSON_OBJ_DESCR_PRIM_NAMED(
-        lte_data_frame_edrx_ptw_t, "milliseconds", msec,
-        JSON_TOK_NUMBER
-    )
-};
-
-// JSON description for lte_data_frame_edrx_t structures.
-static const struct json_obj_descr _lte_data_frame_edrx_descr [] = {
-    JSON_OBJ_DESCR_PRIM_NAMED(
-        lte_data_frame_edrx_t, "valid", valid,
-        JSON_TOK_TRUE
-    ),
-    JSON_OBJ_DESCR_PRIM_NAMED(
-        lte_data_frame_edrx_t, "mode", mode,
-        JSON_TOK_STRING
-    ),
-    JSON_OBJ_DESCR_OBJECT_NAMED(
-        lte_data_frame_edrx_t, "edrx", edrx,
-        _lte_data_frame_edrx_edrx_descr
-    ),
-    JSON_OBJ_DESCR_OBJECT_NAMED(
-        lte_data_frame_edrx_t, "ptw", ptw,
-        _lte_data_frame_edrx_ptw_descr
-    )
-};
-
-// JSON description for lte_data_frame_t structures.
-static const struct json_obj_descr _lte_data_frame_descr [] = {
-    JSON_OBJ_DESCR_OBJECT_NAMED(
-        lte_data_frame_t, "mode", mode,
-        _lte_data_frame_mode_descr
-    ),
-    JSON_OBJ_DESCR_OBJECT_NAMED(
-        lte_data_frame_t, "cell", cell,
-        _lte_data_frame_cell_descr
-    ),
-    JSON_OBJ_DESCR_OBJECT_NAMED(
-        lte_data_frame_t, "psm", psm,
-        _lte_data_frame_psm_descr
-    ),
-    JSON_OBJ_DESCR_OBJECT_NAMED(
-        lte_data_frame_t, "edrx", edrx,
-        _lte_data_frame_edrx_descr
-    )
-};
-
-// JSON description for gnss_data_frame_loc_lat_t structures.
-static const struct json_obj_descr _gnss_data_frame_loc_lat_descr [] = {
-    JSON_OBJ_DESCR_PRIM_NAMED(
-        gnss_data_frame_loc_lat_t, "direction", dir,
-        JSON_TOK_STRING
-    ),
-    JSON_OBJ_DESCR_PRIM_NAMED(
-        gnss_data_frame_loc_lat_t, "degrees", deg,
-        JSON_TOK_NUMBER
-    ),
-    JSON_OBJ_DESCR_PRIM_NAMED(
-        gnss_data_frame_loc_lat_t, "minutes", min,
-        JSON_TOK_NUMBER
-    ),
-    JSON_OBJ_DESCR_PRIM_NAMED(
-        gnss_data_frame_loc_lat_t, "seconds", sec,
-        JSON_TOK_NUMBER
-    ),
-    JSON_OBJ_DESCR_PRIM_NAMED(
-        gnss_data_frame_loc_lat_t, "milliseconds", msec,
-        JSON_TOK_NUMBER
-    )
-};
-
-// JSON description for gnss_data_frame_loc_lon_t structures.
-static const struct json_obj_descr _gnss_data_frame_loc_lon_descr [] = {
-    JSON_OBJ_DESCR_PRIM_NAMED(
-        gnss_data_frame_loc_lon_t, "direction", dir,
-        JSON_TOK_STRING
-    ),
-    JSON_OBJ_DESCR_PRIM_NAMED(
-        gnss_data_frame_loc_lon_t, "degrees", deg,
-        JSON_TOK_NUMBER
-    ),
-    JSON_OBJ_DESCR_PRIM_NAMED(
-        gnss_data_frame_loc_lon_t, "minutes", min,
-        JSON_TOK_NUMBER
-    ),
-    JSON_OBJ_DESCR_PRIM_NAMED(
-        gnss_data_frame_loc_lon_t, "seconds", sec,
-        JSON_TOK_NUMBER
-    ),
-    JSON_OBJ_DESCR_PRIM_NAMED(
-        gnss_data_frame_loc_lon_t, "milliseconds", msec,
-        JSON_TOK_NUMBER
-    )
-};
-
-// JSON description for gnss_data_frame_loc_t structures.
-static const struct json_obj_descr _gnss_data_frame_loc_descr [] = {
-    JSON_OBJ_DESCR_PRIM_NAMED(
-        gnss_data_frame_loc_t, "valid", valid,
-        JSON_TOK_TRUE
-    ),
-    JSON_OBJ_DESCR_OBJECT_NAMED(
-        gnss_data_frame_loc_t, "latitude", lat,
-        _gnss_data_frame_loc_lat_descr
-    ),
-    JSON_OBJ_DESCR_OBJECT_NAMED(
-        gnss_data_frame_loc_t, "longitude", lon,
-        _gnss_data_frame_loc_lon_descr
-    )
-};
-
-// JSON description for gnss_data_frame_date_t structures.
-static const struct json_obj_descr _gnss_data_frame_date_descr [] = {
-    JSON_OBJ_DESCR_PRIM_NAMED(
-        gnss_data_frame_date_t, "valid", valid,
-        JSON_TOK_TRUE
-    ),
-    JSON_OBJ_DESCR_PRIM_NAMED(
-        gnss_data_frame_date_t, "year", year,
-        JSON_TOK_NUMBER
-    ),
-    JSON_OBJ_DESCR_PRIM_NAMED(
-        gnss_data_frame_date_t, "month", mon,
-        JSON_TOK_NUMBER
-    ),
-    JSON_OBJ_DESCR_PRIM_NAMED(
-        gnss_data_frame_date_t, "day", day,
-        JSON_TOK_NUMBER
-    )
-};
-
-// JSON description for gnss_data_frame_time_t structures.
-static const struct json_obj_descr _gnss_data_frame_time_descr [] = {
-    JSON_OBJ_DESCR_PRIM_NAMED(
-        gnss_data_frame_time_t, "valid", valid,
-        JSON_TOK_TRUE
-    ),
-    JSON_OBJ_DESCR_PRIM_NAMED(
-        gnss_data_frame_time_t, "hour", hour,
-        JSON_TOK_NUMBER
-    ),
-    JSON_OBJ_DESCR_PRIM_NAMED(
-        gnss_data_frame_time_t, "minute", min,
-        JSON_TOK_NUMBER
-    ),
-    JSON_OBJ_DESCR_PRIM_NAMED(
-        gnss_data_frame_time_t, "second", sec,
-        JSON_TOK_NUMBER
-    ),
-    JSON_OBJ_DESCR_PRIM_NAMED(
-        gnss_data_frame_time_t, "millisecond", msec,
-        JSON_TOK_NUMBER
-    )
-};
-
-// JSON description for gnss_data_frame_t structures.
-static const struct json_obj_descr _gnss_data_frame_descr [] = {
-    JSON_OBJ_DESCR_OBJECT_NAMED(
-        gnss_data_frame_t, "location", loc,
-        _gnss_data_frame_loc_descr
-    ),
-    JSON_OBJ_DESCR_OBJECT_NAMED(
-        gnss_data_frame_t, "date", date,
-        _gnss_data_frame_date_descr
-    ),
-    JSON_OBJ_DESCR_OBJECT_NAMED(
-        gnss_data_frame_t, "time", time,
-        _gnss_data_frame_time_descr
-    )
-};
+// Output buffer of the JSON encoder, filled without a terminating null byte.
+typedef struct {
+    char * buf;     // Output buffer.
+    size_t len;     // Length of output buffer.
+    size_t used;    // Number of bytes written.
+} _data_json_out_t;
+
+#if defined(CONFIG_DATA_JSON_LIBRARY)
+/*
+ * JSON descriptions are generated from the schema, and walked by the JSON
+ * library at runtime.
+ */
+
+static int _data_json_append (const char * bytes, size_t len, void * data) {
+    _data_json_out_t * out = data;  // Output buffer.
+
+    // Append bytes to output buffer, failing if they do not fit.
+    if (len > out->len - out->used) {
+        return -ENOMEM;
+    }
+    memcpy(&out->buf[out->used], bytes, len);
+    out->used += len;
+    return 0;
+}
+
+// JSON description of a structure, named after the structure type.
+#define _DATA_JSON_DESCR_DEFINE(type, schema)                                  \
+    static const struct json_obj_descr _##type##_descr [] = {                 \
+        schema(_DATA_JSON_DESCR, type)                                         \
+    };
+
+// JSON description of a structure member of each kind.
+#define _DATA_JSON_DESCR(P, KIND, ...) _DATA_JSON_DESCR_##KIND(P, __VA_ARGS__)
+#define _DATA_JSON_DESCR_BOOL(P, member, name)                                 \
+    JSON_OBJ_DESCR_PRIM_NAMED(P##_t, name, member, JSON_TOK_TRUE),
+#define _DATA_JSON_DESCR_INT(P, member, name, min, max)                        \
+    JSON_OBJ_DESCR_PRIM_NAMED(P##_t, name, member, JSON_TOK_NUMBER),
+#define _DATA_JSON_DESCR_STR(P, member, name, max)                             \
+    JSON_OBJ_DESCR_PRIM_NAMED(P##_t, name, member, JSON_TOK_STRING),
+#define _DATA_JSON_DESCR_OBJ(P, member, name, sub)                             \
+    JSON_OBJ_DESCR_OBJECT_NAMED(P##_t, name, member, _##sub##_descr),
+#define _DATA_JSON_DESCR_ARRAY(P, member, name, sub, max, count)               \
+    JSON_OBJ_DESCR_OBJ_ARRAY_NAMED(                                            \
+        P##_t, name, member, max, count,                                       \
+        _##sub##_descr, ARRAY_SIZE(_##sub##_descr)                             \
+    ),
+
+DATA_SCHEMA_ALL(_DATA_JSON_DESCR_DEFINE)
+
+// Replacement of missing strings with empty ones in a structure, named after
+// the structure type, as the JSON library cannot encode missing strings.
+#define _DATA_JSON_FILL_DEFINE(type, schema)                                   \
+    static void _data_json_fill_##type (type##_t * value) {                    \
+        schema(_DATA_JSON_FILL, value)                                         \
+    }
+
+// Replacement of missing strings in a structure member of each kind.
+#define _DATA_JSON_FILL(P, KIND, member, name, ...)                            \
+    _DATA_JSON_FILL_##KIND(P, member, __VA_ARGS__)
+#define _DATA_JSON_FILL_BOOL(P, member, ...)
+#define _DATA_JSON_FILL_INT(P, member, ...)
+#define _DATA_JSON_FILL_STR(P, member, max)                                    \
+    if ((P)->member == NULL) {                                                 \
+        (P)->member = "";                                                      \
+    }
+#define _DATA_JSON_FILL_OBJ(P, member, sub)                                    \
+    _data_json_fill_##sub(&(P)->member);
+#define _DATA_JSON_FILL_ARRAY(P, member, sub, max, count)                      \
+    for (size_t i = 0; i < MIN((P)->count, max); i++) {                        \
+        _data_json_fill_##sub(&(P)->member[i]);                                \
+    }
+
+DATA_SCHEMA_ALL(_DATA_JSON_FILL_DEFINE)
+
+static int _data_json_encode (
+    const struct json_obj_descr * descr, size_t descr_len, const void * value,
+    _data_json_out_t * out
+) {
+    ssize_t need;   // Encoded length.
+
+    // Determine encoded length, and fail before writing anything if it does
+    // not fit in output buffer.
+
+    need = json_calc_encoded_len(descr, descr_len, value);
+    if (need < 0) {
+        return need;
+    }
+
+    if (need > out->len - out->used) {
+        LOG_ERR(
+            "Encoded data frame needs %zd bytes, buffer holds %zu bytes",
+            need, out->len - out->used
+        );
+        return -ENOMEM;
+    }
+
+    return json_obj_encode(descr, descr_len, value, _data_json_append, out);
+}
+
+// Encode structure of given type with JSON library. Missing strings are
+// encoded as empty, like the generated encoders do, on a copy of the structure.
+#define _DATA_JSON_ENCODE(type, value, out)                                    \
+    ({                                                                         \
+        type##_t _copy = *(value);                                             \
+        _data_json_fill_##type(&_copy);                                        \
+        _data_json_encode(                                                     \
+            _##type##_descr, ARRAY_SIZE(_##type##_descr), &_copy, out          \
+        );                                                                     \
+    })
+
+#else
+/*
+ * JSON encoders are generated from the schema as straight-line code, with one
+ * function per structure. Each member is written with its key and a leading
+ * comma, and the comma of the first member is replaced with the opening brace
+ * once the structure is complete. Strings are escaped in the same way as by
+ * the JSON library, so that the output is identical.
+ */
+
+static bool _data_json_put (
+    _data_json_out_t * out, const char * bytes, size_t len
+) {
+    // Append bytes to output buffer, failing if they do not fit.
+    if (len > out->len - out->used) {
+        return false;
+    }
+    memcpy(&out->buf[out->used], bytes, len);
+    out->used += len;
+    return true;
+}
+
+static bool _data_json_bool (_data_json_out_t * out, bool value) {
+    // Append boolean value.
+    return value ? _data_json_put(out, "true", 4)
+        : _data_json_put(out, "false", 5);
+}
+
+static bool _data_json_int (_data_json_out_t * out, int value) {
+    char digits[11];    // Decimal representation, filled from the end.
+    size_t n = 0;       // Number of characters in representation.
+    unsigned int mag;   // Magnitude of value.
+
+    // Append integer value in decimal representation.
+
+    mag = value < 0 ? 0U - (unsigned int)value : (unsigned int)value;
+
+    do {
+        digits[sizeof(digits) - ++n] = '0' + mag % 10;
+        mag /= 10;
+    } while (mag > 0);
+
+    if (value < 0) {
+        digits[sizeof(digits) - ++n] = '-';
+    }
+
+    return _data_json_put(out, &digits[sizeof(digits) - n], n);
+}
+
+static char _data_json_escape (char c) {
+    // Obtain escape character for characters that must be escaped, or zero.
+    switch (c) {
+        case '"':
+            return '"';
+        case '\\':
+            return '\\';
+        case '\b':
+            return 'b';
+        case '\f':
+            return 'f';
+        case '\n':
+            return 'n';
+        case '\r':
+            return 'r';
+        case '\t':
+            return 't';
+        default:
+            return 0;
+    }
+}
+
+static bool _data_json_str (_data_json_out_t * out, const char * value) {
+    const char * run;           // Start of characters not yet written.
+    char esc[2] = {'\\', 0};    // Escape sequence.
+
+    // Append quoted string value, escaping characters where needed, and
+    // treating missing strings as empty.
+
+    if (value == NULL) {
+        value = "";
+    }
+
+    if (!_data_json_put(out, "\"", 1)) {
+        return false;
+    }
+
+    for (run = value; *value != '\0'; value++) {
+        esc[1] = _data_json_escape(*value);
+        if (esc[1] == 0) {
+            continue;
+        }
+        if (
+            !_data_json_put(out, run, value - run)
+            || !_data_json_put(out, esc, sizeof(esc))
+        ) {
+            return false;
+        }
+        run = value + 1;
+    }
+
+    return _data_json_put(out, run, value - run)
+        && _data_json_put(out, "\"", 1);
+}
+
+// JSON encoder of a structure, named after the structure type.
+#define _DATA_JSON_DEFINE(type, schema)                                        \
+    static bool _data_json_##type (                                            \
+        _data_json_out_t * out, const type##_t * value                         \
+    ) {                                                                        \
+        size_t start = out->used;                                              \
+        if (!(true schema(_DATA_JSON_MEMBER, value))) {                        \
+            return false;                                                      \
+        }                                                                      \
+        out->buf[start] = '{';                                                 \
+        return _data_json_put(out, "}", 1);                                    \
+    }
+
+// JSON encoding of a structure member, with its key.
+#define _DATA_JSON_MEMBER(P, KIND, member, name, ...)                          \
+    && _data_json_put(out, ",\"" name "\":", sizeof(",\"" name "\":") - 1)     \
+    && _DATA_JSON_VALUE_##KIND(P, member, __VA_ARGS__)
+
+// JSON encoding of a structure member of each kind.
+#define _DATA_JSON_VALUE_BOOL(P, member, ...)                                  \
+    _data_json_bool(out, (P)->member)
+#define _DATA_JSON_VALUE_INT(P, member, ...)                                   \
+    _data_json_int(out, (P)->member)
+#define _DATA_JSON_VALUE_STR(P, member, ...)                                   \
+    _data_json_str(out, (P)->member)
+#define _DATA_JSON_VALUE_OBJ(P, member, sub)                                   \
+    _data_json_##sub(out, &(P)->member)
+#define _DATA_JSON_VALUE_ARRAY(P, member, sub, max, count)                     \
+    ({                                                                         \
+        bool ok = _data_json_put(out, "[", 1);                                 \
+        for (size_t i = 0; ok && i < MIN((P)->count, max); i++) {              \
+            ok = (i == 0 || _data_json_put(out, ",", 1))                       \
+                && _data_json_##sub(out, &(P)->member[i]);                     \
+        }                                                                      \
+        ok && _data_json_put(out, "]", 1);                                     \
+    })
+
+DATA_SCHEMA_ALL(_DATA_JSON_DEFINE)
+
+// Encode structure of given type with generated encoder.
+#define _DATA_JSON_ENCODE(type, value, out)                                    \
+    (_data_json_##type(out, value) ? 0 : -ENOMEM)
+
+#endif
+
+/*
+ * Bound checks are generated from the schema, with one function per structure.
+ * They verify that every integer member lies within its declared range, and
+ * that every string member is no longer than its declared maximum, as the
+ * worst-case encoded sizes in data.h only hold for such data frames.
+ */
+
+static bool _data_check_fail (const char * name) {
+    // Report member exceeding its declared bounds.
+    LOG_WRN("Member %s exceeds its declared bounds", name);
+    return false;
+}
+
+// Bound check of a structure, named after the structure type.
+#define _DATA_CHECK_DEFINE(type, schema)                                       \
+    static bool _data_check_##type (const type##_t * value) {                  \
+        return true schema(_DATA_CHECK_MEMBER, value);                         \
+    }
+
+// Bound check of a structure member.
+#define _DATA_CHECK_MEMBER(P, KIND, member, name, ...)                         \
+    && _DATA_CHECK_##KIND(P, member, name, __VA_ARGS__)
+
+// Bound check of a structure member of each kind.
+#define _DATA_CHECK_BOOL(P, member, name, ...)                                 \
+    true
+#define _DATA_CHECK_INT(P, member, name, min, max)                             \
+    (((P)->member >= (min) && (P)->member <= (max))                            \
+        || _data_check_fail(name))
+#define _DATA_CHECK_STR(P, member, name, max)                                  \
+    ((P)->member == NULL || strlen((P)->member) <= (max)                       \
+        || _data_check_fail(name))
+#define _DATA_CHECK_OBJ(P, member, name, sub)                                  \
+    _data_check_##sub(&(P)->member)
+#define _DATA_CHECK_ARRAY(P, member, name, sub, max, count)                    \
+    ({                                                                         \
+        bool ok = (P)->count <= (max) || _data_check_fail(name);               \
+        for (size_t i = 0; ok && i < MIN((P)->count, max); i++) {              \
+            ok = _data_check_##sub(&(P)->member[i]);                           \
+        }                                                                      \
+        ok;                                                                    \
+    })
+
+DATA_SCHEMA_ALL(_DATA_CHECK_DEFINE)
+
+#if defined(CONFIG_DATA_FORMAT_CBOR)
+/*
+ * CBOR encoders are generated from the schema in the same way as the JSON
+ * encoders, but use integer keys in place of key names. Within each map, the
+ * keys number the members in the order in which they are listed in the
+ * schema, starting from 0.
+ */
+
+static bool _data_cbor_str (zcbor_state_t * state, const char * value) {
+    // Encode string value, treating missing strings as empty.
+    if (value == NULL) {
+        value = "";
+    }
+    return zcbor_tstr_encode_ptr(state, value, strlen(value));
+}
+
+// CBOR encoder of a structure, named after the structure type.
+#define _DATA_CBOR_DEFINE(type, schema)                                        \
+    static bool _data_cbor_##type (                                            \
+        zcbor_state_t * state, const type##_t * value                          \
+    ) {                                                                        \
+        uint32_t key = 0;                                                      \
+        return zcbor_map_start_encode(state, DATA_COUNT(schema))               \
+            schema(_DATA_CBOR_MEMBER, value)                                   \
+            && zcbor_map_end_encode(state, DATA_COUNT(schema));                \
+    }
+
+// CBOR encoding of a structure member, with its key.
+#define _DATA_CBOR_MEMBER(P, KIND, member, name, ...)                          \
+    && zcbor_uint32_put(state, key++)                                          \
+    && _DATA_CBOR_VALUE_##KIND(P, member, __VA_ARGS__)
+
+// CBOR encoding of a structure member of each kind.
+#define _DATA_CBOR_VALUE_BOOL(P, member, ...)                                  \
+    zcbor_bool_put(state, (P)->member)
+#define _DATA_CBOR_VALUE_INT(P, member, ...)                                   \
+    zcbor_int32_put(state, (P)->member)
+#define _DATA_CBOR_VALUE_STR(P, member, ...)                                   \
+    _data_cbor_str(state, (P)->member)
+#define _DATA_CBOR_VALUE_OBJ(P, member, sub)                                   \
+    _data_cbor_##sub(state, &(P)->member)
+#define _DATA_CBOR_VALUE_ARRAY(P, member, sub, max, count)                     \
+    ({                                                                         \
+        bool ok = zcbor_list_start_encode(state, max);                         \
+        for (size_t i = 0; ok && i < MIN((P)->count, max); i++) {              \
+            ok = _data_cbor_##sub(state, &(P)->member[i]);                     \
+        }                                                                      \
+        ok && zcbor_list_end_encode(state, max);                               \
+    })
+
+DATA_SCHEMA_ALL(_DATA_CBOR_DEFINE)
+
+#endif
+
+#if defined(CONFIG_DATA_FORMAT_CBOR)
+/*
+ * Delta encoding works on encoded CBOR data frames, so that it applies to
+ * frames of every type. A delta is a map holding only those members of a frame
+ * that differ from the previous frame. Members that are maps in both frames are
+ * replaced by the delta of the two maps, and members that are integers in both
+ * frames by their difference. All other differing members are given in full.
+ */
+
+// CBOR major types, and additional information values, used in delta encoding.
+#define _DATA_CBOR_MAJOR_UINT   0
+#define _DATA_CBOR_MAJOR_NINT   1
+#define _DATA_CBOR_MAJOR_BSTR   2
+#define _DATA_CBOR_MAJOR_TSTR   3
+#define _DATA_CBOR_MAJOR_ARRAY  4
+#define _DATA_CBOR_MAJOR_MAP    5
+#define _DATA_CBOR_MAJOR_TAG    6
+#define _DATA_CBOR_INFO_INDEF   31
+#define _DATA_CBOR_MAP_INDEF    0xbf
+#define _DATA_CBOR_BREAK        0xff
+
+// Maximum nesting depth of CBOR items walked in delta encoding.
+#define _DATA_CBOR_DEPTH_MAX    8
+
+// Encoded CBOR item.
+typedef struct {
+    const uint8_t * start;  // Start of item.
+    const uint8_t * end;    // End of item.
+    const uint8_t * body;   // Start of item contents, following its head.
+    int major;              // Major type.
+    uint64_t arg;           // Argument of head.
+    bool indef;             // Indefinite length.
+} _data_cbor_item_t;
+
+// Output of the delta encoder, passed to an output function.
+typedef struct {
+    data_write_t write;     // Output function, or NULL to measure only.
+    void * ctx;             // Context of output function.
+    size_t used;            // Number of bytes output.
+    bool failed;            // Output function failed.
+} _data_cbor_out_t;
+
+static bool _data_cbor_item (
+    _data_cbor_item_t * item, const uint8_t * buf, const uint8_t * end,
+    int depth
+) {
+    const uint8_t * pos;    // Position within item.
+    size_t size;            // Size of argument.
+    uint64_t count;         // Number of nested items.
+    _data_cbor_item_t sub;  // Nested item.
+
+    /*
+     * Parse head of item at given position, and locate end of item by walking
+     * its contents. If the item is malformed or nested too deeply, fail.
+     */
+
+    if (
+        buf >= end || *buf == _DATA_CBOR_BREAK
+        || depth > _DATA_CBOR_DEPTH_MAX
+    ) {
+        return false;
+    }
+
+    // Parse head.
+
+    item->start = buf;
+    item->major = *buf >> 5;
+    item->arg = *buf & 0x1f;
+    item->indef = false;
+    pos = buf + 1;
+
+    if (item->arg == _DATA_CBOR_INFO_INDEF) {
+        item->indef = true;
+        item->arg = 0;
+    } else if (item->arg >= 24) {
+        if (item->arg > 27) {
+            return false;
+        }
+        size = 1 << (item->arg - 24);
+        if ((size_t)(end - pos) < size) {
+            return false;
+        }
+        item->arg = 0;
+        while (size-- > 0) {
+            item->arg = item->arg << 8 | *pos++;
+        }
+    }
+
+    item->body = pos;
+
+    // Walk contents.
+
+    switch (item->major) {
+        case _DATA_CBOR_MAJOR_BSTR:
+        case _DATA_CBOR_MAJOR_TSTR:
+            if (item->indef || (uint64_t)(end - pos) < item->arg) {
+                return false;
+            }
+            pos += item->arg;
+            break;
+        case _DATA_CBOR_MAJOR_ARRAY:
+        case _DATA_CBOR_MAJOR_MAP:
+            count = item->major == _DATA_CBOR_MAJOR_MAP
+                ? 2 * item->arg : item->arg;
+            while (item->indef ? pos < end && *pos != _DATA_CBOR_BREAK
+                    : count-- > 0) {
+                if (!_data_cbor_item(&sub, pos, end, depth + 1)) {
+                    return false;
+                }
+                pos = sub.end;
+            }
+            if (item->indef) {
+                if (pos >= end) {
+                    return false;
+                }
+                pos++;
+            }
+            break;
+        case _DATA_CBOR_MAJOR_TAG:
+            if (item->indef || !_data_cbor_item(&sub, pos, end, depth + 1)) {
+                return false;
+            }
+            pos = sub.end;
+            break;
+        default:
+            if (item->indef) {
+                return false;
+            }
+            break;
+    }
+
+    item->end = pos;
+
+    return true;
+}
+
+static bool _data_cbor_is_int (const _data_cbor_item_t * item) {
+    // Check whether item is an integer.
+    return item->major == _DATA_CBOR_MAJOR_UINT
+        || item->major == _DATA_CBOR_MAJOR_NINT;
+}
+
+static bool _data_cbor_equal (
+    const _data_cbor_item_t * a, const _data_cbor_item_t * b
+) {
+    // Compare encoded items byte by byte.
+    return a->end - a->start == b->end - b->start
+        && memcmp(a->start, b->start, a->end - a->start) == 0;
+}
+
+static bool _data_cbor_lookup (
+    const _data_cbor_item_t * map, const _data_cbor_item_t * key,
+    _data_cbor_item_t * value
+) {
+    const uint8_t * pos = map->body;    // Position within map.
+    _data_cbor_item_t entry;            // Key of current entry.
+
+    // Find value of given key in map. The map has been walked already, so its
+    // entries need not be checked for errors again.
+    while (pos < map->end && *pos != _DATA_CBOR_BREAK) {
+        _data_cbor_item(&entry, pos, map->end, 0);
+        _data_cbor_item(value, entry.end, map->end, 0);
+        if (_data_cbor_equal(&entry, key)) {
+            return true;
+        }
+        pos = value->end;
+    }
+    return false;
+}
+
+static void _data_cbor_put (
+    _data_cbor_out_t * out, const void * data, size_t len
+) {
+    // Pass data to output function, unless only measuring.
+    if (
+        out->write != NULL && !out->failed
+        && out->write(out->ctx, data, len) < 0
+    ) {
+        out->failed = true;
+    }
+    out->used += len;
+}
+
+static void _data_cbor_put_int (_data_cbor_out_t * out, int64_t value) {
+    uint8_t head[9];    // Encoded head.
+    uint64_t arg;       // Argument of head.
+    size_t size;        // Size of argument.
+
+    // Encode integer with shortest possible head.
+
+    arg = value < 0 ? (uint64_t)(-1 - value) : (uint64_t)value;
+    head[0] = (value < 0 ? _DATA_CBOR_MAJOR_NINT : _DATA_CBOR_MAJOR_UINT) << 5;
+
+    if (arg < 24) {
+        head[0] |= arg;
+        size = 0;
+    } else {
+        size = arg <= 0xff ? 1 : arg <= 0xffff ? 2 : arg <= 0xffffffff ? 4 : 8;
+        head[0] |= 24 + (size == 1 ? 0 : size == 2 ? 1 : size == 4 ? 2 : 3);
+        for (size_t i = 0; i < size; i++) {
+            head[size - i] = arg >> (8 * i);
+        }
+    }
+
+    _data_cbor_put(out, head, 1 + size);
+}
+
+static int64_t _data_cbor_int (const _data_cbor_item_t * item) {
+    // Decode integer value.
+    return item->major == _DATA_CBOR_MAJOR_NINT
+        ? -1 - (int64_t)item->arg : (int64_t)item->arg;
+}
+
+static size_t _data_cbor_delta_map (
+    _data_cbor_out_t * out, const _data_cbor_item_t * prev,
+    const _data_cbor_item_t * cur
+) {
+    static const uint8_t start = _DATA_CBOR_MAP_INDEF;  // Start of map.
+    static const uint8_t brk = _DATA_CBOR_BREAK;        // End of map.
+    const uint8_t * pos = cur->body;                    // Position in map.
+    size_t count = 0;                                   // Members output.
+    _data_cbor_item_t key;                              // Current key.
+    _data_cbor_item_t value;                            // Current value.
+    _data_cbor_item_t old;                              // Previous value.
+    _data_cbor_out_t measure;                           // Measured output.
+
+    /*
+     * Output delta of two maps as an indefinite-length map, holding every
+     * member of the current map that differs from the previous map. Both maps
+     * have been walked already, so their members need not be checked for
+     * errors again. Return the number of members output.
+     */
+
+    _data_cbor_put(out, &start, 1);
+
+    while (pos < cur->end && *pos != _DATA_CBOR_BREAK) {
+        _data_cbor_item(&key, pos, cur->end, 0);
+        _data_cbor_item(&value, key.end, cur->end, 0);
+        pos = value.end;
+
+        if (!_data_cbor_lookup(prev, &key, &old)) {
+            // Member is new, so give it in full.
+            _data_cbor_put(out, key.start, key.end - key.start);
+            _data_cbor_put(out, value.start, value.end - value.start);
+        } else if (_data_cbor_equal(&old, &value)) {
+            // Member is unchanged, so leave it out.
+            continue;
+        } else if (
+            old.major == _DATA_CBOR_MAJOR_MAP
+            && value.major == _DATA_CBOR_MAJOR_MAP
+        ) {
+            // Member is a changed map, so give its delta, if not empty.
+            measure = (_data_cbor_out_t){NULL, NULL, 0, false};
+            if (_data_cbor_delta_map(&measure, &old, &value) == 0) {
+                continue;
+            }
+            _data_cbor_put(out, key.start, key.end - key.start);
+            _data_cbor_delta_map(out, &old, &value);
+        } else if (_data_cbor_is_int(&old) && _data_cbor_is_int(&value)) {
+            // Member is a changed integer, so give its difference.
+            _data_cbor_put(out, key.start, key.end - key.start);
+            _data_cbor_put_int(
+                out, _data_cbor_int(&value) - _data_cbor_int(&old)
+            );
+        } else {
+            // Member is otherwise changed, so give it in full.
+            _data_cbor_put(out, key.start, key.end - key.start);
+            _data_cbor_put(out, value.start, value.end - value.start);
+        }
+
+        count++;
+    }
+
+    _data_cbor_put(out, &brk, 1);
+
+    return count;
+}
+
+#endif
 
 int data_dummy_data_frame_to_json (
     dummy_data_frame_t * data_frame, char * json, size_t len
 ) {
-    int status; // Return status for API calls.
-
-    // Initialize output buffer with zeros.
-    memset(json, 0, len);
+    int status;                             // Return status for API calls.
+    _data_json_out_t out = {json, len, 0};  // Output buffer.
 
     /*
      * Encode data frame in JSON format and store it in output buffer. If an
@@ -323,10 +674,7 @@ int data_dummy_data_frame_to_json (
 
     // Encode data frame into buffer.
 
-    status = json_obj_encode_buf(
-        _dummy_data_frame_descr, ARRAY_SIZE(_dummy_data_frame_descr),
-        data_frame, json, len
-    );
+    status = _DATA_JSON_ENCODE(dummy_data_frame, data_frame, &out);
 
     if (status < 0) {
         // On error, exit with failure.
@@ -337,16 +685,14 @@ int data_dummy_data_frame_to_json (
         return -1;
     }
 
-    return 0;
+    return out.used;
 }
 
 int data_lte_data_frame_to_json (
     lte_data_frame_t * data_frame, char * json, size_t len
 ) {
-    int status; // Return status for API calls.
-
-    // Initialize output buffer with zeros.
-    memset(json, 0, len);
+    int status;                             // Return status for API calls.
+    _data_json_out_t out = {json, len, 0};  // Output buffer.
 
     /*
      * Encode data frame in JSON format and store it in output buffer. If an
@@ -357,10 +703,7 @@ int data_lte_data_frame_to_json (
 
     // Encode data frame into buffer.
 
-    status = json_obj_encode_buf(
-        _lte_data_frame_descr, ARRAY_SIZE(_lte_data_frame_descr),
-        data_frame, json, len
-    );
+    status = _DATA_JSON_ENCODE(lte_data_frame, data_frame, &out);
 
     if (status < 0) {
         // On error, exit with failure.
@@ -371,16 +714,14 @@ int data_lte_data_frame_to_json (
         return -1;
     }
 
-    return 0;
+    return out.used;
 }
 
 int data_gnss_data_frame_to_json (
     gnss_data_frame_t * data_frame, char * json, size_t len
 ) {
-    int status; // Return status for API calls.
-
-    // Initialize output buffer with zeros.
-    memset(json, 0, len);
+    int status;                             // Return status for API calls.
+    _data_json_out_t out = {json, len, 0};  // Output buffer.
 
     /*
      * Encode data frame in JSON format and store it in output buffer. If an
@@ -391,10 +732,7 @@ int data_gnss_data_frame_to_json (
 
     // Encode data frame into buffer.
 
-    status = json_obj_encode_buf(
-        _gnss_data_frame_descr, ARRAY_SIZE(_gnss_data_frame_descr),
-        data_frame, json, len
-    );
+    status = _DATA_JSON_ENCODE(gnss_data_frame, data_frame, &out);
 
     if (status < 0) {
         // On error, exit with failure.
@@ -405,5 +743,266 @@ int data_gnss_data_frame_to_json (
         return -1;
     }
 
-    return 0;
+    return out.used;
+}
+
+int data_perf_data_frame_to_json (
+    perf_data_frame_t * data_frame, char * json, size_t len
+) {
+    int status;                             // Return status for API calls.
+    _data_json_out_t out = {json, len, 0};  // Output buffer.
+
+    /*
+     * Encode data frame in JSON format and store it in output buffer. If an
+     * error occurs in this process, exit with failure.
+     */
+
+    LOG_INF("Encoding performance data frame into JSON format");
+
+    // Encode data frame into buffer.
+
+    status = _DATA_JSON_ENCODE(perf_data_frame, data_frame, &out);
+
+    if (status < 0) {
+        // On error, exit with failure.
+        LOG_ERR(
+            "Failed to encode performance data frame into JSON format (%s)",
+            strerror(-status)
+        );
+        return -1;
+    }
+
+    return out.used;
+}
+
+int data_dummy_data_frame_to_cbor (
+    dummy_data_frame_t * data_frame, uint8_t * cbor, size_t len
+) {
+#if defined(CONFIG_DATA_FORMAT_CBOR)
+    // CBOR encoder state.
+    ZCBOR_STATE_E(state, 0, cbor, len, 1);
+
+    /*
+     * Encode data frame in CBOR format and store it in output buffer. If an
+     * error occurs in this process, exit with failure.
+     */
+
+    LOG_INF("Encoding dummy data frame into CBOR format");
+
+    if (!_data_cbor_dummy_data_frame(state, data_frame)) {
+        // On error, exit with failure.
+        LOG_ERR(
+            "Failed to encode dummy data frame into CBOR format (Error %d)",
+            zcbor_peek_error(state)
+        );
+        return -1;
+    }
+
+    return state->payload - cbor;
+#else
+    // CBOR support not built.
+    return -1;
+#endif
+}
+
+int data_lte_data_frame_to_cbor (
+    lte_data_frame_t * data_frame, uint8_t * cbor, size_t len
+) {
+#if defined(CONFIG_DATA_FORMAT_CBOR)
+    // CBOR encoder state.
+    ZCBOR_STATE_E(state, 0, cbor, len, 1);
+
+    /*
+     * Encode data frame in CBOR format and store it in output buffer. If an
+     * error occurs in this process, exit with failure.
+     */
+
+    LOG_INF("Encoding LTE data frame into CBOR format");
+
+    if (!_data_cbor_lte_data_frame(state, data_frame)) {
+        // On error, exit with failure.
+        LOG_ERR(
+            "Failed to encode LTE data frame into CBOR format (Error %d)",
+            zcbor_peek_error(state)
+        );
+        return -1;
+    }
+
+    return state->payload - cbor;
+#else
+    // CBOR support not built.
+    return -1;
+#endif
+}
+
+int data_gnss_data_frame_to_cbor (
+    gnss_data_frame_t * data_frame, uint8_t * cbor, size_t len
+) {
+#if defined(CONFIG_DATA_FORMAT_CBOR)
+    // CBOR encoder state.
+    ZCBOR_STATE_E(state, 0, cbor, len, 1);
+
+    /*
+     * Encode data frame in CBOR format and store it in output buffer. If an
+     * error occurs in this process, exit with failure.
+     */
+
+    LOG_INF("Encoding GNSS data frame into CBOR format");
+
+    if (!_data_cbor_gnss_data_frame(state, data_frame)) {
+        // On error, exit with failure.
+        LOG_ERR(
+            "Failed to encode GNSS data frame into CBOR format (Error %d)",
+            zcbor_peek_error(state)
+        );
+        return -1;
+    }
+
+    return state->payload - cbor;
+#else
+    // CBOR support not built.
+    return -1;
+#endif
+}
+
+int data_perf_data_frame_to_cbor (
+    perf_data_frame_t * data_frame, uint8_t * cbor, size_t len
+) {
+#if defined(CONFIG_DATA_FORMAT_CBOR)
+    // CBOR encoder state.
+    ZCBOR_STATE_E(state, 0, cbor, len, 1);
+
+    /*
+     * Encode data frame in CBOR format and store it in output buffer. If an
+     * error occurs in this process, exit with failure.
+     */
+
+    LOG_INF("Encoding performance data frame into CBOR format");
+
+    if (!_data_cbor_perf_data_frame(state, data_frame)) {
+        // On error, exit with failure.
+        LOG_ERR(
+            "Failed to encode performance data frame into CBOR format "
+            "(Error %d)",
+            zcbor_peek_error(state)
+        );
+        return -1;
+    }
+
+    return state->payload - cbor;
+#else
+    // CBOR support not built.
+    return -1;
+#endif
+}
+
+int data_dummy_data_frame_encode (
+    dummy_data_frame_t * data_frame, char * buf, size_t len
+) {
+    // Check variable parts of data frame against the bounds from which the
+    // encoding buffers are sized. Data frames exceeding them are still
+    // encoded, as long as they fit.
+    if (!_data_check_dummy_data_frame(data_frame)) {
+        LOG_WRN("Dummy data frame may exceed worst-case size");
+    }
+
+    // Encode data frame in configured format.
+#if defined(CONFIG_DATA_FORMAT_CBOR)
+    return data_dummy_data_frame_to_cbor(data_frame, (uint8_t *)buf, len);
+#else
+    return data_dummy_data_frame_to_json(data_frame, buf, len);
+#endif
+}
+
+int data_lte_data_frame_encode (
+    lte_data_frame_t * data_frame, char * buf, size_t len
+) {
+    // Check variable parts of data frame against the bounds from which the
+    // encoding buffers are sized. Data frames exceeding them are still
+    // encoded, as long as they fit.
+    if (!_data_check_lte_data_frame(data_frame)) {
+        LOG_WRN("LTE data frame may exceed worst-case size");
+    }
+
+    // Encode data frame in configured format.
+#if defined(CONFIG_DATA_FORMAT_CBOR)
+    return data_lte_data_frame_to_cbor(data_frame, (uint8_t *)buf, len);
+#else
+    return data_lte_data_frame_to_json(data_frame, buf, len);
+#endif
+}
+
+int data_gnss_data_frame_encode (
+    gnss_data_frame_t * data_frame, char * buf, size_t len
+) {
+    // Check variable parts of data frame against the bounds from which the
+    // encoding buffers are sized. Data frames exceeding them are still
+    // encoded, as long as they fit.
+    if (!_data_check_gnss_data_frame(data_frame)) {
+        LOG_WRN("GNSS data frame may exceed worst-case size");
+    }
+
+    // Encode data frame in configured format.
+#if defined(CONFIG_DATA_FORMAT_CBOR)
+    return data_gnss_data_frame_to_cbor(data_frame, (uint8_t *)buf, len);
+#else
+    return data_gnss_data_frame_to_json(data_frame, buf, len);
+#endif
+}
+
+int data_perf_data_frame_encode (
+    perf_data_frame_t * data_frame, char * buf, size_t len
+) {
+    // Check variable parts of data frame against the bounds from which the
+    // encoding buffers are sized. Data frames exceeding them are still
+    // encoded, as long as they fit.
+    if (!_data_check_perf_data_frame(data_frame)) {
+        LOG_WRN("Performance data frame may exceed worst-case size");
+    }
+
+    // Encode data frame in configured format.
+#if defined(CONFIG_DATA_FORMAT_CBOR)
+    return data_perf_data_frame_to_cbor(data_frame, (uint8_t *)buf, len);
+#else
+    return data_perf_data_frame_to_json(data_frame, buf, len);
+#endif
+}
+
+int data_cbor_delta (
+    const uint8_t * prev, size_t prev_len, const uint8_t * cbor, size_t len,
+    data_write_t write, void * ctx
+) {
+#if defined(CONFIG_DATA_FORMAT_CBOR)
+    _data_cbor_item_t old;                          // Previous data frame.
+    _data_cbor_item_t cur;                          // Current data frame.
+    _data_cbor_out_t out = {write, ctx, 0, false};  // Delta output.
+
+    /*
+     * Walk both data frames, which must be maps, and output the delta between
+     * them. If an error occurs in this process, exit with failure.
+     */
+
+    if (
+        !_data_cbor_item(&old, prev, prev + prev_len, 0)
+        || old.major != _DATA_CBOR_MAJOR_MAP
+        || !_data_cbor_item(&cur, cbor, cbor + len, 0)
+        || cur.major != _DATA_CBOR_MAJOR_MAP
+    ) {
+        // On malformed data frame, exit with failure.
+        LOG_ERR("Failed to delta-encode data frame (Malformed data frame)");
+        return -1;
+    }
+
+    _data_cbor_delta_map(&out, &old, &cur);
+
+    if (out.failed) {
+        // On output error, exit with failure.
+        return -1;
+    }
+
+    return out.used;
+#else
+    // CBOR support not built.
+    return -1;
+#endif
 }
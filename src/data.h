@@ -3,11 +3,21 @@
  *  @brief      Data frame processing.
  *
  *  This module defines the various data frame structures required by the
- *  application and is responsible for encoding them in JSON format. The three
- *  types of data frames used are dummy_data_frame_t, lte_data_frame_t, and
- *  gnss_data_frame_t, which can be encoded in JSON format by calling
- *  data_dummy_data_frame_to_json(), data_lte_data_frame_to_json(), and
- *  data_gnss_data_frame_to_json() respectively.
+ *  application and is responsible for encoding them in JSON or CBOR format. The
+ *  four types of data frames used are dummy_data_frame_t, lte_data_frame_t,
+ *  gnss_data_frame_t, and perf_data_frame_t, which can be encoded in JSON
+ *  format by calling data_dummy_data_frame_to_json(),
+ *  data_lte_data_frame_to_json(), data_gnss_data_frame_to_json(), and
+ *  data_perf_data_frame_to_json() respectively. If CBOR support is configured,
+ *  they can be encoded in CBOR format, with integer keys in place of key names,
+ *  by calling the corresponding data_*_data_frame_to_cbor() functions. The
+ *  data_*_data_frame_encode() functions encode data frames in whichever format
+ *  is configured. The layout of every data frame structure is described once
+ *  in data_schema.h, from which the structures and their encoders are
+ *  generated at compile time. If the compact layout is configured, coordinates
+ *  and LTE timer values are held as plain fixed-point integers rather than as
+ *  nested structures broken down into units. CBOR-encoded data frames can be
+ *  delta-encoded against the previous data frame by calling data_cbor_delta().
  */
 
 #ifndef __DATA_H__
@@ -15,6 +25,52 @@
 
 #include <stdbool.h>
 #include <stddef.h>
+#include <stdint.h>
+
+#include "data_schema.h"
+
+/** @ingroup    data
+ *
+ *  @brief      Define data frame structure.
+ *
+ *  Defines a data frame structure named after the given type, with a _t
+ *  suffix, whose members are those listed by the given schema macro.
+ *
+ *  @param      type    Type name, without the _t suffix.
+ *  @param      schema  Schema macro from data_schema.h.
+ */
+
+#define DATA_STRUCT(type, schema)                                              \
+    typedef struct {                                                           \
+        schema(DATA_STRUCT_MEMBER, type)                                       \
+    } type##_t
+
+// Structure member of each kind, as listed by a schema macro.
+#define DATA_STRUCT_MEMBER(P, KIND, ...) DATA_STRUCT_MEMBER_##KIND(__VA_ARGS__)
+#define DATA_STRUCT_MEMBER_BOOL(member, name) bool member;
+#define DATA_STRUCT_MEMBER_INT(member, name, min, max) int member;
+#define DATA_STRUCT_MEMBER_STR(member, name, max) const char * member;
+#define DATA_STRUCT_MEMBER_OBJ(member, name, sub) sub##_t member;
+#define DATA_STRUCT_MEMBER_ARRAY(member, name, sub, max, count)                \
+    sub##_t member[max];                                                       \
+    size_t count;
+
+/** @ingroup    data
+ *
+ *  @brief      Data frame type.
+ *
+ *  This enumeration identifies the type of a data frame. It is used to keep
+ *  track of data frames of different types after they have been encoded, for
+ *  instance while they are queued for upload.
+ */
+
+typedef enum {
+    DATA_TYPE_DUMMY,    //!< Dummy data frame.
+    DATA_TYPE_LTE,      //!< LTE data frame.
+    DATA_TYPE_GNSS,     //!< GNSS data frame.
+    DATA_TYPE_PERF,     //!< Performance data frame.
+    DATA_TYPE_COUNT     //!< Number of data frame types.
+} data_type_t;
 
 /** @ingroup    data
  *
@@ -24,12 +80,7 @@
  *  does not, itself, contain any real useful information.
  */
 
-typedef struct {
-    const char * field1;    //!< Dummy string 1.
-    const char * field2;    //!< Dummy string 2.
-    const char * field3;    //!< Dummy string 3.
-    const char * field4;    //!< Dummy string 4.
-} dummy_data_frame_t;
+DATA_STRUCT(dummy_data_frame, DATA_SCHEMA_DUMMY_DATA_FRAME);
 
 /** @ingroup    data
  *
@@ -40,10 +91,7 @@ typedef struct {
  *  complete LTE data frame.
  */
 
-typedef struct {
-    bool valid;         //!< Data valid.
-    const char * mode;  //!< String representation of active network mode.
-} lte_data_frame_mode_t;
+DATA_STRUCT(lte_data_frame_mode, DATA_SCHEMA_LTE_DATA_FRAME_MODE);
 
 /** @ingroup    data
  *
@@ -54,11 +102,9 @@ typedef struct {
  *  frame.
  */
 
-typedef struct {
-    bool valid; //!< Data valid.
-    int id;     //!< Cell ID.
-    int tac;    //!< Tracking area code.
-} lte_data_frame_cell_t;
+DATA_STRUCT(lte_data_frame_cell, DATA_SCHEMA_LTE_DATA_FRAME_CELL);
+
+#if !defined(CONFIG_DATA_LAYOUT_COMPACT)
 
 /** @ingroup    data
  *
@@ -69,12 +115,7 @@ typedef struct {
  *  PSM configuration.
  */
 
-typedef struct {
-    int day;    //!< Days.
-    int hour;   //!< Hours.
-    int min;    //!< Minutes.
-    int sec;    //!< Seconds.
-} lte_data_frame_psm_tau_t;
+DATA_STRUCT(lte_data_frame_psm_tau, DATA_SCHEMA_LTE_DATA_FRAME_PSM_TAU);
 
 /** @ingroup    data
  *
@@ -85,11 +126,9 @@ typedef struct {
  *  PSM configuration.
  */
 
-typedef struct {
-    int hour;   //!< Hours.
-    int min;    //!< Minutes.
-    int sec;    //!< Seconds.
-} lte_data_frame_psm_at_t;
+DATA_STRUCT(lte_data_frame_psm_at, DATA_SCHEMA_LTE_DATA_FRAME_PSM_AT);
+
+#endif
 
 /** @ingroup    data
  *
@@ -100,11 +139,9 @@ typedef struct {
  *  frame.
  */
 
-typedef struct {
-    bool valid;                     //!< Data valid.
-    lte_data_frame_psm_tau_t tau;   //!< Periodic TAU interval.
-    lte_data_frame_psm_at_t at;     //!< Active time interval.
-} lte_data_frame_psm_t;
+DATA_STRUCT(lte_data_frame_psm, DATA_SCHEMA_LTE_DATA_FRAME_PSM);
+
+#if !defined(CONFIG_DATA_LAYOUT_COMPACT)
 
 /** @ingroup    data
  *
@@ -115,12 +152,7 @@ typedef struct {
  *  configuration.
  */
 
-typedef struct {
-    int hour;   //!< Hours.
-    int min;    //!< Minutes.
-    int sec;    //!< Seconds.
-    int msec;   //!< Milliseconds.
-} lte_data_frame_edrx_edrx_t;
+DATA_STRUCT(lte_data_frame_edrx_edrx, DATA_SCHEMA_LTE_DATA_FRAME_EDRX_EDRX);
 
 /** @ingroup    data
  *
@@ -131,10 +163,9 @@ typedef struct {
  *  eDRX configuration.
  */
 
-typedef struct {
-    int sec;    //!< Seconds.
-    int msec;   //!< Milliseconds.
-} lte_data_frame_edrx_ptw_t;
+DATA_STRUCT(lte_data_frame_edrx_ptw, DATA_SCHEMA_LTE_DATA_FRAME_EDRX_PTW);
+
+#endif
 
 /** @ingroup    data
  *
@@ -145,12 +176,7 @@ typedef struct {
  *  data frame.
  */
 
-typedef struct {
-    bool valid;                         //!< Data valid.
-    const char * mode;                  //!< Associated network mode.
-    lte_data_frame_edrx_edrx_t edrx;    //!< Time interval.
-    lte_data_frame_edrx_ptw_t ptw;      //!< Paging time window.
-} lte_data_frame_edrx_t;
+DATA_STRUCT(lte_data_frame_edrx, DATA_SCHEMA_LTE_DATA_FRAME_EDRX);
 
 /** @ingroup    data
  *
@@ -160,12 +186,9 @@ typedef struct {
  *  notifications received from the modem.
  */
 
-typedef struct {
-    lte_data_frame_mode_t mode; //!< Network mode.
-    lte_data_frame_cell_t cell; //!< Cell information.
-    lte_data_frame_psm_t psm;   //!< PSM configuration.
-    lte_data_frame_edrx_t edrx; //!< eDRX configuration.
-} lte_data_frame_t;
+DATA_STRUCT(lte_data_frame, DATA_SCHEMA_LTE_DATA_FRAME);
+
+#if !defined(CONFIG_DATA_LAYOUT_COMPACT)
 
 /** @ingroup    data
  *
@@ -175,13 +198,7 @@ typedef struct {
  *  gnss_data_frame_loc_t structure that represents the complete GNSS location.
  */
 
-typedef struct {
-    const char * dir;   //!< Geographic direction.
-    int deg;            //!< Degrees.
-    int min;            //!< Minutes.
-    int sec;            //!< Seconds.
-    int msec;           //!< Milliseconds.
-} gnss_data_frame_loc_lat_t;
+DATA_STRUCT(gnss_data_frame_loc_lat, DATA_SCHEMA_GNSS_DATA_FRAME_LOC_LAT);
 
 /** @ingroup    data
  *
@@ -191,13 +208,9 @@ typedef struct {
  *  gnss_data_frame_loc_t structure that represents the complete GNSS location.
  */
 
-typedef struct {
-    const char * dir;   //!< Geographic direction.
-    int deg;            //!< Degrees.
-    int min;            //!< Minutes.
-    int sec;            //!< Seconds.
-    int msec;           //!< Milliseconds.
-} gnss_data_frame_loc_lon_t;
+DATA_STRUCT(gnss_data_frame_loc_lon, DATA_SCHEMA_GNSS_DATA_FRAME_LOC_LON);
+
+#endif
 
 /** @ingroup    data
  *
@@ -207,11 +220,7 @@ typedef struct {
  *  gnss_data_frame_t structure that represents the complete GNSS data frame.
  */
 
-typedef struct {
-    bool valid;                     //!< Data valid.
-    gnss_data_frame_loc_lat_t lat;  //!< Latitude.
-    gnss_data_frame_loc_lon_t lon;  //!< Longitude.
-} gnss_data_frame_loc_t;
+DATA_STRUCT(gnss_data_frame_loc, DATA_SCHEMA_GNSS_DATA_FRAME_LOC);
 
 /** @ingroup    data
  *
@@ -221,12 +230,7 @@ typedef struct {
  *  gnss_data_frame_t structure that represents the complete GNSS data frame.
  */
 
-typedef struct {
-    bool valid; //!< Data valid.
-    int year;   //!< Year.
-    int mon;    //!< Month.
-    int day;    //!< Day.
-} gnss_data_frame_date_t;
+DATA_STRUCT(gnss_data_frame_date, DATA_SCHEMA_GNSS_DATA_FRAME_DATE);
 
 /** @ingroup    data
  *
@@ -236,13 +240,7 @@ typedef struct {
  *  gnss_data_frame_t structure that represents the complete GNSS data frame.
  */
 
-typedef struct {
-    bool valid; //!< Data valid.
-    int hour;   //!< Hour.
-    int min;    //!< Minute.
-    int sec;    //!< Second.
-    int msec;   //!< Millisecond.
-} gnss_data_frame_time_t;
+DATA_STRUCT(gnss_data_frame_time, DATA_SCHEMA_GNSS_DATA_FRAME_TIME);
 
 /** @ingroup    data
  *
@@ -251,25 +249,149 @@ typedef struct {
  *  This data frame contains information from the latest obtained GNSS fix.
  */
 
-typedef struct {
-    gnss_data_frame_loc_t loc;      //!< Location.
-    gnss_data_frame_date_t date;    //!< Date.
-    gnss_data_frame_time_t time;    //!< Time.
-} gnss_data_frame_t;
+DATA_STRUCT(gnss_data_frame, DATA_SCHEMA_GNSS_DATA_FRAME);
+
+/** @ingroup    data
+ *
+ *  @brief      Performance phase summary.
+ *
+ *  This structure summarizes the recorded durations of a single phase of the
+ *  logging cycle. It is embedded in the parent perf_data_frame_t structure
+ *  that represents the complete performance data frame.
+ */
+
+DATA_STRUCT(perf_data_frame_phase, DATA_SCHEMA_PERF_DATA_FRAME_PHASE);
+
+/** @ingroup    data
+ *
+ *  @brief      Performance data frame.
+ *
+ *  This data frame contains telemetry on how long the phases of the logging
+ *  cycle have taken since the histograms were last cleared.
+ */
+
+DATA_STRUCT(perf_data_frame, DATA_SCHEMA_PERF_DATA_FRAME);
+
+/** @ingroup    data
+ *
+ *  @brief      Number of members listed by a schema macro.
+ *
+ *  @param      schema  Schema macro from data_schema.h.
+ */
+
+#define DATA_COUNT(schema) (0 schema(DATA_COUNT_ONE, _))
+#define DATA_COUNT_ONE(P, KIND, ...) + 1
+
+/** @ingroup    data
+ *
+ *  @brief      Worst-case encoded size of structure in JSON format.
+ *
+ *  Evaluates at compile time to the maximum length of the given structure type
+ *  encoded in JSON format, for any member values within the ranges declared in
+ *  data_schema.h. Strings are assumed to consist entirely of characters that
+ *  must be escaped.
+ *
+ *  @param      type    Type name, without the _t suffix.
+ */
+
+#define DATA_JSON_MAX(type) ((int)data_##type##_json_max)
+
+/** @ingroup    data
+ *
+ *  @brief      Worst-case encoded size of structure in CBOR format.
+ *
+ *  Evaluates at compile time to the maximum length of the given structure type
+ *  encoded in CBOR format, for any member values within the ranges declared in
+ *  data_schema.h.
+ *
+ *  @param      type    Type name, without the _t suffix.
+ */
+
+#define DATA_CBOR_MAX(type) ((int)data_##type##_cbor_max)
+
+/** @ingroup    data
+ *
+ *  @brief      Worst-case encoded size of structure in configured format.
+ *
+ *  @param      type    Type name, without the _t suffix.
+ */
+
+#if defined(CONFIG_DATA_FORMAT_CBOR)
+#define DATA_ENCODED_MAX(type) DATA_CBOR_MAX(type)
+#else
+#define DATA_ENCODED_MAX(type) DATA_JSON_MAX(type)
+#endif
+
+// Worst-case encoded sizes of a structure, as enumeration constants so that
+// they can be used in array sizes and static assertions.
+#define DATA_MAX_DEFINE(type, schema)                                          \
+    enum {                                                                     \
+        data_##type##_json_max = 1 schema(DATA_MAX_JSON_MEMBER, _),            \
+        data_##type##_cbor_max = DATA_MAX_CBOR_HEAD(DATA_COUNT(schema))        \
+            * (DATA_COUNT(schema) + 1) + 1 schema(DATA_MAX_CBOR_MEMBER, _)     \
+    };
+
+// Larger of two values.
+#define DATA_MAX_OF(a, b) ((a) > (b) ? (a) : (b))
+
+// Number of decimal digits of a non-negative value below 10^10.
+#define DATA_MAX_DIGITS(v)                                                     \
+    ((v) < 10 ? 1 : (v) < 100 ? 2 : (v) < 1000 ? 3 : (v) < 10000 ? 4           \
+        : (v) < 100000 ? 5 : (v) < 1000000 ? 6 : (v) < 10000000 ? 7            \
+        : (v) < 100000000 ? 8 : (v) < 1000000000 ? 9 : 10)
+
+// Length of decimal representation of a value, with its sign.
+#define DATA_MAX_DEC(v)                                                        \
+    ((v) < 0 ? 1 + DATA_MAX_DIGITS(-(long long)(v))                            \
+        : DATA_MAX_DIGITS((long long)(v)))
+
+// Length of CBOR head with the given argument.
+#define DATA_MAX_CBOR_HEAD(v)                                                  \
+    ((v) < 24 ? 1 : (v) < 256 ? 2 : (v) < 65536 ? 3                            \
+        : (v) < 4294967296LL ? 5 : 9)
+
+// Worst-case JSON encoding of a structure member, with its key and the comma
+// separating it from the previous member.
+#define DATA_MAX_JSON_MEMBER(P, KIND, member, name, ...)                       \
+    + (int)sizeof(",\"" name "\":") - 1 + DATA_MAX_JSON_##KIND(__VA_ARGS__)
+
+// Worst-case JSON encoding of a structure member of each kind.
+#define DATA_MAX_JSON_BOOL(...) 5
+#define DATA_MAX_JSON_INT(min, max)                                            \
+    DATA_MAX_OF(DATA_MAX_DEC(min), DATA_MAX_DEC(max))
+#define DATA_MAX_JSON_STR(max) (2 + 2 * (max))
+#define DATA_MAX_JSON_OBJ(sub) DATA_JSON_MAX(sub)
+#define DATA_MAX_JSON_ARRAY(sub, max, count)                                   \
+    (1 + (max) * (DATA_JSON_MAX(sub) + 1))
+
+// Worst-case CBOR encoding of a structure member, without its key.
+#define DATA_MAX_CBOR_MEMBER(P, KIND, member, name, ...)                       \
+    + DATA_MAX_CBOR_##KIND(__VA_ARGS__)
+
+// Worst-case CBOR encoding of a structure member of each kind.
+#define DATA_MAX_CBOR_BOOL(...) 1
+#define DATA_MAX_CBOR_INT(min, max)                                            \
+    DATA_MAX_CBOR_HEAD(DATA_MAX_OF((long long)(max), -1 - (long long)(min)))
+#define DATA_MAX_CBOR_STR(max) (DATA_MAX_CBOR_HEAD(max) + (max))
+#define DATA_MAX_CBOR_OBJ(sub) DATA_CBOR_MAX(sub)
+#define DATA_MAX_CBOR_ARRAY(sub, max, count)                                   \
+    (DATA_MAX_CBOR_HEAD(max) + 1 + (max) * DATA_CBOR_MAX(sub))
+
+DATA_SCHEMA_ALL(DATA_MAX_DEFINE)
 
 /** @ingroup    data
  *
  *  @brief      Encode dummy data frame in JSON format.
  *
- *  Encodes the given dummy data frame structure in a JSON-format string.
+ *  Encodes the given dummy data frame structure in JSON format. The buffer is
+ *  not cleared beforehand, and no terminating null byte is written.
  *
  *  @param      data_frame  Pointer to dummy data frame to be encoded.
- *  @param      json        Pointer to buffer into which encoded string should
- *                          be written, along with terminating null byte.
- *  @param      len         Length of buffer provided for encoded string.
+ *  @param      json        Pointer to buffer into which encoded data frame
+ *                          should be written.
+ *  @param      len         Length of buffer provided for encoded data frame.
  *
- *  @retval     0           Success.
- *  @retval     -1          Failure.
+ *  @return     Length of encoded data frame on success, -1 on failure.
  */
 
 int data_dummy_data_frame_to_json (
@@ -280,15 +402,15 @@ int data_dummy_data_frame_to_json (
  *
  *  @brief      Encode LTE data frame in JSON format.
  *
- *  Encodes the given LTE data frame structure in a JSON-format string.
+ *  Encodes the given LTE data frame structure in JSON format. The buffer is
+ *  not cleared beforehand, and no terminating null byte is written.
  *
  *  @param      data_frame  Pointer to LTE data frame to be encoded.
- *  @param      json        Pointer to buffer into which encoded string should
- *                          be written, along with terminating null byte.
- *  @param      len         Length of buffer provided for encoded string.
+ *  @param      json        Pointer to buffer into which encoded data frame
+ *                          should be written.
+ *  @param      len         Length of buffer provided for encoded data frame.
  *
- *  @retval     0           Success.
- *  @retval     -1          Failure.
+ *  @return     Length of encoded data frame on success, -1 on failure.
  */
 
 int data_lte_data_frame_to_json (
@@ -299,19 +421,234 @@ int data_lte_data_frame_to_json (
  *
  *  @brief      Encode GNSS data frame in JSON format.
  *
- *  Encodes the given GNSS data frame structure in a JSON-format string.
+ *  Encodes the given GNSS data frame structure in JSON format. The buffer is
+ *  not cleared beforehand, and no terminating null byte is written.
  *
  *  @param      data_frame  Pointer to GNSS data frame to be encoded.
- *  @param      json        Pointer to buffer into which encoded string should
- *                          be written, along with terminating null byte.
- *  @param      len         Length of buffer provided for encoded string.
+ *  @param      json        Pointer to buffer into which encoded data frame
+ *                          should be written.
+ *  @param      len         Length of buffer provided for encoded data frame.
  *
- *  @retval     0           Success.
- *  @retval     -1          Failure.
+ *  @return     Length of encoded data frame on success, -1 on failure.
  */
 
 int data_gnss_data_frame_to_json (
     gnss_data_frame_t * data_frame, char * json, size_t len
 );
 
+/** @ingroup    data
+ *
+ *  @brief      Encode performance data frame in JSON format.
+ *
+ *  Encodes the given performance data frame structure in JSON format. The
+ *  buffer is not cleared beforehand, and no terminating null byte is written.
+ *
+ *  @param      data_frame  Pointer to performance data frame to be encoded.
+ *  @param      json        Pointer to buffer into which encoded data frame
+ *                          should be written.
+ *  @param      len         Length of buffer provided for encoded data frame.
+ *
+ *  @return     Length of encoded data frame on success, -1 on failure.
+ */
+
+int data_perf_data_frame_to_json (
+    perf_data_frame_t * data_frame, char * json, size_t len
+);
+
+/** @ingroup    data
+ *
+ *  @brief      Encode dummy data frame in CBOR format.
+ *
+ *  Encodes the given dummy data frame structure in CBOR format. This function
+ *  fails if CBOR support is not configured.
+ *
+ *  @param      data_frame  Pointer to dummy data frame to be encoded.
+ *  @param      cbor        Pointer to buffer into which encoded data frame
+ *                          should be written.
+ *  @param      len         Length of buffer provided for encoded data frame.
+ *
+ *  @return     Length of encoded data frame on success, -1 on failure.
+ */
+
+int data_dummy_data_frame_to_cbor (
+    dummy_data_frame_t * data_frame, uint8_t * cbor, size_t len
+);
+
+/** @ingroup    data
+ *
+ *  @brief      Encode LTE data frame in CBOR format.
+ *
+ *  Encodes the given LTE data frame structure in CBOR format. This function
+ *  fails if CBOR support is not configured.
+ *
+ *  @param      data_frame  Pointer to LTE data frame to be encoded.
+ *  @param      cbor        Pointer to buffer into which encoded data frame
+ *                          should be written.
+ *  @param      len         Length of buffer provided for encoded data frame.
+ *
+ *  @return     Length of encoded data frame on success, -1 on failure.
+ */
+
+int data_lte_data_frame_to_cbor (
+    lte_data_frame_t * data_frame, uint8_t * cbor, size_t len
+);
+
+/** @ingroup    data
+ *
+ *  @brief      Encode GNSS data frame in CBOR format.
+ *
+ *  Encodes the given GNSS data frame structure in CBOR format. This function
+ *  fails if CBOR support is not configured.
+ *
+ *  @param      data_frame  Pointer to GNSS data frame to be encoded.
+ *  @param      cbor        Pointer to buffer into which encoded data frame
+ *                          should be written.
+ *  @param      len         Length of buffer provided for encoded data frame.
+ *
+ *  @return     Length of encoded data frame on success, -1 on failure.
+ */
+
+int data_gnss_data_frame_to_cbor (
+    gnss_data_frame_t * data_frame, uint8_t * cbor, size_t len
+);
+
+/** @ingroup    data
+ *
+ *  @brief      Encode performance data frame in CBOR format.
+ *
+ *  Encodes the given performance data frame structure in CBOR format. This
+ *  function fails if CBOR support is not configured.
+ *
+ *  @param      data_frame  Pointer to performance data frame to be encoded.
+ *  @param      cbor        Pointer to buffer into which encoded data frame
+ *                          should be written.
+ *  @param      len         Length of buffer provided for encoded data frame.
+ *
+ *  @return     Length of encoded data frame on success, -1 on failure.
+ */
+
+int data_perf_data_frame_to_cbor (
+    perf_data_frame_t * data_frame, uint8_t * cbor, size_t len
+);
+
+/** @ingroup    data
+ *
+ *  @brief      Encode dummy data frame in configured format.
+ *
+ *  Encodes the given dummy data frame structure in JSON or CBOR format, as
+ *  configured.
+ *
+ *  @param      data_frame  Pointer to dummy data frame to be encoded.
+ *  @param      buf         Pointer to buffer into which encoded data frame
+ *                          should be written.
+ *  @param      len         Length of buffer provided for encoded data frame.
+ *
+ *  @return     Length of encoded data frame on success, -1 on failure.
+ */
+
+int data_dummy_data_frame_encode (
+    dummy_data_frame_t * data_frame, char * buf, size_t len
+);
+
+/** @ingroup    data
+ *
+ *  @brief      Encode LTE data frame in configured format.
+ *
+ *  Encodes the given LTE data frame structure in JSON or CBOR format, as
+ *  configured.
+ *
+ *  @param      data_frame  Pointer to LTE data frame to be encoded.
+ *  @param      buf         Pointer to buffer into which encoded data frame
+ *                          should be written.
+ *  @param      len         Length of buffer provided for encoded data frame.
+ *
+ *  @return     Length of encoded data frame on success, -1 on failure.
+ */
+
+int data_lte_data_frame_encode (
+    lte_data_frame_t * data_frame, char * buf, size_t len
+);
+
+/** @ingroup    data
+ *
+ *  @brief      Encode GNSS data frame in configured format.
+ *
+ *  Encodes the given GNSS data frame structure in JSON or CBOR format, as
+ *  configured.
+ *
+ *  @param      data_frame  Pointer to GNSS data frame to be encoded.
+ *  @param      buf         Pointer to buffer into which encoded data frame
+ *                          should be written.
+ *  @param      len         Length of buffer provided for encoded data frame.
+ *
+ *  @return     Length of encoded data frame on success, -1 on failure.
+ */
+
+int data_gnss_data_frame_encode (
+    gnss_data_frame_t * data_frame, char * buf, size_t len
+);
+
+/** @ingroup    data
+ *
+ *  @brief      Encode performance data frame in configured format.
+ *
+ *  Encodes the given performance data frame structure in JSON or CBOR format,
+ *  as configured.
+ *
+ *  @param      data_frame  Pointer to performance data frame to be encoded.
+ *  @param      buf         Pointer to buffer into which encoded data frame
+ *                          should be written.
+ *  @param      len         Length of buffer provided for encoded data frame.
+ *
+ *  @return     Length of encoded data frame on success, -1 on failure.
+ */
+
+int data_perf_data_frame_encode (
+    perf_data_frame_t * data_frame, char * buf, size_t len
+);
+
+/** @ingroup    data
+ *
+ *  @brief      Output function for delta-encoded data frames.
+ *
+ *  Function called by data_cbor_delta() to write each piece of a delta.
+ *
+ *  @param      ctx     Context given along with the output function.
+ *  @param      data    Pointer to data that must be written.
+ *  @param      len     Length of data.
+ *
+ *  @retval     0       Success.
+ *  @retval     -1      Failure. Delta encoding is aborted.
+ */
+
+typedef int (* data_write_t) (void * ctx, const void * data, size_t len);
+
+/** @ingroup    data
+ *
+ *  @brief      Delta-encode data frame in CBOR format.
+ *
+ *  Encodes the given CBOR-encoded data frame as a delta from the given previous
+ *  data frame of the same type. The delta is a CBOR map that holds only those
+ *  members of the data frame that differ from the previous data frame. Members
+ *  that are maps in both data frames are given as the delta of the two maps,
+ *  and members that are integers in both data frames as their difference.
+ *  Other members are given in full. The delta is passed piece by piece to the
+ *  given output function, which may be NULL to only determine its length. This
+ *  function fails if CBOR support is not configured.
+ *
+ *  @param      prev        Pointer to previous encoded data frame.
+ *  @param      prev_len    Length of previous encoded data frame.
+ *  @param      cbor        Pointer to encoded data frame.
+ *  @param      len         Length of encoded data frame.
+ *  @param      write       Output function, or NULL.
+ *  @param      ctx         Context passed to output function.
+ *
+ *  @return     Length of delta on success, -1 on failure.
+ */
+
+int data_cbor_delta (
+    const uint8_t * prev, size_t prev_len, const uint8_t * cbor, size_t len,
+    data_write_t write, void * ctx
+);
+
 #endif
@@ -0,0 +1,235 @@
+/** @defgroup   data_schema Data schema
+ *
+ *  @brief      Data frame schema.
+ *
+ *  This header describes the layout of every data frame structure in a single
+ *  place. Each structure is described by a schema macro, which lists its
+ *  members in order by invoking a given generator macro once per member, as
+ *  X(P, KIND, member, "name", ...), where P is passed through unchanged, KIND
+ *  is one of BOOL, INT, STR, OBJ, and ARRAY, member is the name of the
+ *  structure member, and "name" is the key under which it is encoded. Members
+ *  of kind INT give the smallest and largest value they may take, members of
+ *  kind STR give the maximum length of their string, members of kind OBJ give
+ *  the type of the nested structure, without the _t suffix, and members of
+ *  kind ARRAY give the element type, the maximum number of elements, and the
+ *  name of the member holding the element count. The data module expands
+ *  these macros into the structure definitions, into the JSON descriptions and
+ *  encoders, and into the worst-case encoded size of every structure, which is
+ *  derived from the value ranges and string lengths. Adding a member to a data
+ *  frame therefore only requires adding it here. Nested structures must be
+ *  listed before the structures that contain them. Every data frame ends with
+ *  a sequence number, which is assigned by the queue and lets the server
+ *  recognize data frames that it receives more than once. It is listed last,
+ *  so that the CBOR keys of the other members are unaffected by it.
+ */
+
+#ifndef __DATA_SCHEMA_H__
+#define __DATA_SCHEMA_H__
+
+#include <stdint.h>
+
+/** @ingroup    data_schema
+ *
+ *  @brief      Maximum number of phases in a performance data frame.
+ */
+
+#define DATA_PERF_PHASE_MAX   16
+
+// Dummy data frame.
+#define DATA_SCHEMA_DUMMY_DATA_FRAME(X, P)                                     \
+    X(P, STR, field1, "field1", 64)     /* Dummy string 1. */                  \
+    X(P, STR, field2, "field2", 64)     /* Dummy string 2. */                  \
+    X(P, STR, field3, "field3", 64)     /* Dummy string 3. */                  \
+    X(P, STR, field4, "field4", 64)     /* Dummy string 4. */                  \
+    X(P, INT, seq, "seq", 0, INT32_MAX) /* Sequence number. */
+
+// LTE network mode.
+#define DATA_SCHEMA_LTE_DATA_FRAME_MODE(X, P)                                  \
+    X(P, BOOL, valid, "valid")          /* Data valid. */                      \
+    X(P, STR, mode, "mode", 8)          /* Active network mode. */
+
+// LTE cell information.
+#define DATA_SCHEMA_LTE_DATA_FRAME_CELL(X, P)                                  \
+    X(P, BOOL, valid, "valid")          /* Data valid. */                      \
+    X(P, INT, id, "id", 0, 268435455)   /* Cell ID. */                         \
+    X(P, INT, tac, "tac", 0, 65535)     /* Tracking area code. */
+
+#if defined(CONFIG_DATA_LAYOUT_COMPACT)
+
+// LTE PSM configuration. Timer values are given in seconds.
+#define DATA_SCHEMA_LTE_DATA_FRAME_PSM(X, P)                                   \
+    X(P, BOOL, valid, "valid")          /* Data valid. */                      \
+    X(P, INT, tau, "tau_s", 0, 35712000) /* Periodic TAU interval. */          \
+    X(P, INT, at, "at_s", 0, 11160)     /* Active time interval. */
+
+// LTE eDRX configuration. Timer values are given in milliseconds.
+#define DATA_SCHEMA_LTE_DATA_FRAME_EDRX(X, P)                                  \
+    X(P, BOOL, valid, "valid")          /* Data valid. */                      \
+    X(P, STR, mode, "mode", 8)          /* Associated network mode. */         \
+    X(P, INT, edrx, "edrx_ms", 0, 10485760) /* Time interval. */               \
+    X(P, INT, ptw, "ptw_ms", 0, 40960)  /* Paging time window. */
+
+#else
+
+// LTE PSM periodic TAU interval.
+#define DATA_SCHEMA_LTE_DATA_FRAME_PSM_TAU(X, P)                               \
+    X(P, INT, day, "days", 0, 413)      /* Days. */                            \
+    X(P, INT, hour, "hours", 0, 23)     /* Hours. */                           \
+    X(P, INT, min, "minutes", 0, 59)    /* Minutes. */                         \
+    X(P, INT, sec, "seconds", 0, 59)    /* Seconds. */
+
+// LTE PSM active time interval.
+#define DATA_SCHEMA_LTE_DATA_FRAME_PSM_AT(X, P)                                \
+    X(P, INT, hour, "hours", 0, 3)      /* Hours. */                           \
+    X(P, INT, min, "minutes", 0, 59)    /* Minutes. */                         \
+    X(P, INT, sec, "seconds", 0, 59)    /* Seconds. */
+
+// LTE PSM configuration.
+#define DATA_SCHEMA_LTE_DATA_FRAME_PSM(X, P)                                   \
+    X(P, BOOL, valid, "valid")          /* Data valid. */                      \
+    X(P, OBJ, tau, "tau", lte_data_frame_psm_tau)   /* Periodic TAU. */        \
+    X(P, OBJ, at, "at", lte_data_frame_psm_at)      /* Active time. */
+
+// LTE eDRX time interval.
+#define DATA_SCHEMA_LTE_DATA_FRAME_EDRX_EDRX(X, P)                             \
+    X(P, INT, hour, "hours", 0, 2)      /* Hours. */                           \
+    X(P, INT, min, "minutes", 0, 59)    /* Minutes. */                         \
+    X(P, INT, sec, "seconds", 0, 59)    /* Seconds. */                         \
+    X(P, INT, msec, "milliseconds", 0, 999) /* Milliseconds. */
+
+// LTE eDRX paging time window.
+#define DATA_SCHEMA_LTE_DATA_FRAME_EDRX_PTW(X, P)                              \
+    X(P, INT, sec, "seconds", 0, 40)    /* Seconds. */                         \
+    X(P, INT, msec, "milliseconds", 0, 999) /* Milliseconds. */
+
+// LTE eDRX configuration.
+#define DATA_SCHEMA_LTE_DATA_FRAME_EDRX(X, P)                                  \
+    X(P, BOOL, valid, "valid")          /* Data valid. */                      \
+    X(P, STR, mode, "mode", 8)          /* Associated network mode. */         \
+    X(P, OBJ, edrx, "edrx", lte_data_frame_edrx_edrx)   /* Time interval. */   \
+    X(P, OBJ, ptw, "ptw", lte_data_frame_edrx_ptw)      /* Paging window. */
+
+#endif
+
+// LTE data frame.
+#define DATA_SCHEMA_LTE_DATA_FRAME(X, P)                                       \
+    X(P, OBJ, mode, "mode", lte_data_frame_mode)    /* Network mode. */        \
+    X(P, OBJ, cell, "cell", lte_data_frame_cell)    /* Cell information. */    \
+    X(P, OBJ, psm, "psm", lte_data_frame_psm)       /* PSM configuration. */   \
+    X(P, OBJ, edrx, "edrx", lte_data_frame_edrx)    /* eDRX configuration. */  \
+    X(P, INT, seq, "seq", 0, INT32_MAX)             /* Sequence number. */
+
+#if defined(CONFIG_DATA_LAYOUT_COMPACT)
+
+// GNSS location. Coordinates are given in micro-degrees, positive towards the
+// north and east.
+#define DATA_SCHEMA_GNSS_DATA_FRAME_LOC(X, P)                                  \
+    X(P, BOOL, valid, "valid")          /* Data valid. */                      \
+    X(P, INT, lat, "latitude_udeg", -90000000, 90000000) /* Latitude. */       \
+    X(P, INT, lon, "longitude_udeg", -180000000, 180000000) /* Longitude. */
+
+#else
+
+// GNSS latitude.
+#define DATA_SCHEMA_GNSS_DATA_FRAME_LOC_LAT(X, P)                              \
+    X(P, STR, dir, "direction", 1)      /* Geographic direction. */            \
+    X(P, INT, deg, "degrees", 0, 90)    /* Degrees. */                         \
+    X(P, INT, min, "minutes", 0, 59)    /* Minutes. */                         \
+    X(P, INT, sec, "seconds", 0, 59)    /* Seconds. */                         \
+    X(P, INT, msec, "milliseconds", 0, 999) /* Milliseconds. */
+
+// GNSS longitude.
+#define DATA_SCHEMA_GNSS_DATA_FRAME_LOC_LON(X, P)                              \
+    X(P, STR, dir, "direction", 1)      /* Geographic direction. */            \
+    X(P, INT, deg, "degrees", 0, 180)   /* Degrees. */                         \
+    X(P, INT, min, "minutes", 0, 59)    /* Minutes. */                         \
+    X(P, INT, sec, "seconds", 0, 59)    /* Seconds. */                         \
+    X(P, INT, msec, "milliseconds", 0, 999) /* Milliseconds. */
+
+// GNSS location.
+#define DATA_SCHEMA_GNSS_DATA_FRAME_LOC(X, P)                                  \
+    X(P, BOOL, valid, "valid")          /* Data valid. */                      \
+    X(P, OBJ, lat, "latitude", gnss_data_frame_loc_lat)     /* Latitude. */    \
+    X(P, OBJ, lon, "longitude", gnss_data_frame_loc_lon)    /* Longitude. */
+
+#endif
+
+// GNSS date.
+#define DATA_SCHEMA_GNSS_DATA_FRAME_DATE(X, P)                                 \
+    X(P, BOOL, valid, "valid")          /* Data valid. */                      \
+    X(P, INT, year, "year", 0, 65535)   /* Year. */                            \
+    X(P, INT, mon, "month", 0, 12)      /* Month. */                           \
+    X(P, INT, day, "day", 0, 31)        /* Day. */
+
+// GNSS time.
+#define DATA_SCHEMA_GNSS_DATA_FRAME_TIME(X, P)                                 \
+    X(P, BOOL, valid, "valid")          /* Data valid. */                      \
+    X(P, INT, hour, "hour", 0, 23)      /* Hour. */                            \
+    X(P, INT, min, "minute", 0, 59)     /* Minute. */                          \
+    X(P, INT, sec, "second", 0, 60)     /* Second. */                          \
+    X(P, INT, msec, "millisecond", 0, 999) /* Millisecond. */
+
+// GNSS data frame.
+#define DATA_SCHEMA_GNSS_DATA_FRAME(X, P)                                      \
+    X(P, OBJ, loc, "location", gnss_data_frame_loc)     /* Location. */        \
+    X(P, OBJ, date, "date", gnss_data_frame_date)       /* Date. */            \
+    X(P, OBJ, time, "time", gnss_data_frame_time)       /* Time. */            \
+    X(P, INT, seq, "seq", 0, INT32_MAX)                 /* Sequence number. */
+
+// Performance phase summary. Durations are given in milliseconds.
+#define DATA_SCHEMA_PERF_DATA_FRAME_PHASE(X, P)                                \
+    X(P, STR, name, "phase", 16)        /* Phase name. */                      \
+    X(P, INT, count, "count", 0, INT32_MAX) /* Number of durations. */         \
+    X(P, INT, min, "min", 0, INT32_MAX) /* Minimum duration. */                \
+    X(P, INT, max, "max", 0, INT32_MAX) /* Maximum duration. */                \
+    X(P, INT, p50, "p50", 0, INT32_MAX) /* Median duration. */                 \
+    X(P, INT, p95, "p95", 0, INT32_MAX) /* 95th percentile duration. */
+
+// Performance data frame.
+#define DATA_SCHEMA_PERF_DATA_FRAME(X, P)                                      \
+    X(                                                                         \
+        P, ARRAY, phases, "phases", perf_data_frame_phase,                     \
+        DATA_PERF_PHASE_MAX, phase_count                                       \
+    )                                   /* Phases and phase count. */          \
+    X(P, INT, seq, "seq", 0, INT32_MAX) /* Sequence number. */
+
+// All data frame structures, with nested structures listed before the
+// structures that contain them. The given macro is invoked as X(type, schema)
+// for each structure, where type is the type name without the _t suffix.
+#if defined(CONFIG_DATA_LAYOUT_COMPACT)
+#define DATA_SCHEMA_ALL(X)                                                     \
+    X(dummy_data_frame, DATA_SCHEMA_DUMMY_DATA_FRAME)                          \
+    X(lte_data_frame_mode, DATA_SCHEMA_LTE_DATA_FRAME_MODE)                    \
+    X(lte_data_frame_cell, DATA_SCHEMA_LTE_DATA_FRAME_CELL)                    \
+    X(lte_data_frame_psm, DATA_SCHEMA_LTE_DATA_FRAME_PSM)                      \
+    X(lte_data_frame_edrx, DATA_SCHEMA_LTE_DATA_FRAME_EDRX)                    \
+    X(lte_data_frame, DATA_SCHEMA_LTE_DATA_FRAME)                              \
+    X(gnss_data_frame_loc, DATA_SCHEMA_GNSS_DATA_FRAME_LOC)                    \
+    X(gnss_data_frame_date, DATA_SCHEMA_GNSS_DATA_FRAME_DATE)                  \
+    X(gnss_data_frame_time, DATA_SCHEMA_GNSS_DATA_FRAME_TIME)                  \
+    X(gnss_data_frame, DATA_SCHEMA_GNSS_DATA_FRAME)                            \
+    X(perf_data_frame_phase, DATA_SCHEMA_PERF_DATA_FRAME_PHASE)                \
+    X(perf_data_frame, DATA_SCHEMA_PERF_DATA_FRAME)
+#else
+#define DATA_SCHEMA_ALL(X)                                                     \
+    X(dummy_data_frame, DATA_SCHEMA_DUMMY_DATA_FRAME)                          \
+    X(lte_data_frame_mode, DATA_SCHEMA_LTE_DATA_FRAME_MODE)                    \
+    X(lte_data_frame_cell, DATA_SCHEMA_LTE_DATA_FRAME_CELL)                    \
+    X(lte_data_frame_psm_tau, DATA_SCHEMA_LTE_DATA_FRAME_PSM_TAU)              \
+    X(lte_data_frame_psm_at, DATA_SCHEMA_LTE_DATA_FRAME_PSM_AT)                \
+    X(lte_data_frame_psm, DATA_SCHEMA_LTE_DATA_FRAME_PSM)                      \
+    X(lte_data_frame_edrx_edrx, DATA_SCHEMA_LTE_DATA_FRAME_EDRX_EDRX)          \
+    X(lte_data_frame_edrx_ptw, DATA_SCHEMA_LTE_DATA_FRAME_EDRX_PTW)            \
+    X(lte_data_frame_edrx, DATA_SCHEMA_LTE_DATA_FRAME_EDRX)                    \
+    X(lte_data_frame, DATA_SCHEMA_LTE_DATA_FRAME)                              \
+    X(gnss_data_frame_loc_lat, DATA_SCHEMA_GNSS_DATA_FRAME_LOC_LAT)            \
+    X(gnss_data_frame_loc_lon, DATA_SCHEMA_GNSS_DATA_FRAME_LOC_LON)            \
+    X(gnss_data_frame_loc, DATA_SCHEMA_GNSS_DATA_FRAME_LOC)                    \
+    X(gnss_data_frame_date, DATA_SCHEMA_GNSS_DATA_FRAME_DATE)                  \
+    X(gnss_data_frame_time, DATA_SCHEMA_GNSS_DATA_FRAME_TIME)                  \
+    X(gnss_data_frame, DATA_SCHEMA_GNSS_DATA_FRAME)                            \
+    X(perf_data_frame_phase, DATA_SCHEMA_PERF_DATA_FRAME_PHASE)                \
+    X(perf_data_frame, DATA_SCHEMA_PERF_DATA_FRAME)
+#endif
+
+#endif
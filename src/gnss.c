@@ -1,4 +1,5 @@
 #include <stdbool.h>
+#include <stdint.h>
 #include <string.h>
 
 #include <zephyr/kernel.h>
@@ -8,10 +9,60 @@
 #include <nrf_modem_gnss.h>
 
 #include "data.h"
+#include "lte.h"
+#include "perf.h"
 
 // Register module for logging.
 LOG_MODULE_REGISTER(gnss, CONFIG_GNSS_LOG_LEVEL);
 
+static void _gnss_release (void) {
+    int status;     // Return status for API calls.
+    int64_t start;  // Start time of deinitialization.
+
+    if (lte_active()) {
+        /*
+         * The LTE link is kept registered, so the modem must stay initialized.
+         * Deactivate only the GNSS interface. If an error occurs in this
+         * process, report failure.
+         */
+
+        LOG_WRN("Deactivating GNSS");
+
+        // Deactivate GNSS but not LTE.
+        status = lte_lc_func_mode_set(LTE_LC_FUNC_MODE_DEACTIVATE_GNSS);
+        if (status < 0) {
+            // On error, report failure.
+            LOG_ERR(
+                "Failed to deactivate GNSS (%s)",
+                strerror(-status)
+            );
+        }
+        return;
+    }
+
+    /*
+     * Deinitialize modem. If an error occurs in this process, report failure.
+     */
+
+    LOG_WRN("Deinitializing modem");
+
+    // Deinitialize modem.
+    start = perf_start();
+    status = lte_lc_deinit();
+    if (status < 0) {
+        // On error, report failure.
+        LOG_ERR(
+            "Failed to deinitialize modem (%s)",
+            strerror(-status)
+        );
+    }
+    perf_record(PERF_PHASE_DEINIT, start);
+}
+
+// Time at which GNSS reception was started, used to measure the time to fix.
+// Value is zero once the fix has been timed.
+static int64_t _gnss_fix_start = 0;
+
 // Data available flag. Value indicates whether or not data is available.
 // Semaphore is released whenever value is set to true, to signal threads
 // waiting for data to become available. Mutex protects against concurrent
@@ -26,6 +77,10 @@ static K_MUTEX_DEFINE(_gnss_data_frame_mutex);
 static gnss_data_frame_t _gnss_data_frame = {
     .loc = {
         .valid = false,
+#if defined(CONFIG_DATA_LAYOUT_COMPACT)
+        .lat = 0,
+        .lon = 0
+#else
         .lat = {
             .dir = "",
             .deg = 0,
@@ -40,6 +95,7 @@ static gnss_data_frame_t _gnss_data_frame = {
             .sec = 0,
             .msec = 0
         }
+#endif
     },
     .date = {
         .valid = false,
@@ -56,9 +112,29 @@ static gnss_data_frame_t _gnss_data_frame = {
     }
 };
 
+#if defined(CONFIG_DATA_LAYOUT_COMPACT)
+
+static int _gnss_coord_udeg (double coord) {
+    // Round coordinate in degrees to nearest micro-degree.
+    return (int)(coord * 1000000 + (coord < 0 ? -0.5 : 0.5));
+}
+
+#else
+
+static int64_t _gnss_coord_mas (double coord) {
+    // Round magnitude of coordinate in degrees to nearest milliarcsecond. All
+    // further breakdown of the coordinate is done in integer arithmetic.
+    return (int64_t)((coord < 0 ? -coord : coord) * 3600000 + 0.5);
+}
+
+#endif
+
 static void _gnss_handler (int evt) {
     int status;                                 // Return status for API calls.
     struct nrf_modem_gnss_pvt_data_frame pvt;   // PVT solution.
+#if !defined(CONFIG_DATA_LAYOUT_COMPACT)
+    int64_t mas;                                // Coordinate in milliarcsec.
+#endif
 
     // Check event type and handle event accordingly.
     switch (evt) {
@@ -100,57 +176,24 @@ static void _gnss_handler (int evt) {
 
                 _gnss_data_frame.loc.valid = true;
 
-                if (pvt.latitude < 0) {
-                    pvt.latitude = -pvt.latitude;
-                    _gnss_data_frame.loc.lat.dir = "S";
-                } else {
-                    _gnss_data_frame.loc.lat.dir = "N";
-                }
-
-                _gnss_data_frame.loc.lat.deg = (int)(
-                    pvt.latitude
-                );
-                _gnss_data_frame.loc.lat.min = (int)(
-                    60 * pvt.latitude
-                    - 60 * _gnss_data_frame.loc.lat.deg
-                );
-                _gnss_data_frame.loc.lat.sec = (int)(
-                    3600 * pvt.latitude
-                    - 3600 * _gnss_data_frame.loc.lat.deg
-                    - 60 * _gnss_data_frame.loc.lat.min
-                );
-                _gnss_data_frame.loc.lat.msec = (int)(
-                    3600000 * pvt.latitude
-                    - 3600000 * _gnss_data_frame.loc.lat.deg
-                    - 60000 * _gnss_data_frame.loc.lat.min
-                    - 1000 * _gnss_data_frame.loc.lat.sec
-                );
-
-                if (pvt.longitude < 0) {
-                    pvt.longitude = -pvt.longitude;
-                    _gnss_data_frame.loc.lon.dir = "W";
-                } else {
-                    _gnss_data_frame.loc.lon.dir = "E";
-                }
-
-                _gnss_data_frame.loc.lon.deg = (int)(
-                    pvt.longitude
-                );
-                _gnss_data_frame.loc.lon.min = (int)(
-                    60 * pvt.longitude
-                    - 60 * _gnss_data_frame.loc.lon.deg
-                );
-                _gnss_data_frame.loc.lon.sec = (int)(
-                    3600 * pvt.longitude
-                    - 3600 * _gnss_data_frame.loc.lon.deg
-                    - 60 * _gnss_data_frame.loc.lon.min
-                );
-                _gnss_data_frame.loc.lon.msec = (int)(
-                    3600000 * pvt.longitude
-                    - 3600000 * _gnss_data_frame.loc.lon.deg
-                    - 60000 * _gnss_data_frame.loc.lon.min
-                    - 1000 * _gnss_data_frame.loc.lon.sec
-                );
+#if defined(CONFIG_DATA_LAYOUT_COMPACT)
+                _gnss_data_frame.loc.lat = _gnss_coord_udeg(pvt.latitude);
+                _gnss_data_frame.loc.lon = _gnss_coord_udeg(pvt.longitude);
+#else
+                mas = _gnss_coord_mas(pvt.latitude);
+                _gnss_data_frame.loc.lat.dir = pvt.latitude < 0 ? "S" : "N";
+                _gnss_data_frame.loc.lat.deg = (int)(mas / 3600000);
+                _gnss_data_frame.loc.lat.min = (int)(mas / 60000 % 60);
+                _gnss_data_frame.loc.lat.sec = (int)(mas / 1000 % 60);
+                _gnss_data_frame.loc.lat.msec = (int)(mas % 1000);
+
+                mas = _gnss_coord_mas(pvt.longitude);
+                _gnss_data_frame.loc.lon.dir = pvt.longitude < 0 ? "W" : "E";
+                _gnss_data_frame.loc.lon.deg = (int)(mas / 3600000);
+                _gnss_data_frame.loc.lon.min = (int)(mas / 60000 % 60);
+                _gnss_data_frame.loc.lon.sec = (int)(mas / 1000 % 60);
+                _gnss_data_frame.loc.lon.msec = (int)(mas % 1000);
+#endif
 
                 _gnss_data_frame.date.valid = true;
                 _gnss_data_frame.date.year = pvt.datetime.year;
@@ -163,6 +206,18 @@ static void _gnss_handler (int evt) {
                 _gnss_data_frame.time.sec = pvt.datetime.seconds;
                 _gnss_data_frame.time.msec = pvt.datetime.ms;
 
+#if defined(CONFIG_DATA_LAYOUT_COMPACT)
+                LOG_INF(
+                    "Obtained GNSS fix: "
+                    "%d %d (micro-degrees) "
+                    "%04d-%02d-%02d %02d:%02d:%02d.%03d",
+                    _gnss_data_frame.loc.lat, _gnss_data_frame.loc.lon,
+                    _gnss_data_frame.date.year, _gnss_data_frame.date.mon,
+                    _gnss_data_frame.date.day,
+                    _gnss_data_frame.time.hour, _gnss_data_frame.time.min,
+                    _gnss_data_frame.time.sec, _gnss_data_frame.time.msec
+                );
+#else
                 LOG_INF(
                     "Obtained GNSS fix: "
                     "%d°%d'%d.%03d\"%s %d°%d'%d.%03d\"%s "
@@ -178,6 +233,7 @@ static void _gnss_handler (int evt) {
                     _gnss_data_frame.time.hour, _gnss_data_frame.time.min,
                     _gnss_data_frame.time.sec, _gnss_data_frame.time.msec
                 );
+#endif
 
                 // Allow other threads to access shared resources.
                 k_mutex_unlock(&_gnss_data_avail_mutex);
@@ -190,23 +246,31 @@ static void _gnss_handler (int evt) {
 }
 
 int gnss_init (void) {
-    int status; // Return status for API calls.
+    int status;     // Return status for API calls.
+    int64_t start;  // Start time of initialization.
+
+    // Start timing initialization.
+    start = perf_start();
 
     /*
-     * Initialize modem. If an error occurs in this process, exit with failure.
+     * Initialize modem, unless the LTE link is kept registered, in which case
+     * the modem is already initialized. If an error occurs in this process,
+     * exit with failure.
      */
 
-    LOG_INF("Initializing modem");
+    if (!lte_active()) {
+        LOG_INF("Initializing modem");
 
-    // Initialize modem.
-    status = lte_lc_init();
-    if (status < 0) {
-        // On error, exit with failure.
-        LOG_ERR(
-            "Failed to initialize modem (%s)",
-            strerror(-status)
-        );
-        return -1;
+        // Initialize modem.
+        status = lte_lc_init();
+        if (status < 0) {
+            // On error, exit with failure.
+            LOG_ERR(
+                "Failed to initialize modem (%s)",
+                strerror(-status)
+            );
+            return -1;
+        }
     }
 
     /*
@@ -214,7 +278,7 @@ int gnss_init (void) {
      * interface, configure the GNSS to operate in single fix mode by setting
      * the periodic fix interval as well as the fix retry period to zero, and
      * finally register the GNSS event handler. If an error occurs anywhere in
-     * this process, deinitialize the modem and exit with failure.
+     * this process, release the modem and exit with failure.
      */
 
     LOG_INF("Initializing GNSS");
@@ -222,66 +286,48 @@ int gnss_init (void) {
     // Activate GNSS but not LTE.
     status = lte_lc_func_mode_set(LTE_LC_FUNC_MODE_ACTIVATE_GNSS);
     if (status < 0) {
-        // On error, deinitialize modem and exit with failure.
+        // On error, release modem and exit with failure.
         LOG_ERR(
             "Failed to set modem to GNSS active mode (%s)",
             strerror(-status)
         );
-        LOG_WRN("Deinitializing modem");
-        status = lte_lc_deinit();
-        if (status < 0) {
-            LOG_ERR(
-                "Failed to deinitialize modem (%s)",
-                strerror(-status)
-            );
-        }
+        _gnss_release();
         return -1;
     }
 
     // Set periodic fix interval to zero.
     status = nrf_modem_gnss_fix_interval_set(0);
     if (status < 0) {
-        // On error, deinitialize modem and exit with failure.
+        // On error, release modem and exit with failure.
         LOG_ERR(
             "Failed to set GNSS fix interval (%s)",
             strerror(-status)
         );
-        LOG_WRN("Deinitializing modem");
-        status = lte_lc_deinit();
-        if (status < 0) {
-            LOG_ERR(
-                "Failed to deinitialize modem (%s)",
-                strerror(-status)
-            );
-        }
+        _gnss_release();
         return -1;
     }
 
     // Set fix retry interval to zero.
     status = nrf_modem_gnss_fix_retry_set(0);
     if (status < 0) {
-        // On error, deinitialize modem and exit with failure.
+        // On error, release modem and exit with failure.
         LOG_ERR(
             "Failed to set GNSS fix retry period (%s)",
             strerror(-status)
         );
-        LOG_WRN("Deinitializing modem");
-        status = lte_lc_deinit();
-        if (status < 0) {
-            LOG_ERR(
-                "Failed to deinitialize modem (%s)",
-                strerror(-status)
-            );
-        }
+        _gnss_release();
         return -1;
     }
 
     // Register GNSS event handler.
     nrf_modem_gnss_event_handler_set(_gnss_handler);
 
+    // Record initialization time.
+    perf_record(PERF_PHASE_MODEM_INIT, start);
+
     /*
-     *  Start GNSS reception. If an error occurs in this process, deinitialize
-     *  the modem and exit with failure.
+     *  Start GNSS reception. If an error occurs in this process, release the
+     *  modem and exit with failure.
      */
 
     LOG_INF("Starting GNSS");
@@ -289,22 +335,18 @@ int gnss_init (void) {
     // Start GNSS reception.
     status = nrf_modem_gnss_start();
     if (status < 0) {
-        // On error, deinitialize modem and exit with failure.
+        // On error, release modem and exit with failure.
         LOG_ERR(
             "Failed to start GNSS (%s)",
             strerror(-status)
         );
-        LOG_WRN("Deinitializing modem");
-        status = lte_lc_deinit();
-        if (status < 0) {
-            LOG_ERR(
-                "Failed to deinitialize modem (%s)",
-                strerror(-status)
-            );
-        }
+        _gnss_release();
         return -1;
     }
 
+    // Start timing fix.
+    _gnss_fix_start = perf_start();
+
     return 0;
 }
 
@@ -313,7 +355,7 @@ void gnss_deinit (void) {
 
     /*
      * Stop GNSS reception. If an error occurs in this process, report failure
-     * but proceed anyway to deinitialize the modem.
+     * but proceed anyway to release the modem.
      */
 
     LOG_WRN("Stopping GNSS");
@@ -328,21 +370,8 @@ void gnss_deinit (void) {
         );
     }
 
-    /*
-     * Deinitialize modem. If an error occurs in this process, report failure.
-     */
-
-    LOG_WRN("Deinitializing modem");
-
-    // Deinitialize modem.
-    status = lte_lc_deinit();
-    if (status < 0) {
-        // On error, report failure.
-        LOG_ERR(
-            "Failed to deinitialize modem (%s)",
-            strerror(-status)
-        );
-    }
+    // Deactivate GNSS, and deinitialize modem unless LTE link is kept.
+    _gnss_release();
 }
 
 bool gnss_data_avail (void) {
@@ -386,6 +415,12 @@ int gnss_wait_data_avail (void) {
         }
     }
 
+    if (_gnss_fix_start != 0) {
+        // Record time to first fix since reception was started.
+        perf_record(PERF_PHASE_GNSS_FIX, _gnss_fix_start);
+        _gnss_fix_start = 0;
+    }
+
     return 0;
 }
 
@@ -24,10 +24,10 @@
  *  @brief      Initialize GNSS interface.
  *
  *  Powers on and initializes the modem GNSS interface. The LTE interface
- *  remains powered off.
+ *  remains powered off, unless the LTE link was kept registered by lte_park(),
+ *  in which case GNSS runs alongside it while the modem is in PSM.
  *
- *  @note       This function must not be called while the LTE interface is
- *              active.
+ *  @note       This function must not be called during an LTE session.
  *
  *  @retval     0   Success.
  *  @retval     -1  Failure. Interface is powered back off in this case.
@@ -39,7 +39,8 @@ int gnss_init (void);
  *
  *  @brief      Deinitialize GNSS interface.
  *
- *  Deinitializes and powers off the modem GNSS interface.
+ *  Deinitializes and powers off the modem GNSS interface. If the LTE link was
+ *  kept registered, only the GNSS interface is deactivated.
  */
 
 void gnss_deinit (void);
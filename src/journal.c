@@ -0,0 +1,715 @@
+#include <stdbool.h>
+#include <stddef.h>
+#include <stdint.h>
+#include <string.h>
+
+#include <zephyr/kernel.h>
+#include <zephyr/logging/log.h>
+#include <zephyr/device.h>
+#include <zephyr/devicetree.h>
+#include <zephyr/drivers/flash.h>
+
+#include "data.h"
+#include "journal.h"
+
+// Register module for logging.
+LOG_MODULE_REGISTER(journal, CONFIG_JOURNAL_LOG_LEVEL);
+
+// Flash device holding the journal. The "logger,journal" chosen node is used if
+// present, otherwise the first enabled SPI NOR flash device.
+#if DT_HAS_CHOSEN(logger_journal)
+#define JOURNAL_NODE    DT_CHOSEN(logger_journal)
+#else
+#define JOURNAL_NODE    DT_COMPAT_GET_ANY_STATUS_OKAY(jedec_spi_nor)
+#endif
+
+// Journal geometry.
+#define JOURNAL_SECTOR_SIZE     CONFIG_JOURNAL_SECTOR_SIZE
+#define JOURNAL_SECTOR_COUNT \
+    (CONFIG_JOURNAL_SIZE / CONFIG_JOURNAL_SECTOR_SIZE)
+
+BUILD_ASSERT(
+    CONFIG_JOURNAL_SIZE % CONFIG_JOURNAL_SECTOR_SIZE == 0,
+    "Journal size must be a multiple of the sector size"
+);
+BUILD_ASSERT(
+    JOURNAL_SECTOR_COUNT >= 2,
+    "Journal must span at least two sectors"
+);
+
+// Sector header magic value. It identifies the journal format, and changes
+// whenever the format does.
+#define JOURNAL_MAGIC   0x324E524AU
+
+// Frame states. Flash bits can only be cleared without an erase, so each state
+// is reached from the previous one by clearing bits.
+#define JOURNAL_STATE_FREE      0xFF    // Header not yet committed.
+#define JOURNAL_STATE_VALID     0xFE    // Frame stored, not acknowledged.
+#define JOURNAL_STATE_ACKED     0x00    // Frame acknowledged.
+
+// Length value of an erased frame header.
+#define JOURNAL_LEN_FREE        0xFFFF
+
+// Sector header, written at the start of every sector when it is erased. The
+// sequence number increases with every sector opened, which allows the newest
+// sector to be found when recovering the journal. The frame sequence number
+// exceeds those of all frames journaled before the sector was opened, so that
+// frame sequence numbers keep increasing even once older sectors are erased.
+typedef struct {
+    uint32_t magic;     // Magic value.
+    uint32_t seq;       // Sector sequence number.
+    uint32_t frame_seq; // Next frame sequence number.
+} _journal_sector_hdr_t;
+
+// Frame header, written in front of every frame. The sequence number, length
+// and type are written along with the frame contents, and the state byte is
+// written last to commit it.
+typedef struct {
+    uint32_t seq;   // Frame sequence number.
+    uint16_t len;   // Frame length.
+    uint8_t type;   // Frame type.
+    uint8_t state;  // Frame state.
+} _journal_frame_hdr_t;
+
+// Largest frame that fits in a single sector.
+#define JOURNAL_FRAME_MAX ( \
+    JOURNAL_SECTOR_SIZE \
+    - sizeof(_journal_sector_hdr_t) \
+    - sizeof(_journal_frame_hdr_t) \
+)
+
+// Flash device.
+static const struct device * const _journal_dev = DEVICE_DT_GET(JOURNAL_NODE);
+
+// Journal state. The head is the location at which the next frame is written,
+// and the tail is the location of the oldest unacknowledged frame. Mutex
+// protects against concurrent access, as this is a shared resource.
+static K_MUTEX_DEFINE(_journal_mutex);
+static bool _journal_ready = false;
+static uint32_t _journal_head_sector;
+static uint32_t _journal_head_off;
+static uint32_t _journal_head_seq;
+static uint32_t _journal_frame_seq;
+static uint32_t _journal_tail_sector;
+static uint32_t _journal_tail_off;
+static size_t _journal_count[DATA_TYPE_COUNT];
+
+static bool _journal_pending (const _journal_frame_hdr_t * hdr) {
+    // Check if frame is committed, unacknowledged and of a known type.
+    return hdr->state == JOURNAL_STATE_VALID && hdr->type < DATA_TYPE_COUNT;
+}
+
+static off_t _journal_addr (uint32_t sector, uint32_t off) {
+    // Translate sector and offset into flash address.
+    return CONFIG_JOURNAL_OFFSET + (off_t)sector * JOURNAL_SECTOR_SIZE + off;
+}
+
+static int _journal_flash_read (
+    uint32_t sector, uint32_t off, void * buf, size_t len
+) {
+    int status; // Return status for API calls.
+
+    // Read from flash.
+    status = flash_read(_journal_dev, _journal_addr(sector, off), buf, len);
+    if (status < 0) {
+        // On error, exit with failure.
+        LOG_ERR(
+            "Failed to read journal (%s)",
+            strerror(-status)
+        );
+        return -1;
+    }
+
+    return 0;
+}
+
+static int _journal_flash_write (
+    uint32_t sector, uint32_t off, const void * buf, size_t len
+) {
+    int status; // Return status for API calls.
+
+    // Write to flash.
+    status = flash_write(_journal_dev, _journal_addr(sector, off), buf, len);
+    if (status < 0) {
+        // On error, exit with failure.
+        LOG_ERR(
+            "Failed to write journal (%s)",
+            strerror(-status)
+        );
+        return -1;
+    }
+
+    return 0;
+}
+
+static int _journal_open_sector (uint32_t sector, uint32_t seq) {
+    int status;                     // Return status for API calls.
+    _journal_sector_hdr_t hdr;      // Sector header.
+
+    /*
+     * Erase sector and write a fresh sector header into it. If an error occurs
+     * in this process, exit with failure.
+     */
+
+    LOG_DBG("Opening journal sector %u", sector);
+
+    // Erase sector.
+
+    status = flash_erase(
+        _journal_dev, _journal_addr(sector, 0), JOURNAL_SECTOR_SIZE
+    );
+
+    if (status < 0) {
+        // On error, exit with failure.
+        LOG_ERR(
+            "Failed to erase journal sector (%s)",
+            strerror(-status)
+        );
+        return -1;
+    }
+
+    // Write sector header.
+    hdr.magic = JOURNAL_MAGIC;
+    hdr.seq = seq;
+    hdr.frame_seq = _journal_frame_seq;
+    return _journal_flash_write(sector, 0, &hdr, sizeof(hdr));
+}
+
+static int _journal_read_sector_hdr (
+    uint32_t sector, _journal_sector_hdr_t * hdr, bool * valid
+) {
+    int status; // Return status for API calls.
+
+    // Read sector header and check magic value.
+    status = _journal_flash_read(sector, 0, hdr, sizeof(*hdr));
+    if (status < 0) {
+        return -1;
+    }
+
+    *valid = (hdr->magic == JOURNAL_MAGIC);
+
+    return 0;
+}
+
+static int _journal_step (
+    uint32_t * sector, uint32_t * off, _journal_frame_hdr_t * hdr
+) {
+    int status; // Return status for API calls.
+
+    /*
+     * Starting at the given location, find the next location holding a
+     * committed frame header, moving on to the next sector whenever the end of
+     * written data in a sector is reached. Frames whose write was interrupted
+     * are skipped. The head location marks the end of the journal.
+     */
+
+    while (true) {
+        if (*sector == _journal_head_sector && *off >= _journal_head_off) {
+            // Reached head of journal.
+            return -1;
+        }
+
+        if (*off + sizeof(*hdr) <= JOURNAL_SECTOR_SIZE) {
+            // Read frame header.
+            status = _journal_flash_read(*sector, *off, hdr, sizeof(*hdr));
+            if (status < 0) {
+                return -1;
+            }
+
+            if (
+                hdr->len != JOURNAL_LEN_FREE
+                && *off + sizeof(*hdr) + hdr->len <= JOURNAL_SECTOR_SIZE
+            ) {
+                if (hdr->state != JOURNAL_STATE_FREE) {
+                    // Found committed frame.
+                    return 0;
+                }
+
+                // Skip frame whose write was interrupted.
+                *off += sizeof(*hdr) + hdr->len;
+                continue;
+            }
+        }
+
+        // No further frames in this sector, move on to next sector.
+        *sector = (*sector + 1) % JOURNAL_SECTOR_COUNT;
+        *off = sizeof(_journal_sector_hdr_t);
+    }
+}
+
+static int _journal_skip_acked (void) {
+    int status;                 // Return status for API calls.
+    _journal_frame_hdr_t hdr;   // Frame header.
+
+    /*
+     * Advance tail past any acknowledged frames, so that it points to the
+     * oldest unacknowledged frame or to the head.
+     */
+
+    while (true) {
+        status = _journal_step(&_journal_tail_sector, &_journal_tail_off, &hdr);
+        if (status < 0 || _journal_pending(&hdr)) {
+            break;
+        }
+        _journal_tail_off += sizeof(hdr) + hdr.len;
+    }
+
+    return 0;
+}
+
+static int _journal_find (
+    data_type_t type, uint32_t * sector, uint32_t * off,
+    _journal_frame_hdr_t * hdr
+) {
+    int status; // Return status for API calls.
+
+    // Starting at the given location, find the next unacknowledged frame of the
+    // given type.
+    while (true) {
+        status = _journal_step(sector, off, hdr);
+        if (status < 0) {
+            return -1;
+        }
+        if (_journal_pending(hdr) && hdr->type == type) {
+            return 0;
+        }
+        *off += sizeof(*hdr) + hdr->len;
+    }
+}
+
+static int _journal_recover (void) {
+    int status;                     // Return status for API calls.
+    _journal_sector_hdr_t shdr;     // Sector header.
+    _journal_frame_hdr_t fhdr;      // Frame header.
+    bool valid;                     // Sector header valid.
+    bool found = false;             // Any valid sector found.
+    uint32_t sector;                // Sector index.
+    uint32_t off;                   // Offset within sector.
+    uint32_t n;                     // Number of sectors in journal.
+
+    /*
+     * Find the newest sector, which holds the head of the journal. If no valid
+     * sector is found, start a new journal.
+     */
+
+    for (sector = 0; sector < JOURNAL_SECTOR_COUNT; sector++) {
+        status = _journal_read_sector_hdr(sector, &shdr, &valid);
+        if (status < 0) {
+            return -1;
+        }
+
+        if (valid && (!found || (int32_t)(shdr.seq - _journal_head_seq) > 0)) {
+            found = true;
+            _journal_head_sector = sector;
+            _journal_head_seq = shdr.seq;
+            _journal_frame_seq = shdr.frame_seq;
+        }
+    }
+
+    if (!found) {
+        LOG_WRN("No journal found, creating new journal");
+
+        _journal_frame_seq = 0;
+
+        status = _journal_open_sector(0, 0);
+        if (status < 0) {
+            return -1;
+        }
+
+        _journal_head_sector = 0;
+        _journal_head_off = sizeof(_journal_sector_hdr_t);
+        _journal_head_seq = 0;
+        _journal_tail_sector = 0;
+        _journal_tail_off = _journal_head_off;
+        memset(_journal_count, 0, sizeof(_journal_count));
+
+        return 0;
+    }
+
+    /*
+     * Find the end of written data in the head sector, and the next frame
+     * sequence number, which follows that of the newest frame. A frame whose
+     * header was not committed indicates an interrupted write, in which case
+     * the rest of the sector is abandoned.
+     */
+
+    off = sizeof(_journal_sector_hdr_t);
+
+    while (off + sizeof(fhdr) <= JOURNAL_SECTOR_SIZE) {
+        status = _journal_flash_read(
+            _journal_head_sector, off, &fhdr, sizeof(fhdr)
+        );
+        if (status < 0) {
+            return -1;
+        }
+
+        if (fhdr.state == JOURNAL_STATE_FREE) {
+            if (fhdr.len != JOURNAL_LEN_FREE) {
+                LOG_WRN("Interrupted journal write detected");
+                off = JOURNAL_SECTOR_SIZE;
+            }
+            break;
+        }
+
+        if ((int32_t)(fhdr.seq + 1 - _journal_frame_seq) > 0) {
+            _journal_frame_seq = fhdr.seq + 1;
+        }
+
+        off += sizeof(fhdr) + fhdr.len;
+    }
+
+    _journal_head_off = MIN(off, JOURNAL_SECTOR_SIZE);
+
+    /*
+     * Walk backwards from the head sector over sectors with consecutive
+     * sequence numbers to find the oldest sector still in the journal.
+     */
+
+    for (n = 1; n < JOURNAL_SECTOR_COUNT; n++) {
+        sector = (
+            _journal_head_sector + JOURNAL_SECTOR_COUNT - n
+        ) % JOURNAL_SECTOR_COUNT;
+
+        status = _journal_read_sector_hdr(sector, &shdr, &valid);
+        if (status < 0) {
+            return -1;
+        }
+
+        if (!valid || shdr.seq != _journal_head_seq - n) {
+            break;
+        }
+    }
+
+    _journal_tail_sector = (
+        _journal_head_sector + JOURNAL_SECTOR_COUNT - (n - 1)
+    ) % JOURNAL_SECTOR_COUNT;
+    _journal_tail_off = sizeof(_journal_sector_hdr_t);
+
+    /*
+     * Advance tail to the oldest unacknowledged frame, and count the
+     * unacknowledged frames from there to the head.
+     */
+
+    _journal_skip_acked();
+
+    memset(_journal_count, 0, sizeof(_journal_count));
+    sector = _journal_tail_sector;
+    off = _journal_tail_off;
+
+    while (_journal_step(&sector, &off, &fhdr) == 0) {
+        if (_journal_pending(&fhdr)) {
+            _journal_count[fhdr.type]++;
+        }
+        off += sizeof(fhdr) + fhdr.len;
+    }
+
+    return 0;
+}
+
+static int _journal_drop_sector (uint32_t sector) {
+    int status;                 // Return status for API calls.
+    _journal_frame_hdr_t hdr;   // Frame header.
+
+    /*
+     * Discard all unacknowledged frames in the sector holding the tail, and
+     * move the tail to the start of the following sector.
+     */
+
+    while (_journal_tail_sector == sector) {
+        status = _journal_step(
+            &_journal_tail_sector, &_journal_tail_off, &hdr
+        );
+        if (status < 0) {
+            break;
+        }
+        if (_journal_tail_sector != sector) {
+            break;
+        }
+        if (_journal_pending(&hdr)) {
+            _journal_count[hdr.type]--;
+            LOG_WRN("Journal full, discarding oldest data frame");
+        }
+        _journal_tail_off += sizeof(hdr) + hdr.len;
+    }
+
+    if (_journal_tail_sector == sector) {
+        _journal_tail_sector = (sector + 1) % JOURNAL_SECTOR_COUNT;
+        _journal_tail_off = sizeof(_journal_sector_hdr_t);
+    }
+
+    return 0;
+}
+
+int journal_init (void) {
+    int status;                             // Return status for API calls.
+    const struct flash_parameters * params; // Flash parameters.
+    size_t count = 0;                       // Number of recovered frames.
+
+    /*
+     * Check that the flash device is ready and supports the single-byte
+     * writes and erase value that the journal format relies on. If not, exit
+     * with failure.
+     */
+
+    LOG_INF("Initializing journal");
+
+    if (!device_is_ready(_journal_dev)) {
+        LOG_ERR("Failed to initialize journal (Flash device not ready)");
+        return -1;
+    }
+
+    params = flash_get_parameters(_journal_dev);
+    if (params->write_block_size != 1 || params->erase_value != 0xFF) {
+        LOG_ERR("Failed to initialize journal (Unsupported flash device)");
+        return -1;
+    }
+
+    /*
+     * Recover journal state from flash. If an error occurs in this process,
+     * exit with failure.
+     */
+
+    // Block other threads from accessing shared resources.
+    k_mutex_lock(&_journal_mutex, K_FOREVER);
+
+    status = _journal_recover();
+    if (status == 0) {
+        _journal_ready = true;
+        for (data_type_t type = 0; type < DATA_TYPE_COUNT; type++) {
+            count += _journal_count[type];
+        }
+        LOG_INF("Journal recovered with %u unacknowledged data frames", count);
+    }
+
+    // Allow other threads to access shared resources.
+    k_mutex_unlock(&_journal_mutex);
+
+    return status;
+}
+
+int journal_append (
+    data_type_t type, uint32_t seq, const void * frame, size_t len
+) {
+    int status;                 // Return status for API calls.
+    _journal_frame_hdr_t hdr;   // Frame header.
+    uint32_t next;              // Index of next sector.
+
+    /*
+     * Check that the journal is ready and that the frame fits in a sector. If
+     * not, exit with failure.
+     */
+
+    if (!_journal_ready) {
+        LOG_ERR("Failed to append to journal (Not initialized)");
+        return -1;
+    }
+
+    if (len > JOURNAL_FRAME_MAX) {
+        LOG_ERR("Failed to append to journal (Frame too large)");
+        return -1;
+    }
+
+    // Block other threads from accessing shared resources.
+    k_mutex_lock(&_journal_mutex, K_FOREVER);
+
+    /*
+     * If the frame does not fit in the rest of the head sector, open the next
+     * sector. If that sector still holds unacknowledged frames, they are
+     * discarded.
+     */
+
+    if (_journal_head_off + sizeof(hdr) + len > JOURNAL_SECTOR_SIZE) {
+        next = (_journal_head_sector + 1) % JOURNAL_SECTOR_COUNT;
+
+        if (next == _journal_tail_sector) {
+            _journal_drop_sector(next);
+        }
+
+        status = _journal_open_sector(next, _journal_head_seq + 1);
+        if (status < 0) {
+            k_mutex_unlock(&_journal_mutex);
+            return -1;
+        }
+
+        _journal_head_sector = next;
+        _journal_head_off = sizeof(_journal_sector_hdr_t);
+        _journal_head_seq++;
+    }
+
+    /*
+     * Write frame header without state, then frame contents, and finally the
+     * state byte to commit the frame. An interrupted write therefore never
+     * leaves a committed frame with incomplete contents.
+     */
+
+    hdr.seq = seq;
+    hdr.len = (uint16_t)len;
+    hdr.type = (uint8_t)type;
+    hdr.state = JOURNAL_STATE_VALID;
+
+    status = _journal_flash_write(
+        _journal_head_sector, _journal_head_off,
+        &hdr, offsetof(_journal_frame_hdr_t, state)
+    );
+
+    if (status == 0) {
+        status = _journal_flash_write(
+            _journal_head_sector, _journal_head_off + sizeof(hdr), frame, len
+        );
+    }
+
+    if (status == 0) {
+        status = _journal_flash_write(
+            _journal_head_sector,
+            _journal_head_off + offsetof(_journal_frame_hdr_t, state),
+            &hdr.state, sizeof(hdr.state)
+        );
+    }
+
+    // Advance head past the frame even on error, so the location is not reused.
+    _journal_head_off += sizeof(hdr) + len;
+
+    // Keep frame sequence number ahead of that of the frame.
+    if ((int32_t)(seq + 1 - _journal_frame_seq) > 0) {
+        _journal_frame_seq = seq + 1;
+    }
+
+    if (status == 0) {
+        _journal_count[type]++;
+        LOG_DBG(
+            "Journaled data frame (%u unacknowledged)", _journal_count[type]
+        );
+    }
+
+    // Allow other threads to access shared resources.
+    k_mutex_unlock(&_journal_mutex);
+
+    return status;
+}
+
+size_t journal_count (data_type_t type) {
+    size_t count;   // Non-shared copy of frame count.
+
+    // Safely copy frame count to non-shared variable.
+    k_mutex_lock(&_journal_mutex, K_FOREVER);
+    count = _journal_count[type];
+    k_mutex_unlock(&_journal_mutex);
+
+    return count;
+}
+
+uint32_t journal_seq (void) {
+    uint32_t seq;   // Non-shared copy of frame sequence number.
+
+    // Safely copy frame sequence number to non-shared variable.
+    k_mutex_lock(&_journal_mutex, K_FOREVER);
+    seq = _journal_frame_seq;
+    k_mutex_unlock(&_journal_mutex);
+
+    return seq;
+}
+
+int journal_first (data_type_t type, journal_entry_t * entry) {
+    int status;                 // Return status for API calls.
+    _journal_frame_hdr_t hdr;   // Frame header.
+
+    // Block other threads from accessing shared resources.
+    k_mutex_lock(&_journal_mutex, K_FOREVER);
+
+    // Locate first frame of given type, starting at tail.
+    entry->sector = _journal_tail_sector;
+    entry->off = _journal_tail_off;
+    status = _journal_find(type, &entry->sector, &entry->off, &hdr);
+    entry->len = hdr.len;
+    entry->seq = hdr.seq;
+
+    // Allow other threads to access shared resources.
+    k_mutex_unlock(&_journal_mutex);
+
+    return status;
+}
+
+int journal_next (data_type_t type, journal_entry_t * entry) {
+    int status;                 // Return status for API calls.
+    _journal_frame_hdr_t hdr;   // Frame header.
+
+    // Block other threads from accessing shared resources.
+    k_mutex_lock(&_journal_mutex, K_FOREVER);
+
+    // Locate frame of given type following the given one.
+    entry->off += sizeof(hdr) + entry->len;
+    status = _journal_find(type, &entry->sector, &entry->off, &hdr);
+    entry->len = hdr.len;
+    entry->seq = hdr.seq;
+
+    // Allow other threads to access shared resources.
+    k_mutex_unlock(&_journal_mutex);
+
+    return status;
+}
+
+int journal_read (const journal_entry_t * entry, void * buf) {
+    // Read frame contents following frame header.
+    return _journal_flash_read(
+        entry->sector, entry->off + sizeof(_journal_frame_hdr_t),
+        buf, entry->len
+    );
+}
+
+int journal_ack (data_type_t type, uint32_t first, uint32_t last) {
+    int status = 0;                         // Return status for API calls.
+    _journal_frame_hdr_t hdr;               // Frame header.
+    uint8_t state = JOURNAL_STATE_ACKED;    // Acknowledged state.
+    uint32_t sector;                        // Sector of current frame.
+    uint32_t off;                           // Offset of current frame.
+    size_t acked = 0;                       // Number of frames acknowledged.
+
+    // Block other threads from accessing shared resources.
+    k_mutex_lock(&_journal_mutex, K_FOREVER);
+
+    /*
+     * Mark the oldest frames of the given type whose sequence numbers lie in
+     * the given range as acknowledged, and then advance the tail past any
+     * acknowledged frames. Frames of a type are journaled in order of their
+     * sequence numbers, so the range ends at the first frame beyond it. If an
+     * error occurs in this process, exit with failure.
+     */
+
+    sector = _journal_tail_sector;
+    off = _journal_tail_off;
+
+    while (_journal_count[type] > 0) {
+        if (_journal_find(type, &sector, &off, &hdr) < 0) {
+            break;
+        }
+
+        if (hdr.seq - first > last - first) {
+            // Skip frame before range, or stop at frame beyond it.
+            if (acked > 0) {
+                break;
+            }
+            off += sizeof(hdr) + hdr.len;
+            continue;
+        }
+
+        status = _journal_flash_write(
+            sector, off + offsetof(_journal_frame_hdr_t, state),
+            &state, sizeof(state)
+        );
+
+        if (status < 0) {
+            break;
+        }
+
+        off += sizeof(hdr) + hdr.len;
+        _journal_count[type]--;
+        acked++;
+    }
+
+    _journal_skip_acked();
+
+    // Allow other threads to access shared resources.
+    k_mutex_unlock(&_journal_mutex);
+
+    return status;
+}
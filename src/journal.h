@@ -0,0 +1,174 @@
+/** @defgroup   journal Journal
+ *
+ *  @brief      Persistent data frame storage.
+ *
+ *  This module stores encoded data frames in an append-only journal on external
+ *  flash memory, so that frames awaiting upload survive reboots and long
+ *  periods without network coverage. The journal must be initialized by calling
+ *  journal_init(), which recovers its state from flash. Frames are added to the
+ *  journal by calling journal_append(), and tagged with their data frame type
+ *  and sequence number. The sequence number following that of the newest frame
+ *  ever journaled is recovered along with the journal, and can be obtained
+ *  with journal_seq(). The number of unacknowledged frames of a type can be
+ *  checked with journal_count(). Unacknowledged frames of a type can be
+ *  traversed from oldest to newest with journal_first() and journal_next(),
+ *  and their contents read with journal_read(). Once frames have been
+ *  delivered, they are marked as acknowledged by their range of sequence
+ *  numbers by calling journal_ack(). The read cursor advances past frames once
+ *  they, and all frames preceding them, have been acknowledged.
+ *
+ *  The journal occupies a configurable region of flash memory, divided into
+ *  erase sectors that are written in circular order. Every sector is therefore
+ *  erased equally often. When the journal is full, the sector holding the
+ *  oldest frames is erased to make room for new ones, and those frames are
+ *  lost.
+ */
+
+#ifndef __JOURNAL_H__
+#define __JOURNAL_H__
+
+#include <stddef.h>
+#include <stdint.h>
+
+#include "data.h"
+
+/** @ingroup    journal
+ *
+ *  @brief      Journal entry.
+ *
+ *  This structure identifies the location of a frame stored in the journal. It
+ *  is filled in by journal_first() and journal_next().
+ */
+
+typedef struct {
+    uint32_t sector;    //!< Index of sector containing the frame.
+    uint32_t off;       //!< Offset of frame header within sector.
+    uint16_t len;       //!< Length of frame contents.
+    uint32_t seq;       //!< Sequence number of frame.
+} journal_entry_t;
+
+/** @ingroup    journal
+ *
+ *  @brief      Initialize journal.
+ *
+ *  Checks the flash device and recovers the journal state from flash. If no
+ *  journal is found, a new, empty journal is created.
+ *
+ *  @retval     0   Success.
+ *  @retval     -1  Failure.
+ */
+
+int journal_init (void);
+
+/** @ingroup    journal
+ *
+ *  @brief      Append frame to journal.
+ *
+ *  Writes the given frame to the end of the journal, along with its sequence
+ *  number. If the journal is full, the sector holding the oldest frames is
+ *  erased first.
+ *
+ *  @param      type    Data frame type.
+ *  @param      seq     Frame sequence number.
+ *  @param      frame   Pointer to buffer containing frame.
+ *  @param      len     Length of frame.
+ *
+ *  @retval     0       Success.
+ *  @retval     -1      Failure.
+ */
+
+int journal_append (
+    data_type_t type, uint32_t seq, const void * frame, size_t len
+);
+
+/** @ingroup    journal
+ *
+ *  @brief      Obtain next frame sequence number.
+ *
+ *  Obtains the sequence number following that of the newest frame ever
+ *  written to the journal, including frames that have since been acknowledged
+ *  or discarded.
+ *
+ *  @return     Next frame sequence number.
+ */
+
+uint32_t journal_seq (void);
+
+/** @ingroup    journal
+ *
+ *  @brief      Count unacknowledged frames.
+ *
+ *  Obtains the number of frames of the given type in the journal that have not
+ *  yet been acknowledged.
+ *
+ *  @param      type    Data frame type.
+ *
+ *  @return     Number of unacknowledged frames.
+ */
+
+size_t journal_count (data_type_t type);
+
+/** @ingroup    journal
+ *
+ *  @brief      Locate oldest unacknowledged frame.
+ *
+ *  @param      type    Data frame type.
+ *  @param      entry   Pointer to entry into which location of the oldest
+ *                      unacknowledged frame of the given type must be written.
+ *
+ *  @retval     0       Success.
+ *  @retval     -1      Failure. Journal contains no unacknowledged frames of
+ *                      the given type.
+ */
+
+int journal_first (data_type_t type, journal_entry_t * entry);
+
+/** @ingroup    journal
+ *
+ *  @brief      Locate following frame.
+ *
+ *  @param      type    Data frame type.
+ *  @param      entry   Pointer to entry containing location of a frame, which
+ *                      must be overwritten with the location of the following
+ *                      unacknowledged frame of the given type.
+ *
+ *  @retval     0       Success.
+ *  @retval     -1      Failure. No further frames of the given type.
+ */
+
+int journal_next (data_type_t type, journal_entry_t * entry);
+
+/** @ingroup    journal
+ *
+ *  @brief      Read frame contents.
+ *
+ *  @param      entry   Pointer to entry containing location of frame.
+ *  @param      buf     Pointer to buffer into which frame contents must be
+ *                      written. Must be at least entry->len bytes long.
+ *
+ *  @retval     0       Success.
+ *  @retval     -1      Failure.
+ */
+
+int journal_read (const journal_entry_t * entry, void * buf);
+
+/** @ingroup    journal
+ *
+ *  @brief      Acknowledge frames.
+ *
+ *  Marks the unacknowledged frames of the given type whose sequence numbers lie
+ *  within the given range as acknowledged. Frames that are no longer in the
+ *  journal are skipped. The acknowledgement is written to flash and persists
+ *  across reboots.
+ *
+ *  @param      type    Data frame type.
+ *  @param      first   Sequence number of first frame to acknowledge.
+ *  @param      last    Sequence number of last frame to acknowledge.
+ *
+ *  @retval     0       Success.
+ *  @retval     -1      Failure.
+ */
+
+int journal_ack (data_type_t type, uint32_t first, uint32_t last);
+
+#endif
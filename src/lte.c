@@ -1,4 +1,5 @@
 #include <stdbool.h>
+#include <stdint.h>
 #include <string.h>
 
 #include <zephyr/kernel.h>
@@ -7,6 +8,7 @@
 #include <modem/lte_lc.h>
 
 #include "data.h"
+#include "perf.h"
 
 // Register module for logging.
 LOG_MODULE_REGISTER(lte, CONFIG_LTE_LOG_LEVEL);
@@ -42,6 +44,10 @@ static lte_data_frame_t _lte_data_frame = {
     },
     .psm = {
         .valid = false,
+#if defined(CONFIG_DATA_LAYOUT_COMPACT)
+        .tau = 0,
+        .at = 0
+#else
         .tau = {
             .day = 0,
             .hour = 0,
@@ -53,10 +59,15 @@ static lte_data_frame_t _lte_data_frame = {
             .min = 0,
             .sec = 0
         }
+#endif
     },
     .edrx = {
         .valid = false,
         .mode = "",
+#if defined(CONFIG_DATA_LAYOUT_COMPACT)
+        .edrx = 0,
+        .ptw = 0
+#else
         .edrx = {
             .hour = 0,
             .min = 0,
@@ -67,10 +78,88 @@ static lte_data_frame_t _lte_data_frame = {
             .sec = 0,
             .msec = 0
         }
+#endif
     }
 };
 
+// Link state and statistics. The active flag indicates whether or not the LTE
+// interface is initialized, which may outlast a session if the link is kept
+// registered. The attach start time is the time at which the current attach
+// began, and is only meaningful while not registered. Mutex protects against
+// concurrent access, as these are shared resources.
+static K_MUTEX_DEFINE(_lte_stats_mutex);
+static bool _lte_active = false;
+static int64_t _lte_attach_start = 0;
+static lte_stats_t _lte_stats = {
+    .sessions = 0,
+    .resumed = 0,
+    .attaches = 0,
+    .attach_ms = 0
+};
+
+static void _lte_attach_begin (void) {
+    // Record start of attach, unless one is already under way.
+    k_mutex_lock(&_lte_stats_mutex, K_FOREVER);
+    if (_lte_attach_start == 0) {
+        _lte_attach_start = k_uptime_get();
+    }
+    k_mutex_unlock(&_lte_stats_mutex);
+}
+
+static void _lte_attach_end (void) {
+    // Count completed attach and the time it took.
+    k_mutex_lock(&_lte_stats_mutex, K_FOREVER);
+    if (_lte_attach_start != 0) {
+        perf_record(PERF_PHASE_ATTACH, _lte_attach_start);
+        _lte_stats.attaches++;
+        _lte_stats.attach_ms += (uint32_t)(
+            k_uptime_get() - _lte_attach_start
+        );
+        _lte_attach_start = 0;
+    }
+    k_mutex_unlock(&_lte_stats_mutex);
+}
+
+static void _lte_set_psm (int tau, int at) {
+    // Store PSM timer values, given in seconds, in data frame. Caller must
+    // hold data frame mutex.
+#if defined(CONFIG_DATA_LAYOUT_COMPACT)
+    _lte_data_frame.psm.tau = tau;
+    _lte_data_frame.psm.at = at;
+#else
+    _lte_data_frame.psm.tau.day = tau / 86400;
+    _lte_data_frame.psm.tau.hour = tau / 3600 % 24;
+    _lte_data_frame.psm.tau.min = tau / 60 % 60;
+    _lte_data_frame.psm.tau.sec = tau % 60;
+
+    _lte_data_frame.psm.at.hour = at / 3600;
+    _lte_data_frame.psm.at.min = at / 60 % 60;
+    _lte_data_frame.psm.at.sec = at % 60;
+#endif
+}
+
+static void _lte_set_edrx (const char * mode, int edrx, int ptw) {
+    // Store eDRX network mode, and timer values, given in milliseconds, in data
+    // frame. Caller must hold data frame mutex.
+    _lte_data_frame.edrx.mode = mode;
+#if defined(CONFIG_DATA_LAYOUT_COMPACT)
+    _lte_data_frame.edrx.edrx = edrx;
+    _lte_data_frame.edrx.ptw = ptw;
+#else
+    _lte_data_frame.edrx.edrx.hour = edrx / 3600000;
+    _lte_data_frame.edrx.edrx.min = edrx / 60000 % 60;
+    _lte_data_frame.edrx.edrx.sec = edrx / 1000 % 60;
+    _lte_data_frame.edrx.edrx.msec = edrx % 1000;
+
+    _lte_data_frame.edrx.ptw.sec = ptw / 1000;
+    _lte_data_frame.edrx.ptw.msec = ptw % 1000;
+#endif
+}
+
 static void _lte_handler (const struct lte_lc_evt * const evt) {
+    int edrx;   // eDRX time interval in milliseconds.
+    int ptw;    // eDRX paging time window in milliseconds.
+
     // Check event type and handle event accordingly.
     switch (evt->type) {
         case LTE_LC_EVT_RRC_UPDATE:
@@ -110,6 +199,7 @@ static void _lte_handler (const struct lte_lc_evt * const evt) {
                      * is unavailable.
                      */
                     LOG_INF("Searching for LTE network");
+                    _lte_attach_begin();
                     k_sem_take(&_lte_conn_avail_sem, K_NO_WAIT);
                     _lte_conn_avail_flag = false;
                     break;
@@ -119,6 +209,7 @@ static void _lte_handler (const struct lte_lc_evt * const evt) {
                      * connection is available.
                      */
                     LOG_INF("Connected to LTE home network");
+                    _lte_attach_end();
                     k_sem_give(&_lte_conn_avail_sem);
                     _lte_conn_avail_flag = true;
                     break;
@@ -128,6 +219,7 @@ static void _lte_handler (const struct lte_lc_evt * const evt) {
                      * connection is available.
                      */
                     LOG_INF("Connected to LTE roaming network");
+                    _lte_attach_end();
                     k_sem_give(&_lte_conn_avail_sem);
                     _lte_conn_avail_flag = true;
                     break;
@@ -275,59 +367,16 @@ static void _lte_handler (const struct lte_lc_evt * const evt) {
             // Update data frame.
             if (evt->psm_cfg.tau < 0 || evt->psm_cfg.active_time < 0) {
                 _lte_data_frame.psm.valid = false;
-
-                _lte_data_frame.psm.tau.day = 0;
-                _lte_data_frame.psm.tau.hour = 0;
-                _lte_data_frame.psm.tau.min = 0;
-                _lte_data_frame.psm.tau.sec = 0;
-
-                _lte_data_frame.psm.at.hour = 0;
-                _lte_data_frame.psm.at.min = 0;
-                _lte_data_frame.psm.at.sec = 0;
+                _lte_set_psm(0, 0);
 
                 LOG_WRN("PSM parameters rejected");
             } else {
                 _lte_data_frame.psm.valid = true;
-
-                _lte_data_frame.psm.tau.day = (int)(
-                    evt->psm_cfg.tau / 86400
-                );
-                _lte_data_frame.psm.tau.hour = (int)(
-                    evt->psm_cfg.tau / 3600
-                    - 24 * _lte_data_frame.psm.tau.day
-                );
-                _lte_data_frame.psm.tau.min = (int)(
-                    evt->psm_cfg.tau / 60
-                    - 1440 * _lte_data_frame.psm.tau.day
-                    - 60 * _lte_data_frame.psm.tau.hour
-                );
-                _lte_data_frame.psm.tau.sec = (int)(
-                    evt->psm_cfg.tau
-                    - 86400 * _lte_data_frame.psm.tau.day
-                    - 3600 * _lte_data_frame.psm.tau.hour
-                    - 60 * _lte_data_frame.psm.tau.min
-                );
-
-                _lte_data_frame.psm.at.hour = (int)(
-                    evt->psm_cfg.active_time / 3600
-                );
-                _lte_data_frame.psm.at.min = (int)(
-                    evt->psm_cfg.active_time / 60
-                    - 60 * _lte_data_frame.psm.at.hour
-                );
-                _lte_data_frame.psm.at.sec = (int)(
-                    evt->psm_cfg.active_time
-                    - 3600 * _lte_data_frame.psm.at.hour
-                    - 60 * _lte_data_frame.psm.at.min
-                );
+                _lte_set_psm(evt->psm_cfg.tau, evt->psm_cfg.active_time);
 
                 LOG_INF(
-                    "PSM parameters granted: "
-                    "TAU: %dd:%dh:%dm:%ds, AT: %dh:%dm:%ds",
-                    _lte_data_frame.psm.tau.day, _lte_data_frame.psm.tau.hour,
-                    _lte_data_frame.psm.tau.min, _lte_data_frame.psm.tau.sec,
-                    _lte_data_frame.psm.at.hour, _lte_data_frame.psm.at.min,
-                    _lte_data_frame.psm.at.sec
+                    "PSM parameters granted: TAU: %ds, AT: %ds",
+                    evt->psm_cfg.tau, evt->psm_cfg.active_time
                 );
             }
 
@@ -354,103 +403,29 @@ static void _lte_handler (const struct lte_lc_evt * const evt) {
             switch (evt->edrx_cfg.mode) {
                 case LTE_LC_LTE_MODE_NONE:
                     _lte_data_frame.edrx.valid = false;
-
-                    _lte_data_frame.edrx.mode = "";
-
-                    _lte_data_frame.edrx.edrx.hour = 0;
-                    _lte_data_frame.edrx.edrx.min = 0;
-                    _lte_data_frame.edrx.edrx.sec = 0;
-                    _lte_data_frame.edrx.edrx.msec = 0;
-
-                    _lte_data_frame.edrx.ptw.sec = 0;
-                    _lte_data_frame.edrx.ptw.msec = 0;
+                    _lte_set_edrx("", 0, 0);
 
                     LOG_WRN("eDRX parameters rejected");
                     break;
                 case LTE_LC_LTE_MODE_LTEM:
-                    _lte_data_frame.edrx.valid = true;
-
-                    _lte_data_frame.edrx.mode = "LTE-M";
-
-                    _lte_data_frame.edrx.edrx.hour = (int)(
-                        evt->edrx_cfg.edrx / 3600
-                    );
-                    _lte_data_frame.edrx.edrx.min = (int)(
-                        evt->edrx_cfg.edrx / 60
-                        - 60 * _lte_data_frame.edrx.edrx.hour
-                    );
-                    _lte_data_frame.edrx.edrx.sec = (int)(
-                        evt->edrx_cfg.edrx
-                        - 3600 * _lte_data_frame.edrx.edrx.hour
-                        - 60 * _lte_data_frame.edrx.edrx.min
-                    );
-                    _lte_data_frame.edrx.edrx.msec = (int)(
-                        1000 * evt->edrx_cfg.edrx
-                        - 3600000 * _lte_data_frame.edrx.edrx.hour
-                        - 60000 * _lte_data_frame.edrx.edrx.min
-                        - 1000 * _lte_data_frame.edrx.edrx.sec
-                    );
-
-                    _lte_data_frame.edrx.ptw.sec = (int)(
-                        evt->edrx_cfg.ptw
-                    );
-                    _lte_data_frame.edrx.ptw.msec = (int)(
-                        1000 * evt->edrx_cfg.ptw
-                        - 1000 * _lte_data_frame.edrx.ptw.sec
-                    );
-
-                    LOG_INF(
-                        "eDRX parameters granted: "
-                        "Mode: LTE-M, eDRX: %dh:%dm:%d.%03ds, PTW: %d.%03ds",
-                        _lte_data_frame.edrx.edrx.hour,
-                        _lte_data_frame.edrx.edrx.min,
-                        _lte_data_frame.edrx.edrx.sec,
-                        _lte_data_frame.edrx.edrx.msec,
-                        _lte_data_frame.edrx.ptw.sec,
-                        _lte_data_frame.edrx.ptw.msec
-                    );
-                    break;
                 case LTE_LC_LTE_MODE_NBIOT:
-                    _lte_data_frame.edrx.valid = true;
+                    // Timer values are reported in seconds, as floating-point
+                    // numbers. Convert them once to milliseconds.
+                    edrx = (int)(1000 * evt->edrx_cfg.edrx + 0.5f);
+                    ptw = (int)(1000 * evt->edrx_cfg.ptw + 0.5f);
 
-                    _lte_data_frame.edrx.mode = "NB-IoT";
-
-                    _lte_data_frame.edrx.edrx.hour = (int)(
-                        evt->edrx_cfg.edrx / 3600
-                    );
-                    _lte_data_frame.edrx.edrx.min = (int)(
-                        evt->edrx_cfg.edrx / 60
-                        - 60 * _lte_data_frame.edrx.edrx.hour
-                    );
-                    _lte_data_frame.edrx.edrx.sec = (int)(
-                        evt->edrx_cfg.edrx
-                        - 3600 * _lte_data_frame.edrx.edrx.hour
-                        - 60 * _lte_data_frame.edrx.edrx.min
-                    );
-                    _lte_data_frame.edrx.edrx.msec = (int)(
-                        1000 * evt->edrx_cfg.edrx
-                        - 3600000 * _lte_data_frame.edrx.edrx.hour
-                        - 60000 * _lte_data_frame.edrx.edrx.min
-                        - 1000 * _lte_data_frame.edrx.edrx.sec
-                    );
-
-                    _lte_data_frame.edrx.ptw.sec = (int)(
-                        evt->edrx_cfg.ptw
-                    );
-                    _lte_data_frame.edrx.ptw.msec = (int)(
-                        1000 * evt->edrx_cfg.ptw
-                        - 1000 * _lte_data_frame.edrx.ptw.sec
+                    _lte_data_frame.edrx.valid = true;
+                    _lte_set_edrx(
+                        evt->edrx_cfg.mode == LTE_LC_LTE_MODE_LTEM
+                            ? "LTE-M" : "NB-IoT",
+                        edrx, ptw
                     );
 
                     LOG_INF(
                         "eDRX parameters granted: "
-                        "Mode: NB-IoT, eDRX: %dh:%dm:%d.%03ds, PTW: %d.%03ds",
-                        _lte_data_frame.edrx.edrx.hour,
-                        _lte_data_frame.edrx.edrx.min,
-                        _lte_data_frame.edrx.edrx.sec,
-                        _lte_data_frame.edrx.edrx.msec,
-                        _lte_data_frame.edrx.ptw.sec,
-                        _lte_data_frame.edrx.ptw.msec
+                        "Mode: %s, eDRX: %d.%03ds, PTW: %d.%03ds",
+                        _lte_data_frame.edrx.mode,
+                        edrx / 1000, edrx % 1000, ptw / 1000, ptw % 1000
                     );
                     break;
             }
@@ -465,7 +440,30 @@ static void _lte_handler (const struct lte_lc_evt * const evt) {
 }
 
 int lte_init (void) {
-    int status; // Return status for API calls.
+    int status;     // Return status for API calls.
+    bool active;    // Non-shared copy of active flag.
+    int64_t start;  // Start time of initialization.
+
+    // Count session, and check whether the link is still active from the
+    // previous one.
+    k_mutex_lock(&_lte_stats_mutex, K_FOREVER);
+    _lte_stats.sessions++;
+    active = _lte_active;
+    if (active) {
+        _lte_stats.resumed++;
+    }
+    k_mutex_unlock(&_lte_stats_mutex);
+
+    if (active) {
+        /*
+         * The link was kept registered after the previous session, and the
+         * network may have put the modem in PSM. There is nothing to set up,
+         * as the modem wakes up on its own once data is sent.
+         */
+
+        LOG_INF("Resuming registered LTE link");
+        return 0;
+    }
 
     /*
      * Initialize modem. If an error occurs in this process, exit with failure.
@@ -473,6 +471,9 @@ int lte_init (void) {
 
     LOG_INF("Initializing modem");
 
+    // Start timing initialization.
+    start = perf_start();
+
     // Initialize modem.
     status = lte_lc_init();
     if (status < 0) {
@@ -595,6 +596,10 @@ int lte_init (void) {
     // Register LTE event handler.
     lte_lc_register_handler(_lte_handler);
 
+    // Record initialization time, and start timing attach.
+    perf_record(PERF_PHASE_MODEM_INIT, start);
+    _lte_attach_begin();
+
     // Activate LTE but not GNSS.
     status = lte_lc_func_mode_set(LTE_LC_FUNC_MODE_ACTIVATE_LTE);
     if (status < 0) {
@@ -614,11 +619,29 @@ int lte_init (void) {
         return -1;
     }
 
+    // Mark link as active.
+    k_mutex_lock(&_lte_stats_mutex, K_FOREVER);
+    _lte_active = true;
+    k_mutex_unlock(&_lte_stats_mutex);
+
     return 0;
 }
 
+void lte_park (void) {
+    if (IS_ENABLED(CONFIG_LTE_KEEP_REGISTERED)) {
+        // If configured to keep the link registered, leave it to the network
+        // to put the modem in PSM.
+        LOG_INF("Leaving LTE link registered");
+        return;
+    }
+
+    // Otherwise, deinitialize modem.
+    lte_deinit();
+}
+
 void lte_deinit (void) {
-    int status; // Return status for API calls.
+    int status;     // Return status for API calls.
+    int64_t start;  // Start time of deinitialization.
 
     /*
      * Deinitialize modem. If an error occurs in this process, report failure.
@@ -627,6 +650,7 @@ void lte_deinit (void) {
     LOG_WRN("Deinitializing modem");
 
     // Deinitialize modem.
+    start = perf_start();
     status = lte_lc_deinit();
     if (status < 0) {
         // On error, report failure.
@@ -635,6 +659,31 @@ void lte_deinit (void) {
             strerror(-status)
         );
     }
+    perf_record(PERF_PHASE_DEINIT, start);
+
+    // Mark link as inactive, and discard any unfinished attach.
+    k_mutex_lock(&_lte_stats_mutex, K_FOREVER);
+    _lte_active = false;
+    _lte_attach_start = 0;
+    k_mutex_unlock(&_lte_stats_mutex);
+}
+
+bool lte_active (void) {
+    bool flag;  // Non-shared copy of flag value.
+
+    // Safely copy flag value to non-shared variable.
+    k_mutex_lock(&_lte_stats_mutex, K_FOREVER);
+    flag = _lte_active;
+    k_mutex_unlock(&_lte_stats_mutex);
+
+    return flag;
+}
+
+void lte_stats (lte_stats_t * stats) {
+    // Safely copy statistics into output buffer.
+    k_mutex_lock(&_lte_stats_mutex, K_FOREVER);
+    memcpy(stats, &_lte_stats, sizeof(_lte_stats));
+    k_mutex_unlock(&_lte_stats_mutex);
 }
 
 bool lte_conn_avail (void) {
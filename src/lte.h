@@ -11,21 +11,45 @@
  *  The availability of such data can be checked with lte_data_avail(). The LTE
  *  data frame can be read by calling lte_read(). When not required, the LTE
  *  interface can be deactivated by calling lte_deinit().
+ *
+ *  If configured to keep the link registered, a session can instead be ended by
+ *  calling lte_park(), which leaves the modem registered so that the network
+ *  can put it in PSM. The next call to lte_init() then resumes the link without
+ *  a new network search and attach. Whether the link is currently initialized
+ *  can be checked with lte_active(), and attach statistics can be obtained with
+ *  lte_stats().
  */
 
 #ifndef __LTE_H__
 #define __LTE_H__
 
 #include <stdbool.h>
+#include <stdint.h>
 
 #include "data.h"
 
+/** @ingroup    lte
+ *
+ *  @brief      LTE link statistics.
+ *
+ *  This structure holds counters describing how often sessions required a full
+ *  network attach. It is filled in by lte_stats().
+ */
+
+typedef struct {
+    uint32_t sessions;  //!< Number of sessions started by lte_init().
+    uint32_t resumed;   //!< Number of sessions that resumed a registered link.
+    uint32_t attaches;  //!< Number of completed network attaches.
+    uint32_t attach_ms; //!< Total time spent attaching in milliseconds.
+} lte_stats_t;
+
 /** @ingroup    lte
  *
  *  @brief      Initialize LTE interface.
  *
  *  Powers on and initializes the modem LTE interface. The GNSS interface
- *  remains powered off.
+ *  remains powered off. If the link was kept registered by lte_park(), it is
+ *  resumed instead.
  *
  *  @note       This function must not be called while the GNSS interface is
  *              active.
@@ -45,6 +69,40 @@ int lte_init (void);
 
 void lte_deinit (void);
 
+/** @ingroup    lte
+ *
+ *  @brief      End LTE session.
+ *
+ *  Ends a session started by lte_init(). If configured to keep the link
+ *  registered, the modem is left registered with the network, which puts it in
+ *  PSM once idle. Otherwise, the LTE interface is deinitialized as by
+ *  lte_deinit().
+ */
+
+void lte_park (void);
+
+/** @ingroup    lte
+ *
+ *  @brief      Check for active LTE interface.
+ *
+ *  Checks if the modem LTE interface is initialized, either because a session
+ *  is in progress or because the link was kept registered.
+ *
+ *  @retval     true    LTE interface active.
+ *  @retval     false   LTE interface inactive.
+ */
+
+bool lte_active (void);
+
+/** @ingroup    lte
+ *
+ *  @brief      Read LTE link statistics.
+ *
+ *  @param      stats   Pointer to buffer into which statistics must be copied.
+ */
+
+void lte_stats (lte_stats_t * stats);
+
 /** @ingroup    lte
  *
  *  @brief      Check for LTE connection.
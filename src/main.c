@@ -4,12 +4,15 @@
  *
  *  The *nRF9160 Logger* is a configurable logging device based on the Actinius
  *  Icarus v2 development board, which features the nRF9160 SiP. This logger can
- *  be configured to regularly upload dummy data, LTE network information, or
- *  GNSS fixes to an online database. For uploading data, the device accesses
- *  the internet over the LTE-M/NB-IoT network.
+ *  be configured to regularly upload dummy data, LTE network information, and
+ *  GNSS fixes to an online database, along with telemetry on its own timing.
+ *  For uploading data, the device accesses the internet over the LTE-M/NB-IoT
+ *  network.
  */
 
 #include <stdbool.h>
+#include <stdint.h>
+#include <string.h>
 
 #include <zephyr/kernel.h>
 #include <zephyr/logging/log.h>
@@ -19,285 +22,988 @@
 #include "lte.h"
 #include "gnss.h"
 #include "rest.h"
+#include "queue.h"
+#include "sched.h"
+#include "perf.h"
+
+#if defined(CONFIG_MAIN_COMPRESS)
+#include "compress.h"
+#endif
+
+#if defined(CONFIG_REST_COAP)
+#include "coapc.h"
+#endif
+
+#if defined(CONFIG_REST_MQTT)
+#include "mqttc.h"
+#endif
 
 // Register module for logging.
 LOG_MODULE_REGISTER(main, CONFIG_MAIN_LOG_LEVEL);
 
-void app_dummy_logger (void) {
+// Mutex grants exclusive control of the modem. The LTE and GNSS interfaces
+// cannot be active at the same time, so whichever thread activates one of them
+// holds this mutex until it has been deactivated again.
+static K_MUTEX_DEFINE(app_modem_mutex);
+
+// Semaphore wakes up the uplink stage early, once producers have queued enough
+// data frames for an upload to be due.
+static K_SEM_DEFINE(app_uplink_sem, 0, 1);
+
+// Size of the encoding buffer of each data frame type. Buffers configured with
+// a size of 0 are sized to hold a worst-case encoded data frame, as computed
+// from the data frame schema. Buffers configured explicitly must hold one too.
+#define APP_BUF_SIZE(size, type)                                               \
+    ((size) > 0 ? (size) : DATA_ENCODED_MAX(type))
+#define APP_DUMMY_BUF_SIZE                                                     \
+    APP_BUF_SIZE(CONFIG_MAIN_DUMMY_BUF_SIZE, dummy_data_frame)
+#define APP_LTE_BUF_SIZE                                                       \
+    APP_BUF_SIZE(CONFIG_MAIN_LTE_BUF_SIZE, lte_data_frame)
+#define APP_GNSS_BUF_SIZE                                                      \
+    APP_BUF_SIZE(CONFIG_MAIN_GNSS_BUF_SIZE, gnss_data_frame)
+#define APP_PERF_BUF_SIZE                                                      \
+    APP_BUF_SIZE(CONFIG_MAIN_PERF_BUF_SIZE, perf_data_frame)
+
+BUILD_ASSERT(
+    APP_DUMMY_BUF_SIZE >= DATA_ENCODED_MAX(dummy_data_frame),
+    "Dummy data buffer cannot hold worst-case data frame"
+);
+BUILD_ASSERT(
+    APP_LTE_BUF_SIZE >= DATA_ENCODED_MAX(lte_data_frame),
+    "LTE data buffer cannot hold worst-case data frame"
+);
+BUILD_ASSERT(
+    APP_GNSS_BUF_SIZE >= DATA_ENCODED_MAX(gnss_data_frame),
+    "GNSS data buffer cannot hold worst-case data frame"
+);
+BUILD_ASSERT(
+    APP_PERF_BUF_SIZE >= DATA_ENCODED_MAX(perf_data_frame),
+    "Performance data buffer cannot hold worst-case data frame"
+);
+
+// Size of the largest encoding buffer.
+#define APP_FRAME_MAX                                                          \
+    MAX(                                                                       \
+        MAX(APP_DUMMY_BUF_SIZE, APP_LTE_BUF_SIZE),                             \
+        MAX(APP_GNSS_BUF_SIZE, APP_PERF_BUF_SIZE)                              \
+    )
+
+// Every batch must be able to carry at least one data frame of any type, along
+// with the two bytes that open and close the array.
+BUILD_ASSERT(
+    CONFIG_MAIN_BATCH_MAX_SIZE >= APP_FRAME_MAX + 2,
+    "Batch size limit cannot hold worst-case data frame"
+);
+
+#if defined(CONFIG_MAIN_COMPRESS)
+// Size limit of the start of a batch compressed on trial, which must hold at
+// least one data frame of any type.
+#define APP_COMPRESS_TRIAL_MAX                                                 \
+    MAX(CONFIG_MAIN_COMPRESS_TRIAL_SIZE, APP_FRAME_MAX + 2)
+#endif
+
+#if defined(CONFIG_REST_MQTT)
+// Batches published over MQTT must fit in a single message.
+BUILD_ASSERT(
+    CONFIG_MQTTC_PAYLOAD_SIZE >= APP_FRAME_MAX + 2,
+    "MQTT payload size cannot hold worst-case data frame"
+);
+#define APP_MQTT_BATCH_MAX                                                     \
+    MIN(CONFIG_MAIN_BATCH_MAX_SIZE, CONFIG_MQTTC_PAYLOAD_SIZE)
+#endif
+
+// Buffer through which queued data frames are streamed into batch uploads, one
+// at a time. It must hold an encoded data frame of any type, or, if batches are
+// delta-encoded, two of them. Mutex protects it, along with the compressed
+// stream, as batches of different types are prepared and uploaded by
+// different threads.
+static char app_frame[
+    (IS_ENABLED(CONFIG_DATA_CBOR_DELTA) ? 2 : 1) * APP_FRAME_MAX
+];
+static K_MUTEX_DEFINE(app_frame_mutex);
+
+// Batch upload of one data frame type. Batches of all types are uploaded in the
+// background at the same time, each by submitting requests one after another
+// until no frames of its type remain.
+typedef struct {
+    data_type_t type;       // Data frame type.
+    size_t max;             // Size limit of batches.
+    queue_batch_t frames;   // Data frames in batch.
+    bool compress;          // Batch is compressed.
+    int retries;            // Number of retries of current batch.
+    int status;             // Result of upload.
+    atomic_t active;        // Upload is in progress.
+    rest_req_t req;         // Upload request.
+} app_batch_t;
+
+// Batch uploads of all types. Semaphore is given each time the upload of a
+// type is complete. Types streamed over MQTT may complete several times per
+// session, so the semaphore counts without limit.
+static app_batch_t app_batch[DATA_TYPE_COUNT];
+static K_SEM_DEFINE(app_upload_sem, 0, K_SEM_MAX_LIMIT);
+
+// Number of data frames dropped because the server rejected their batch.
+static atomic_t app_rejected = ATOMIC_INIT(0);
+
+#if defined(CONFIG_MAIN_COMPRESS)
+// Compressed stream through which batches are uploaded. It is also used to
+// determine beforehand whether compressing a batch pays off.
+static compress_t app_compress;
+#endif
+
+// Upload URLs for each data frame type, or topics for types published over
+// MQTT.
+static const char * const app_upload_url [DATA_TYPE_COUNT] = {
+#if defined(CONFIG_MAIN_DUMMY_UPLOAD_MQTT)
+    [DATA_TYPE_DUMMY] = CONFIG_MAIN_DUMMY_UPLOAD_TOPIC,
+#else
+    [DATA_TYPE_DUMMY] = CONFIG_MAIN_DUMMY_UPLOAD_URL,
+#endif
+#if defined(CONFIG_MAIN_LTE_UPLOAD_MQTT)
+    [DATA_TYPE_LTE] = CONFIG_MAIN_LTE_UPLOAD_TOPIC,
+#else
+    [DATA_TYPE_LTE] = CONFIG_MAIN_LTE_UPLOAD_URL,
+#endif
+#if defined(CONFIG_MAIN_GNSS_UPLOAD_MQTT)
+    [DATA_TYPE_GNSS] = CONFIG_MAIN_GNSS_UPLOAD_TOPIC,
+#else
+    [DATA_TYPE_GNSS] = CONFIG_MAIN_GNSS_UPLOAD_URL,
+#endif
+#if defined(CONFIG_MAIN_PERF_UPLOAD_MQTT)
+    [DATA_TYPE_PERF] = CONFIG_MAIN_PERF_UPLOAD_TOPIC
+#else
+    [DATA_TYPE_PERF] = CONFIG_MAIN_PERF_UPLOAD_URL
+#endif
+};
+
+// Upload transport selected for a data frame type.
+#define APP_UPLOAD_TRANSPORT(type)                                             \
+    (IS_ENABLED(CONFIG_MAIN_##type##_UPLOAD_COAP) ? REST_TRANSPORT_COAP        \
+        : IS_ENABLED(CONFIG_MAIN_##type##_UPLOAD_MQTT) ? REST_TRANSPORT_MQTT   \
+        : REST_TRANSPORT_HTTP)
+
+// Upload transports for each data frame type.
+static const rest_transport_t app_upload_transport [DATA_TYPE_COUNT] = {
+    [DATA_TYPE_DUMMY] = APP_UPLOAD_TRANSPORT(DUMMY),
+    [DATA_TYPE_LTE] = APP_UPLOAD_TRANSPORT(LTE),
+    [DATA_TYPE_GNSS] = APP_UPLOAD_TRANSPORT(GNSS),
+    [DATA_TYPE_PERF] = APP_UPLOAD_TRANSPORT(PERF)
+};
+
+void app_queue (
+    data_type_t type, uint32_t seq, const char * frame, size_t len
+) {
     int status; // Return status for API calls.
 
-    dummy_data_frame_t dummy_data_frame;            // Data frame.
-    char dummy_json[CONFIG_MAIN_DUMMY_BUF_SIZE];    // JSON buffer.
+    // Add data frame to queue.
+    status = queue_push(type, seq, frame, len);
+    if (status < 0) {
+        return;
+    }
+
+    // Wake up uplink stage once enough data frames are queued.
+    if (queue_count_all() >= CONFIG_MAIN_BATCH_COUNT) {
+        k_sem_give(&app_uplink_sem);
+    }
+}
+
+int app_write (void * ctx, const void * data, size_t len) {
+    // Write batch data to request payload.
+    return rest_stream_write(ctx, data, len);
+}
+
+#if defined(CONFIG_MAIN_COMPRESS)
+
+int app_deflate (void * ctx, const void * data, size_t len) {
+    // Write batch data to compressed stream.
+    return compress_write(ctx, data, len);
+}
+
+bool app_compress_pays (data_type_t type) {
+    int status;             // Return status for API calls.
+    queue_batch_t frames;   // Data frames in batch.
+    int64_t start;          // Start time of compression.
 
     /*
-     * Program loop. Each cycle begins with an interval during which the device
-     * remains in sleep mode. After this, it obtains a dummy data frame and
-     * encodes it in JSON format. Finally, it connects to the LTE network,
-     * uploads the data frame, and then disconnects from the network. If errors
-     * occur anywhere in this process, the LTE module is deactivated and the
-     * cycle is restarted.
+     * Compress the start of the next batch of the given type without output,
+     * to estimate how well the batch compresses, without compressing all of it
+     * twice. The batch is later streamed starting from the same oldest frame,
+     * so the trial covers its first frames. Compression pays off if it saves
+     * at least the configured share of the trial size. If an error occurs in
+     * this process, report that compression does not pay off.
      */
 
-    while (true) {
-        /*
-         * Enter sleep mode for the configured time interval.
-         */
+    start = perf_start();
 
-        LOG_INF("Entered sleep mode");
-        k_sleep(K_SECONDS(CONFIG_MAIN_SLEEP_TIME));
+    compress_init(&app_compress, NULL, NULL);
+    status = queue_stream(
+        type, app_frame, sizeof(app_frame), APP_COMPRESS_TRIAL_MAX,
+        app_deflate, &app_compress, &frames
+    );
+    if (status == 0) {
+        status = compress_finish(&app_compress);
+    }
 
-        /*
-         * Obtain data frame and encode it in JSON format. If an error occurs in
-         * this process, restart the cycle.
-         */
+    perf_record(PERF_PHASE_COMPRESS, start);
 
-        LOG_INF("Obtaining dummy data");
+    if (status < 0) {
+        return false;
+    }
 
-        // Read data frame.
-        dummy_read(&dummy_data_frame);
+    LOG_DBG(
+        "Trial of %u data frames compresses from %u to %u bytes in %u us",
+        frames.count, app_compress.in, app_compress.out, app_compress.time_us
+    );
 
-        // Encode data frame in JSON format.
+    return 100 * (uint64_t)app_compress.out
+        <= (100 - CONFIG_MAIN_COMPRESS_MIN_SAVING) * (uint64_t)app_compress.in;
+}
 
-        status = data_dummy_data_frame_to_json(
-            &dummy_data_frame, dummy_json, sizeof(dummy_json)
-        );
+#endif
 
-        if (status < 0) {
-            // On error, restart cycle.
-            continue;
+int app_payload (rest_stream_t * stream, void * user_data) {
+    app_batch_t * batch = user_data;    // Batch upload.
+    int status;                         // Return status for API calls.
+
+    k_mutex_lock(&app_frame_mutex, K_FOREVER);
+
+#if defined(CONFIG_MAIN_COMPRESS)
+    if (batch->compress) {
+        // Stream queued data frames into request payload through compressed
+        // stream.
+        compress_init(&app_compress, app_write, stream);
+        status = queue_stream(
+            batch->type, app_frame, sizeof(app_frame),
+            CONFIG_MAIN_BATCH_MAX_SIZE, app_deflate, &app_compress,
+            &batch->frames
+        );
+        if (status == 0) {
+            status = compress_finish(&app_compress);
+        }
+        if (status == 0) {
+            LOG_INF(
+                "Batch of %u data frames compressed from %u to %u bytes "
+                "(%u%%) in %u us",
+                batch->frames.count, app_compress.in, app_compress.out,
+                app_compress.in > 0
+                    ? 100 * app_compress.out / app_compress.in : 0,
+                app_compress.time_us
+            );
         }
+        k_mutex_unlock(&app_frame_mutex);
+        return status;
+    }
+#endif
 
-        /*
-         * Connect to LTE network, upload data frame, and then disconnect from
-         * network. If an error occurs anywhere in this process, deactivate LTE
-         * and restart the cycle.
-         */
+    // Stream queued data frames into request payload.
+    status = queue_stream(
+        batch->type, app_frame, sizeof(app_frame), batch->max, app_write,
+        stream, &batch->frames
+    );
 
-        LOG_INF("Activating LTE system");
+    k_mutex_unlock(&app_frame_mutex);
 
-        // Activate LTE.
-        status = lte_init();
-        if (status < 0) {
-            // On error, restart cycle.
-            continue;
+    return status;
+}
+
+void app_upload_submit (app_batch_t * batch, k_timeout_t delay) {
+    /*
+     * Submit the next batch of the given type for upload. If an error occurs
+     * in this process, report the upload of the type as complete and failed.
+     */
+
+    memset(&batch->frames, 0, sizeof(batch->frames));
+
+#if defined(CONFIG_REST_MQTT)
+    // Batch published over MQTT must fit in a single message.
+    batch->max = app_upload_transport[batch->type] == REST_TRANSPORT_MQTT
+        ? APP_MQTT_BATCH_MAX : CONFIG_MAIN_BATCH_MAX_SIZE;
+#else
+    batch->max = CONFIG_MAIN_BATCH_MAX_SIZE;
+#endif
+
+#if defined(CONFIG_MAIN_COMPRESS)
+    // Compress batch only if it pays off, and send it plain otherwise. Neither
+    // CoAP nor MQTT can announce a content encoding, so batches sent over them
+    // are plain. A retried batch keeps the result of its first trial.
+    if (batch->retries == 0) {
+        k_mutex_lock(&app_frame_mutex, K_FOREVER);
+        batch->compress =
+            app_upload_transport[batch->type] == REST_TRANSPORT_HTTP
+            && app_compress_pays(batch->type);
+        k_mutex_unlock(&app_frame_mutex);
+    }
+#else
+    batch->compress = false;
+#endif
+
+    batch->req.method = REST_METHOD_POST;
+    batch->req.transport = app_upload_transport[batch->type];
+    batch->req.url = app_upload_url[batch->type];
+    batch->req.stream = app_payload;
+    batch->req.encoding = batch->compress ? "gzip" : NULL;
+    batch->req.user_data = batch;
+
+    if (rest_submit(&batch->req, delay) < 0) {
+        batch->status = -1;
+        atomic_clear(&batch->active);
+        k_sem_give(&app_upload_sem);
+    }
+}
+
+void app_uploaded (rest_req_t * req, int status) {
+    app_batch_t * batch = CONTAINER_OF(req, app_batch_t, req);  // Batch.
+    int delay;                                                  // Retry delay.
+
+    /*
+     * Once the server has acknowledged a batch, remove its frames from the
+     * queue, and submit the next batch of its type, until no frames of that
+     * type remain. A failed batch is submitted again after a delay that
+     * doubles with every retry, as every frame carries a sequence number by
+     * which the server can recognize frames it has already received. If the
+     * server rejects a batch, sending it again would be rejected just the
+     * same, so its frames are dropped and counted, and the upload carries on
+     * with the next batch without failing. If the retries of a batch are
+     * exhausted, the upload of its type fails, leaving the remaining frames in
+     * the queue. Frames queued while the upload was in progress are picked up
+     * by it, including those queued after the last check of the queue, as the
+     * upload carries on if any remain once it has been marked inactive.
+     */
+
+    if (status == -2) {
+        // On rejection, drop frames of batch.
+        atomic_add(&app_rejected, batch->frames.count);
+        LOG_ERR(
+            "Batch rejected, dropping data frames %u-%u (%d dropped so far)",
+            batch->frames.first, batch->frames.last,
+            (int)atomic_get(&app_rejected)
+        );
+        status = 0;
+    }
+
+    if (status == 0) {
+        // Remove acknowledged or rejected frames from queue.
+        queue_release(batch->type, &batch->frames);
+        batch->retries = 0;
+
+        if (queue_count(batch->type) > 0) {
+            // Upload next batch.
+            app_upload_submit(batch, K_NO_WAIT);
+            return;
         }
+    } else if (batch->retries < CONFIG_MAIN_UPLOAD_RETRIES) {
+        // On error, retry batch after delay.
+        LOG_WRN(
+            "Batch upload failed, retrying in %d s (%d/%d)",
+            CONFIG_MAIN_UPLOAD_BACKOFF << batch->retries, batch->retries + 1,
+            CONFIG_MAIN_UPLOAD_RETRIES
+        );
+        delay = CONFIG_MAIN_UPLOAD_BACKOFF << batch->retries;
+        batch->retries++;
+        app_upload_submit(batch, K_SECONDS(delay));
+        return;
+    }
 
-        // Wait for connection to establish.
-        status = lte_wait_conn_avail();
-        if (status < 0) {
-            // On error, deactivate LTE and restart cycle.
-            lte_deinit();
+    // Report upload of type as complete.
+    batch->status = status;
+    atomic_clear(&batch->active);
+
+    if (
+        status == 0 && queue_count(batch->type) > 0
+        && atomic_cas(&batch->active, 0, 1)
+    ) {
+        // Frames queued since the check above found the upload still in
+        // progress, so carry on with them instead of completing.
+        app_upload_submit(batch, K_NO_WAIT);
+        return;
+    }
+
+    k_sem_give(&app_upload_sem);
+}
+
+int app_upload_start (void) {
+    int count = 0;      // Number of types being uploaded.
+    data_type_t type;   // Data frame type.
+
+    /*
+     * Submit the first batch of every type with queued data frames, without
+     * waiting for it to be uploaded. Each batch is streamed from the queue
+     * straight into the request payload on the work queue of the REST module,
+     * and further batches are submitted from the completion callback. Return
+     * the number of types being uploaded.
+     */
+
+    for (type = 0; type < DATA_TYPE_COUNT; type++) {
+        memset(&app_batch[type], 0, sizeof(app_batch[type]));
+        app_batch[type].type = type;
+        app_batch[type].req.cb = app_uploaded;
+
+        if (queue_count(type) == 0) {
             continue;
         }
 
-        // Upload data frame.
-        LOG_INF("Uploading dummy data");
-        rest_post(CONFIG_MAIN_DUMMY_UPLOAD_URL, dummy_json);
-
-        // Deactivate LTE.
-        LOG_INF("Deactivating LTE system");
-        lte_deinit();
+        atomic_set(&app_batch[type].active, 1);
+        app_upload_submit(&app_batch[type], K_NO_WAIT);
+        count++;
     }
-}
 
-void app_lte_logger (void) {
-    int status; // Return status for API calls.
+    return count;
+}
 
-    lte_data_frame_t lte_data_frame;            // Data frame.
-    char lte_json[CONFIG_MAIN_LTE_BUF_SIZE];    // JSON buffer.
+int app_upload_resume (data_type_t type) {
+    app_batch_t * batch = &app_batch[type]; // Batch upload.
 
     /*
-     * Program loop. Each cycle begins with an interval during which the device
-     * remains in sleep mode. After this, it connects to the LTE network. Once
-     * connected, it repeatedly waits for updates to network-related
-     * information. Every time an update is received, an LTE data frame is
-     * obtained, encoded in JSON format, and uploaded. If no update is received
-     * before a timeout expires, the device disconnects from the network. If an
-     * error occurs anywhere in this process, the LTE module is deactivated and
-     * the cycle is restarted.
+     * Submit the next batch of the given type, unless an upload of the type is
+     * still in progress, which picks up newly queued data frames by itself, or
+     * the upload of the type has failed earlier in the session. Return the
+     * number of types whose upload was resumed.
      */
 
-    while (true) {
-        /*
-         * Enter sleep mode for the configured time interval.
-         */
+    if (!atomic_cas(&batch->active, 0, 1)) {
+        return 0;
+    }
 
-        LOG_INF("Entered sleep mode");
-        k_sleep(K_SECONDS(CONFIG_MAIN_SLEEP_TIME));
+    if (batch->status < 0) {
+        atomic_clear(&batch->active);
+        return 0;
+    }
 
-        /*
-         * Connect to LTE network. After this, repeatedly wait for data frames
-         * and upload them as they are received. If a timeout expires,
-         * disconnect from the network. If an error occurs anywhere in this
-         * process, deactivate LTE and restart the cycle.
-         */
+    app_upload_submit(batch, K_NO_WAIT);
 
-        LOG_INF("Activating LTE system");
+    return 1;
+}
 
-        // Activate LTE.
-        status = lte_init();
-        if (status < 0) {
-            // On error, restart cycle.
-            continue;
-        }
+int app_upload_wait (int count) {
+    int status = 0; // Result of uploads.
 
-        // Wait for connection to establish.
-        status = lte_wait_conn_avail();
-        if (status < 0) {
-            // On error, deactivate LTE and restart cycle.
-            lte_deinit();
-            continue;
+    // Wait for uploads of the given number of types to complete, and fail if
+    // any of them failed.
+    while (count > 0) {
+        k_sem_take(&app_upload_sem, K_FOREVER);
+        count--;
+    }
+
+    for (data_type_t type = 0; type < DATA_TYPE_COUNT; type++) {
+        if (app_batch[type].status < 0) {
+            status = -1;
         }
+    }
 
-        // Repeatedly obtain and upload data frames.
-        while (true) {
-            LOG_INF("Obtaining LTE data");
+    return status;
+}
 
-            // Wait for data frame.
-            status = lte_wait_data_avail();
-            if (status < 0) {
-                // On timeout expiry, exit upload cycle.
-                break;
-            }
+void app_dummy_producer (void * p1, void * p2, void * p3) {
+    int status; // Return status for API calls.
 
-            // Read data frame.
-            lte_read(&lte_data_frame);
+    dummy_data_frame_t dummy_data_frame;            // Data frame.
+    char dummy_buf[APP_DUMMY_BUF_SIZE];             // Encoding buffer.
+    sched_t dummy_sched;                            // Sampling schedule.
+    int64_t late;                                   // Wake-up lateness.
+    int64_t start;                                  // Start time of encoding.
 
-            // Encode data frame in JSON format.
+    /*
+     * Producer loop. Each cycle begins with the thread sleeping until the next
+     * deadline of its schedule. After this, it obtains a dummy data frame,
+     * encodes it and adds it to the queue. If an error occurs in this process,
+     * the cycle is restarted.
+     */
 
-            status = data_lte_data_frame_to_json(
-                &lte_data_frame, lte_json, sizeof(lte_json)
-            );
+    sched_init(&dummy_sched, CONFIG_MAIN_DUMMY_PERIOD);
+
+    while (true) {
+        // Sleep until next deadline.
+        late = sched_wait(&dummy_sched);
+
+        LOG_INF("Obtaining dummy data (%lld ms late)", late);
 
-            if (status < 0) {
-                // On error, restart upload cycle.
-                continue;
-            }
+        // Read data frame.
+        dummy_read(&dummy_data_frame);
+
+        // Assign sequence number.
+        dummy_data_frame.seq = queue_seq();
+
+        // Encode data frame.
+
+        start = perf_start();
+
+        status = data_dummy_data_frame_encode(
+            &dummy_data_frame, dummy_buf, sizeof(dummy_buf)
+        );
+
+        perf_record(PERF_PHASE_ENCODE, start);
 
-            // Upload data frame.
-            LOG_INF("Uploading LTE data");
-            rest_post(CONFIG_MAIN_LTE_UPLOAD_URL, lte_json);
+        if (status < 0) {
+            // On error, restart cycle.
+            continue;
         }
 
-        // Deactivate LTE.
-        LOG_INF("Deactivating LTE system");
-        lte_deinit();
+        // Add data frame to queue.
+        app_queue(DATA_TYPE_DUMMY, dummy_data_frame.seq, dummy_buf, status);
     }
 }
 
-void app_gnss_logger (void) {
+void app_gnss_producer (void * p1, void * p2, void * p3) {
     int status; // Return status for API calls.
 
     gnss_data_frame_t gnss_data_frame;          // Data frame.
-    char gnss_json[CONFIG_MAIN_GNSS_BUF_SIZE];  // JSON buffer.
+    char gnss_buf[APP_GNSS_BUF_SIZE];           // Encoding buffer.
+    sched_t gnss_sched;                         // Sampling schedule.
+    int64_t late;                               // Wake-up lateness.
+    int64_t start;                              // Start time of encoding.
 
     /*
-     * Program loop. Each cycle begins with an interval during which the device
-     * remains in sleep mode. After this, it starts GNSS reception and waits for
-     * a fix. If a timeout expires, the GNSS module is deactivated and the cycle
-     * is restarted. If a fix was achieved, a data frame is obtained and encoded
-     * in JSON format. The device then deactivates the GNSS module and connects
-     * to the LTE network, uploads the data frame, and then disconnects from the
-     * network. If an error occurs anywhere in this process, the GNSS and LTE
-     * modules are both deactivated, and the cycle is restarted.
+     * Producer loop. Each cycle begins with the thread sleeping until the next
+     * deadline of its schedule. After this, it takes control of the modem,
+     * starts GNSS reception and waits for a fix. If a timeout expires, the
+     * GNSS module is deactivated and the cycle is restarted. If a fix was
+     * achieved, a data frame is obtained, the GNSS module is deactivated, and
+     * the data frame is encoded and added to the queue. If an error occurs
+     * anywhere in this process, the GNSS module is deactivated and the cycle is
+     * restarted. Cycles that overrun their deadlines, for instance while
+     * waiting for an upload session to finish, are merged.
      */
 
-    while (true) {
-        /*
-         * Enter sleep mode for the configured time interval.
-         */
+    sched_init(&gnss_sched, CONFIG_MAIN_GNSS_PERIOD);
 
-        LOG_INF("Entered sleep mode");
-        k_sleep(K_SECONDS(CONFIG_MAIN_SLEEP_TIME));
+    while (true) {
+        // Sleep until next deadline.
+        late = sched_wait(&gnss_sched);
 
         /*
-         * Start GNSS reception and wait for a data frame. If a timeout expires,
-         * deactivate GNSS and restart the cycle. Otherwise, deactivate GNSS,
-         * encode the data frame in JSON format and proceed. If an error occurs
-         * anywhere in this process, deactivate GNSS and restart the cycle.
+         * Take control of the modem, start GNSS reception and wait for a data
+         * frame. Deactivate GNSS and release the modem once done. If a timeout
+         * expires or an error occurs, restart the cycle.
          */
 
-        LOG_INF("Activating GNSS system");
+        k_mutex_lock(&app_modem_mutex, K_FOREVER);
+
+        LOG_INF("Activating GNSS system (%lld ms late)", late);
 
         // Activate GNSS.
         status = gnss_init();
         if (status < 0) {
-            // On error, restart cycle.
+            // On error, release modem and restart cycle.
+            k_mutex_unlock(&app_modem_mutex);
             continue;
         }
 
         LOG_INF("Obtaining GNSS data");
 
-        // Wait for data frame.
+        // Wait for data frame, and read it if available.
         status = gnss_wait_data_avail();
+        if (status == 0) {
+            gnss_read(&gnss_data_frame);
+
+            // Assign sequence number.
+            gnss_data_frame.seq = queue_seq();
+        }
+
+        // Deactivate GNSS.
+        LOG_INF("Deactivating GNSS system");
+        gnss_deinit();
+
+        k_mutex_unlock(&app_modem_mutex);
+
         if (status < 0) {
-            // On error, deactivate GNSS and restart cycle.
-            gnss_deinit();
+            // On timeout expiry, restart cycle.
             continue;
         }
 
-        // Read data frame.
-        gnss_read(&gnss_data_frame);
+        // Encode data frame.
 
-        // Encode data frame in JSON format.
+        start = perf_start();
 
-        status = data_gnss_data_frame_to_json(
-            &gnss_data_frame, gnss_json, sizeof(gnss_json)
+        status = data_gnss_data_frame_encode(
+            &gnss_data_frame, gnss_buf, sizeof(gnss_buf)
         );
 
+        perf_record(PERF_PHASE_ENCODE, start);
+
         if (status < 0) {
-            // On error, deactivate GNSS and restart cycle.
-            gnss_deinit();
+            // On error, restart cycle.
             continue;
         }
 
-        // Deactivate GNSS.
-        LOG_INF("Deactivating GNSS system");
-        gnss_deinit();
+        // Add data frame to queue.
+        app_queue(DATA_TYPE_GNSS, gnss_data_frame.seq, gnss_buf, status);
+    }
+}
 
-        /*
-         * Connect to LTE network, upload data frame, and then disconnect from
-         * the network. If an error occurs anywhere in this process, deactivate
-         * LTE and restart the cycle.
-         */
+int app_lte_capture (void) {
+    int status;     // Return status for API calls.
+    int count = 0;  // Number of uploads resumed.
+
+    lte_data_frame_t lte_data_frame;            // Data frame.
+    char lte_buf[APP_LTE_BUF_SIZE];             // Encoding buffer.
+    int64_t start;                              // Start time of encoding.
 
-        LOG_INF("Activating LTE system");
+    /*
+     * Repeatedly wait for updates to network-related information. Every time
+     * an update is received, an LTE data frame is obtained, encoded, and added
+     * to the queue. If LTE data frames are published over MQTT, they are
+     * streamed to the broker as they are captured, by resuming the upload of
+     * their type whenever it has run out of data frames. Once no update is
+     * received before a timeout expires, return the number of uploads resumed.
+     */
+
+    while (true) {
+        LOG_INF("Obtaining LTE data");
 
-        // Activate LTE.
-        status = lte_init();
+        // Wait for data frame.
+        status = lte_wait_data_avail();
         if (status < 0) {
-            // On error, restart cycle.
-            continue;
+            // On timeout expiry, stop capturing.
+            break;
         }
 
-        // Wait for connection to establish.
-        status = lte_wait_conn_avail();
+        // Read data frame.
+        lte_read(&lte_data_frame);
+
+        // Assign sequence number.
+        lte_data_frame.seq = queue_seq();
+
+        // Encode data frame.
+
+        start = perf_start();
+
+        status = data_lte_data_frame_encode(
+            &lte_data_frame, lte_buf, sizeof(lte_buf)
+        );
+
+        perf_record(PERF_PHASE_ENCODE, start);
+
         if (status < 0) {
-            // On error, deactivate LTE and restart cycle.
-            lte_deinit();
+            // On error, wait for next data frame.
             continue;
         }
 
-        // Upload data frame.
-        LOG_INF("Uploading GNSS data");
-        rest_post(CONFIG_MAIN_GNSS_UPLOAD_URL, gnss_json);
+        // Add data frame to queue.
+        app_queue(DATA_TYPE_LTE, lte_data_frame.seq, lte_buf, status);
+
+        if (app_upload_transport[DATA_TYPE_LTE] == REST_TRANSPORT_MQTT) {
+            // Publish data frame right away.
+            count += app_upload_resume(DATA_TYPE_LTE);
+        }
+    }
+
+    return count;
+}
+
+void app_perf_capture (void) {
+    int status; // Return status for API calls.
+
+    perf_data_frame_t perf_data_frame;          // Data frame.
+    char perf_buf[APP_PERF_BUF_SIZE];           // Encoding buffer.
+
+    /*
+     * Obtain a performance data frame summarizing the phase timings recorded
+     * since the previous one, encode it and add it to the queue. Then clear the
+     * histograms, so that every data frame covers its own interval.
+     */
+
+    LOG_INF("Obtaining performance data");
+
+    // Read data frame.
+    perf_read(&perf_data_frame);
+
+    // Assign sequence number.
+    perf_data_frame.seq = queue_seq();
+
+    // Encode data frame.
+
+    status = data_perf_data_frame_encode(
+        &perf_data_frame, perf_buf, sizeof(perf_buf)
+    );
+
+    if (status < 0) {
+        // On error, keep histograms for next attempt.
+        return;
+    }
+
+    // Add data frame to queue, and clear histograms.
+    app_queue(DATA_TYPE_PERF, perf_data_frame.seq, perf_buf, status);
+    perf_reset();
+}
+
+int app_uplink_session (void) {
+    int status;         // Return status for API calls.
+    int count;          // Number of types being uploaded.
+    lte_stats_t stats;  // LTE link statistics.
+    rest_stats_t rest;  // REST connection statistics.
+    int64_t start;      // Start time of session.
+#if defined(CONFIG_MAIN_COMPRESS)
+    compress_stats_t comp_stats;    // Compression statistics.
+#endif
+#if defined(CONFIG_REST_COAP)
+    coapc_stats_t coap_stats;       // CoAP transfer statistics.
+#endif
+#if defined(CONFIG_REST_MQTT)
+    mqttc_stats_t mqtt_stats;       // MQTT publication statistics.
+#endif
+
+    /*
+     * Take control of the modem and connect to the LTE network, or resume the
+     * link if it was kept registered. Start uploading the queued data frames
+     * of all types in the background, and, if configured to log LTE data,
+     * capture network information until updates stop while the uploads
+     * proceed. LTE data frames captured after their type has been uploaded
+     * are left for the next session, unless they are published over MQTT, in
+     * which case they are published as they are captured. Once the uploads
+     * are complete, park the link and release the modem. If an error occurs
+     * anywhere in this process, deactivate LTE entirely so that the next
+     * session starts from a fresh attach, and exit with failure.
+     */
+
+    k_mutex_lock(&app_modem_mutex, K_FOREVER);
+
+    // Start timing session.
+    start = perf_start();
+
+    LOG_INF("Activating LTE system");
+
+    // Activate LTE.
+    status = lte_init();
+    if (status < 0) {
+        // On error, release modem and exit with failure.
+        perf_record(PERF_PHASE_SESSION, start);
+        k_mutex_unlock(&app_modem_mutex);
+        return -1;
+    }
+
+    // Wait for connection to establish.
+    status = lte_wait_conn_avail();
+    if (status == 0) {
+        // Start uploading queued data frames.
+        LOG_INF("Uploading queued data");
+        count = app_upload_start();
+
+        if (IS_ENABLED(CONFIG_MAIN_DATA_TYPE_LTE)) {
+            // Capture LTE data frames while uploads proceed.
+            count += app_lte_capture();
+        }
+
+        // Wait for uploads to complete.
+        status = app_upload_wait(count);
+    }
+
+    // Close connection to server, which does not survive the session.
+    rest_close();
 
-        // Deactivate LTE.
+    if (status == 0) {
+        // End session, keeping the link registered if configured.
+        LOG_INF("Parking LTE system");
+        lte_park();
+    } else {
+        // On error, deactivate LTE.
         LOG_INF("Deactivating LTE system");
         lte_deinit();
     }
+
+    // Record session time.
+    perf_record(PERF_PHASE_SESSION, start);
+
+    k_mutex_unlock(&app_modem_mutex);
+
+    // Report how often a full attach was needed.
+    lte_stats(&stats);
+    LOG_INF(
+        "LTE sessions: %u, resumed: %u, attaches: %u (%u ms)",
+        stats.sessions, stats.resumed, stats.attaches, stats.attach_ms
+    );
+
+    // Report how often a TLS handshake was needed.
+    rest_stats(&rest);
+    LOG_INF(
+        "REST requests: %u, reused: %u, handshakes: %u, reconnects: %u",
+        rest.requests, rest.reused, rest.handshakes, rest.reconnects
+    );
+    LOG_INF(
+        "Connections full: %u (%u ms), session offered: %u (%u ms)",
+        rest.handshakes - rest.session_offered, rest.full_ms,
+        rest.session_offered, rest.session_offered_ms
+    );
+    LOG_INF(
+        "DNS cache hits: %u, misses: %u", rest.dns_hits, rest.dns_misses
+    );
+
+#if defined(CONFIG_REST_COAP)
+    // Report how many blocks had to be retransmitted over CoAP.
+    coapc_stats(&coap_stats);
+    LOG_INF(
+        "CoAP transfers: %u, blocks: %u, retransmits: %u, handshakes: %u, "
+        "sent: %u bytes",
+        coap_stats.transfers, coap_stats.blocks, coap_stats.retransmits,
+        coap_stats.handshakes, coap_stats.sent
+    );
+#endif
+
+#if defined(CONFIG_REST_MQTT)
+    // Report how many messages were published, and how often the broker kept
+    // the session.
+    mqttc_stats(&mqtt_stats);
+    LOG_INF(
+        "MQTT publishes: %u, connects: %u, resumed: %u, reconnects: %u, "
+        "sent: %u bytes",
+        mqtt_stats.publishes, mqtt_stats.connects, mqtt_stats.resumed,
+        mqtt_stats.reconnects, mqtt_stats.sent
+    );
+#endif
+
+#if defined(CONFIG_MAIN_COMPRESS)
+    // Report how much compression saved, and at what processor time.
+    compress_stats(&comp_stats);
+    LOG_INF(
+        "Compressed streams: %u, %u to %u bytes (%u ms)",
+        comp_stats.streams, comp_stats.in, comp_stats.out, comp_stats.time_ms
+    );
+#endif
+
+    return status;
+}
+
+void app_uplink (void) {
+    int status;                             // Return status for API calls.
+    int64_t now;                            // Current uptime.
+    int64_t due;                            // Time at which session is due.
+    int64_t last_upload = k_uptime_get();   // Time of last upload.
+    bool capture = false;                   // LTE capture deadline reached.
+    int64_t start;                          // Start time of sleep.
+
+#if defined(CONFIG_MAIN_DATA_TYPE_LTE)
+    sched_t lte_sched;                      // LTE capture schedule.
+    int64_t late;                           // Wake-up lateness.
+#endif
+
+#if defined(CONFIG_MAIN_DATA_TYPE_PERF)
+    sched_t perf_sched;                     // Performance report schedule.
+#endif
+
+    /*
+     * Uplink loop. Each cycle sleeps until a session is due, which is the case
+     * once producers have queued enough data frames, once the configured time
+     * has passed since the last successful upload, or, if configured to log LTE
+     * data, once the next deadline of the LTE capture schedule is reached. It
+     * then runs a session, which carries the queued data frames of all types
+     * together. After a failed session, no new session is started before the
+     * configured retry time has passed.
+     */
+
+#if defined(CONFIG_MAIN_DATA_TYPE_LTE)
+    sched_init(&lte_sched, CONFIG_MAIN_LTE_PERIOD);
+#endif
+
+#if defined(CONFIG_MAIN_DATA_TYPE_PERF)
+    sched_init(&perf_sched, CONFIG_MAIN_PERF_PERIOD);
+#endif
+
+    while (true) {
+        // Determine time at which next session is due.
+
+        due = last_upload + 1000LL * CONFIG_MAIN_BATCH_TIME;
+
+#if defined(CONFIG_MAIN_DATA_TYPE_LTE)
+        due = MIN(due, sched_deadline(&lte_sched));
+#endif
+
+        // Sleep until then, or until woken up by a producer.
+        LOG_INF("Entered sleep mode");
+        start = perf_start();
+        k_sem_take(&app_uplink_sem, K_TIMEOUT_ABS_MS(due));
+        perf_record(PERF_PHASE_SLEEP, start);
+
+        now = k_uptime_get();
+
+#if defined(CONFIG_MAIN_DATA_TYPE_PERF)
+        if (now >= sched_deadline(&perf_sched)) {
+            // Queue performance data frame, to be carried by next session.
+            sched_advance(&perf_sched);
+            app_perf_capture();
+        }
+#endif
+
+#if defined(CONFIG_MAIN_DATA_TYPE_LTE)
+        capture = now >= sched_deadline(&lte_sched);
+#endif
+
+        if (queue_count_all() < CONFIG_MAIN_BATCH_COUNT && now < due) {
+            // If session isn't due yet, restart cycle.
+            continue;
+        }
+
+        if (queue_count_all() == 0 && !capture) {
+            // If there is nothing to upload, restart cycle.
+            last_upload = now;
+            continue;
+        }
+
+#if defined(CONFIG_MAIN_DATA_TYPE_LTE)
+        if (capture) {
+            // Mark LTE capture deadline as served.
+            late = sched_advance(&lte_sched);
+            LOG_INF("LTE capture due (%lld ms late)", late);
+        }
+#endif
+
+        // Run session.
+        status = app_uplink_session();
+        if (status < 0) {
+            // On error, wait before retrying.
+            k_sleep(K_SECONDS(CONFIG_MAIN_RETRY_TIME));
+            continue;
+        }
+
+        last_upload = k_uptime_get();
+    }
 }
 
+#if defined(CONFIG_MAIN_DATA_TYPE_DUMMY)
+K_THREAD_DEFINE(
+    app_dummy_thread, CONFIG_MAIN_PRODUCER_STACK_SIZE,
+    app_dummy_producer, NULL, NULL, NULL,
+    CONFIG_MAIN_PRODUCER_PRIORITY, 0, K_TICKS_FOREVER
+);
+#endif
+
+#if defined(CONFIG_MAIN_DATA_TYPE_GNSS)
+K_THREAD_DEFINE(
+    app_gnss_thread, CONFIG_MAIN_PRODUCER_STACK_SIZE,
+    app_gnss_producer, NULL, NULL, NULL,
+    CONFIG_MAIN_PRODUCER_PRIORITY, 0, K_TICKS_FOREVER
+);
+#endif
+
 void main (void) {
-    // Check configuration and start corresponding application.
-    if (IS_ENABLED(CONFIG_MAIN_DATA_TYPE_DUMMY)) {
-        LOG_INF("Starting dummy logging application");
-        app_dummy_logger();
-    } else if (IS_ENABLED(CONFIG_MAIN_DATA_TYPE_LTE)) {
-        LOG_INF("Starting LTE logging application");
-        app_lte_logger();
-    } else if (IS_ENABLED(CONFIG_MAIN_DATA_TYPE_GNSS)) {
-        LOG_INF("Starting GNSS logging application");
-        app_gnss_logger();
+    int status; // Return status for API calls.
+
+    // Initialize queue for data frames awaiting upload.
+    status = queue_init();
+    if (status < 0) {
+        // On error, stop.
+        LOG_ERR("Failed to initialize queue");
+        return;
     }
+
+    // Start work queue for REST requests.
+    rest_init();
+
+    // Start producer threads for configured data types.
+
+#if defined(CONFIG_MAIN_DATA_TYPE_DUMMY)
+    LOG_INF("Starting dummy data producer");
+    k_thread_start(app_dummy_thread);
+#endif
+
+#if defined(CONFIG_MAIN_DATA_TYPE_GNSS)
+    LOG_INF("Starting GNSS data producer");
+    k_thread_start(app_gnss_thread);
+#endif
+
+    if (IS_ENABLED(CONFIG_MAIN_DATA_TYPE_LTE)) {
+        LOG_INF("Capturing LTE data during uplink sessions");
+    }
+
+    // Run uplink stage.
+    LOG_INF("Starting uplink");
+    app_uplink();
 }
@@ -0,0 +1,369 @@
+#include <stdlib.h>
+#include <stdbool.h>
+#include <stdint.h>
+#include <stdio.h>
+#include <string.h>
+#include <errno.h>
+
+#include <zephyr/kernel.h>
+#include <zephyr/logging/log.h>
+#include <zephyr/sys/util.h>
+#include <zephyr/net/socket.h>
+#include <zephyr/net/tls_credentials.h>
+#include <zephyr/net/mqtt.h>
+
+#include "mqttc.h"
+
+// Register module for logging.
+LOG_MODULE_REGISTER(mqttc, CONFIG_MQTTC_LOG_LEVEL);
+
+// Client, broker address, and packet buffers. Payloads are sent straight from
+// the message, so the transmit buffer need only hold the header and topic.
+static struct mqtt_client _mqttc_client;
+static struct sockaddr_storage _mqttc_broker;
+static uint8_t _mqttc_rx_buf[CONFIG_MQTTC_BUF_SIZE];
+static uint8_t _mqttc_tx_buf[CONFIG_MQTTC_BUF_SIZE];
+
+#if defined(CONFIG_MQTTC_USE_TLS)
+// TLS security tags, which must outlive the connection.
+static sec_tag_t _mqttc_sec_tag[] = {CONFIG_MQTTC_SEC_TAG};
+#endif
+
+// Client is connected to broker.
+static bool _mqttc_connected = false;
+
+// Message ID of the last publication. IDs are never 0.
+static uint16_t _mqttc_msg_id = 0;
+
+// Packets received from broker, as reported by the event handler.
+static struct {
+    bool connack;       // Connection acknowledged.
+    int result;         // Result of connection.
+    bool session;       // Broker kept session from earlier connection.
+    uint16_t puback;    // Message ID of last publication acknowledged.
+} _mqttc_evt;
+
+// Publication statistics. Mutex protects against concurrent access, as this is
+// a shared resource.
+static K_MUTEX_DEFINE(_mqttc_stats_mutex);
+static mqttc_stats_t _mqttc_stats = {
+    .publishes = 0,
+    .connects = 0,
+    .resumed = 0,
+    .reconnects = 0,
+    .sent = 0
+};
+
+static void _mqttc_count (uint32_t * counter, uint32_t value) {
+    // Add to statistics counter.
+    k_mutex_lock(&_mqttc_stats_mutex, K_FOREVER);
+    *counter += value;
+    k_mutex_unlock(&_mqttc_stats_mutex);
+}
+
+static void _mqttc_event (
+    struct mqtt_client * client, const struct mqtt_evt * evt
+) {
+    // Record acknowledgements, and note when the connection is lost.
+    switch (evt->type) {
+        case MQTT_EVT_CONNACK:
+            _mqttc_evt.connack = true;
+            _mqttc_evt.result = evt->result;
+            _mqttc_evt.session = evt->param.connack.session_present_flag;
+            break;
+        case MQTT_EVT_PUBACK:
+            if (evt->result == 0) {
+                _mqttc_evt.puback = evt->param.puback.message_id;
+            }
+            break;
+        case MQTT_EVT_DISCONNECT:
+            _mqttc_connected = false;
+            break;
+        default:
+            break;
+    }
+}
+
+static int _mqttc_sock (void) {
+    // Return socket of connection.
+#if defined(CONFIG_MQTTC_USE_TLS)
+    return _mqttc_client.transport.tls.sock;
+#else
+    return _mqttc_client.transport.tcp.sock;
+#endif
+}
+
+static int _mqttc_input (int timeout) {
+    int status;         // Return status for API calls.
+    struct pollfd fds;  // Poll descriptor.
+
+    /*
+     * Wait for packets from the broker for up to the given time in
+     * milliseconds, and pass them to the event handler. If the connection has
+     * been closed, or an error occurs in this process, exit with failure.
+     */
+
+    fds.fd = _mqttc_sock();
+    fds.events = POLLIN;
+
+    status = poll(&fds, 1, timeout);
+    if (status < 0) {
+        LOG_ERR("Failed to poll socket (%s)", strerror(errno));
+        return -1;
+    }
+
+    if (status > 0 && mqtt_input(&_mqttc_client) < 0) {
+        _mqttc_connected = false;
+    }
+
+    return _mqttc_connected ? 0 : -1;
+}
+
+static int _mqttc_await (uint16_t id, int timeout) {
+    int64_t deadline;   // Time by which acknowledgement must arrive.
+    int remaining;      // Time remaining until deadline.
+
+    /*
+     * Wait for the acknowledgement of the publication with the given message
+     * ID, or, if the ID is 0, of the connection. Return 1 once it has been
+     * received, 0 if it has not arrived in time, and -1 if the connection has
+     * been closed.
+     */
+
+    deadline = k_uptime_get() + timeout;
+
+    while (id == 0 ? !_mqttc_evt.connack : _mqttc_evt.puback != id) {
+        remaining = (int)CLAMP(deadline - k_uptime_get(), 0, INT32_MAX);
+        if (remaining == 0) {
+            return 0;
+        }
+
+        if (_mqttc_input(remaining) < 0) {
+            return -1;
+        }
+    }
+
+    return 1;
+}
+
+static int _mqttc_connect (void) {
+    int status;                 // Return status for API calls.
+    char port[8];               // Port number as string.
+    struct addrinfo hints;      // Address lookup hints.
+    struct addrinfo * addr;     // Resolved broker address.
+
+#if defined(CONFIG_MQTTC_USE_TLS)
+    struct mqtt_sec_config * tls;   // TLS configuration.
+#endif
+
+    /*
+     * Resolve broker address, set up client, connect to broker, and wait for
+     * the broker to acknowledge the connection. If a persistent session is
+     * configured, the broker is asked to keep the session from the last
+     * connection, and reports whether it did. If an error occurs in this
+     * process, close the connection and exit with failure.
+     */
+
+    memset(&hints, 0, sizeof(hints));
+    hints.ai_family = AF_INET;
+    hints.ai_socktype = SOCK_STREAM;
+
+    snprintf(port, sizeof(port), "%d", CONFIG_MQTTC_PORT_NUM);
+
+    // Resolve broker address.
+    status = getaddrinfo(CONFIG_MQTTC_HOST_NAME, port, &hints, &addr);
+    if (status != 0) {
+        // On error, exit with failure.
+        LOG_ERR("Failed to resolve broker address (%d)", status);
+        return -1;
+    }
+
+    memcpy(&_mqttc_broker, addr->ai_addr, addr->ai_addrlen);
+    freeaddrinfo(addr);
+
+    // Set up client.
+
+    mqtt_client_init(&_mqttc_client);
+
+    _mqttc_client.broker = &_mqttc_broker;
+    _mqttc_client.evt_cb = _mqttc_event;
+    _mqttc_client.client_id.utf8 = (const uint8_t *)CONFIG_MQTTC_CLIENT_ID;
+    _mqttc_client.client_id.size = strlen(CONFIG_MQTTC_CLIENT_ID);
+    _mqttc_client.protocol_version = MQTT_VERSION_3_1_1;
+    _mqttc_client.clean_session = !IS_ENABLED(CONFIG_MQTTC_PERSISTENT_SESSION);
+    _mqttc_client.keepalive = CONFIG_MQTTC_KEEP_ALIVE;
+    _mqttc_client.rx_buf = _mqttc_rx_buf;
+    _mqttc_client.rx_buf_size = sizeof(_mqttc_rx_buf);
+    _mqttc_client.tx_buf = _mqttc_tx_buf;
+    _mqttc_client.tx_buf_size = sizeof(_mqttc_tx_buf);
+
+#if defined(CONFIG_MQTTC_USE_TLS)
+    _mqttc_client.transport.type = MQTT_TRANSPORT_SECURE;
+    tls = &_mqttc_client.transport.tls.config;
+    tls->peer_verify = TLS_PEER_VERIFY_NONE;
+    tls->cipher_list = NULL;
+    tls->sec_tag_list = _mqttc_sec_tag;
+    tls->sec_tag_count = ARRAY_SIZE(_mqttc_sec_tag);
+    tls->hostname = CONFIG_MQTTC_HOST_NAME;
+#else
+    _mqttc_client.transport.type = MQTT_TRANSPORT_NON_SECURE;
+#endif
+
+    memset(&_mqttc_evt, 0, sizeof(_mqttc_evt));
+
+    // Connect to broker.
+    status = mqtt_connect(&_mqttc_client);
+    if (status < 0) {
+        // On error, exit with failure.
+        LOG_ERR("Failed to connect to broker (%s)", strerror(-status));
+        return -1;
+    }
+
+    _mqttc_connected = true;
+
+    // Wait for acknowledgement.
+    status = _mqttc_await(0, 1000 * CONFIG_MQTTC_ACK_TIMEOUT);
+    if (status <= 0 || _mqttc_evt.result != 0) {
+        // On error, close connection and exit with failure.
+        LOG_ERR("Connection refused by broker (%d)", _mqttc_evt.result);
+        mqtt_abort(&_mqttc_client);
+        _mqttc_connected = false;
+        return -1;
+    }
+
+    LOG_INF(
+        "Connected to broker (%s session)",
+        _mqttc_evt.session ? "resumed" : "new"
+    );
+
+    _mqttc_count(&_mqttc_stats.connects, 1);
+    if (_mqttc_evt.session) {
+        _mqttc_count(&_mqttc_stats.resumed, 1);
+    }
+
+    return 0;
+}
+
+void mqttc_begin (mqttc_msg_t * msg, const char * topic) {
+    // Reset message state.
+    msg->topic = topic;
+    msg->len = 0;
+    msg->overflow = false;
+}
+
+int mqttc_write (mqttc_msg_t * msg, const void * data, size_t len) {
+    // Append data to payload, unless it does not fit.
+    if (msg->overflow || len > sizeof(msg->payload) - msg->len) {
+        if (!msg->overflow) {
+            LOG_ERR(
+                "Payload exceeds %u bytes", (unsigned int)sizeof(msg->payload)
+            );
+        }
+        msg->overflow = true;
+        return -1;
+    }
+
+    memcpy(&msg->payload[msg->len], data, len);
+    msg->len += len;
+
+    return 0;
+}
+
+int mqttc_publish (mqttc_msg_t * msg) {
+    int status;                         // Return status for API calls.
+    struct mqtt_publish_param param;    // Publication.
+    bool reused;                        // Connection was kept open.
+
+    /*
+     * Refuse a message whose payload did not fit. Otherwise, connect to broker
+     * unless a connection is still open, publish message with QoS 1, and wait
+     * for its acknowledgement. Packets that arrived while the connection was
+     * idle are handled first, so that a connection the broker has closed in
+     * the meantime is noticed. If the broker closes a connection that was kept
+     * open before acknowledging the message, the message is published again
+     * over a new connection, with the same message ID and flagged as a
+     * duplicate. If an error occurs in this process, close the connection, so
+     * that the next publication establishes a new one, and exit with failure.
+     */
+
+    if (msg->overflow) {
+        return -1;
+    }
+
+    _mqttc_msg_id = _mqttc_msg_id < UINT16_MAX ? _mqttc_msg_id + 1 : 1;
+
+    memset(&param, 0, sizeof(param));
+    param.message.topic.topic.utf8 = (const uint8_t *)msg->topic;
+    param.message.topic.topic.size = strlen(msg->topic);
+    param.message.topic.qos = MQTT_QOS_1_AT_LEAST_ONCE;
+    param.message.payload.data = msg->payload;
+    param.message.payload.len = msg->len;
+    param.message_id = _mqttc_msg_id;
+
+    while (true) {
+        reused = _mqttc_connected && _mqttc_input(0) == 0;
+
+        if (!reused) {
+            // Connect to broker.
+            if (_mqttc_connect() < 0) {
+                return -1;
+            }
+        }
+
+        status = mqtt_publish(&_mqttc_client, &param);
+        if (status < 0) {
+            LOG_ERR("Failed to publish message (%s)", strerror(-status));
+            status = -1;
+        } else {
+            status = _mqttc_await(
+                param.message_id, 1000 * CONFIG_MQTTC_ACK_TIMEOUT
+            );
+        }
+
+        if (status > 0) {
+            break;
+        }
+
+        mqtt_abort(&_mqttc_client);
+        _mqttc_connected = false;
+
+        if (reused && status < 0 && !param.dup_flag) {
+            // Broker closed connection kept open, so publish message again
+            // over new connection.
+            LOG_INF("Connection closed by broker, reconnecting");
+            _mqttc_count(&_mqttc_stats.reconnects, 1);
+            param.dup_flag = 1;
+            continue;
+        }
+
+        // On error, exit with failure.
+        LOG_ERR("No acknowledgement for message %u", param.message_id);
+        return -1;
+    }
+
+    LOG_DBG(
+        "Published %u bytes to %s (Message %u)",
+        (unsigned int)msg->len, msg->topic, param.message_id
+    );
+
+    _mqttc_count(&_mqttc_stats.publishes, 1);
+    _mqttc_count(&_mqttc_stats.sent, msg->len);
+
+    return 0;
+}
+
+void mqttc_close (void) {
+    // Disconnect from broker, if connected.
+    if (_mqttc_connected) {
+        LOG_INF("Disconnecting from broker");
+        mqtt_disconnect(&_mqttc_client);
+        _mqttc_connected = false;
+    }
+}
+
+void mqttc_stats (mqttc_stats_t * stats) {
+    // Copy statistics.
+    k_mutex_lock(&_mqttc_stats_mutex, K_FOREVER);
+    *stats = _mqttc_stats;
+    k_mutex_unlock(&_mqttc_stats_mutex);
+}
@@ -0,0 +1,121 @@
+/** @defgroup   mqttc MQTT client
+ *
+ *  @brief      MQTT publications with QoS 1.
+ *
+ *  This module publishes messages to the configured MQTT broker. It serves the
+ *  REST module as a transport for streams of small uploads, which all share a
+ *  single long-lived connection, and carry no more than a few bytes of header
+ *  each. A message is started by calling mqttc_begin(), its payload is written
+ *  piece by piece with mqttc_write(), and it is published by calling
+ *  mqttc_publish(), which waits until the broker has acknowledged it. The
+ *  connection is established on the first publication, and kept open between
+ *  publications until it is closed by calling mqttc_close(). If configured,
+ *  the client asks the broker to keep a persistent session, which survives
+ *  between connections. How many messages were published, and how often a
+ *  connection was established, can be obtained with mqttc_stats().
+ */
+
+#ifndef __MQTTC_H__
+#define __MQTTC_H__
+
+#include <stdbool.h>
+#include <stddef.h>
+#include <stdint.h>
+
+/** @ingroup    mqttc
+ *
+ *  @brief      Publication statistics.
+ *
+ *  This structure holds counters describing the traffic caused by
+ *  publications. It is filled in by mqttc_stats().
+ */
+
+typedef struct {
+    uint32_t publishes;     //!< Number of messages acknowledged by broker.
+    uint32_t connects;      //!< Number of connections established.
+    uint32_t resumed;       //!< Number of connections resuming a session.
+    uint32_t reconnects;    //!< Number of connections found closed by broker.
+    uint32_t sent;          //!< Total number of payload bytes published.
+} mqttc_stats_t;
+
+/** @ingroup    mqttc
+ *
+ *  @brief      Message.
+ *
+ *  This structure holds a message awaiting publication. It is initialized by
+ *  mqttc_begin(), and must not be modified directly.
+ */
+
+typedef struct {
+    const char * topic;                         //!< Topic of message.
+    size_t len;                                 //!< Length of payload.
+    bool overflow;                              //!< Payload did not fit.
+    uint8_t payload[CONFIG_MQTTC_PAYLOAD_SIZE]; //!< Payload buffer.
+} mqttc_msg_t;
+
+/** @ingroup    mqttc
+ *
+ *  @brief      Start message.
+ *
+ *  Prepares the given message for publication to the given topic, with an
+ *  empty payload.
+ *
+ *  @param      msg     Pointer to message.
+ *  @param      topic   Topic of message.
+ */
+
+void mqttc_begin (mqttc_msg_t * msg, const char * topic);
+
+/** @ingroup    mqttc
+ *
+ *  @brief      Write message payload.
+ *
+ *  Appends the given data to the payload of the message.
+ *
+ *  @param      msg     Pointer to message.
+ *  @param      data    Pointer to data that must be written.
+ *  @param      len     Length of data.
+ *
+ *  @retval     0       Success.
+ *  @retval     -1      Failure. The payload exceeds the payload buffer.
+ */
+
+int mqttc_write (mqttc_msg_t * msg, const void * data, size_t len);
+
+/** @ingroup    mqttc
+ *
+ *  @brief      Publish message.
+ *
+ *  Publishes the message with QoS 1, and waits until the broker has
+ *  acknowledged it. If no connection is open, a new one is established first.
+ *
+ *  @param      msg     Pointer to message.
+ *
+ *  @retval     0       Success. The broker acknowledged the message.
+ *  @retval     -1      Failure. The message may or may not have been received.
+ */
+
+int mqttc_publish (mqttc_msg_t * msg);
+
+/** @ingroup    mqttc
+ *
+ *  @brief      Close connection.
+ *
+ *  Disconnects from the broker, if connected. This must be called before the
+ *  network connection is lost. A persistent session is kept by the broker,
+ *  and resumed by the next connection.
+ */
+
+void mqttc_close (void);
+
+/** @ingroup    mqttc
+ *
+ *  @brief      Obtain publication statistics.
+ *
+ *  @param      stats   Pointer to buffer into which statistics must be
+ *                      written.
+ */
+
+void mqttc_stats (mqttc_stats_t * stats);
+
+#endif
@@ -0,0 +1,288 @@
+#include <stdbool.h>
+#include <stddef.h>
+#include <stdint.h>
+#include <string.h>
+
+#include <zephyr/kernel.h>
+#include <zephyr/logging/log.h>
+#include <zephyr/spinlock.h>
+
+#if defined(CONFIG_PERF_SHELL)
+#include <zephyr/shell/shell.h>
+#endif
+
+#include "data.h"
+#include "perf.h"
+
+// Register module for logging.
+LOG_MODULE_REGISTER(perf, CONFIG_PERF_LOG_LEVEL);
+
+// Number of histogram buckets. Bucket 0 holds durations of 0 ms, and bucket i
+// holds durations from 2^(i-1) ms up to 2^i - 1 ms. The last bucket also holds
+// all longer durations.
+#define PERF_BUCKET_COUNT 24
+
+BUILD_ASSERT(
+    PERF_PHASE_COUNT <= DATA_PERF_PHASE_MAX,
+    "Performance data frame cannot hold all phases"
+);
+
+// Phase names, as reported in the shell and in performance data frames.
+static const char * const _perf_phase_name [PERF_PHASE_COUNT] = {
+    [PERF_PHASE_SLEEP] = "sleep",
+    [PERF_PHASE_MODEM_INIT] = "modem_init",
+    [PERF_PHASE_ATTACH] = "attach",
+    [PERF_PHASE_ENCODE] = "encode",
+    [PERF_PHASE_COMPRESS] = "compress",
+    [PERF_PHASE_REQUEST] = "request",
+    [PERF_PHASE_CONNECT] = "connect",
+    [PERF_PHASE_SESSION] = "session",
+    [PERF_PHASE_GNSS_FIX] = "gnss_fix",
+    [PERF_PHASE_DEINIT] = "deinit"
+};
+
+// Histogram of a phase, along with the exact count, minimum and maximum.
+typedef struct {
+    uint32_t count;
+    uint32_t min;
+    uint32_t max;
+    uint32_t buckets[PERF_BUCKET_COUNT];
+} _perf_hist_t;
+
+// Histograms of all phases. Spinlock protects against concurrent access, as
+// this is a shared resource that may be updated from any context.
+static struct k_spinlock _perf_lock;
+static _perf_hist_t _perf_hist[PERF_PHASE_COUNT];
+
+static size_t _perf_bucket (uint32_t dur) {
+    size_t bucket;  // Bucket index.
+
+    // Find bucket holding duration, from the position of its highest set bit.
+    bucket = (dur == 0) ? 0 : 32 - __builtin_clz(dur);
+    return MIN(bucket, PERF_BUCKET_COUNT - 1);
+}
+
+static uint32_t _perf_percentile (const _perf_hist_t * hist, uint32_t pct) {
+    uint32_t target;    // Rank of percentile among recorded durations.
+    uint32_t seen = 0;  // Number of durations in buckets so far.
+    uint32_t bound;     // Upper bound of bucket.
+    size_t bucket;      // Bucket index.
+
+    /*
+     * Walk the buckets until the one containing the requested rank is found,
+     * and estimate the percentile as the upper bound of that bucket, clamped to
+     * the range of recorded durations.
+     */
+
+    target = (uint32_t)(((uint64_t)hist->count * pct + 99) / 100);
+
+    for (bucket = 0; bucket < PERF_BUCKET_COUNT; bucket++) {
+        seen += hist->buckets[bucket];
+        if (seen >= target) {
+            break;
+        }
+    }
+
+    bound = (bucket == 0) ? 0 : (1U << bucket) - 1;
+
+    return CLAMP(bound, hist->min, hist->max);
+}
+
+static void _perf_summarize (
+    const _perf_hist_t * hist, perf_summary_t * summary
+) {
+    // Summarize histogram. An empty histogram is summarized as all zeros.
+    if (hist->count == 0) {
+        memset(summary, 0, sizeof(*summary));
+        return;
+    }
+
+    summary->count = hist->count;
+    summary->min = hist->min;
+    summary->max = hist->max;
+    summary->p50 = _perf_percentile(hist, 50);
+    summary->p95 = _perf_percentile(hist, 95);
+}
+
+int64_t perf_start (void) {
+    // Use uptime as start time.
+    return k_uptime_get();
+}
+
+void perf_record (perf_phase_t phase, int64_t start) {
+    uint32_t dur;           // Phase duration.
+    _perf_hist_t * hist;    // Histogram of phase.
+    k_spinlock_key_t key;   // Spinlock key.
+
+    // Compute duration, saturating at the largest representable value.
+    dur = (uint32_t)CLAMP(k_uptime_get() - start, 0, UINT32_MAX);
+
+    LOG_DBG("Phase %s took %u ms", _perf_phase_name[phase], dur);
+
+    // Block other contexts from accessing shared resources.
+    key = k_spin_lock(&_perf_lock);
+
+    // Add duration to histogram.
+
+    hist = &_perf_hist[phase];
+
+    if (hist->count == 0 || dur < hist->min) {
+        hist->min = dur;
+    }
+
+    if (hist->count == 0 || dur > hist->max) {
+        hist->max = dur;
+    }
+
+    hist->count++;
+    hist->buckets[_perf_bucket(dur)]++;
+
+    // Allow other contexts to access shared resources.
+    k_spin_unlock(&_perf_lock, key);
+}
+
+void perf_summary (perf_phase_t phase, perf_summary_t * summary) {
+    _perf_hist_t hist;      // Non-shared copy of histogram.
+    k_spinlock_key_t key;   // Spinlock key.
+
+    // Safely copy histogram to non-shared variable.
+    key = k_spin_lock(&_perf_lock);
+    memcpy(&hist, &_perf_hist[phase], sizeof(hist));
+    k_spin_unlock(&_perf_lock, key);
+
+    // Summarize histogram.
+    _perf_summarize(&hist, summary);
+}
+
+void perf_read (perf_data_frame_t * data_frame) {
+    perf_summary_t summary;       // Summary of phase.
+    perf_data_frame_phase_t * p;  // Data frame entry of phase.
+    perf_phase_t phase;           // Timed phase.
+
+    // Write summaries of all phases with recorded durations into data frame.
+
+    data_frame->phase_count = 0;
+
+    for (phase = 0; phase < PERF_PHASE_COUNT; phase++) {
+        perf_summary(phase, &summary);
+        if (summary.count == 0) {
+            continue;
+        }
+
+        p = &data_frame->phases[data_frame->phase_count++];
+
+        p->name = _perf_phase_name[phase];
+        p->count = (int)MIN(summary.count, INT32_MAX);
+        p->min = (int)MIN(summary.min, INT32_MAX);
+        p->max = (int)MIN(summary.max, INT32_MAX);
+        p->p50 = (int)MIN(summary.p50, INT32_MAX);
+        p->p95 = (int)MIN(summary.p95, INT32_MAX);
+    }
+}
+
+void perf_reset (void) {
+    k_spinlock_key_t key;   // Spinlock key.
+
+    // Safely clear all histograms.
+    key = k_spin_lock(&_perf_lock);
+    memset(_perf_hist, 0, sizeof(_perf_hist));
+    k_spin_unlock(&_perf_lock, key);
+
+    LOG_INF("Cleared performance histograms");
+}
+
+#if defined(CONFIG_PERF_SHELL)
+static int _perf_cmd_show (
+    const struct shell * sh, size_t argc, char ** argv
+) {
+    perf_summary_t summary;   // Summary of phase.
+    perf_phase_t phase;       // Timed phase.
+
+    // Print summary of every phase, in milliseconds.
+
+    shell_print(
+        sh, "%-12s %8s %8s %8s %8s %8s",
+        "phase", "count", "min", "p50", "p95", "max"
+    );
+
+    for (phase = 0; phase < PERF_PHASE_COUNT; phase++) {
+        perf_summary(phase, &summary);
+        shell_print(
+            sh, "%-12s %8u %8u %8u %8u %8u",
+            _perf_phase_name[phase], summary.count, summary.min,
+            summary.p50, summary.p95, summary.max
+        );
+    }
+
+    return 0;
+}
+
+static int _perf_cmd_hist (
+    const struct shell * sh, size_t argc, char ** argv
+) {
+    _perf_hist_t hist;      // Non-shared copy of histogram.
+    k_spinlock_key_t key;   // Spinlock key.
+    perf_phase_t phase;     // Timed phase.
+    size_t bucket;          // Bucket index.
+
+    // Find phase by name.
+
+    for (phase = 0; phase < PERF_PHASE_COUNT; phase++) {
+        if (strcmp(argv[1], _perf_phase_name[phase]) == 0) {
+            break;
+        }
+    }
+
+    if (phase == PERF_PHASE_COUNT) {
+        shell_error(sh, "Unknown phase: %s", argv[1]);
+        return -EINVAL;
+    }
+
+    // Safely copy histogram to non-shared variable.
+    key = k_spin_lock(&_perf_lock);
+    memcpy(&hist, &_perf_hist[phase], sizeof(hist));
+    k_spin_unlock(&_perf_lock, key);
+
+    // Print non-empty buckets along with their range, in milliseconds.
+    for (bucket = 0; bucket < PERF_BUCKET_COUNT; bucket++) {
+        if (hist.buckets[bucket] == 0) {
+            continue;
+        }
+        shell_print(
+            sh, "%8u - %8u: %u",
+            (bucket == 0) ? 0 : 1U << (bucket - 1),
+            (bucket == 0) ? 0 : (1U << bucket) - 1,
+            hist.buckets[bucket]
+        );
+    }
+
+    return 0;
+}
+
+static int _perf_cmd_reset (
+    const struct shell * sh, size_t argc, char ** argv
+) {
+    // Clear all histograms.
+    perf_reset();
+    return 0;
+}
+
+SHELL_STATIC_SUBCMD_SET_CREATE(
+    _perf_cmds,
+    SHELL_CMD_ARG(
+        show, NULL, "Show timing summary of all phases.",
+        _perf_cmd_show, 1, 0
+    ),
+    SHELL_CMD_ARG(
+        hist, NULL, "Show histogram buckets of a phase. Usage: hist <phase>",
+        _perf_cmd_hist, 2, 0
+    ),
+    SHELL_CMD_ARG(
+        reset, NULL, "Clear histograms of all phases.",
+        _perf_cmd_reset, 1, 0
+    ),
+    SHELL_SUBCMD_SET_END
+);
+
+SHELL_CMD_REGISTER(perf, &_perf_cmds, "Phase timing histograms", NULL);
+#endif
@@ -0,0 +1,117 @@
+/** @defgroup   perf Performance
+ *
+ *  @brief      Phase timing instrumentation.
+ *
+ *  This module measures how long the individual phases of a logging cycle take,
+ *  such as modem initialization, network attach, GNSS fix, or HTTP requests.
+ *  The start of a phase is marked by calling perf_start(), and its end by
+ *  calling perf_record(), which adds the duration to the histogram of that
+ *  phase. Histograms are kept in RAM, using fixed logarithmic buckets, so
+ *  recording a duration takes constant time and memory. A summary of a phase
+ *  can be obtained with perf_summary(), and summaries of all phases can be
+ *  read as a data frame with perf_read(). All histograms can be cleared by
+ *  calling perf_reset(). If the shell is enabled, the histograms can also be
+ *  inspected with the "perf" shell command. This module may be used from
+ *  several threads concurrently.
+ */
+
+#ifndef __PERF_H__
+#define __PERF_H__
+
+#include <stdint.h>
+
+#include "data.h"
+
+/** @ingroup    perf
+ *
+ *  @brief      Timed phase.
+ *
+ *  This enumeration identifies the phases of a logging cycle that are timed.
+ */
+
+typedef enum {
+    PERF_PHASE_SLEEP,         //!< Uplink stage sleeping between sessions.
+    PERF_PHASE_MODEM_INIT,    //!< Modem initialization and configuration.
+    PERF_PHASE_ATTACH,        //!< Network search and registration.
+    PERF_PHASE_ENCODE,        //!< Data frame encoding.
+    PERF_PHASE_COMPRESS,      //!< Trial compression of a batch upload.
+    PERF_PHASE_REQUEST,       //!< HTTP request, including DNS and TLS.
+    PERF_PHASE_CONNECT,       //!< Server connection, including TLS handshake.
+    PERF_PHASE_SESSION,       //!< Complete uplink session.
+    PERF_PHASE_GNSS_FIX,      //!< GNSS time to fix.
+    PERF_PHASE_DEINIT,        //!< Modem deinitialization.
+    PERF_PHASE_COUNT          //!< Number of timed phases.
+} perf_phase_t;
+
+/** @ingroup    perf
+ *
+ *  @brief      Phase timing summary.
+ *
+ *  This structure summarizes the recorded durations of a phase. Percentiles
+ *  are estimated from the histogram buckets, and are therefore accurate to
+ *  within a factor of two.
+ */
+
+typedef struct {
+    uint32_t count; //!< Number of recorded durations.
+    uint32_t min;   //!< Minimum duration in milliseconds.
+    uint32_t max;   //!< Maximum duration in milliseconds.
+    uint32_t p50;   //!< Median duration in milliseconds.
+    uint32_t p95;   //!< 95th percentile duration in milliseconds.
+} perf_summary_t;
+
+/** @ingroup    perf
+ *
+ *  @brief      Mark start of phase.
+ *
+ *  @return     Start time to be passed to perf_record().
+ */
+
+int64_t perf_start (void);
+
+/** @ingroup    perf
+ *
+ *  @brief      Record phase duration.
+ *
+ *  Adds the time elapsed since the given start time to the histogram of the
+ *  given phase.
+ *
+ *  @param      phase   Timed phase.
+ *  @param      start   Start time obtained from perf_start().
+ */
+
+void perf_record (perf_phase_t phase, int64_t start);
+
+/** @ingroup    perf
+ *
+ *  @brief      Summarize phase durations.
+ *
+ *  @param      phase   Timed phase.
+ *  @param      summary Pointer to buffer into which summary must be written.
+ */
+
+void perf_summary (perf_phase_t phase, perf_summary_t * summary);
+
+/** @ingroup    perf
+ *
+ *  @brief      Read performance data frame.
+ *
+ *  Writes summaries of all phases with at least one recorded duration into the
+ *  provided data frame, for upload as telemetry.
+ *
+ *  @param      data_frame  Pointer to buffer into which performance data frame
+ *                          must be written.
+ */
+
+void perf_read (perf_data_frame_t * data_frame);
+
+/** @ingroup    perf
+ *
+ *  @brief      Clear histograms.
+ *
+ *  Discards the recorded durations of all phases.
+ */
+
+void perf_reset (void);
+
+#endif
@@ -0,0 +1,634 @@
+#include <stdbool.h>
+#include <stddef.h>
+#include <stdint.h>
+#include <string.h>
+
+#include <zephyr/kernel.h>
+#include <zephyr/logging/log.h>
+#include <zephyr/sys/crc.h>
+
+#include "data.h"
+#include "queue.h"
+#include "journal.h"
+
+// Register module for logging.
+LOG_MODULE_REGISTER(queue, CONFIG_QUEUE_LOG_LEVEL);
+
+// Mutex protects the queue contents against concurrent access, as this is a
+// shared resource.
+static K_MUTEX_DEFINE(_queue_mutex);
+
+// Framing of batches. Batches are JSON arrays, or, if data frames are encoded
+// in CBOR format, indefinite-length CBOR arrays.
+#if defined(CONFIG_DATA_FORMAT_CBOR)
+#define QUEUE_BATCH_HEAD    "\x9f"
+#define QUEUE_BATCH_SEP     ""
+#define QUEUE_BATCH_TAIL    "\xff"
+#else
+#define QUEUE_BATCH_HEAD    "["
+#define QUEUE_BATCH_SEP     ","
+#define QUEUE_BATCH_TAIL    "]"
+#endif
+
+// Number of frames discarded so far to make room for new ones. Positions of
+// frames obtained before a discard may no longer be valid afterwards.
+static uint32_t _queue_discards = 0;
+
+// Sequence number of the next data frame. If the queue is persistent, it is
+// recovered from the journal, so that it keeps increasing across reboots.
+static uint32_t _queue_seq = 0;
+
+#if defined(CONFIG_QUEUE_SEQ_RETAINED)
+
+// Copy of the sequence number of the next data frame, kept in RAM that is not
+// cleared on reset, so that sequence numbers keep increasing across resets
+// even though the queue is in RAM. It is only trusted if its checksum matches.
+typedef struct {
+    uint32_t seq;   // Sequence number of next data frame.
+    uint32_t crc;   // Checksum of the member above.
+} _queue_retained_t;
+
+static __noinit _queue_retained_t _queue_retained;
+
+static uint32_t _queue_retained_crc (void) {
+    // Compute checksum of retained sequence number.
+    return crc32_ieee(
+        (const uint8_t *)&_queue_retained, offsetof(_queue_retained_t, crc)
+    );
+}
+
+#endif
+
+#if defined(CONFIG_QUEUE_PERSISTENT)
+
+// Position of a frame in the queue. Frames are stored in the journal on flash.
+typedef journal_entry_t _queue_pos_t;
+
+static size_t _queue_stored_all (void) {
+    size_t count = 0;   // Total frame count.
+    data_type_t type;   // Data frame type.
+
+    // Sum unacknowledged frames of all types in journal.
+    for (type = 0; type < DATA_TYPE_COUNT; type++) {
+        count += journal_count(type);
+    }
+    return count;
+}
+
+static int _queue_store (
+    data_type_t type, uint32_t seq, const char * frame, size_t len
+) {
+    size_t count;   // Frame count before appending.
+
+    // Append frame to journal. The journal discards its oldest sector if full,
+    // which shows as fewer frames than expected afterwards.
+    count = _queue_stored_all();
+    if (journal_append(type, seq, frame, len) < 0) {
+        return -1;
+    }
+    if (_queue_stored_all() <= count) {
+        _queue_discards++;
+    }
+    return 0;
+}
+
+static size_t _queue_stored (data_type_t type) {
+    // Count unacknowledged frames in journal.
+    return journal_count(type);
+}
+
+static int _queue_first (data_type_t type, _queue_pos_t * pos, size_t * len) {
+    // Locate oldest unacknowledged frame in journal.
+    if (journal_first(type, pos) < 0) {
+        return -1;
+    }
+    *len = pos->len;
+    return 0;
+}
+
+static int _queue_next (data_type_t type, _queue_pos_t * pos, size_t * len) {
+    // Locate following frame in journal.
+    if (journal_next(type, pos) < 0) {
+        return -1;
+    }
+    *len = pos->len;
+    return 0;
+}
+
+static int _queue_load (const _queue_pos_t * pos, char * buf) {
+    // Read frame from journal.
+    return journal_read(pos, buf);
+}
+
+static void _queue_remove (data_type_t type, uint32_t first, uint32_t last) {
+    // Acknowledge frames in journal.
+    journal_ack(type, first, last);
+}
+
+#else
+
+// Header preceding each frame in the ring buffer.
+typedef struct {
+    uint32_t seq;   // Frame sequence number.
+    uint16_t len;   // Frame length.
+    uint8_t type;   // Frame type.
+    uint8_t valid;  // Frame not yet removed.
+} _queue_hdr_t;
+
+// Position of a frame in the queue. Frames are stored in the ring buffer, and
+// their position is tracked as the offset of the frame header and the number of
+// frames preceding it, along with the sequence number of the frame.
+typedef struct {
+    size_t off;     // Offset of frame header in ring buffer.
+    size_t index;   // Number of preceding frames.
+    uint32_t seq;   // Frame sequence number.
+} _queue_pos_t;
+
+// Ring buffer holding queued frames. Each frame is stored as a header followed
+// by the frame contents, and may wrap around the end of the buffer. Frames of
+// all types share the buffer. A frame that is removed while frames of other
+// types precede it is only marked as removed, and its space is reclaimed once
+// all frames before it have been removed too. The read offset points to the
+// oldest frame, and the number of used bytes, stored frames, and valid frames
+// of each type are tracked separately.
+static uint8_t _queue_buf[CONFIG_QUEUE_BUF_SIZE];
+static size_t _queue_rd = 0;
+static size_t _queue_used = 0;
+static size_t _queue_frames = 0;
+static size_t _queue_valid[DATA_TYPE_COUNT];
+
+static void _queue_copy_in (size_t off, const void * src, size_t len) {
+    size_t part;    // Length of part before buffer end.
+
+    // Copy data into ring buffer, wrapping around at the end.
+    off %= sizeof(_queue_buf);
+    part = MIN(len, sizeof(_queue_buf) - off);
+    memcpy(&_queue_buf[off], src, part);
+    memcpy(_queue_buf, (const uint8_t *)src + part, len - part);
+}
+
+static void _queue_copy_out (size_t off, void * dst, size_t len) {
+    size_t part;    // Length of part before buffer end.
+
+    // Copy data out of ring buffer, wrapping around at the end.
+    off %= sizeof(_queue_buf);
+    part = MIN(len, sizeof(_queue_buf) - off);
+    memcpy(dst, &_queue_buf[off], part);
+    memcpy((uint8_t *)dst + part, _queue_buf, len - part);
+}
+
+static void _queue_drop (void) {
+    _queue_hdr_t hdr;   // Frame header.
+
+    // Remove oldest frame from ring buffer.
+    _queue_copy_out(_queue_rd, &hdr, sizeof(hdr));
+
+    if (hdr.valid) {
+        LOG_WRN("Queue full, discarding oldest data frame");
+        _queue_valid[hdr.type]--;
+        _queue_discards++;
+    }
+
+    _queue_rd = (_queue_rd + sizeof(hdr) + hdr.len) % sizeof(_queue_buf);
+    _queue_used -= sizeof(hdr) + hdr.len;
+    _queue_frames--;
+}
+
+static int _queue_find (
+    data_type_t type, _queue_pos_t * pos, _queue_hdr_t * hdr
+) {
+    // Starting at the given position, find the next valid frame of the given
+    // type.
+    while (pos->index < _queue_frames) {
+        _queue_copy_out(pos->off, hdr, sizeof(*hdr));
+        if (hdr->valid && hdr->type == type) {
+            return 0;
+        }
+        pos->off = (pos->off + sizeof(*hdr) + hdr->len) % sizeof(_queue_buf);
+        pos->index++;
+    }
+
+    return -1;
+}
+
+static int _queue_store (
+    data_type_t type, uint32_t seq, const char * frame, size_t len
+) {
+    _queue_hdr_t hdr;   // Frame header.
+    size_t wr;          // Write offset.
+
+    /*
+     * Check that the frame can fit in the ring buffer at all. If not, exit with
+     * failure.
+     */
+
+    if (len > UINT16_MAX || sizeof(hdr) + len > sizeof(_queue_buf)) {
+        LOG_ERR("Failed to queue data frame (Frame too large)");
+        return -1;
+    }
+
+    /*
+     * Discard oldest frames until there is enough free space for the new one,
+     * and then append it to the end of the ring buffer.
+     */
+
+    while (sizeof(_queue_buf) - _queue_used < sizeof(hdr) + len) {
+        _queue_drop();
+    }
+
+    hdr.seq = seq;
+    hdr.len = (uint16_t)len;
+    hdr.type = (uint8_t)type;
+    hdr.valid = true;
+    wr = _queue_rd + _queue_used;
+
+    _queue_copy_in(wr, &hdr, sizeof(hdr));
+    _queue_copy_in(wr + sizeof(hdr), frame, len);
+
+    _queue_used += sizeof(hdr) + len;
+    _queue_frames++;
+    _queue_valid[type]++;
+
+    return 0;
+}
+
+static size_t _queue_stored (data_type_t type) {
+    // Count valid frames of given type in ring buffer.
+    return _queue_valid[type];
+}
+
+static int _queue_first (data_type_t type, _queue_pos_t * pos, size_t * len) {
+    _queue_hdr_t hdr;   // Frame header.
+
+    // Locate oldest valid frame of given type in ring buffer.
+    pos->off = _queue_rd;
+    pos->index = 0;
+    if (_queue_find(type, pos, &hdr) < 0) {
+        return -1;
+    }
+    pos->seq = hdr.seq;
+    *len = hdr.len;
+    return 0;
+}
+
+static int _queue_next (data_type_t type, _queue_pos_t * pos, size_t * len) {
+    _queue_hdr_t hdr;   // Frame header.
+
+    // Locate following valid frame of given type in ring buffer.
+    _queue_copy_out(pos->off, &hdr, sizeof(hdr));
+    pos->off = (pos->off + sizeof(hdr) + hdr.len) % sizeof(_queue_buf);
+    pos->index++;
+    if (_queue_find(type, pos, &hdr) < 0) {
+        return -1;
+    }
+    pos->seq = hdr.seq;
+    *len = hdr.len;
+    return 0;
+}
+
+static int _queue_load (const _queue_pos_t * pos, char * buf) {
+    _queue_hdr_t hdr;   // Frame header.
+
+    // Copy frame out of ring buffer.
+    _queue_copy_out(pos->off, &hdr, sizeof(hdr));
+    _queue_copy_out(pos->off + sizeof(hdr), buf, hdr.len);
+    return 0;
+}
+
+static void _queue_remove (data_type_t type, uint32_t first, uint32_t last) {
+    _queue_pos_t pos;   // Position of current frame.
+    _queue_hdr_t hdr;   // Frame header.
+    size_t removed = 0; // Number of frames removed.
+
+    // Mark oldest valid frames of given type whose sequence numbers lie in the
+    // given range as removed. Frames of a type are queued in order of their
+    // sequence numbers, so the range ends at the first frame beyond it.
+
+    pos.off = _queue_rd;
+    pos.index = 0;
+
+    while (_queue_find(type, &pos, &hdr) == 0) {
+        if (hdr.seq - first > last - first) {
+            // Skip frame before range, or stop at frame beyond it.
+            if (removed > 0) {
+                break;
+            }
+        } else {
+            hdr.valid = false;
+            _queue_copy_in(pos.off, &hdr, sizeof(hdr));
+            _queue_valid[type]--;
+            removed++;
+        }
+        pos.off = (pos.off + sizeof(hdr) + hdr.len) % sizeof(_queue_buf);
+        pos.index++;
+    }
+
+    // Reclaim space of removed frames at the start of the ring buffer.
+
+    while (_queue_frames > 0) {
+        _queue_copy_out(_queue_rd, &hdr, sizeof(hdr));
+        if (hdr.valid) {
+            break;
+        }
+        _queue_drop();
+    }
+}
+
+#endif
+
+static int _queue_read (
+    data_type_t type, _queue_pos_t * pos, size_t * flen, char * frame,
+    size_t len, uint32_t discards
+) {
+    int status; // Return status for API calls.
+
+    // Block other threads from accessing shared resources.
+    k_mutex_lock(&_queue_mutex, K_FOREVER);
+
+    /*
+     * Check that no frames have been discarded since the position was obtained,
+     * copy the frame at the position into the output buffer, and advance the
+     * position and frame length to those of the following frame of the given
+     * type, or set the frame length to 0 at the end of the queue.
+     */
+
+    if (_queue_discards != discards) {
+        LOG_ERR("Failed to read data frame (Frames discarded)");
+        status = -1;
+    } else if (*flen > len) {
+        LOG_ERR("Failed to read data frame (Frame too large)");
+        status = -1;
+    } else {
+        status = _queue_load(pos, frame);
+    }
+
+    if (status == 0 && _queue_next(type, pos, flen) < 0) {
+        // Mark end of queue.
+        *flen = 0;
+    }
+
+    // Allow other threads to access shared resources.
+    k_mutex_unlock(&_queue_mutex);
+
+    return status;
+}
+
+int queue_init (void) {
+#if defined(CONFIG_QUEUE_PERSISTENT)
+    // Recover persistent queue from flash, and continue sequence numbers from
+    // where they left off.
+    if (journal_init() < 0) {
+        return -1;
+    }
+    _queue_seq = journal_seq() & INT32_MAX;
+    LOG_INF("Data frame sequence numbers start at %u", _queue_seq);
+    return 0;
+#elif defined(CONFIG_QUEUE_SEQ_RETAINED)
+    // Continue sequence numbers from where they left off before the reset, or
+    // start them from 0 if the retained copy is not valid, as after a power
+    // cycle.
+    if (_queue_retained.crc == _queue_retained_crc()) {
+        _queue_seq = _queue_retained.seq & INT32_MAX;
+    }
+    LOG_INF("Data frame sequence numbers start at %u", _queue_seq);
+    return 0;
+#else
+    // Nothing to recover for queue in RAM.
+    return 0;
+#endif
+}
+
+uint32_t queue_seq (void) {
+    uint32_t seq;   // Non-shared copy of sequence number.
+
+    // Safely take next sequence number. Sequence numbers are kept within the
+    // range of data frame integers.
+    k_mutex_lock(&_queue_mutex, K_FOREVER);
+    seq = _queue_seq;
+    _queue_seq = (_queue_seq + 1) & INT32_MAX;
+#if defined(CONFIG_QUEUE_SEQ_RETAINED)
+    _queue_retained.seq = _queue_seq;
+    _queue_retained.crc = _queue_retained_crc();
+#endif
+    k_mutex_unlock(&_queue_mutex);
+
+    return seq;
+}
+
+int queue_push (
+    data_type_t type, uint32_t seq, const char * frame, size_t len
+) {
+    int status; // Return status for API calls.
+
+    // Block other threads from accessing shared resources.
+    k_mutex_lock(&_queue_mutex, K_FOREVER);
+
+    // Append frame to end of queue.
+    status = _queue_store(type, seq, frame, len);
+    if (status == 0) {
+        LOG_INF("Queued data frame (%u queued)", _queue_stored(type));
+    }
+
+    // Allow other threads to access shared resources.
+    k_mutex_unlock(&_queue_mutex);
+
+    return status;
+}
+
+size_t queue_count (data_type_t type) {
+    size_t count;   // Non-shared copy of frame count.
+
+    // Safely copy frame count to non-shared variable.
+    k_mutex_lock(&_queue_mutex, K_FOREVER);
+    count = _queue_stored(type);
+    k_mutex_unlock(&_queue_mutex);
+
+    return count;
+}
+
+size_t queue_count_all (void) {
+    size_t count = 0;   // Total frame count.
+    data_type_t type;   // Data frame type.
+
+    // Safely sum frame counts of all types.
+    k_mutex_lock(&_queue_mutex, K_FOREVER);
+    for (type = 0; type < DATA_TYPE_COUNT; type++) {
+        count += _queue_stored(type);
+    }
+    k_mutex_unlock(&_queue_mutex);
+
+    return count;
+}
+
+#if defined(CONFIG_DATA_CBOR_DELTA)
+
+static int _queue_delta (
+    const char * prev, size_t plen, const char * frame, size_t len,
+    queue_write_t write, void * ctx
+) {
+    // Delta-encode frame against previous frame.
+    return data_cbor_delta(
+        (const uint8_t *)prev, plen, (const uint8_t *)frame, len, write, ctx
+    );
+}
+
+#endif
+
+int queue_stream (
+    data_type_t type, char * frame, size_t len, size_t max,
+    queue_write_t write, void * ctx, queue_batch_t * batch
+) {
+    int status;         // Return status for API calls.
+    _queue_pos_t pos;   // Position of next frame.
+    size_t flen;        // Length of next frame.
+    uint32_t seq;       // Sequence number of current frame.
+    size_t size;        // Length of array written so far.
+    size_t n = 0;       // Number of frames in batch.
+    uint32_t discards;  // Number of discarded frames at start.
+    size_t sep;         // Length of separator before current frame.
+    char * cur;         // Current frame.
+    size_t clen;        // Length of current frame.
+    int wlen;           // Length of current frame as written.
+#if defined(CONFIG_DATA_CBOR_DELTA)
+    char * prev;        // Previous frame.
+    size_t plen;        // Length of previous frame.
+#endif
+
+    /*
+     * Write the oldest frames of the given type to the output as elements of
+     * an array, for as long as the array stays within the given size. Each
+     * frame is copied out of the queue while it is locked, and then written
+     * while it is unlocked, so that other threads are not held up while the
+     * output is written. The frames themselves are left in the queue. If
+     * delta encoding is configured, every frame but the first is written as a
+     * delta from the frame before it, so the frame buffer is split in two to
+     * hold both. If an error occurs in this process, exit with failure.
+     */
+
+#if defined(CONFIG_DATA_CBOR_DELTA)
+    len /= 2;
+    prev = frame + len;
+    plen = 0;
+#endif
+    cur = frame;
+
+    // Locate oldest frame.
+
+    k_mutex_lock(&_queue_mutex, K_FOREVER);
+    discards = _queue_discards;
+    status = _queue_first(type, &pos, &flen);
+    k_mutex_unlock(&_queue_mutex);
+
+    if (status < 0) {
+        // On empty queue, exit with failure.
+        LOG_ERR("Failed to stream batch of data frames (Queue empty)");
+        return -1;
+    }
+
+    // Write start of array.
+
+    if (write(ctx, QUEUE_BATCH_HEAD, sizeof(QUEUE_BATCH_HEAD) - 1) < 0) {
+        return -1;
+    }
+
+    size = sizeof(QUEUE_BATCH_HEAD) - 1;
+
+    // Write frames.
+
+    while (flen > 0) {
+        clen = flen;
+        seq = pos.seq;
+
+        status = _queue_read(type, &pos, &flen, cur, len, discards);
+        if (status < 0) {
+            return -1;
+        }
+
+#if defined(CONFIG_DATA_CBOR_DELTA)
+        // Measure delta from previous frame.
+        wlen = n > 0 ? _queue_delta(prev, plen, cur, clen, NULL, NULL)
+            : (int)clen;
+        if (wlen < 0) {
+            return -1;
+        }
+#else
+        wlen = clen;
+#endif
+
+        // Check for space for separator, frame, and end of array. The first
+        // frame is always written, so that every batch makes progress.
+        sep = n > 0 ? sizeof(QUEUE_BATCH_SEP) - 1 : 0;
+        if (
+            n > 0
+            && size + sep + wlen + sizeof(QUEUE_BATCH_TAIL) - 1 > max
+        ) {
+            break;
+        }
+
+        if (sep > 0 && write(ctx, QUEUE_BATCH_SEP, sep) < 0) {
+            return -1;
+        }
+
+#if defined(CONFIG_DATA_CBOR_DELTA)
+        // Write delta from previous frame, and keep current frame as the
+        // reference for the next delta.
+        status = n > 0 ? _queue_delta(prev, plen, cur, clen, write, ctx)
+            : write(ctx, cur, clen);
+        prev = cur;
+        plen = clen;
+        cur = cur == frame ? frame + len : frame;
+#else
+        status = write(ctx, cur, clen);
+#endif
+        if (status < 0) {
+            return -1;
+        }
+
+        size += sep + wlen;
+        n++;
+
+        // Extend range of batch to frame.
+        if (n == 1) {
+            batch->first = seq;
+        }
+        batch->last = seq;
+    }
+
+    // Write end of array.
+
+    if (write(ctx, QUEUE_BATCH_TAIL, sizeof(QUEUE_BATCH_TAIL) - 1) < 0) {
+        return -1;
+    }
+
+    size += sizeof(QUEUE_BATCH_TAIL) - 1;
+
+    batch->count = n;
+    batch->discards = discards;
+
+    LOG_INF(
+        "Streamed batch of %u data frames %u-%u (%u bytes)",
+        n, batch->first, batch->last, size
+    );
+
+    return 0;
+}
+
+void queue_release (data_type_t type, const queue_batch_t * batch) {
+    if (batch->count == 0) {
+        return;
+    }
+
+    // Block other threads from accessing shared resources.
+    k_mutex_lock(&_queue_mutex, K_FOREVER);
+
+    // Remove frames of the batch. Frames discarded since the batch was
+    // streamed are no longer in the queue, so only those still present are
+    // removed, while newer frames are left in place.
+    if (_queue_discards != batch->discards) {
+        LOG_WRN("Frames discarded during upload, releasing remaining ones");
+    }
+    _queue_remove(type, batch->first, batch->last);
+
+    // Allow other threads to access shared resources.
+    k_mutex_unlock(&_queue_mutex);
+}
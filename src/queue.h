@@ -0,0 +1,192 @@
+/** @defgroup   queue Queue
+ *
+ *  @brief      Data frame queueing.
+ *
+ *  This module stores encoded data frames until they are uploaded, so that
+ *  several frames can be sent together in a single request. Frames are kept in
+ *  RAM, or, if configured, in the persistent journal on flash memory, in which
+ *  case they survive reboots. The queue must be initialized by calling
+ *  queue_init() before use. Frames of all data frame types share the queue,
+ *  but are batched and removed separately for each type. Every frame carries a
+ *  sequence number, obtained by calling queue_seq() before it is encoded, so
+ *  that the server can recognize frames that it receives more than once. If
+ *  the queue is persistent, sequence numbers keep increasing across reboots.
+ *  Frames are added to the end of the queue by calling queue_push(). The number of queued frames
+ *  can be checked with queue_count() and queue_count_all(). The oldest frames
+ *  of a type can be streamed out as a single JSON or CBOR array, matching the
+ *  configured encoding, by calling queue_stream(), and once the batch has been
+ *  uploaded, they can be removed from the queue by calling queue_release(). If
+ *  the queue runs out of space, the oldest frames are discarded to make room
+ *  for new ones. The queue may be used from several threads concurrently.
+ */
+
+#ifndef __QUEUE_H__
+#define __QUEUE_H__
+
+#include <stddef.h>
+#include <stdint.h>
+
+#include "data.h"
+
+/** @ingroup    queue
+ *
+ *  @brief      Output function for streamed batches.
+ *
+ *  Function called by queue_stream() to write each piece of a batch.
+ *
+ *  @param      ctx     Context given along with the output function.
+ *  @param      data    Pointer to data that must be written.
+ *  @param      len     Length of data.
+ *
+ *  @retval     0       Success.
+ *  @retval     -1      Failure. Streaming is aborted.
+ */
+
+typedef int (* queue_write_t) (void * ctx, const void * data, size_t len);
+
+/** @ingroup    queue
+ *
+ *  @brief      Streamed batch.
+ *
+ *  This structure describes a batch of frames written by queue_stream(). It
+ *  identifies the frames of the batch by the range of their sequence numbers,
+ *  so that queue_release() removes exactly these frames, even if older frames
+ *  were discarded from the queue in the meantime.
+ */
+
+typedef struct {
+    size_t count;       //!< Number of frames in batch.
+    uint32_t first;     //!< Sequence number of first frame in batch.
+    uint32_t last;      //!< Sequence number of last frame in batch.
+    uint32_t discards;  //!< Number of frames discarded before batch.
+} queue_batch_t;
+
+/** @ingroup    queue
+ *
+ *  @brief      Initialize queue.
+ *
+ *  Prepares the queue for use. If the queue is configured to be persistent,
+ *  the journal is recovered from flash memory, along with any frames that were
+ *  queued but not uploaded before the last reboot.
+ *
+ *  @retval     0   Success.
+ *  @retval     -1  Failure.
+ */
+
+int queue_init (void);
+
+/** @ingroup    queue
+ *
+ *  @brief      Obtain sequence number for new frame.
+ *
+ *  Obtains the sequence number that the next data frame must carry. Every call
+ *  returns a number one larger than the previous one, wrapping around to 0
+ *  after INT32_MAX.
+ *
+ *  @return     Sequence number.
+ */
+
+uint32_t queue_seq (void);
+
+/** @ingroup    queue
+ *
+ *  @brief      Add frame to queue.
+ *
+ *  Copies the given encoded data frame to the end of the queue. If there is not
+ *  enough free space in the queue, the oldest frames are discarded until the
+ *  new frame fits.
+ *
+ *  @param      type    Data frame type.
+ *  @param      seq     Sequence number carried by the data frame.
+ *  @param      frame   Pointer to buffer containing encoded data frame.
+ *  @param      len     Length of encoded data frame, excluding any
+ *                      terminating null byte.
+ *
+ *  @retval     0       Success.
+ *  @retval     -1      Failure. Frame is too large to ever fit in the queue,
+ *                      or could not be stored.
+ */
+
+int queue_push (
+    data_type_t type, uint32_t seq, const char * frame, size_t len
+);
+
+/** @ingroup    queue
+ *
+ *  @brief      Count queued frames of a type.
+ *
+ *  Obtains the number of frames of the given type currently stored in the
+ *  queue.
+ *
+ *  @param      type    Data frame type.
+ *
+ *  @return     Number of queued frames.
+ */
+
+size_t queue_count (data_type_t type);
+
+/** @ingroup    queue
+ *
+ *  @brief      Count all queued frames.
+ *
+ *  Obtains the number of frames of all types currently stored in the queue.
+ *
+ *  @return     Number of queued frames.
+ */
+
+size_t queue_count_all (void);
+
+/** @ingroup    queue
+ *
+ *  @brief      Stream batch of queued frames.
+ *
+ *  Writes as many of the oldest queued frames of the given type as fit within
+ *  the given size to the given output function, as a single JSON array, or, if
+ *  data frames are encoded in CBOR format, as a single indefinite-length CBOR
+ *  array. The oldest frame is always written, even if it alone exceeds the
+ *  given size. Frames are copied out of the queue one at a time through the
+ *  provided frame buffer, so the batch is never held in memory as a whole, and
+ *  the queue is not locked while the output function runs. The frames are not
+ *  removed from the queue. Once the batch has been successfully uploaded,
+ *  queue_release() must be called to remove them. This function fails if
+ *  frames are discarded from the queue while the batch is being written. If
+ *  delta encoding is configured, every frame but the first is written as a
+ *  delta from the frame before it, as produced by data_cbor_delta(), and the
+ *  frame buffer must be large enough to hold two frames.
+ *
+ *  @param      type    Data frame type.
+ *  @param      frame   Pointer to buffer through which frames are copied.
+ *  @param      len     Length of frame buffer.
+ *  @param      max     Maximum length of array.
+ *  @param      write   Output function.
+ *  @param      ctx     Context passed to output function.
+ *  @param      batch   Pointer to structure into which the description of the
+ *                      batch must be written.
+ *
+ *  @retval     0       Success.
+ *  @retval     -1      Failure. Queue holds no frames of the given type, a
+ *                      frame does not fit in the frame buffer, frames were
+ *                      discarded, or the output function failed.
+ */
+
+int queue_stream (
+    data_type_t type, char * frame, size_t len, size_t max,
+    queue_write_t write, void * ctx, queue_batch_t * batch
+);
+
+/** @ingroup    queue
+ *
+ *  @brief      Remove frames from queue.
+ *
+ *  Removes the frames of the given batch from the queue. This function is
+ *  intended to be called once a batch assembled by queue_stream() has been
+ *  successfully uploaded. Frames of the batch that have been discarded in the
+ *  meantime are skipped, and frames queued after the batch are left in place.
+ *
+ *  @param      type    Data frame type.
+ *  @param      batch   Pointer to description of batch.
+ */
+
+void queue_release (data_type_t type, const queue_batch_t * batch);
+
+#endif
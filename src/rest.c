@@ -1,287 +1,1376 @@
 #include <stdlib.h>
 #include <stdbool.h>
+#include <stdint.h>
+#include <stdio.h>
 #include <string.h>
+#include <errno.h>
 
 #include <zephyr/kernel.h>
 #include <zephyr/logging/log.h>
+#include <zephyr/sys/util.h>
+#include <zephyr/sys/crc.h>
 #include <zephyr/net/socket.h>
 #include <zephyr/net/tls_credentials.h>
+#include <zephyr/net/http_client.h>
+#include <zephyr/net/http/parser.h>
 
-#include <net/rest_client.h>
+#include "rest.h"
+#include "perf.h"
+
+#if defined(CONFIG_REST_COAP)
+#include <zephyr/net/coap.h>
+
+#include "coapc.h"
+#endif
+
+#if defined(CONFIG_REST_MQTT)
+#include "mqttc.h"
+#endif
 
 // Register module for logging.
 LOG_MODULE_REGISTER(rest, CONFIG_REST_LOG_LEVEL);
 
-// HTTP response buffer.
-static char _rest_resp[CONFIG_REST_BUF_SIZE];
+// Room before the data of a chunk for its size line, which is written with a
+// fixed number of digits, and after it for its line break, followed by the
+// last chunk if it ends the payload.
+#define REST_CHUNK_HEAD 10
+#define REST_CHUNK_TAIL 7
+
+// Room for a chunk, along with its framing.
+#define REST_CHUNK_ROOM                                                        \
+    (REST_CHUNK_HEAD + CONFIG_REST_CHUNK_SIZE + REST_CHUNK_TAIL)
+
+#if defined(CONFIG_REST_LEAN_HTTP)
+
+BUILD_ASSERT(
+    CONFIG_REST_SEND_BUF_SIZE >= REST_CHUNK_ROOM,
+    "REST send buffer must hold a chunk along with its framing"
+);
+
+// Size of send buffer, which holds a chunk, and ahead of it the request head,
+// if it has not been sent yet.
+#define REST_SEND_BUF_SIZE CONFIG_REST_SEND_BUF_SIZE
+
+// Request headers, which are the same for every request.
+#define REST_HEADERS                                                           \
+    "Host: " CONFIG_REST_HOST_NAME "\r\n"                                      \
+    "x-apikey: " CONFIG_REST_API_KEY "\r\n"                                    \
+    "Content-Type: " CONFIG_REST_CONT_TYPE "\r\n"
+
+#else
+
+// Size of send buffer, which holds a chunk.
+#define REST_SEND_BUF_SIZE REST_CHUNK_ROOM
+
+#endif
+
+// Streamed request payload. Data written to the stream is collected in the
+// send buffer, and sent as a single chunk, together with the request head if
+// it has not been sent yet, once the chunk is full, or, if the request is made
+// over CoAP or MQTT, passed on to the CoAP transfer or MQTT message.
+struct rest_stream {
+    int sock;                           // Socket descriptor.
+#if defined(CONFIG_REST_COAP)
+    coapc_xfer_t * xfer;                // CoAP transfer, or NULL.
+#endif
+#if defined(CONFIG_REST_MQTT)
+    mqttc_msg_t * msg;                  // MQTT message, or NULL.
+#endif
+    const char * encoding;              // Content encoding, or NULL.
+    rest_stream_cb_t cb;                // Payload writer.
+    void * user_data;                   // User data passed to payload writer.
+    size_t head;                        // Length of request head not sent.
+    uint8_t * chunk;                    // Chunk in send buffer.
+    size_t fill;                        // Number of bytes in chunk.
+    size_t sent;                        // Number of payload bytes sent.
+};
+
+// HTTP response. The response payload is copied into the buffer provided with
+// the request, or discarded if there is none.
+typedef struct {
+    uint16_t code;          // Response code.
+    char * buf;             // Buffer for response payload, or NULL.
+    size_t size;            // Size of buffer.
+    size_t len;             // Length of response payload.
+    bool overflow;          // Response payload did not fit in buffer.
+    rest_stream_t * stream; // Streamed request payload, if any.
+} _rest_resp_t;
+
+// HTTP method, name, and expected response code of each request method.
+static const struct {
+    enum http_method method;    // HTTP method.
+    const char * name;          // Method name.
+    uint16_t code;              // Expected response code.
+} _rest_methods [] = {
+    [REST_METHOD_GET] = {HTTP_GET, "GET", 200},
+    [REST_METHOD_PUT] = {HTTP_PUT, "PUT", 200},
+    [REST_METHOD_POST] = {HTTP_POST, "POST", 201},
+    [REST_METHOD_DELETE] = {HTTP_DELETE, "DELETE", 200}
+};
+
+#if defined(CONFIG_REST_COAP)
+
+// CoAP method, and expected response code of each request method. Response
+// codes are written as class times 100 plus detail, so that 2.01 Created, for
+// instance, reads as 201, like its HTTP counterpart.
+static const struct {
+    uint8_t method;             // CoAP method.
+    uint16_t code;              // Expected response code.
+} _rest_coap_methods [] = {
+    [REST_METHOD_GET] = {COAP_METHOD_GET, 205},
+    [REST_METHOD_PUT] = {COAP_METHOD_PUT, 204},
+    [REST_METHOD_POST] = {COAP_METHOD_POST, 201},
+    [REST_METHOD_DELETE] = {COAP_METHOD_DELETE, 202}
+};
+
+#endif
+
+// Work queue on which requests are made, one at a time.
+K_THREAD_STACK_DEFINE(_rest_work_stack, CONFIG_REST_STACK_SIZE);
+static struct k_work_q _rest_work_q;
+
+// Connection to server, kept open between requests if configured, or -1 if no
+// connection is open. It is only used on the work queue, so that requests from
+// different threads never share it at the same time.
+static int _rest_sock = -1;
+
+// Buffer in which requests, or their chunks, are assembled before being sent.
+// It is only used on the work queue, like the connection.
+static uint8_t _rest_send_buf[REST_SEND_BUF_SIZE];
+
+// TLS session cached by the modem from an earlier handshake, which the next
+// connection can resume.
+static bool _rest_session = false;
+
+#if defined(CONFIG_REST_DNS_CACHE)
+
+// Cached server address, which saves a DNS lookup for every connection.
+typedef struct {
+    uint32_t host;              // Checksum of host name.
+    struct sockaddr_in addr;    // Server address.
+    int64_t expiry;             // Uptime at which address expires.
+    int64_t stamp;              // Uptime at which address was last used.
+    uint32_t crc;               // Checksum of the members above.
+} _rest_dns_t;
+
+// Cache of server address. If configured, it is kept in RAM that is not
+// cleared on reset, so that it survives resets as well as LTE sessions, and is
+// only trusted if its checksum matches. Flag tells whether its expiry time has
+// been carried over to the uptime since the last reset.
+#if defined(CONFIG_REST_DNS_CACHE_RETAINED)
+static __noinit _rest_dns_t _rest_dns;
+#else
+static _rest_dns_t _rest_dns;
+#endif
+static bool _rest_dns_rebased = false;
+
+#endif
+
+// Connection statistics. Mutex protects against concurrent access, as this is
+// a shared resource.
+static K_MUTEX_DEFINE(_rest_stats_mutex);
+static rest_stats_t _rest_stats = {
+    .requests = 0,
+    .handshakes = 0,
+    .reused = 0,
+    .reconnects = 0,
+    .session_offered = 0,
+    .full_ms = 0,
+    .session_offered_ms = 0,
+    .dns_hits = 0,
+    .dns_misses = 0
+};
+
+static void _rest_count (uint32_t * counter) {
+    // Increment statistics counter.
+    k_mutex_lock(&_rest_stats_mutex, K_FOREVER);
+    (*counter)++;
+    k_mutex_unlock(&_rest_stats_mutex);
+}
 
-int rest_get (const char * url, char * payload) {
-    int status; // Return status for API calls.
+#if defined(CONFIG_REST_DNS_CACHE)
 
-    struct rest_client_req_context req;     // HTTP request.
-    struct rest_client_resp_context resp;   // HTTP response.
+static uint32_t _rest_dns_crc (void) {
+    // Compute checksum of cached server address.
+    return crc32_ieee(
+        (const uint8_t *)&_rest_dns, offsetof(_rest_dns_t, crc)
+    );
+}
 
-    // HTTP request headers.
-    const char * header_fields [] = {
-        "content-type: " CONFIG_REST_CONT_TYPE "\r\n",
-        "x-apikey: " CONFIG_REST_API_KEY "\r\n",
-        NULL
-    };
+static bool _rest_dns_lookup (struct sockaddr_in * addr) {
+    int64_t now = k_uptime_get();   // Current uptime.
 
     /*
-     * Make HTTP request and interpret response. If an error occurs in this
-     * process, or if the response has an unexpected code, exit with failure.
+     * Take server address from cache, if the cache holds a valid address of
+     * the configured host that has not expired. The first time after a reset,
+     * uptime has started again from 0, so the lifetime left at the last use of
+     * the address is carried over to the new uptime.
      */
 
-    // Create HTTP request.
+    if (
+        _rest_dns.crc != _rest_dns_crc()
+        || _rest_dns.host != crc32_ieee(
+            (const uint8_t *)CONFIG_REST_HOST_NAME,
+            strlen(CONFIG_REST_HOST_NAME)
+        )
+    ) {
+        return false;
+    }
 
-    req.host = CONFIG_REST_HOST_NAME;
-    req.port = CONFIG_REST_PORT_NUM;
-    req.url = url;
+    if (!_rest_dns_rebased) {
+        _rest_dns.expiry = now + MAX(_rest_dns.expiry - _rest_dns.stamp, 0);
+        _rest_dns_rebased = true;
+    }
+
+    if (now >= _rest_dns.expiry) {
+        return false;
+    }
 
-    req.http_method = HTTP_GET;
-    req.header_fields = header_fields;
-    req.body = NULL;
+    _rest_dns.stamp = now;
+    _rest_dns.crc = _rest_dns_crc();
 
-    req.connect_socket = REST_CLIENT_SCKT_CONNECT;
-    req.keep_alive = false;
-    req.timeout_ms = 1000 * CONFIG_REST_REQ_TIMEOUT;
+    *addr = _rest_dns.addr;
 
-    req.sec_tag = CONFIG_REST_SEC_TAG;
-    req.tls_peer_verify = TLS_PEER_VERIFY_NONE;
+    return true;
+}
 
-    req.resp_buff = _rest_resp;
-    req.resp_buff_len = sizeof(_rest_resp);
+static void _rest_dns_store (const struct sockaddr_in * addr) {
+    int64_t now = k_uptime_get();   // Current uptime.
+
+    // Cache server address, along with the time at which it expires.
+    memset(&_rest_dns, 0, sizeof(_rest_dns));
+    _rest_dns.host = crc32_ieee(
+        (const uint8_t *)CONFIG_REST_HOST_NAME, strlen(CONFIG_REST_HOST_NAME)
+    );
+    _rest_dns.addr = *addr;
+    _rest_dns.expiry = now + 1000LL * CONFIG_REST_DNS_CACHE_TTL;
+    _rest_dns.stamp = now;
+    _rest_dns.crc = _rest_dns_crc();
+    _rest_dns_rebased = true;
+}
 
-    // Initialize HTTP response buffer with zeros.
-    memset(_rest_resp, 0, sizeof(_rest_resp));
+static void _rest_dns_forget (void) {
+    // Clear cache, which leaves its checksum invalid.
+    memset(&_rest_dns, 0, sizeof(_rest_dns));
+}
 
-    LOG_INF("Making GET request");
+#endif
 
-    // Make HTTP request.
+static int _rest_resolve (struct sockaddr_in * addr, bool * cached) {
+    int status;                 // Return status for API calls.
+    char port[8];               // Port number as string.
+    struct addrinfo hints;      // Address lookup hints.
+    struct addrinfo * res;      // Resolved server address.
+
+    /*
+     * Take server address from cache, if configured and the cache holds one.
+     * Otherwise, look it up, and cache it. If an error occurs in this process,
+     * exit with failure.
+     */
+
+#if defined(CONFIG_REST_DNS_CACHE)
+    if (_rest_dns_lookup(addr)) {
+        _rest_count(&_rest_stats.dns_hits);
+        *cached = true;
+        return 0;
+    }
+#endif
+
+    _rest_count(&_rest_stats.dns_misses);
+    *cached = false;
+
+    memset(&hints, 0, sizeof(hints));
+    hints.ai_family = AF_INET;
+    hints.ai_socktype = SOCK_STREAM;
+
+    snprintf(port, sizeof(port), "%d", CONFIG_REST_PORT_NUM);
+
+    // Resolve server address.
+    status = getaddrinfo(CONFIG_REST_HOST_NAME, port, &hints, &res);
+    if (status != 0) {
+        // On error, exit with failure.
+        LOG_ERR("Failed to resolve server address (%d)", status);
+        return -1;
+    }
+
+    memcpy(addr, res->ai_addr, sizeof(*addr));
+    freeaddrinfo(res);
+
+#if defined(CONFIG_REST_DNS_CACHE)
+    _rest_dns_store(addr);
+#endif
+
+    return 0;
+}
+
+static int _rest_open (const struct sockaddr_in * addr, bool resume) {
+    int status;                 // Return status for API calls.
+    int sock;                   // Socket descriptor.
+
+#if defined(CONFIG_REST_USE_TLS)
+    sec_tag_t sec_tag = CONFIG_REST_SEC_TAG;    // TLS security tag.
+    int verify = TLS_PEER_VERIFY_NONE;          // TLS peer verification.
+#endif
+
+#if defined(CONFIG_REST_TLS_SESSION_CACHE)
+    int cache = TLS_SESSION_CACHE_ENABLED;      // TLS session caching.
+#endif
 
-    status = rest_client_request(&req, &resp);
+    /*
+     * Open socket, configure TLS if used, and connect to the given server
+     * address. If configured, the TLS session is cached by the modem, so that
+     * later connections, including those after the LTE link has been
+     * deactivated, can resume it with an abbreviated handshake. If an error
+     * occurs in this process, close the socket and exit with failure. If a
+     * cached session was offered, it is purged, so that the next connection
+     * makes a full handshake.
+     */
+
+    // Open socket.
+#if defined(CONFIG_REST_USE_TLS)
+    sock = socket(AF_INET, SOCK_STREAM, IPPROTO_TLS_1_2);
+#else
+    sock = socket(AF_INET, SOCK_STREAM, IPPROTO_TCP);
+#endif
+    if (sock < 0) {
+        // On error, exit with failure.
+        LOG_ERR("Failed to open socket (%s)", strerror(errno));
+        return -1;
+    }
+
+#if defined(CONFIG_REST_USE_TLS)
+    // Configure TLS.
+    if (
+        setsockopt(
+            sock, SOL_TLS, TLS_SEC_TAG_LIST, &sec_tag, sizeof(sec_tag)
+        ) < 0
+        || setsockopt(
+            sock, SOL_TLS, TLS_PEER_VERIFY, &verify, sizeof(verify)
+        ) < 0
+        || setsockopt(
+            sock, SOL_TLS, TLS_HOSTNAME, CONFIG_REST_HOST_NAME,
+            strlen(CONFIG_REST_HOST_NAME)
+        ) < 0
+#if defined(CONFIG_REST_TLS_SESSION_CACHE)
+        || setsockopt(
+            sock, SOL_TLS, TLS_SESSION_CACHE, &cache, sizeof(cache)
+        ) < 0
+#endif
+    ) {
+        // On error, close socket and exit with failure.
+        LOG_ERR("Failed to configure TLS (%s)", strerror(errno));
+        close(sock);
+        return -1;
+    }
+#endif
+
+    // Connect to server.
+    status = connect(sock, (const struct sockaddr *)addr, sizeof(*addr));
+    if (status < 0) {
+        // On error, purge cached session, close socket and exit with failure.
+        LOG_ERR("Failed to connect to server (%s)", strerror(errno));
+#if defined(CONFIG_REST_TLS_SESSION_CACHE)
+        if (resume) {
+            LOG_INF("Purging cached TLS session");
+            setsockopt(
+                sock, SOL_TLS, TLS_SESSION_CACHE_PURGE, &cache, sizeof(cache)
+            );
+        }
+#endif
+        close(sock);
+        return -1;
+    }
+
+    return sock;
+}
+
+static int _rest_connect (void) {
+    int status;                 // Return status for API calls.
+    int sock;                   // Socket descriptor.
+    struct sockaddr_in addr;    // Server address.
+    bool cached;                // Server address taken from cache.
+    bool resume;                // Cached TLS session offered to server.
+    int64_t start;              // Start time of connection.
+    uint32_t dur;               // Duration of connection.
+
+    /*
+     * Resolve server address, or take it from the cache, and connect to
+     * server. A cached address may have gone stale, so if connecting to it
+     * fails, the address is looked up afresh, and the connection is attempted
+     * once more. If an error occurs in this process, exit with failure.
+     */
+
+    start = perf_start();
+    resume = IS_ENABLED(CONFIG_REST_TLS_SESSION_CACHE) && _rest_session;
+
+    // Resolve server address.
+    status = _rest_resolve(&addr, &cached);
     if (status < 0) {
         // On error, exit with failure.
-        LOG_ERR(
-            "Failed to make GET request (%s)",
-            strerror(-status)
-        );
+        perf_record(PERF_PHASE_CONNECT, start);
         return -1;
     }
 
-    if (resp.http_status_code != 200) {
-        // On unexpected response code, exit with failure.
-        LOG_ERR(
-            "GET request failed (Response code %hu)",
-            resp.http_status_code
-        );
+    // Connect to server.
+    sock = _rest_open(&addr, resume);
+
+#if defined(CONFIG_REST_DNS_CACHE)
+    if (sock < 0 && cached) {
+        // On error with cached address, look address up again and retry.
+        LOG_WRN("Failed to connect to cached server address, resolving again");
+        _rest_dns_forget();
+        resume = false;
+        if (_rest_resolve(&addr, &cached) == 0) {
+            sock = _rest_open(&addr, resume);
+        }
+    }
+#endif
+
+    if (sock < 0) {
+        // On error, exit with failure.
+        _rest_session = false;
+        perf_record(PERF_PHASE_CONNECT, start);
         return -1;
     }
 
-    // Copy payload to output buffer.
-    strncpy(payload, resp.response, resp.response_len);
+    perf_record(PERF_PHASE_CONNECT, start);
+    dur = (uint32_t)CLAMP(k_uptime_get() - start, 0, UINT32_MAX);
+
+    LOG_DBG(
+        "Connected in %u ms (%s)", dur, resume ? "session offered" : "full"
+    );
+
+    // Add connection to statistics.
+    k_mutex_lock(&_rest_stats_mutex, K_FOREVER);
+    _rest_stats.handshakes++;
+    if (resume) {
+        _rest_stats.session_offered++;
+        _rest_stats.session_offered_ms += dur;
+    } else {
+        _rest_stats.full_ms += dur;
+    }
+    k_mutex_unlock(&_rest_stats_mutex);
+
+    _rest_session = true;
+
+    return sock;
+}
+
+static void _rest_resp_body (
+    _rest_resp_t * resp, const void * data, size_t len
+) {
+    size_t part;    // Length of part fitting in buffer.
+
+    // Copy payload fragment out of receive buffer, leaving room for the
+    // terminating null byte, unless payload is discarded.
+    if (resp->buf != NULL && data != NULL && len > 0) {
+        part = MIN(len, resp->size - 1 - resp->len);
+        memcpy(&resp->buf[resp->len], data, part);
+        resp->len += part;
+        if (part < len) {
+            resp->overflow = true;
+        }
+    }
+}
+
+static int _rest_send (int sock, const void * buf, size_t len) {
+    ssize_t sent;   // Number of bytes sent.
+
+    // Send all data, as the socket may accept only part of it at once.
+    while (len > 0) {
+        sent = send(sock, buf, len, 0);
+        if (sent < 0) {
+            return -errno;
+        }
+        buf = (const uint8_t *)buf + sent;
+        len -= sent;
+    }
 
     return 0;
 }
 
-int rest_put (const char * url, const char * payload) {
-    int status; // Return status for API calls.
+static void _rest_stream_start (
+    rest_stream_t * stream, int sock, size_t head
+) {
+    // Start first chunk right after the request head, and the room for its
+    // size line.
+    stream->sock = sock;
+    stream->head = head;
+    stream->chunk = &_rest_send_buf[head + REST_CHUNK_HEAD];
+    stream->fill = 0;
+    stream->sent = 0;
+}
 
-    struct rest_client_req_context req;     // HTTP request.
-    struct rest_client_resp_context resp;   // HTTP response.
+static int _rest_stream_flush (rest_stream_t * stream, bool last) {
+    int status;                     // Return status for API calls.
+    char size[REST_CHUNK_HEAD + 1]; // Chunk size line.
+    uint8_t * frame;                // Chunk along with its framing.
+    size_t len;                     // Length of chunk with framing.
 
-    // HTTP request headers.
-    const char * header_fields [] = {
-        "content-type: " CONFIG_REST_CONT_TYPE "\r\n",
-        "x-apikey: " CONFIG_REST_API_KEY "\r\n",
-        NULL
-    };
+    if (stream->fill == 0 && !last) {
+        return 0;
+    }
 
     /*
-     * Make HTTP request and interpret response. If an error occurs in this
-     * process, or if the response has an unexpected code, exit with failure.
+     * Frame collected data as a chunk, preceded by its size in hexadecimal,
+     * and, if it ends the payload, followed by the last chunk. Send it with a
+     * single write, together with the request head if it has not been sent
+     * yet, which directly precedes the chunk in the send buffer. The next
+     * chunk starts at the beginning of the send buffer. If an error occurs in
+     * this process, exit with failure.
      */
 
-    // Create HTTP request.
+    frame = stream->chunk - REST_CHUNK_HEAD;
+    len = 0;
 
-    req.host = CONFIG_REST_HOST_NAME;
-    req.port = CONFIG_REST_PORT_NUM;
-    req.url = url;
+    if (stream->fill > 0) {
+        snprintf(size, sizeof(size), "%08x\r\n", (unsigned int)stream->fill);
+        memcpy(frame, size, REST_CHUNK_HEAD);
+        len = REST_CHUNK_HEAD + stream->fill;
+        memcpy(&frame[len], "\r\n", 2);
+        len += 2;
+    }
 
-    req.http_method = HTTP_PUT;
-    req.header_fields = header_fields;
-    req.body = payload;
+    if (last) {
+        memcpy(&frame[len], "0\r\n\r\n", 5);
+        len += 5;
+    }
 
-    req.connect_socket = REST_CLIENT_SCKT_CONNECT;
-    req.keep_alive = false;
-    req.timeout_ms = 1000 * CONFIG_REST_REQ_TIMEOUT;
+    status = _rest_send(stream->sock, frame - stream->head, stream->head + len);
+    if (status < 0) {
+        // On error, exit with failure.
+        LOG_ERR("Failed to send payload chunk (%s)", strerror(-status));
+        return -1;
+    }
 
-    req.sec_tag = CONFIG_REST_SEC_TAG;
-    req.tls_peer_verify = TLS_PEER_VERIFY_NONE;
+    stream->sent += len;
+    stream->head = 0;
+    stream->chunk = &_rest_send_buf[REST_CHUNK_HEAD];
+    stream->fill = 0;
 
-    req.resp_buff = _rest_resp;
-    req.resp_buff_len = sizeof(_rest_resp);
+    return 0;
+}
 
-    // Initialize HTTP response buffer with zeros.
-    memset(_rest_resp, 0, sizeof(_rest_resp));
+#if defined(CONFIG_REST_LEAN_HTTP)
 
-    LOG_INF("Making PUT request");
+static int _rest_body_cb (
+    struct http_parser * parser, const char * at, size_t length
+) {
+    // Copy payload fragment.
+    _rest_resp_body(parser->data, at, length);
+    return 0;
+}
 
-    // Make HTTP request.
+static int _rest_complete_cb (struct http_parser * parser) {
+    _rest_resp_t * resp = parser->data; // HTTP response.
 
-    status = rest_client_request(&req, &resp);
-    if (status < 0) {
-        // On error, exit with failure.
-        LOG_ERR(
-            "Failed to make PUT request (%s)",
-            strerror(-status)
+    // Record response code once response is complete, unless it is only an
+    // interim response, which is followed by the final one.
+    if (parser->status_code >= 200) {
+        resp->code = parser->status_code;
+    }
+
+    return 0;
+}
+
+static int _rest_exchange (
+    int sock, enum http_method method, const char * name, const char * url,
+    const char * payload, size_t len, rest_stream_t * stream,
+    _rest_resp_t * resp, bool * keep
+) {
+    int status;                                 // Return status for API calls.
+    size_t head;                                // Length of request head.
+    ssize_t rcvd;                               // Number of bytes received.
+    int64_t deadline;                           // Time limit for response.
+    struct pollfd fds;                          // Poll descriptor.
+    struct http_parser parser;                  // HTTP response parser.
+    struct http_parser_settings settings;       // HTTP parser callbacks.
+    uint8_t rx_buf[CONFIG_REST_RECV_BUF_SIZE];  // Receive buffer.
+
+    char * tx_buf = (char *)_rest_send_buf;     // Send buffer.
+
+    /*
+     * Assemble request head in send buffer, from the request line, the
+     * headers that are the same for every request, and the length or encoding
+     * of the payload. Append the payload to it, or, if it is streamed, collect
+     * its first chunk right after it, so that the request is sent with as few
+     * writes as possible, which is usually a single one. Then receive the
+     * response, and take only its code, payload, and whether the connection
+     * may be kept open from it. If an error occurs in this process, exit with
+     * failure.
+     */
+
+    if (stream != NULL) {
+        head = snprintf(
+            tx_buf, sizeof(_rest_send_buf),
+            "%s %s HTTP/1.1\r\n" REST_HEADERS "%s%s%s"
+            "Transfer-Encoding: chunked\r\n\r\n",
+            name, url,
+            stream->encoding != NULL ? "Content-Encoding: " : "",
+            stream->encoding != NULL ? stream->encoding : "",
+            stream->encoding != NULL ? "\r\n" : ""
+        );
+    } else if (payload != NULL) {
+        head = snprintf(
+            tx_buf, sizeof(_rest_send_buf),
+            "%s %s HTTP/1.1\r\n" REST_HEADERS "Content-Length: %u\r\n\r\n",
+            name, url, (unsigned int)len
+        );
+    } else {
+        head = snprintf(
+            tx_buf, sizeof(_rest_send_buf),
+            "%s %s HTTP/1.1\r\n" REST_HEADERS "\r\n", name, url
         );
-        return -1;
     }
 
-    if (resp.http_status_code != 200) {
-        // On unexpected response code, exit with failure.
+    if (head >= sizeof(_rest_send_buf)) {
+        // On error, exit with failure.
         LOG_ERR(
-            "PUT request failed (Response code %hu)",
-            resp.http_status_code
+            "Request head exceeds %u bytes",
+            (unsigned int)sizeof(_rest_send_buf)
         );
-        return -1;
+        return -ENOBUFS;
+    }
+
+    if (stream != NULL) {
+        // Send request head on its own if no full chunk fits after it.
+        if (head > sizeof(_rest_send_buf) - REST_CHUNK_ROOM) {
+            status = _rest_send(sock, tx_buf, head);
+            if (status < 0) {
+                return status;
+            }
+            head = 0;
+        }
+
+        // Have the payload writer produce the payload, which is sent in chunks
+        // as it is written, and then terminate it with the last chunk. If an
+        // error occurs, the payload is left unterminated, so that the server
+        // does not accept it.
+        _rest_stream_start(stream, sock, head);
+        if (
+            stream->cb(stream, stream->user_data) < 0
+            || _rest_stream_flush(stream, true) < 0
+        ) {
+            return -EIO;
+        }
+    } else {
+        // Append payload to request head if it fits, and send both.
+        if (payload != NULL && len <= sizeof(_rest_send_buf) - head) {
+            memcpy(&tx_buf[head], payload, len);
+            head += len;
+            payload = NULL;
+        }
+
+        status = _rest_send(sock, tx_buf, head);
+        if (status == 0 && payload != NULL) {
+            status = _rest_send(sock, payload, len);
+        }
+        if (status < 0) {
+            return status;
+        }
     }
 
+    // Receive response, until it is complete, or the server closes the
+    // connection.
+
+    http_parser_init(&parser, HTTP_RESPONSE);
+    http_parser_settings_init(&settings);
+    settings.on_body = _rest_body_cb;
+    settings.on_message_complete = _rest_complete_cb;
+    parser.data = resp;
+
+    deadline = k_uptime_get() + 1000 * CONFIG_REST_REQ_TIMEOUT;
+
+    fds.fd = sock;
+    fds.events = POLLIN;
+
+    while (resp->code == 0) {
+        status = poll(&fds, 1, MAX(deadline - k_uptime_get(), 0));
+        if (status < 0) {
+            return -errno;
+        } else if (status == 0) {
+            return -ETIMEDOUT;
+        }
+
+        rcvd = recv(sock, rx_buf, sizeof(rx_buf), 0);
+        if (rcvd < 0) {
+            return -errno;
+        }
+
+        // Parse received data. No data means the connection was closed, which
+        // ends a response that has no explicit length.
+        http_parser_execute(&parser, &settings, (const char *)rx_buf, rcvd);
+        if (HTTP_PARSER_ERRNO(&parser) != HPE_OK) {
+            return -EBADMSG;
+        }
+
+        if (rcvd == 0) {
+            break;
+        }
+    }
+
+    *keep = http_should_keep_alive(&parser);
+
     return 0;
 }
 
-int rest_post (const char * url, const char * payload) {
-    int status; // Return status for API calls.
+#else
+
+static void _rest_resp_cb (
+    struct http_response * rsp, enum http_final_call final, void * user_data
+) {
+    _rest_resp_t * resp = user_data;    // HTTP response.
+
+    // Copy payload fragment.
+    _rest_resp_body(resp, rsp->body_frag_start, rsp->body_frag_len);
+
+    // Record response code once response is complete.
+    if (final == HTTP_DATA_FINAL) {
+        resp->code = rsp->http_status_code;
+    }
+}
+
+static int _rest_payload_cb (
+    int sock, struct http_request * req, void * user_data
+) {
+    _rest_resp_t * resp = user_data;        // HTTP response.
+    rest_stream_t * stream = resp->stream;  // Streamed request payload.
+
+    /*
+     * Have the payload writer produce the payload, which is sent in chunks as
+     * it is written, and then terminate it with the last chunk. If an error
+     * occurs in this process, the payload is left unterminated, so that the
+     * server does not accept it.
+     */
+
+    _rest_stream_start(stream, sock, 0);
+
+    if (stream->cb(stream, stream->user_data) < 0) {
+        return -EIO;
+    }
+
+    if (_rest_stream_flush(stream, true) < 0) {
+        return -EIO;
+    }
+
+    return stream->sent;
+}
+
+static int _rest_exchange (
+    int sock, enum http_method method, const char * name, const char * url,
+    const char * payload, size_t len, rest_stream_t * stream,
+    _rest_resp_t * resp, bool * keep
+) {
+    int status;     // Return status for API calls.
 
-    struct rest_client_req_context req;     // HTTP request.
-    struct rest_client_resp_context resp;   // HTTP response.
+    struct http_request req;                    // HTTP request.
+    uint8_t recv[CONFIG_REST_RECV_BUF_SIZE];    // Receive buffer.
 
     // HTTP request headers.
     const char * header_fields [] = {
-        "content-type: " CONFIG_REST_CONT_TYPE "\r\n",
         "x-apikey: " CONFIG_REST_API_KEY "\r\n",
         NULL
     };
 
+    // HTTP request headers for streamed payloads. The last entry is filled in
+    // with the content encoding, if any.
+    const char * stream_header_fields [] = {
+        "x-apikey: " CONFIG_REST_API_KEY "\r\n",
+        "Transfer-Encoding: chunked\r\n",
+        NULL,
+        NULL
+    };
+
+    char encoding_field[48];    // Content encoding header.
+
     /*
-     * Make HTTP request and interpret response. If an error occurs in this
-     * process, or if the response has an unexpected code, exit with failure.
+     * Make HTTP request with the HTTP client library, which sends the request
+     * head and payload in several writes, and receive the response.
      */
 
-    // Create HTTP request.
+    memset(&req, 0, sizeof(req));
 
-    req.host = CONFIG_REST_HOST_NAME;
-    req.port = CONFIG_REST_PORT_NUM;
+    req.method = method;
     req.url = url;
+    req.host = CONFIG_REST_HOST_NAME;
+    req.protocol = "HTTP/1.1";
+    if (stream != NULL && stream->encoding != NULL) {
+        snprintf(
+            encoding_field, sizeof(encoding_field),
+            "Content-Encoding: %s\r\n", stream->encoding
+        );
+        stream_header_fields[2] = encoding_field;
+    }
 
-    req.http_method = HTTP_POST;
-    req.header_fields = header_fields;
-    req.body = payload;
+    req.header_fields = stream != NULL ? stream_header_fields : header_fields;
+    req.content_type_value = CONFIG_REST_CONT_TYPE;
+    req.payload = payload;
+    req.payload_len = len;
+    req.payload_cb = stream != NULL ? _rest_payload_cb : NULL;
+    req.response = _rest_resp_cb;
+    req.recv_buf = recv;
+    req.recv_buf_len = sizeof(recv);
 
-    req.connect_socket = REST_CLIENT_SCKT_CONNECT;
-    req.keep_alive = false;
-    req.timeout_ms = 1000 * CONFIG_REST_REQ_TIMEOUT;
+    status = http_client_req(
+        sock, &req, 1000 * CONFIG_REST_REQ_TIMEOUT, resp
+    );
 
-    req.sec_tag = CONFIG_REST_SEC_TAG;
-    req.tls_peer_verify = TLS_PEER_VERIFY_NONE;
+    *keep = http_should_keep_alive(&req.internal.parser);
 
-    req.resp_buff = _rest_resp;
-    req.resp_buff_len = sizeof(_rest_resp);
+    return status;
+}
 
-    // Initialize HTTP response buffer with zeros.
-    memset(_rest_resp, 0, sizeof(_rest_resp));
+#endif
 
-    LOG_INF("Making POST request");
+static int _rest_request (
+    enum http_method method, const char * name, const char * url,
+    const char * payload, size_t len, rest_stream_t * stream,
+    _rest_resp_t * resp
+) {
+    int status;     // Return status for API calls.
+    bool reused;    // Request made over connection kept open.
+    bool keep;      // Response allows connection to be kept open.
+    int64_t start;  // Start time of request.
+
+    /*
+     * Connect to server unless a connection is still open, make HTTP request,
+     * and close connection unless it can be kept open. The payload is sent
+     * with its length given explicitly, so that it may contain arbitrary
+     * binary data, or, if it is streamed, in chunks as it is written. If the
+     * server has closed a connection that was kept open, the request is made
+     * again over a new connection. If an error occurs in this process, exit
+     * with failure.
+     */
+
+    LOG_INF("Making %s request", name);
+
+    _rest_count(&_rest_stats.requests);
 
     // Make HTTP request.
 
-    status = rest_client_request(&req, &resp);
+    start = perf_start();
+
+    while (true) {
+        reused = _rest_sock >= 0;
+
+        if (reused) {
+            _rest_count(&_rest_stats.reused);
+        } else {
+            // Connect to server.
+            _rest_sock = _rest_connect();
+            if (_rest_sock < 0) {
+                // On error, exit with failure.
+                perf_record(PERF_PHASE_REQUEST, start);
+                return -1;
+            }
+        }
+
+        resp->code = 0;
+        resp->len = 0;
+        resp->overflow = false;
+        keep = false;
+
+        status = _rest_exchange(
+            _rest_sock, method, name, url, payload, len, stream, resp, &keep
+        );
+
+        // Close connection unless configured to keep it open, and the
+        // response is complete and allows it.
+        if (
+            !IS_ENABLED(CONFIG_REST_KEEP_ALIVE) || status < 0
+            || resp->code == 0 || !keep
+        ) {
+            close(_rest_sock);
+            _rest_sock = -1;
+        }
+
+        if (reused && resp->code == 0) {
+            // Server closed connection kept open, so make request again over
+            // new connection.
+            LOG_INF("Connection closed by server, reconnecting");
+            _rest_count(&_rest_stats.reconnects);
+            continue;
+        }
+
+        break;
+    }
+
+    perf_record(PERF_PHASE_REQUEST, start);
+
     if (status < 0) {
         // On error, exit with failure.
         LOG_ERR(
-            "Failed to make POST request (%s)",
-            strerror(-status)
+            "Failed to make %s request (%s)",
+            name, strerror(-status)
         );
         return -1;
     }
 
-    if (resp.http_status_code != 201) {
-        // On unexpected response code, exit with failure.
-        LOG_ERR(
-            "POST request failed (Response code %hu)",
-            resp.http_status_code
-        );
+    return 0;
+}
+
+static int _rest_check (const char * name, uint16_t code, uint16_t expected) {
+    // Accept expected response code.
+    if (code == expected) {
+        return 0;
+    }
+
+    LOG_ERR("%s request failed (Response code %hu)", name, code);
+
+    // Client errors, other than timeouts and rate limiting, mean that the
+    // server rejected the request, and that making it again would not help.
+    if (code >= 400 && code < 500 && code != 408 && code != 429) {
+        return -2;
+    }
+
+    return -1;
+}
+
+#if defined(CONFIG_REST_COAP)
+
+static int _rest_coap_request (
+    rest_req_t * req, rest_stream_t * stream, _rest_resp_t * resp
+) {
+    int status;         // Return status for API calls.
+    int64_t start;      // Start time of request.
+    coapc_xfer_t xfer;  // CoAP transfer.
+
+    const char * name = _rest_methods[req->method].name;    // Method name.
+
+    /*
+     * Make CoAP request, sending the payload, whether given or streamed, block
+     * by block. Content encodings cannot be announced over CoAP, so encoded
+     * payloads are refused. If the server ends the transfer early with a
+     * response to one of the blocks, that response is taken as the response
+     * to the request. If no response is received, exit with failure.
+     */
+
+    if (stream != NULL && stream->encoding != NULL) {
+        LOG_ERR("Failed to make %s request (Content encoding over CoAP)", name);
         return -1;
     }
 
+    LOG_INF("Making %s request over CoAP", name);
+
+    _rest_count(&_rest_stats.requests);
+
+    start = perf_start();
+
+    coapc_begin(
+        &xfer, _rest_coap_methods[req->method].method, req->url, resp->buf,
+        resp->size
+    );
+
+    if (stream != NULL) {
+        stream->xfer = &xfer;
+        status = stream->cb(stream, stream->user_data);
+    } else {
+        status = coapc_write(&xfer, req->payload, req->len);
+    }
+    if (status == 0) {
+        status = coapc_finish(&xfer);
+    }
+
+    perf_record(PERF_PHASE_REQUEST, start);
+
+    if (xfer.code == 0) {
+        // On missing response, exit with failure.
+        LOG_ERR("Failed to make %s request over CoAP", name);
+        return -1;
+    }
+
+    resp->code = (xfer.code >> 5) * 100 + (xfer.code & 0x1f);
+    resp->len = xfer.len;
+    resp->overflow = xfer.overflow;
+
     return 0;
 }
 
-int rest_delete (const char * url) {
-    int status; // Return status for API calls.
+#endif
 
-    struct rest_client_req_context req;     // HTTP request.
-    struct rest_client_resp_context resp;   // HTTP response.
+#if defined(CONFIG_REST_MQTT)
 
-    // HTTP request headers.
-    const char * header_fields [] = {
-        "content-type: " CONFIG_REST_CONT_TYPE "\r\n",
-        "x-apikey: " CONFIG_REST_API_KEY "\r\n",
-        NULL
-    };
+static int _rest_mqtt_request (
+    rest_req_t * req, rest_stream_t * stream, _rest_resp_t * resp
+) {
+    int status;         // Return status for API calls.
+    int64_t start;      // Start time of request.
+    mqttc_msg_t msg;    // MQTT message.
+
+    const char * name = _rest_methods[req->method].name;    // Method name.
 
     /*
-     * Make HTTP request and interpret response. If an error occurs in this
-     * process, or if the response has an unexpected code, exit with failure.
+     * Publish the payload, whether given or streamed, as a single MQTT message
+     * to the topic given as URL. Only POST requests map onto publications, and
+     * content encodings cannot be announced over MQTT, so other requests are
+     * refused. Once the broker has acknowledged the message, the request
+     * counts as successful, with the response code a POST request expects,
+     * and no response payload. If no acknowledgement is received, exit with
+     * failure.
      */
 
-    // Create HTTP request.
+    if (
+        req->method != REST_METHOD_POST
+        || (stream != NULL && stream->encoding != NULL)
+    ) {
+        LOG_ERR("Failed to make %s request (Not supported over MQTT)", name);
+        return -1;
+    }
 
-    req.host = CONFIG_REST_HOST_NAME;
-    req.port = CONFIG_REST_PORT_NUM;
-    req.url = url;
+    LOG_INF("Publishing %s request over MQTT", name);
 
-    req.http_method = HTTP_DELETE;
-    req.header_fields = header_fields;
-    req.body = NULL;
+    _rest_count(&_rest_stats.requests);
 
-    req.connect_socket = REST_CLIENT_SCKT_CONNECT;
-    req.keep_alive = false;
-    req.timeout_ms = 1000 * CONFIG_REST_REQ_TIMEOUT;
+    start = perf_start();
 
-    req.sec_tag = CONFIG_REST_SEC_TAG;
-    req.tls_peer_verify = TLS_PEER_VERIFY_NONE;
+    mqttc_begin(&msg, req->url);
 
-    req.resp_buff = _rest_resp;
-    req.resp_buff_len = sizeof(_rest_resp);
+    if (stream != NULL) {
+        stream->msg = &msg;
+        status = stream->cb(stream, stream->user_data);
+    } else {
+        status = mqttc_write(&msg, req->payload, req->len);
+    }
+    if (status == 0) {
+        status = mqttc_publish(&msg);
+    }
 
-    // Initialize HTTP response buffer with zeros.
-    memset(_rest_resp, 0, sizeof(_rest_resp));
+    perf_record(PERF_PHASE_REQUEST, start);
 
-    LOG_INF("Making DELETE request");
+    if (status < 0) {
+        // On missing acknowledgement, exit with failure.
+        LOG_ERR("Failed to make %s request over MQTT", name);
+        return -1;
+    }
 
-    // Make HTTP request.
+    resp->code = _rest_methods[REST_METHOD_POST].code;
+    resp->len = 0;
+    resp->overflow = false;
+
+    return 0;
+}
+
+#endif
+
+static int _rest_exec (rest_req_t * req) {
+    int status;             // Return status for API calls.
+    _rest_resp_t resp;      // HTTP response.
+    rest_stream_t stream;   // Streamed request payload.
+    uint16_t expected;      // Expected response code.
+
+    /*
+     * Make HTTP or CoAP request, or MQTT publication, and interpret response.
+     * The response payload is copied into the buffer of the request, if it has
+     * one, and discarded otherwise. The stream and response state live on the
+     * stack of the work queue for the duration of the request only. If an
+     * error occurs in this process, if the response has an unexpected code,
+     * or if its payload does not fit in the buffer, exit with failure.
+     */
+
+    stream.encoding = req->encoding;
+    stream.cb = req->stream;
+    stream.user_data = req->user_data;
+#if defined(CONFIG_REST_COAP)
+    stream.xfer = NULL;
+#endif
+#if defined(CONFIG_REST_MQTT)
+    stream.msg = NULL;
+#endif
+
+    resp.buf = req->resp_size > 0 ? req->resp : NULL;
+    resp.size = req->resp_size;
+    resp.stream = req->stream != NULL ? &stream : NULL;
+
+    req->resp_len = 0;
+
+    if (req->transport == REST_TRANSPORT_COAP) {
+#if defined(CONFIG_REST_COAP)
+        status = _rest_coap_request(req, resp.stream, &resp);
+        expected = _rest_coap_methods[req->method].code;
+#else
+        LOG_ERR("Failed to make request (CoAP transport not configured)");
+        return -1;
+#endif
+    } else if (req->transport == REST_TRANSPORT_MQTT) {
+#if defined(CONFIG_REST_MQTT)
+        status = _rest_mqtt_request(req, resp.stream, &resp);
+        expected = _rest_methods[req->method].code;
+#else
+        LOG_ERR("Failed to make request (MQTT transport not configured)");
+        return -1;
+#endif
+    } else {
+        status = _rest_request(
+            _rest_methods[req->method].method, _rest_methods[req->method].name,
+            req->url, req->payload, req->len, resp.stream, &resp
+        );
+        expected = _rest_methods[req->method].code;
+    }
 
-    status = rest_client_request(&req, &resp);
     if (status < 0) {
         // On error, exit with failure.
-        LOG_ERR(
-            "Failed to make DELETE request (%s)",
-            strerror(-status)
-        );
         return -1;
     }
 
-    if (resp.http_status_code != 200) {
+    // Interpret response code.
+    status = _rest_check(_rest_methods[req->method].name, resp.code, expected);
+    if (status < 0) {
         // On unexpected response code, exit with failure.
+        return status;
+    }
+
+    if (resp.buf == NULL) {
+        return 0;
+    }
+
+    // Terminate payload in output buffer.
+    resp.buf[resp.len] = '\0';
+    req->resp_len = resp.len;
+
+    if (resp.overflow) {
+        // On truncated payload, exit with failure.
         LOG_ERR(
-            "DELETE request failed (Response code %hu)",
-            resp.http_status_code
+            "%s response payload exceeds %u bytes",
+            _rest_methods[req->method].name, (unsigned int)(resp.size - 1)
         );
         return -1;
     }
 
     return 0;
 }
+
+static void _rest_work (struct k_work * work) {
+    int status;                     // Return status for API calls.
+    rest_req_t * req;               // Request.
+    struct k_poll_signal * signal;  // Completion signal.
+
+    /*
+     * Make request, and report result to the completion callback and signal.
+     * The callback may submit the request again, so the result and signal are
+     * kept aside beforehand. The signal is raised last, as the request may
+     * cease to exist as soon as its work item is released.
+     */
+
+    req = CONTAINER_OF(k_work_delayable_from_work(work), rest_req_t, work);
+
+    status = _rest_exec(req);
+    req->status = status;
+    signal = req->signal;
+
+    if (req->cb != NULL) {
+        req->cb(req, status);
+    }
+
+    if (signal != NULL) {
+        k_poll_signal_raise(signal, status);
+    }
+}
+
+static int _rest_call (rest_req_t * req) {
+    struct k_poll_signal signal;    // Completion signal.
+    struct k_poll_event event;      // Event waiting for completion signal.
+    struct k_work_sync sync;        // Work item synchronization.
+
+    /*
+     * Submit request, and wait for its completion. Requests are made on the
+     * work queue, so waiting for completion there would never end. The request
+     * lives on the stack of the caller, while the work queue still updates its
+     * work item after the signal is raised, so wait for the work item to be
+     * released before returning.
+     */
+
+    if (k_current_get() == k_work_queue_thread_get(&_rest_work_q)) {
+        LOG_ERR("Failed to make request (Called from REST work queue)");
+        return -1;
+    }
+
+    k_poll_signal_init(&signal);
+    k_poll_event_init(
+        &event, K_POLL_TYPE_SIGNAL, K_POLL_MODE_NOTIFY_ONLY, &signal
+    );
+
+    req->signal = &signal;
+
+    if (rest_submit(req, K_NO_WAIT) < 0) {
+        return -1;
+    }
+
+    k_poll(&event, 1, K_FOREVER);
+    k_work_flush_delayable(&req->work, &sync);
+
+    return signal.result;
+}
+
+void rest_init (void) {
+    struct k_work_queue_config cfg = {.name = "rest"};  // Work queue options.
+
+    // Start work queue on which requests are made.
+    k_work_queue_start(
+        &_rest_work_q, _rest_work_stack,
+        K_THREAD_STACK_SIZEOF(_rest_work_stack), CONFIG_REST_PRIORITY, &cfg
+    );
+}
+
+int rest_submit (rest_req_t * req, k_timeout_t delay) {
+    int busy;   // Work item state.
+
+    /*
+     * Check that the request is not already waiting to be made, set up its
+     * work item unless it is being made right now, which is the case when it
+     * is submitted again from its own completion callback, and schedule it on
+     * the work queue. If the request is already waiting, exit with failure.
+     */
+
+    busy = k_work_delayable_busy_get(&req->work);
+    if (busy & (K_WORK_DELAYED | K_WORK_QUEUED)) {
+        LOG_ERR("Failed to submit request (Already pending)");
+        return -1;
+    }
+
+    if (!(busy & K_WORK_RUNNING)) {
+        k_work_init_delayable(&req->work, _rest_work);
+    }
+
+    k_work_schedule_for_queue(&_rest_work_q, &req->work, delay);
+
+    return 0;
+}
+
+int rest_get (const char * url, char * payload, size_t size) {
+    rest_req_t req = {0};   // Request.
+
+    // Make GET request and wait for it.
+    req.method = REST_METHOD_GET;
+    req.url = url;
+    req.resp = payload;
+    req.resp_size = size;
+    return _rest_call(&req);
+}
+
+int rest_put (const char * url, const char * payload, size_t len) {
+    rest_req_t req = {0};   // Request.
+
+    // Make PUT request and wait for it.
+    req.method = REST_METHOD_PUT;
+    req.url = url;
+    req.payload = payload;
+    req.len = len;
+    return _rest_call(&req);
+}
+
+int rest_post (const char * url, const char * payload, size_t len) {
+    rest_req_t req = {0};   // Request.
+
+    // Make POST request and wait for it.
+    req.method = REST_METHOD_POST;
+    req.url = url;
+    req.payload = payload;
+    req.len = len;
+    return _rest_call(&req);
+}
+
+int rest_post_stream (
+    const char * url, const char * encoding, rest_stream_cb_t cb,
+    void * user_data
+) {
+    rest_req_t req = {0};   // Request.
+
+    // Make POST request with streamed payload and wait for it.
+    req.method = REST_METHOD_POST;
+    req.url = url;
+    req.stream = cb;
+    req.encoding = encoding;
+    req.user_data = user_data;
+    return _rest_call(&req);
+}
+
+int rest_stream_write (rest_stream_t * stream, const void * data, size_t len) {
+    size_t part;    // Length of part fitting in chunk buffer.
+
+#if defined(CONFIG_REST_COAP)
+    // Pass data on to CoAP transfer, which collects it in blocks of its own.
+    if (stream->xfer != NULL) {
+        return coapc_write(stream->xfer, data, len);
+    }
+#endif
+
+#if defined(CONFIG_REST_MQTT)
+    // Pass data on to MQTT message, which collects it in a buffer of its own.
+    if (stream->msg != NULL) {
+        return mqttc_write(stream->msg, data, len);
+    }
+#endif
+
+    // Collect data in chunk, sending it once it is full and more data
+    // follows, so that the last chunk is always sent along with the end of
+    // the payload.
+
+    while (len > 0) {
+        if (stream->fill == CONFIG_REST_CHUNK_SIZE) {
+            if (_rest_stream_flush(stream, false) < 0) {
+                return -1;
+            }
+        }
+
+        part = MIN(len, CONFIG_REST_CHUNK_SIZE - stream->fill);
+        memcpy(&stream->chunk[stream->fill], data, part);
+        stream->fill += part;
+        data = (const uint8_t *)data + part;
+        len -= part;
+    }
+
+    return 0;
+}
+
+int rest_delete (const char * url) {
+    rest_req_t req = {0};   // Request.
+
+    // Make DELETE request and wait for it.
+    req.method = REST_METHOD_DELETE;
+    req.url = url;
+    return _rest_call(&req);
+}
+
+static void _rest_close_work (struct k_work * work) {
+    // Close connection kept open, if any.
+    if (_rest_sock >= 0) {
+        LOG_INF("Closing connection to server");
+        close(_rest_sock);
+        _rest_sock = -1;
+    }
+
+#if defined(CONFIG_REST_COAP)
+    // Close CoAP connection as well.
+    coapc_close();
+#endif
+
+#if defined(CONFIG_REST_MQTT)
+    // Disconnect from MQTT broker as well.
+    mqttc_close();
+#endif
+}
+
+// Work item closing connection.
+static K_WORK_DEFINE(_rest_close, _rest_close_work);
+
+void rest_close (void) {
+    struct k_work_sync sync;    // Work item synchronization.
+
+    // Close connection on work queue, once requests already due have been
+    // made, and wait for it, unless already on work queue.
+
+    if (k_current_get() == k_work_queue_thread_get(&_rest_work_q)) {
+        _rest_close_work(&_rest_close);
+        return;
+    }
+
+    k_work_submit_to_queue(&_rest_work_q, &_rest_close);
+    k_work_flush(&_rest_close, &sync);
+}
+
+void rest_stats (rest_stats_t * stats) {
+    // Copy statistics.
+    k_mutex_lock(&_rest_stats_mutex, K_FOREVER);
+    *stats = _rest_stats;
+    k_mutex_unlock(&_rest_stats_mutex);
+}
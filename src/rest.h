@@ -5,27 +5,212 @@
  *  This module makes REST requests and receives responses from the configured
  *  server. The basic requests, GET, PUT, POST, and DELETE, can be made by
  *  calling rest_get(), rest_put(), rest_post(), and rest_delete() respectively.
+ *  These block until the request is complete. Alternatively, requests can be
+ *  submitted without blocking by calling rest_submit(), in which case they are
+ *  queued, made one after another on a dedicated work queue, and their
+ *  completion is reported through a callback or a poll signal. The work queue
+ *  must be started by calling rest_init() before any request is made.
+ *  Payloads are sent with an explicit length, and may contain binary data.
+ *  Alternatively, a POST request can be made with a streamed payload by calling
+ *  rest_post_stream(), in which case the payload is written piece by piece with
+ *  rest_stream_write(), and sent in chunks as it is written. A connection kept
+ *  open between requests is closed by calling rest_close(), and connection
+ *  statistics can be obtained with rest_stats().
  */
 
 #ifndef __REST_H__
 #define __REST_H__
 
+#include <stddef.h>
+#include <stdint.h>
+
+#include <zephyr/kernel.h>
+
+/** @ingroup    rest
+ *
+ *  @brief      Connection statistics.
+ *
+ *  This structure holds counters describing how often requests needed a new
+ *  connection to the server. It is filled in by rest_stats(). Connections
+ *  offering a cached TLS session are counted apart from full handshakes, but
+ *  whether the server actually resumed the session is not reported by the
+ *  modem, and so is not counted. Unless the server address is cached, every
+ *  connection counts as a DNS miss.
+ */
+
+typedef struct {
+    uint32_t requests;              //!< Number of requests made.
+    uint32_t handshakes;            //!< Number of connections established.
+    uint32_t reused;                //!< Number of requests over open socket.
+    uint32_t reconnects;            //!< Number of connections closed by server.
+    uint32_t session_offered;       //!< Connections offering a TLS session.
+    uint32_t full_ms;               //!< Total time of full connections in ms.
+    uint32_t session_offered_ms;    //!< Total time of these connections in ms.
+    uint32_t dns_hits;              //!< Number of addresses taken from cache.
+    uint32_t dns_misses;            //!< Number of addresses looked up.
+} rest_stats_t;
+
+/** @ingroup    rest
+ *
+ *  @brief      Streamed request payload.
+ *
+ *  This opaque structure represents the payload of a request that is being
+ *  streamed to the server. It is passed to the payload writer, which must
+ *  write the payload into it using rest_stream_write().
+ */
+
+typedef struct rest_stream rest_stream_t;
+
+/** @ingroup    rest
+ *
+ *  @brief      Payload writer.
+ *
+ *  Function called once the request headers have been sent, to write the
+ *  payload of a streamed request.
+ *
+ *  @param      stream      Streamed request payload.
+ *  @param      user_data   User data given along with the payload writer.
+ *
+ *  @retval     0           Success.
+ *  @retval     -1          Failure. The request is aborted.
+ */
+
+typedef int (* rest_stream_cb_t) (rest_stream_t * stream, void * user_data);
+
+/** @ingroup    rest
+ *
+ *  @brief      Request method.
+ */
+
+typedef enum {
+    REST_METHOD_GET,        //!< GET request.
+    REST_METHOD_PUT,        //!< PUT request.
+    REST_METHOD_POST,       //!< POST request.
+    REST_METHOD_DELETE      //!< DELETE request.
+} rest_method_t;
+
+/** @ingroup    rest
+ *
+ *  @brief      Request transport.
+ *
+ *  Requests are made over HTTP by default. If the CoAP transport is
+ *  configured, they may instead be made as confirmable CoAP requests over UDP,
+ *  with the payload sent block-wise, which takes fewer bytes and round trips.
+ *  If the MQTT transport is configured, POST requests may instead be published
+ *  to the MQTT broker with QoS 1, taking the URL as the topic, in which case
+ *  the request succeeds once the broker has acknowledged the message, and the
+ *  payload must fit in a single message. A streamed payload with a content
+ *  encoding can only be sent over HTTP.
+ */
+
+typedef enum {
+    REST_TRANSPORT_HTTP,    //!< HTTP over TCP, optionally with TLS.
+    REST_TRANSPORT_COAP,    //!< CoAP over UDP, optionally with DTLS.
+    REST_TRANSPORT_MQTT     //!< MQTT over TCP, optionally with TLS.
+} rest_transport_t;
+
+/** @ingroup    rest
+ *
+ *  @brief      Asynchronous request.
+ *
+ *  This structure describes a request submitted with rest_submit(). It must be
+ *  zero-initialized before it is first submitted, and must remain valid until
+ *  the request is complete. The members up to the completion signal are filled
+ *  in by the caller, and the remaining members are managed by this module.
+ *  Each request carries all of its own state, so requests may be submitted
+ *  from several threads at once. If a response buffer is given, the response
+ *  payload is written into it, followed by a terminating null byte, and the
+ *  request fails if the payload does not fit. Otherwise, the response payload
+ *  is discarded as it is received, and only the response code is checked.
+ */
+
+typedef struct rest_req rest_req_t;
+
+/** @ingroup    rest
+ *
+ *  @brief      Completion callback.
+ *
+ *  Function called on the REST work queue once a submitted request is
+ *  complete. It may submit the same request again, but must not make blocking
+ *  requests, as these are made on the same work queue.
+ *
+ *  @param      req     Completed request.
+ *  @param      status  Result of request, as returned by the blocking request
+ *                      functions.
+ */
+
+typedef void (* rest_done_cb_t) (rest_req_t * req, int status);
+
+struct rest_req {
+    rest_method_t method;           //!< Request method.
+    rest_transport_t transport;     //!< Request transport.
+    const char * url;               //!< URL of the requested resource.
+    const char * payload;           //!< Payload, or NULL.
+    size_t len;                     //!< Length of payload.
+    rest_stream_cb_t stream;        //!< Writer of streamed payload, or NULL.
+    const char * encoding;          //!< Content encoding of payload, or NULL.
+    void * user_data;               //!< User data passed to payload writer.
+    char * resp;                    //!< Buffer for response, or NULL.
+    size_t resp_size;               //!< Size of response buffer.
+    rest_done_cb_t cb;              //!< Completion callback, or NULL.
+    struct k_poll_signal * signal;  //!< Completion signal, or NULL.
+    struct k_work_delayable work;   //!< Work item.
+    int status;                     //!< Result of last completed attempt.
+    size_t resp_len;                //!< Length of response payload.
+};
+
+/** @ingroup    rest
+ *
+ *  @brief      Initialize REST module.
+ *
+ *  Starts the work queue on which requests are made.
+ */
+
+void rest_init (void);
+
+/** @ingroup    rest
+ *
+ *  @brief      Submit request.
+ *
+ *  Queues the given request to be made on the REST work queue after the given
+ *  delay, and returns without waiting for it. Several requests may be queued
+ *  at once, and are made in the order in which they become due. Once the
+ *  request is complete, the completion callback is called, and then the
+ *  completion signal is raised with the result of the request. The work queue
+ *  still accesses the request briefly after that, so it must not be freed
+ *  before k_work_flush_delayable() returns for its work item.
+ *
+ *  @param      req     Request.
+ *  @param      delay   Delay before the request is made.
+ *
+ *  @retval     0       Success.
+ *  @retval     -1      Failure. The request is already queued.
+ */
+
+int rest_submit (rest_req_t * req, k_timeout_t delay);
+
 /** @ingroup    rest
  *
  *  @brief      Make GET request.
  *
  *  Makes a GET request to the configured server, and writes the response
- *  payload into the provided buffer.
+ *  payload into the provided buffer. This function, like the other blocking
+ *  request functions, waits for the request to be made on the REST work
+ *  queue, and must not be called from a completion callback. The blocking
+ *  request functions may be called from several threads at once.
  *
  *  @param      url     URL of the requested resource.
  *  @param      payload Pointer to buffer into which the response payload and a
  *                      terminating null byte must be written.
+ *  @param      size    Size of buffer.
  *
  *  @retval     0       Success.
- *  @retval     -1      Failure.
+ *  @retval     -1      Failure. Making the request again may succeed, or the
+ *                      response payload does not fit in the buffer.
+ *  @retval     -2      Failure. The server rejected the request.
  */
 
-int rest_get (const char * url, char * payload);
+int rest_get (const char * url, char * payload, size_t size);
 
 /** @ingroup    rest
  *
@@ -35,14 +220,15 @@ int rest_get (const char * url, char * payload);
  *  contained in the provided buffer.
  *
  *  @param      url     URL of the requested resource.
- *  @param      payload Pointer to buffer containing null-terminated payload
- *                      that must be sent.
+ *  @param      payload Pointer to buffer containing payload that must be sent.
+ *  @param      len     Length of payload.
  *
  *  @retval     0       Success.
- *  @retval     -1      Failure.
+ *  @retval     -1      Failure. Making the request again may succeed.
+ *  @retval     -2      Failure. The server rejected the request.
  */
 
-int rest_put (const char * url, const char * payload);
+int rest_put (const char * url, const char * payload, size_t len);
 
 /** @ingroup    rest
  *
@@ -52,14 +238,61 @@ int rest_put (const char * url, const char * payload);
  *  contained in the provided buffer.
  *
  *  @param      url     URL of the requested resource.
- *  @param      payload Pointer to buffer containing null-terminated payload
- *                      that must be sent.
+ *  @param      payload Pointer to buffer containing payload that must be sent.
+ *  @param      len     Length of payload.
+ *
+ *  @retval     0       Success.
+ *  @retval     -1      Failure. Making the request again may succeed.
+ *  @retval     -2      Failure. The server rejected the request.
+ */
+
+int rest_post (const char * url, const char * payload, size_t len);
+
+/** @ingroup    rest
+ *
+ *  @brief      Make POST request with streamed payload.
+ *
+ *  Makes a POST request to the configured server, and sends the payload
+ *  written by the given payload writer using chunked transfer encoding. The
+ *  payload is sent in chunks of the configured size as it is written, so its
+ *  total length need not be known in advance. If the payload writer fails, the
+ *  payload is left unterminated, so that the server does not accept it. If a
+ *  content encoding is given, such as "gzip", it is announced to the server,
+ *  and the payload writer must write the payload in that encoding. If the
+ *  request is made again because the server closed the connection, the
+ *  payload writer is called again, and must write the same payload.
+ *
+ *  @param      url         URL of the requested resource.
+ *  @param      encoding    Content encoding of payload, or NULL.
+ *  @param      cb          Payload writer.
+ *  @param      user_data   User data passed to payload writer.
+ *
+ *  @retval     0           Success.
+ *  @retval     -1          Failure. Making the request again may succeed.
+ *  @retval     -2          Failure. The server rejected the request.
+ */
+
+int rest_post_stream (
+    const char * url, const char * encoding, rest_stream_cb_t cb,
+    void * user_data
+);
+
+/** @ingroup    rest
+ *
+ *  @brief      Write to streamed payload.
+ *
+ *  Appends the given data to a streamed payload. This function may only be
+ *  called from within a payload writer.
+ *
+ *  @param      stream  Streamed request payload.
+ *  @param      data    Pointer to data that must be written.
+ *  @param      len     Length of data.
  *
  *  @retval     0       Success.
  *  @retval     -1      Failure.
  */
 
-int rest_post (const char * url, const char * payload);
+int rest_stream_write (rest_stream_t * stream, const void * data, size_t len);
 
 /** @ingroup    rest
  *
@@ -72,4 +305,31 @@ int rest_post (const char * url, const char * payload);
 
 int rest_delete (const char * url);
 
+/** @ingroup    rest
+ *
+ *  @brief      Close connection.
+ *
+ *  Closes the connection to the server if it was kept open after the last
+ *  request, which is the case if keeping connections open is configured and the
+ *  server did not close it. This must be called before the network connection
+ *  is lost, for instance at the end of an upload session. The next request
+ *  establishes a new connection. The connection is closed on the REST work
+ *  queue, once the requests that are already due have been made, and this
+ *  function waits for it.
+ */
+
+void rest_close (void);
+
+/** @ingroup    rest
+ *
+ *  @brief      Obtain connection statistics.
+ *
+ *  Copies the counters of all requests made so far.
+ *
+ *  @param      stats   Pointer to buffer into which statistics must be
+ *                      written.
+ */
+
+void rest_stats (rest_stats_t * stats);
+
 #endif
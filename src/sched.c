@@ -0,0 +1,101 @@
+#include <stdbool.h>
+#include <stdint.h>
+
+#include <zephyr/kernel.h>
+#include <zephyr/logging/log.h>
+
+#if defined(CONFIG_SCHED_ALIGN)
+#include <date_time.h>
+#endif
+
+#include "sched.h"
+
+// Register module for logging.
+LOG_MODULE_REGISTER(sched, CONFIG_SCHED_LOG_LEVEL);
+
+#if defined(CONFIG_SCHED_ALIGN)
+static void _sched_align (sched_t * sched) {
+    int64_t now;    // Current uptime.
+    int64_t wall;   // Current wall-clock time.
+    int64_t phase;  // Offset of deadline from previous wall-clock boundary.
+
+    /*
+     * If the wall-clock time is known, find the wall-clock time at which the
+     * deadline falls, and move the deadline onto the nearest boundary. This
+     * aligns the schedule once the time is first obtained from the network, and
+     * keeps it aligned as the uptime clock drifts.
+     */
+
+    if (date_time_now(&wall) < 0) {
+        // If time is not yet known, keep deadline relative to boot.
+        return;
+    }
+
+    now = k_uptime_get();
+
+    phase = (wall + (sched->next - now) - 1000LL * CONFIG_SCHED_ALIGN_OFFSET)
+        % sched->period;
+
+    if (phase < 0) {
+        phase += sched->period;
+    }
+
+    if (phase < sched->period / 2) {
+        sched->next -= phase;
+    } else {
+        sched->next += sched->period - phase;
+    }
+}
+#endif
+
+void sched_init (sched_t * sched, uint32_t period) {
+    // Place first deadline one period after boot.
+    sched->period = 1000LL * period;
+    sched->next = sched->period;
+    sched->skipped = 0;
+}
+
+int64_t sched_deadline (sched_t * sched) {
+    int64_t now;    // Current uptime.
+    int64_t missed; // Number of missed deadlines to skip.
+
+#if defined(CONFIG_SCHED_ALIGN)
+    // Align deadline to wall clock.
+    _sched_align(sched);
+#endif
+
+    /*
+     * If the deadline following the next one has already passed too, the work
+     * of the previous cycle overran. Skip all missed deadlines except the
+     * latest one, so that a single late cycle is run in their place.
+     */
+
+    now = k_uptime_get();
+
+    if (now - sched->next >= sched->period) {
+        missed = (now - sched->next) / sched->period;
+        sched->next += missed * sched->period;
+        sched->skipped += missed;
+        LOG_WRN("Skipped %lld overrun cycles", missed);
+    }
+
+    return sched->next;
+}
+
+int64_t sched_advance (sched_t * sched) {
+    int64_t late;   // Time by which deadline was missed.
+
+    // Measure lateness of current deadline and move on to the following one.
+    late = MAX(k_uptime_get() - sched->next, 0);
+    sched->next += sched->period;
+
+    LOG_DBG("Deadline served %lld ms late", late);
+
+    return late;
+}
+
+int64_t sched_wait (sched_t * sched) {
+    // Sleep until next deadline, then mark it as served.
+    k_sleep(K_TIMEOUT_ABS_MS(sched_deadline(sched)));
+    return sched_advance(sched);
+}
@@ -0,0 +1,94 @@
+/** @defgroup   sched Scheduler
+ *
+ *  @brief      Periodic deadline scheduling.
+ *
+ *  This module keeps periodic activities on a fixed time grid, independent of
+ *  how long each cycle's work takes. A schedule is set up by calling
+ *  sched_init() with the desired period. Its deadlines lie at whole multiples
+ *  of the period from boot, or, if configured, at whole multiples of the period
+ *  on the wall clock, such as every 15 minutes on the quarter hour. A thread
+ *  can sleep until the next deadline by calling sched_wait(), which reports how
+ *  late the wake-up was. Threads that wait on other events as well can obtain
+ *  the next deadline with sched_deadline(), and mark it as served with
+ *  sched_advance(). If the work of a cycle overruns one or more deadlines, the
+ *  missed deadlines are merged into a single late cycle rather than run back to
+ *  back.
+ */
+
+#ifndef __SCHED_H__
+#define __SCHED_H__
+
+#include <stdint.h>
+
+/** @ingroup    sched
+ *
+ *  @brief      Schedule.
+ *
+ *  This structure holds the state of a periodic schedule. It is initialized by
+ *  sched_init(), and must not be modified directly.
+ */
+
+typedef struct {
+    int64_t period;     //!< Period in milliseconds.
+    int64_t next;       //!< Next deadline as uptime in milliseconds.
+    uint32_t skipped;   //!< Number of deadlines skipped due to overruns.
+} sched_t;
+
+/** @ingroup    sched
+ *
+ *  @brief      Initialize schedule.
+ *
+ *  Sets up a schedule whose first deadline lies one period after boot.
+ *
+ *  @param      sched   Pointer to schedule.
+ *  @param      period  Period in seconds. Must be greater than 0.
+ */
+
+void sched_init (sched_t * sched, uint32_t period);
+
+/** @ingroup    sched
+ *
+ *  @brief      Obtain next deadline.
+ *
+ *  Obtains the next deadline of the schedule. If wall-clock alignment is
+ *  configured and the current time is known, the deadline is first moved onto
+ *  the nearest wall-clock boundary. If more than one deadline has already
+ *  passed, all but the latest one are skipped.
+ *
+ *  @param      sched   Pointer to schedule.
+ *
+ *  @return     Next deadline as uptime in milliseconds. May lie in the past.
+ */
+
+int64_t sched_deadline (sched_t * sched);
+
+/** @ingroup    sched
+ *
+ *  @brief      Mark deadline as served.
+ *
+ *  Moves the schedule on to the deadline following the current one. This
+ *  function is intended to be called once the work of a cycle is started.
+ *
+ *  @param      sched   Pointer to schedule.
+ *
+ *  @return     Time in milliseconds by which the served deadline was missed.
+ */
+
+int64_t sched_advance (sched_t * sched);
+
+/** @ingroup    sched
+ *
+ *  @brief      Sleep until next deadline.
+ *
+ *  Puts the calling thread to sleep until the next deadline, and then marks the
+ *  deadline as served. If the deadline has already passed, returns
+ *  immediately.
+ *
+ *  @param      sched   Pointer to schedule.
+ *
+ *  @return     Time in milliseconds by which the deadline was missed.
+ */
+
+int64_t sched_wait (sched_t * sched);
+
+#endif
@@ -0,0 +1,95 @@
+#include <stdbool.h>
+#include <stdint.h>
+#include <string.h>
+#include <errno.h>
+
+#include <zephyr/kernel.h>
+#include <zephyr/logging/log.h>
+
+#include <nrf_modem_gnss.h>
+
+// Use logging module of simulated modem.
+LOG_MODULE_DECLARE(sim, CONFIG_SIM_LOG_LEVEL);
+
+static void _sim_gnss_work_handler (struct k_work * work);
+
+// Work item raising fix event.
+static K_WORK_DELAYABLE_DEFINE(_sim_gnss_work, _sim_gnss_work_handler);
+
+// Registered event handler.
+static nrf_modem_gnss_event_handler_type_t _sim_gnss_handler = NULL;
+
+// Uptime at which the latest fix was obtained.
+static int64_t _sim_gnss_fix_time = 0;
+
+static void _sim_gnss_work_handler (struct k_work * work) {
+    // Record time of fix and raise PVT event.
+    _sim_gnss_fix_time = k_uptime_get();
+
+    if (_sim_gnss_handler != NULL) {
+        _sim_gnss_handler(NRF_MODEM_GNSS_EVT_PVT);
+    }
+}
+
+int32_t nrf_modem_gnss_event_handler_set (
+    nrf_modem_gnss_event_handler_type_t handler
+) {
+    _sim_gnss_handler = handler;
+    return 0;
+}
+
+int32_t nrf_modem_gnss_fix_interval_set (uint16_t fix_interval) {
+    return 0;
+}
+
+int32_t nrf_modem_gnss_fix_retry_set (uint16_t fix_retry) {
+    return 0;
+}
+
+int32_t nrf_modem_gnss_start (void) {
+    // Obtain fix after the configured time to fix.
+    LOG_DBG("Simulated GNSS started");
+    k_work_reschedule(&_sim_gnss_work, K_MSEC(CONFIG_SIM_GNSS_FIX_TIME));
+    return 0;
+}
+
+int32_t nrf_modem_gnss_stop (void) {
+    // Abort pending fix.
+    LOG_DBG("Simulated GNSS stopped");
+    k_work_cancel_delayable(&_sim_gnss_work);
+    return 0;
+}
+
+int32_t nrf_modem_gnss_read (void * buf, int32_t buf_len, int type) {
+    struct nrf_modem_gnss_pvt_data_frame * pvt;  // PVT solution.
+    int64_t time;                               // Time of day in milliseconds.
+
+    if (type != NRF_MODEM_GNSS_DATA_PVT || buf_len < sizeof(*pvt)) {
+        return -EINVAL;
+    }
+
+    /*
+     * Report a valid fix at the configured location. The date is fixed, and
+     * the time of day is derived from the uptime at which the fix was obtained,
+     * so that consecutive fixes carry increasing timestamps.
+     */
+
+    pvt = buf;
+    memset(pvt, 0, sizeof(*pvt));
+
+    pvt->latitude = CONFIG_SIM_GNSS_LATITUDE / 1e6;
+    pvt->longitude = CONFIG_SIM_GNSS_LONGITUDE / 1e6;
+    pvt->flags = NRF_MODEM_GNSS_PVT_FLAG_FIX_VALID;
+
+    time = _sim_gnss_fix_time % 86400000LL;
+
+    pvt->datetime.year = 2023;
+    pvt->datetime.month = 1;
+    pvt->datetime.day = 1;
+    pvt->datetime.hour = time / 3600000;
+    pvt->datetime.minute = time / 60000 % 60;
+    pvt->datetime.seconds = time / 1000 % 60;
+    pvt->datetime.ms = time % 1000;
+
+    return 0;
+}
@@ -0,0 +1,87 @@
+/** @defgroup   sim_gnss Simulated GNSS interface
+ *
+ *  @brief      Stand-in for the modem library GNSS interface.
+ *
+ *  This header declares the subset of the modem library GNSS interface that is
+ *  used by the application, for builds that run without a modem. The names,
+ *  types and values match those of the modem library, so that the GNSS module
+ *  builds unchanged against either. The interface is implemented by the
+ *  simulated GNSS back-end, which reports scripted fixes.
+ */
+
+#ifndef NRF_MODEM_GNSS_H__
+#define NRF_MODEM_GNSS_H__
+
+#include <stdint.h>
+
+/** @ingroup    sim_gnss
+ *
+ *  @brief      PVT event, raised when a new PVT solution is available.
+ */
+
+#define NRF_MODEM_GNSS_EVT_PVT              1
+
+/** @ingroup    sim_gnss
+ *
+ *  @brief      Data type of PVT solutions, for nrf_modem_gnss_read().
+ */
+
+#define NRF_MODEM_GNSS_DATA_PVT             1
+
+/** @ingroup    sim_gnss
+ *
+ *  @brief      PVT flag indicating a valid fix.
+ */
+
+#define NRF_MODEM_GNSS_PVT_FLAG_FIX_VALID   0x01
+
+/** @ingroup    sim_gnss
+ *
+ *  @brief      Date and time of a PVT solution.
+ */
+
+struct nrf_modem_gnss_datetime {
+    uint16_t year;      //!< Year.
+    uint8_t month;      //!< Month.
+    uint8_t day;        //!< Day.
+    uint8_t hour;       //!< Hour.
+    uint8_t minute;     //!< Minute.
+    uint8_t seconds;    //!< Second.
+    uint16_t ms;        //!< Millisecond.
+};
+
+/** @ingroup    sim_gnss
+ *
+ *  @brief      PVT solution.
+ */
+
+struct nrf_modem_gnss_pvt_data_frame {
+    double latitude;                        //!< Latitude in degrees.
+    double longitude;                       //!< Longitude in degrees.
+    float altitude;                         //!< Altitude in meters.
+    struct nrf_modem_gnss_datetime datetime;    //!< Date and time.
+    uint8_t flags;                          //!< PVT flags.
+};
+
+/** @ingroup    sim_gnss
+ *
+ *  @brief      GNSS event handler.
+ */
+
+typedef void (*nrf_modem_gnss_event_handler_type_t) (int event);
+
+int32_t nrf_modem_gnss_event_handler_set (
+    nrf_modem_gnss_event_handler_type_t handler
+);
+
+int32_t nrf_modem_gnss_fix_interval_set (uint16_t fix_interval);
+
+int32_t nrf_modem_gnss_fix_retry_set (uint16_t fix_retry);
+
+int32_t nrf_modem_gnss_start (void);
+
+int32_t nrf_modem_gnss_stop (void);
+
+int32_t nrf_modem_gnss_read (void * buf, int32_t buf_len, int type);
+
+#endif
@@ -0,0 +1,205 @@
+#include <stdbool.h>
+#include <stddef.h>
+#include <stdint.h>
+
+#include <zephyr/kernel.h>
+#include <zephyr/logging/log.h>
+
+#include <modem/lte_lc.h>
+
+// Register module for logging.
+LOG_MODULE_REGISTER(sim, CONFIG_SIM_LOG_LEVEL);
+
+// Maximum number of events in timeline.
+#define _SIM_LTE_EVT_MAX    8
+
+// Timeline step.
+typedef struct {
+    int32_t delay;          // Delay after previous step in milliseconds.
+    struct lte_lc_evt evt;  // Event raised at this step.
+} _sim_lte_step_t;
+
+static void _sim_lte_work_handler (struct k_work * work);
+
+// Mutex protecting timeline state.
+static K_MUTEX_DEFINE(_sim_lte_mutex);
+
+// Work item replaying timeline.
+static K_WORK_DELAYABLE_DEFINE(_sim_lte_work, _sim_lte_work_handler);
+
+// Registered event handler.
+static lte_lc_evt_handler_t _sim_lte_handler = NULL;
+
+// PSM and eDRX requests.
+static bool _sim_lte_psm = false;
+static bool _sim_lte_edrx = false;
+
+// Timeline of events, and index of next step.
+static _sim_lte_step_t _sim_lte_steps[_SIM_LTE_EVT_MAX];
+static size_t _sim_lte_step_count = 0;
+static size_t _sim_lte_step_next = 0;
+
+static void _sim_lte_step (int32_t delay, struct lte_lc_evt * evt) {
+    // Append step to timeline.
+    if (_sim_lte_step_count < _SIM_LTE_EVT_MAX) {
+        _sim_lte_steps[_sim_lte_step_count].delay = delay;
+        _sim_lte_steps[_sim_lte_step_count].evt = *evt;
+        _sim_lte_step_count++;
+    }
+}
+
+static void _sim_lte_script (void) {
+    struct lte_lc_evt evt;  // Event to be scripted.
+
+    /*
+     * Script the events reported by a modem that attaches to an LTE-M network:
+     * a network search, followed after the attach time by the network mode,
+     * cell and registration, the negotiated PSM and eDRX parameters if
+     * requested, and an RRC connection that is released after the RRC
+     * inactivity time.
+     */
+
+    _sim_lte_step_count = 0;
+    _sim_lte_step_next = 0;
+
+    evt.type = LTE_LC_EVT_NW_REG_STATUS;
+    evt.nw_reg_status = LTE_LC_NW_REG_SEARCHING;
+    _sim_lte_step(0, &evt);
+
+    evt.type = LTE_LC_EVT_LTE_MODE_UPDATE;
+    evt.lte_mode = LTE_LC_LTE_MODE_LTEM;
+    _sim_lte_step(CONFIG_SIM_LTE_ATTACH_TIME, &evt);
+
+    evt.type = LTE_LC_EVT_CELL_UPDATE;
+    evt.cell.id = CONFIG_SIM_LTE_CELL_ID;
+    evt.cell.tac = CONFIG_SIM_LTE_TAC;
+    _sim_lte_step(0, &evt);
+
+    evt.type = LTE_LC_EVT_NW_REG_STATUS;
+    evt.nw_reg_status = LTE_LC_NW_REG_REGISTERED_HOME;
+    _sim_lte_step(0, &evt);
+
+    evt.type = LTE_LC_EVT_RRC_UPDATE;
+    evt.rrc_mode = LTE_LC_RRC_MODE_CONNECTED;
+    _sim_lte_step(0, &evt);
+
+    if (_sim_lte_psm) {
+        evt.type = LTE_LC_EVT_PSM_UPDATE;
+        evt.psm_cfg.tau = CONFIG_SIM_LTE_PSM_TAU;
+        evt.psm_cfg.active_time = CONFIG_SIM_LTE_PSM_ACTIVE_TIME;
+        _sim_lte_step(0, &evt);
+    }
+
+    if (_sim_lte_edrx) {
+        evt.type = LTE_LC_EVT_EDRX_UPDATE;
+        evt.edrx_cfg.mode = LTE_LC_LTE_MODE_LTEM;
+        evt.edrx_cfg.edrx = 81.92;
+        evt.edrx_cfg.ptw = 2.56;
+        _sim_lte_step(0, &evt);
+    }
+
+    evt.type = LTE_LC_EVT_RRC_UPDATE;
+    evt.rrc_mode = LTE_LC_RRC_MODE_IDLE;
+    _sim_lte_step(CONFIG_SIM_LTE_RRC_TIME, &evt);
+}
+
+static void _sim_lte_work_handler (struct k_work * work) {
+    struct lte_lc_evt evt;          // Non-shared copy of event.
+    lte_lc_evt_handler_t handler;   // Non-shared copy of handler.
+
+    // Block other threads from accessing shared resources.
+    k_mutex_lock(&_sim_lte_mutex, K_FOREVER);
+
+    if (_sim_lte_step_next >= _sim_lte_step_count) {
+        // Timeline complete, nothing to do.
+        k_mutex_unlock(&_sim_lte_mutex);
+        return;
+    }
+
+    // Safely copy event and handler to non-shared variables, and schedule
+    // following step.
+
+    evt = _sim_lte_steps[_sim_lte_step_next].evt;
+    handler = _sim_lte_handler;
+    _sim_lte_step_next++;
+
+    if (_sim_lte_step_next < _sim_lte_step_count) {
+        k_work_schedule(
+            &_sim_lte_work, K_MSEC(_sim_lte_steps[_sim_lte_step_next].delay)
+        );
+    }
+
+    // Allow other threads to access shared resources.
+    k_mutex_unlock(&_sim_lte_mutex);
+
+    // Raise event.
+    if (handler != NULL) {
+        handler(&evt);
+    }
+}
+
+static void _sim_lte_stop (void) {
+    // Discard remaining timeline.
+    k_mutex_lock(&_sim_lte_mutex, K_FOREVER);
+    _sim_lte_step_count = 0;
+    _sim_lte_step_next = 0;
+    k_mutex_unlock(&_sim_lte_mutex);
+
+    k_work_cancel_delayable(&_sim_lte_work);
+}
+
+int lte_lc_init (void) {
+    LOG_DBG("Simulated modem initialized");
+    return 0;
+}
+
+int lte_lc_deinit (void) {
+    _sim_lte_stop();
+    LOG_DBG("Simulated modem deinitialized");
+    return 0;
+}
+
+int lte_lc_func_mode_set (enum lte_lc_func_mode mode) {
+    switch (mode) {
+        case LTE_LC_FUNC_MODE_NORMAL:
+        case LTE_LC_FUNC_MODE_ACTIVATE_LTE:
+            // Start replaying attach timeline.
+            LOG_DBG("Simulated LTE activated");
+            k_mutex_lock(&_sim_lte_mutex, K_FOREVER);
+            _sim_lte_script();
+            k_mutex_unlock(&_sim_lte_mutex);
+            k_work_reschedule(&_sim_lte_work, K_NO_WAIT);
+            break;
+        case LTE_LC_FUNC_MODE_POWER_OFF:
+        case LTE_LC_FUNC_MODE_OFFLINE:
+        case LTE_LC_FUNC_MODE_DEACTIVATE_LTE:
+            // Abort timeline.
+            LOG_DBG("Simulated LTE deactivated");
+            _sim_lte_stop();
+            break;
+        default:
+            break;
+    }
+
+    return 0;
+}
+
+int lte_lc_psm_req (bool enable) {
+    k_mutex_lock(&_sim_lte_mutex, K_FOREVER);
+    _sim_lte_psm = enable;
+    k_mutex_unlock(&_sim_lte_mutex);
+    return 0;
+}
+
+int lte_lc_edrx_req (bool enable) {
+    k_mutex_lock(&_sim_lte_mutex, K_FOREVER);
+    _sim_lte_edrx = enable;
+    k_mutex_unlock(&_sim_lte_mutex);
+    return 0;
+}
+
+void lte_lc_register_handler (lte_lc_evt_handler_t handler) {
+    k_mutex_lock(&_sim_lte_mutex, K_FOREVER);
+    _sim_lte_handler = handler;
+    k_mutex_unlock(&_sim_lte_mutex);
+}
@@ -0,0 +1,361 @@
+#include <stdbool.h>
+#include <stddef.h>
+#include <stdint.h>
+#include <stdlib.h>
+#include <string.h>
+#include <errno.h>
+
+#include <zephyr/kernel.h>
+#include <zephyr/init.h>
+#include <zephyr/logging/log.h>
+#include <zephyr/net/socket.h>
+#include <zephyr/net/socket_offload.h>
+#include <zephyr/net/dns_resolve.h>
+#include <zephyr/sys/fdtable.h>
+
+#include "socket_sim_bottom.h"
+
+// Use logging module of simulated modem.
+LOG_MODULE_DECLARE(sim, CONFIG_SIM_LOG_LEVEL);
+
+// Maximum number of open sockets.
+#define SOCKET_SIM_MAX  4
+
+// Resolved address, allocated along with its description.
+typedef struct {
+    struct zsock_addrinfo info; // Address description.
+    struct sockaddr_in addr;    // IPv4 address.
+} _sim_sock_addrinfo_t;
+
+// Host socket descriptors of open sockets, or -1 for unused entries.
+static int _sim_sock_host[SOCKET_SIM_MAX] = {-1, -1, -1, -1};
+
+// Number of sends made and bytes sent on each open socket, and number of sends
+// made on all sockets since start. Every send stands for a write to the modem,
+// so these show how many writes requests take.
+static uint32_t _sim_sock_sends[SOCKET_SIM_MAX];
+static uint32_t _sim_sock_bytes[SOCKET_SIM_MAX];
+static uint32_t _sim_sock_total = 0;
+
+// Mutex protecting socket table and send counters.
+static K_MUTEX_DEFINE(_sim_sock_mutex);
+
+static const struct socket_op_vtable _sim_sock_vtable;
+
+static ssize_t _sim_sock_result (int status) {
+    // Convert negative error code to socket API convention.
+    if (status < 0) {
+        errno = -status;
+        return -1;
+    }
+    return status;
+}
+
+static int _sim_sock_send (int * obj, const void * buf, size_t len) {
+    int status;                         // Return status for API calls.
+    size_t i = obj - _sim_sock_host;    // Index in socket table.
+
+    // Send data on host socket, and count the send.
+    status = socket_sim_bottom_send(*obj, buf, len);
+    if (status >= 0) {
+        k_mutex_lock(&_sim_sock_mutex, K_FOREVER);
+        _sim_sock_sends[i]++;
+        _sim_sock_bytes[i] += status;
+        _sim_sock_total++;
+        k_mutex_unlock(&_sim_sock_mutex);
+    }
+
+    return status;
+}
+
+static ssize_t _sim_sock_read (void * obj, void * buf, size_t len) {
+    return _sim_sock_result(
+        socket_sim_bottom_recv(*(int *)obj, buf, len, false)
+    );
+}
+
+static ssize_t _sim_sock_write (void * obj, const void * buf, size_t len) {
+    return _sim_sock_result(_sim_sock_send(obj, buf, len));
+}
+
+static int _sim_sock_close (void * obj) {
+    int status;                                 // Return status for API calls.
+    size_t i = (int *)obj - _sim_sock_host;     // Index in socket table.
+
+    // Close host socket, report its sends, and release table entry.
+    k_mutex_lock(&_sim_sock_mutex, K_FOREVER);
+    status = socket_sim_bottom_close(*(int *)obj);
+    LOG_INF(
+        "Socket closed after %u sends (%u bytes), %u sends in total",
+        _sim_sock_sends[i], _sim_sock_bytes[i], _sim_sock_total
+    );
+    _sim_sock_sends[i] = 0;
+    _sim_sock_bytes[i] = 0;
+    *(int *)obj = -1;
+    k_mutex_unlock(&_sim_sock_mutex);
+
+    return _sim_sock_result(status);
+}
+
+static int _sim_sock_poll (struct zsock_pollfd * fds, int nfds, int timeout) {
+    int status;                         // Return status for API calls.
+    int socks[SOCKET_SIM_MAX];          // Host socket descriptors.
+    short events[SOCKET_SIM_MAX];       // Requested events.
+    short revents[SOCKET_SIM_MAX];      // Returned events.
+    int * obj;                          // Socket object.
+
+    if (nfds > SOCKET_SIM_MAX) {
+        errno = EINVAL;
+        return -1;
+    }
+
+    // Translate descriptors to host sockets, poll, and report events back.
+
+    for (int i = 0; i < nfds; i++) {
+        obj = z_get_fd_obj(
+            fds[i].fd, (const struct fd_op_vtable *)&_sim_sock_vtable, ENOTSUP
+        );
+        socks[i] = obj != NULL ? *obj : -1;
+        events[i] = fds[i].events;
+    }
+
+    status = socket_sim_bottom_poll(socks, events, revents, nfds, timeout);
+    if (status < 0) {
+        return _sim_sock_result(status);
+    }
+
+    for (int i = 0; i < nfds; i++) {
+        fds[i].revents = revents[i];
+    }
+
+    return status;
+}
+
+static int _sim_sock_ioctl (void * obj, unsigned int request, va_list args) {
+    struct zsock_pollfd * fds;  // Poll descriptors.
+    int nfds;                   // Number of poll descriptors.
+    int timeout;                // Poll timeout.
+
+    switch (request) {
+        case ZFD_IOCTL_POLL_PREPARE:
+            // Have poll() handed over to this socket layer.
+            return -EXDEV;
+        case ZFD_IOCTL_POLL_UPDATE:
+            return -EOPNOTSUPP;
+        case ZFD_IOCTL_POLL_OFFLOAD:
+            fds = va_arg(args, struct zsock_pollfd *);
+            nfds = va_arg(args, int);
+            timeout = va_arg(args, int);
+            return _sim_sock_poll(fds, nfds, timeout);
+        default:
+            errno = EOPNOTSUPP;
+            return -1;
+    }
+}
+
+static int _sim_sock_connect (
+    void * obj, const struct sockaddr * addr, socklen_t addrlen
+) {
+    const struct sockaddr_in * sin; // IPv4 address.
+
+    if (addr->sa_family != AF_INET || addrlen < sizeof(*sin)) {
+        errno = EAFNOSUPPORT;
+        return -1;
+    }
+
+    sin = (const struct sockaddr_in *)addr;
+
+    return _sim_sock_result(
+        socket_sim_bottom_connect(
+            *(int *)obj, sin->sin_addr.s_addr, sin->sin_port
+        )
+    );
+}
+
+static ssize_t _sim_sock_sendto (
+    void * obj, const void * buf, size_t len, int flags,
+    const struct sockaddr * dest_addr, socklen_t addrlen
+) {
+    // Connected sockets ignore the destination address.
+    return _sim_sock_result(_sim_sock_send(obj, buf, len));
+}
+
+static ssize_t _sim_sock_sendmsg (
+    void * obj, const struct msghdr * msg, int flags
+) {
+    int status;         // Return status for API calls.
+    ssize_t sent = 0;   // Number of bytes sent.
+
+    // Send buffers one after another, stopping at the first partial send, as
+    // the caller sends the remainder again.
+    for (size_t i = 0; i < msg->msg_iovlen; i++) {
+        status = _sim_sock_send(
+            obj, msg->msg_iov[i].iov_base, msg->msg_iov[i].iov_len
+        );
+        if (status < 0) {
+            return sent > 0 ? sent : _sim_sock_result(status);
+        }
+        sent += status;
+        if ((size_t)status < msg->msg_iov[i].iov_len) {
+            break;
+        }
+    }
+
+    return sent;
+}
+
+static ssize_t _sim_sock_recvfrom (
+    void * obj, void * buf, size_t max_len, int flags,
+    struct sockaddr * src_addr, socklen_t * addrlen
+) {
+    // Connected sockets do not report the source address.
+    return _sim_sock_result(
+        socket_sim_bottom_recv(
+            *(int *)obj, buf, max_len, (flags & ZSOCK_MSG_DONTWAIT) != 0
+        )
+    );
+}
+
+static int _sim_sock_setsockopt (
+    void * obj, int level, int optname, const void * optval, socklen_t optlen
+) {
+    // Options are accepted, but have no effect.
+    return 0;
+}
+
+// Socket operations.
+static const struct socket_op_vtable _sim_sock_vtable = {
+    .fd_vtable = {
+        .read = _sim_sock_read,
+        .write = _sim_sock_write,
+        .close = _sim_sock_close,
+        .ioctl = _sim_sock_ioctl,
+    },
+    .connect = _sim_sock_connect,
+    .sendto = _sim_sock_sendto,
+    .sendmsg = _sim_sock_sendmsg,
+    .recvfrom = _sim_sock_recvfrom,
+    .setsockopt = _sim_sock_setsockopt,
+};
+
+static bool _sim_sock_is_supported (int family, int type, int proto) {
+    // Support plain TCP and UDP over IPv4 only.
+    return family == AF_INET && (
+        (type == SOCK_STREAM && (proto == 0 || proto == IPPROTO_TCP))
+        || (type == SOCK_DGRAM && (proto == 0 || proto == IPPROTO_UDP))
+    );
+}
+
+static int _sim_sock_create (int family, int type, int proto) {
+    int fd;         // Zephyr file descriptor.
+    int sock;       // Host socket descriptor.
+    int * obj;      // Socket object.
+
+    /*
+     * Reserve a file descriptor, open a host socket, and bind the two through
+     * a free entry in the socket table. If an error occurs in this process,
+     * release what was obtained and exit with failure.
+     */
+
+    fd = z_reserve_fd();
+    if (fd < 0) {
+        return -1;
+    }
+
+    sock = socket_sim_bottom_open(type == SOCK_DGRAM);
+    if (sock < 0) {
+        z_free_fd(fd);
+        return _sim_sock_result(sock);
+    }
+
+    obj = NULL;
+
+    k_mutex_lock(&_sim_sock_mutex, K_FOREVER);
+    for (int i = 0; i < SOCKET_SIM_MAX; i++) {
+        if (_sim_sock_host[i] < 0) {
+            _sim_sock_host[i] = sock;
+            obj = &_sim_sock_host[i];
+            break;
+        }
+    }
+    k_mutex_unlock(&_sim_sock_mutex);
+
+    if (obj == NULL) {
+        socket_sim_bottom_close(sock);
+        z_free_fd(fd);
+        errno = ENOMEM;
+        return -1;
+    }
+
+    z_finalize_fd(fd, obj, (const struct fd_op_vtable *)&_sim_sock_vtable);
+
+    return fd;
+}
+
+static int _sim_sock_getaddrinfo (
+    const char * node, const char * service,
+    const struct zsock_addrinfo * hints, struct zsock_addrinfo ** res
+) {
+    int status;                 // Return status for API calls.
+    uint32_t addr;              // Resolved IPv4 address.
+    _sim_sock_addrinfo_t * ai;  // Resolved address description.
+
+    if (hints != NULL && hints->ai_family != AF_UNSPEC
+            && hints->ai_family != AF_INET) {
+        return DNS_EAI_FAMILY;
+    }
+
+    // Resolve name through host.
+    status = socket_sim_bottom_resolve(node, &addr);
+    if (status < 0) {
+        return DNS_EAI_NONAME;
+    }
+
+    ai = k_calloc(1, sizeof(*ai));
+    if (ai == NULL) {
+        return DNS_EAI_MEMORY;
+    }
+
+    ai->addr.sin_family = AF_INET;
+    ai->addr.sin_addr.s_addr = addr;
+    ai->addr.sin_port = htons(service != NULL ? atoi(service) : 0);
+
+    ai->info.ai_family = AF_INET;
+    if (hints != NULL && hints->ai_socktype == SOCK_DGRAM) {
+        ai->info.ai_socktype = SOCK_DGRAM;
+        ai->info.ai_protocol = IPPROTO_UDP;
+    } else {
+        ai->info.ai_socktype = SOCK_STREAM;
+        ai->info.ai_protocol = IPPROTO_TCP;
+    }
+    ai->info.ai_addr = (struct sockaddr *)&ai->addr;
+    ai->info.ai_addrlen = sizeof(ai->addr);
+
+    *res = &ai->info;
+
+    return 0;
+}
+
+static void _sim_sock_freeaddrinfo (struct zsock_addrinfo * res) {
+    // Description is the first member of the allocated structure.
+    k_free(res);
+}
+
+// Name resolution operations.
+static const struct socket_dns_offload _sim_sock_dns = {
+    .getaddrinfo = _sim_sock_getaddrinfo,
+    .freeaddrinfo = _sim_sock_freeaddrinfo,
+};
+
+static int _sim_sock_init (const struct device * dev) {
+    // Resolve names through host.
+    socket_offload_dns_register(&_sim_sock_dns);
+    return 0;
+}
+
+NET_SOCKET_REGISTER(
+    sim, CONFIG_NET_SOCKETS_PRIORITY_DEFAULT, AF_INET,
+    _sim_sock_is_supported, _sim_sock_create
+);
+
+SYS_INIT(_sim_sock_init, APPLICATION, CONFIG_APPLICATION_INIT_PRIORITY);
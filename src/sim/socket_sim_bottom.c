@@ -0,0 +1,118 @@
+#include <stdbool.h>
+#include <stddef.h>
+#include <stdint.h>
+#include <string.h>
+#include <errno.h>
+
+#include <netdb.h>
+#include <poll.h>
+#include <unistd.h>
+#include <arpa/inet.h>
+#include <netinet/in.h>
+#include <sys/socket.h>
+
+#include "socket_sim_bottom.h"
+
+// Maximum number of sockets polled at once.
+#define SOCKET_SIM_POLL_MAX 8
+
+int socket_sim_bottom_resolve (const char * name, uint32_t * addr) {
+    int status;                 // Return status for API calls.
+    struct addrinfo hints;      // Address lookup hints.
+    struct addrinfo * res;      // Resolved addresses.
+
+    memset(&hints, 0, sizeof(hints));
+    hints.ai_family = AF_INET;
+    hints.ai_socktype = SOCK_STREAM;
+
+    status = getaddrinfo(name, NULL, &hints, &res);
+    if (status != 0) {
+        return -EHOSTUNREACH;
+    }
+
+    *addr = ((struct sockaddr_in *)res->ai_addr)->sin_addr.s_addr;
+    freeaddrinfo(res);
+
+    return 0;
+}
+
+int socket_sim_bottom_open (bool dgram) {
+    int sock;   // Socket descriptor.
+
+    sock = dgram
+        ? socket(AF_INET, SOCK_DGRAM, IPPROTO_UDP)
+        : socket(AF_INET, SOCK_STREAM, IPPROTO_TCP);
+    return sock < 0 ? -errno : sock;
+}
+
+int socket_sim_bottom_connect (int sock, uint32_t addr, uint16_t port) {
+    struct sockaddr_in sin; // Server address.
+
+    memset(&sin, 0, sizeof(sin));
+    sin.sin_family = AF_INET;
+    sin.sin_addr.s_addr = addr;
+    sin.sin_port = port;
+
+    if (connect(sock, (struct sockaddr *)&sin, sizeof(sin)) < 0) {
+        return -errno;
+    }
+
+    return 0;
+}
+
+int socket_sim_bottom_send (int sock, const void * buf, size_t len) {
+    ssize_t sent;   // Number of bytes sent.
+
+    // Do not raise SIGPIPE if the server has closed the connection.
+    sent = send(sock, buf, len, MSG_NOSIGNAL);
+    return sent < 0 ? -errno : (int)sent;
+}
+
+int socket_sim_bottom_recv (int sock, void * buf, size_t len, bool nonblock) {
+    ssize_t received;   // Number of bytes received.
+
+    received = recv(sock, buf, len, nonblock ? MSG_DONTWAIT : 0);
+    return received < 0 ? -errno : (int)received;
+}
+
+int socket_sim_bottom_poll (
+    const int * socks, const short * events, short * revents, int count,
+    int timeout
+) {
+    int status;                             // Return status for API calls.
+    struct pollfd fds[SOCKET_SIM_POLL_MAX]; // Host poll descriptors.
+
+    if (count > SOCKET_SIM_POLL_MAX) {
+        return -EINVAL;
+    }
+
+    // Translate event flags to those of the host, and back.
+
+    for (int i = 0; i < count; i++) {
+        fds[i].fd = socks[i];
+        fds[i].events = 0;
+        fds[i].events |= events[i] & SOCKET_SIM_POLLIN ? POLLIN : 0;
+        fds[i].events |= events[i] & SOCKET_SIM_POLLOUT ? POLLOUT : 0;
+        fds[i].revents = 0;
+    }
+
+    status = poll(fds, count, timeout);
+    if (status < 0) {
+        return -errno;
+    }
+
+    for (int i = 0; i < count; i++) {
+        revents[i] = 0;
+        revents[i] |= fds[i].revents & POLLIN ? SOCKET_SIM_POLLIN : 0;
+        revents[i] |= fds[i].revents & POLLOUT ? SOCKET_SIM_POLLOUT : 0;
+        revents[i] |= fds[i].revents & POLLERR ? SOCKET_SIM_POLLERR : 0;
+        revents[i] |= fds[i].revents & POLLHUP ? SOCKET_SIM_POLLHUP : 0;
+        revents[i] |= fds[i].revents & POLLNVAL ? SOCKET_SIM_POLLNVAL : 0;
+    }
+
+    return status;
+}
+
+int socket_sim_bottom_close (int sock) {
+    return close(sock) < 0 ? -errno : 0;
+}
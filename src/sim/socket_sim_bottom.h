@@ -0,0 +1,129 @@
+/** @defgroup   sim_socket_bottom Simulated socket host interface
+ *
+ *  @brief      TCP and UDP sockets of the host running the simulation.
+ *
+ *  This module gives access to TCP and UDP sockets of the host running the
+ *  simulation. It is compiled against the host's headers rather than
+ *  Zephyr's, and is therefore kept apart from the simulated socket layer,
+ *  which calls into it through this interface only. Addresses and ports are
+ *  given in network byte order. Functions return negative error codes on
+ *  failure.
+ */
+
+#ifndef __SOCKET_SIM_BOTTOM_H__
+#define __SOCKET_SIM_BOTTOM_H__
+
+#include <stdbool.h>
+#include <stddef.h>
+#include <stdint.h>
+
+/** @ingroup    sim_socket_bottom
+ *
+ *  @brief      Poll event flags.
+ *
+ *  These values match those of the Zephyr socket API.
+ */
+
+#define SOCKET_SIM_POLLIN   0x01    //!< Data may be read.
+#define SOCKET_SIM_POLLOUT  0x04    //!< Data may be written.
+#define SOCKET_SIM_POLLERR  0x08    //!< Error condition.
+#define SOCKET_SIM_POLLHUP  0x10    //!< Connection closed.
+#define SOCKET_SIM_POLLNVAL 0x20    //!< Invalid socket.
+
+/** @ingroup    sim_socket_bottom
+ *
+ *  @brief      Resolve host name to IPv4 address.
+ *
+ *  @param      name    Host name.
+ *  @param      addr    Pointer to variable into which address must be written.
+ *
+ *  @return     0 on success, negative error code on failure.
+ */
+
+int socket_sim_bottom_resolve (const char * name, uint32_t * addr);
+
+/** @ingroup    sim_socket_bottom
+ *
+ *  @brief      Open TCP or UDP socket.
+ *
+ *  @param      dgram   Open UDP socket rather than TCP socket.
+ *
+ *  @return     Host socket descriptor on success, negative error code on
+ *              failure.
+ */
+
+int socket_sim_bottom_open (bool dgram);
+
+/** @ingroup    sim_socket_bottom
+ *
+ *  @brief      Connect socket to IPv4 address.
+ *
+ *  @param      sock    Host socket descriptor.
+ *  @param      addr    IPv4 address.
+ *  @param      port    Port number.
+ *
+ *  @return     0 on success, negative error code on failure.
+ */
+
+int socket_sim_bottom_connect (int sock, uint32_t addr, uint16_t port);
+
+/** @ingroup    sim_socket_bottom
+ *
+ *  @brief      Send data.
+ *
+ *  @param      sock    Host socket descriptor.
+ *  @param      buf     Pointer to data.
+ *  @param      len     Length of data.
+ *
+ *  @return     Number of bytes sent on success, negative error code on
+ *              failure.
+ */
+
+int socket_sim_bottom_send (int sock, const void * buf, size_t len);
+
+/** @ingroup    sim_socket_bottom
+ *
+ *  @brief      Receive data.
+ *
+ *  @param      sock        Host socket descriptor.
+ *  @param      buf         Pointer to buffer into which data must be written.
+ *  @param      len         Length of buffer.
+ *  @param      nonblock    Return immediately if no data is available.
+ *
+ *  @return     Number of bytes received on success, negative error code on
+ *              failure.
+ */
+
+int socket_sim_bottom_recv (int sock, void * buf, size_t len, bool nonblock);
+
+/** @ingroup    sim_socket_bottom
+ *
+ *  @brief      Wait for events on sockets.
+ *
+ *  @param      socks   Array of host socket descriptors.
+ *  @param      events  Array of requested event flags.
+ *  @param      revents Array into which returned event flags must be written.
+ *  @param      count   Number of sockets.
+ *  @param      timeout Timeout in milliseconds, or -1 to wait forever.
+ *
+ *  @return     Number of sockets with returned events on success, negative
+ *              error code on failure.
+ */
+
+int socket_sim_bottom_poll (
+    const int * socks, const short * events, short * revents, int count,
+    int timeout
+);
+
+/** @ingroup    sim_socket_bottom
+ *
+ *  @brief      Close socket.
+ *
+ *  @param      sock    Host socket descriptor.
+ *
+ *  @return     0 on success, negative error code on failure.
+ */
+
+int socket_sim_bottom_close (int sock);
+
+#endif
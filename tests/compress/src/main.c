@@ -0,0 +1,413 @@
+#include <stdbool.h>
+#include <stddef.h>
+#include <stdint.h>
+#include <stdio.h>
+#include <string.h>
+
+#include <zephyr/kernel.h>
+#include <zephyr/sys/byteorder.h>
+#include <zephyr/sys/crc.h>
+#include <zephyr/sys/util.h>
+#include <zephyr/ztest.h>
+
+#include "compress.h"
+
+// Size of sliding window.
+#define TEST_WINDOW         CONFIG_COMPRESS_WINDOW_SIZE
+
+// Largest input and output of a single stream.
+#define TEST_DATA_MAX       (5 * TEST_WINDOW + 1000)
+#define TEST_GZIP_MAX       (TEST_DATA_MAX + TEST_DATA_MAX / 4 + 64)
+
+// Period of repeated data, long enough for matches to span several pieces
+// written, but short enough for the hash table to keep track of it.
+#define TEST_REPEAT         300
+
+// Lengths of gzip header and trailer.
+#define TEST_GZIP_HEAD      10
+#define TEST_GZIP_TAIL      8
+
+// Bit reader over a deflate stream, least significant bit first.
+typedef struct {
+    const uint8_t * data;   // Stream contents.
+    size_t len;             // Length of stream.
+    size_t pos;             // Position of next byte.
+    uint32_t bits;          // Pending input bits.
+    int nbits;              // Number of pending input bits.
+    bool overrun;           // Read beyond end of stream.
+} _test_reader_t;
+
+// Header that every stream must start with.
+static const uint8_t _test_gzip_head [] = {
+    0x1f, 0x8b, 0x08, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0xff
+};
+
+// Base values and extra bit counts of deflate length and distance codes, as
+// given by RFC 1951, kept apart from those of the module under test.
+static const uint16_t _test_len_base [] = {
+    3, 4, 5, 6, 7, 8, 9, 10, 11, 13, 15, 17, 19, 23, 27, 31, 35, 43, 51, 59,
+    67, 83, 99, 115, 131, 163, 195, 227, 258
+};
+static const uint8_t _test_len_extra [] = {
+    0, 0, 0, 0, 0, 0, 0, 0, 1, 1, 1, 1, 2, 2, 2, 2, 3, 3, 3, 3, 4, 4, 4, 4,
+    5, 5, 5, 5, 0
+};
+static const uint16_t _test_dist_base [] = {
+    1, 2, 3, 4, 5, 7, 9, 13, 17, 25, 33, 49, 65, 97, 129, 193, 257, 385, 513,
+    769, 1025, 1537, 2049, 3073, 4097, 6145, 8193, 12289, 16385, 24577
+};
+static const uint8_t _test_dist_extra [] = {
+    0, 0, 0, 0, 1, 1, 2, 2, 3, 3, 4, 4, 5, 5, 6, 6, 7, 7, 8, 8, 9, 9, 10, 10,
+    11, 11, 12, 12, 13, 13
+};
+
+// Input, compressed output and decompressed output of the current stream.
+static uint8_t _test_data[TEST_DATA_MAX];
+static uint8_t _test_gzip[TEST_GZIP_MAX];
+static uint8_t _test_plain[TEST_DATA_MAX];
+static size_t _test_gzip_len;
+
+// Number of output function calls, after which it fails, or -1 for never.
+static int _test_fail_after;
+
+static int _test_write (void * ctx, const void * data, size_t len) {
+    ARG_UNUSED(ctx);
+
+    // Append compressed data to output, unless told to fail.
+    if (_test_fail_after == 0) {
+        return -1;
+    }
+    if (_test_fail_after > 0) {
+        _test_fail_after--;
+    }
+
+    zassert_true(
+        _test_gzip_len + len <= sizeof(_test_gzip), "Output overflow"
+    );
+    memcpy(&_test_gzip[_test_gzip_len], data, len);
+    _test_gzip_len += len;
+
+    return 0;
+}
+
+static uint32_t _test_bits (_test_reader_t * rd, int count) {
+    uint32_t value; // Bits read.
+
+    // Read bits, least significant bit first.
+    while (rd->nbits < count) {
+        if (rd->pos == rd->len) {
+            rd->overrun = true;
+            return 0;
+        }
+        rd->bits |= (uint32_t)rd->data[rd->pos++] << rd->nbits;
+        rd->nbits += 8;
+    }
+    value = rd->bits & ((1u << count) - 1);
+    rd->bits >>= count;
+    rd->nbits -= count;
+
+    return value;
+}
+
+static uint32_t _test_code (_test_reader_t * rd, int count) {
+    uint32_t code = 0;  // Huffman code read.
+
+    // Read Huffman code, which is packed most significant bit first.
+    for (int i = 0; i < count; i++) {
+        code = code << 1 | _test_bits(rd, 1);
+    }
+
+    return code;
+}
+
+static int _test_symbol (_test_reader_t * rd) {
+    uint32_t code;  // Huffman code read so far.
+
+    // Read literal or length symbol with fixed Huffman code.
+    code = _test_code(rd, 7);
+    if (code <= 0x17) {
+        return 256 + code;
+    }
+    code = code << 1 | _test_code(rd, 1);
+    if (code >= 0x30 && code <= 0xbf) {
+        return code - 0x30;
+    }
+    if (code >= 0xc0 && code <= 0xc7) {
+        return 280 + code - 0xc0;
+    }
+    code = code << 1 | _test_code(rd, 1);
+    return 144 + code - 0x190;
+}
+
+static int _test_inflate (const uint8_t * gzip, size_t len, uint8_t * out) {
+    _test_reader_t rd = {   // Bit reader.
+        .data = &gzip[TEST_GZIP_HEAD],
+        .len = len - TEST_GZIP_HEAD - TEST_GZIP_TAIL,
+    };
+    size_t olen = 0;        // Length of decompressed data.
+    uint32_t crc;           // CRC-32 given by trailer.
+    uint32_t size;          // Length given by trailer.
+    int sym;                // Literal or length symbol.
+    int code;               // Distance code.
+    size_t mlen;            // Length of back reference.
+    size_t dist;            // Distance of back reference.
+
+    /*
+     * Decompress a gzip stream made up of a single final deflate block with
+     * fixed Huffman codes, which is all the module produces, into the given
+     * buffer. Check the header, that the block ends exactly at the trailer,
+     * and that the trailer matches the decompressed data. Return the length
+     * of the decompressed data, or -1 if the stream is malformed.
+     */
+
+    if (
+        len < TEST_GZIP_HEAD + TEST_GZIP_TAIL
+        || memcmp(gzip, _test_gzip_head, TEST_GZIP_HEAD) != 0
+    ) {
+        return -1;
+    }
+
+    // Block must be final and use fixed Huffman codes.
+    if (_test_bits(&rd, 1) != 1 || _test_bits(&rd, 2) != 1) {
+        return -1;
+    }
+
+    while (!rd.overrun) {
+        sym = _test_symbol(&rd);
+
+        if (sym < 256) {
+            if (olen == TEST_DATA_MAX) {
+                return -1;
+            }
+            out[olen++] = sym;
+            continue;
+        }
+
+        if (sym == 256) {
+            break;
+        }
+
+        if (sym > 285) {
+            return -1;
+        }
+        mlen = _test_len_base[sym - 257]
+            + _test_bits(&rd, _test_len_extra[sym - 257]);
+
+        code = _test_code(&rd, 5);
+        if (code >= ARRAY_SIZE(_test_dist_base)) {
+            return -1;
+        }
+        dist = _test_dist_base[code] + _test_bits(&rd, _test_dist_extra[code]);
+
+        // Back reference must stay within the window and the output.
+        if (
+            dist > olen || dist > 2 * TEST_WINDOW
+            || olen + mlen > TEST_DATA_MAX
+        ) {
+            return -1;
+        }
+        for (size_t i = 0; i < mlen; i++, olen++) {
+            out[olen] = out[olen - dist];
+        }
+    }
+
+    // Block must end in the last byte before the trailer.
+    if (rd.overrun || rd.pos != rd.len || rd.bits != 0) {
+        return -1;
+    }
+
+    crc = sys_get_le32(&gzip[len - TEST_GZIP_TAIL]);
+    size = sys_get_le32(&gzip[len - TEST_GZIP_TAIL + 4]);
+    if (crc != crc32_ieee(out, olen) || size != olen) {
+        return -1;
+    }
+
+    return olen;
+}
+
+static void _test_round_trip (size_t len, size_t chunk) {
+    compress_t comp;                // Compressed stream.
+    compress_t count;               // Stream that is only counted.
+    compress_stats_t before;        // Statistics before compression.
+    compress_stats_t after;         // Statistics after compression.
+    size_t part;                    // Length of piece written.
+    int olen;                       // Length of decompressed data.
+
+    /*
+     * Compress the first given number of bytes of the input, written in pieces
+     * of the given length, and check that the stream decompresses back to the
+     * input. Check that the stream counts match its output, that a stream
+     * that is only counted comes out the same size, and that both are added
+     * to the statistics.
+     */
+
+    compress_stats(&before);
+
+    _test_gzip_len = 0;
+    compress_init(&comp, _test_write, NULL);
+    compress_init(&count, NULL, NULL);
+
+    for (size_t pos = 0; pos < len; pos += part) {
+        part = MIN(chunk, len - pos);
+        zassert_ok(compress_write(&comp, &_test_data[pos], part), "Failed");
+        zassert_ok(compress_write(&count, &_test_data[pos], part), "Failed");
+    }
+
+    zassert_ok(compress_finish(&comp), "Finish failed");
+    zassert_ok(compress_finish(&count), "Finish failed");
+
+    zassert_equal(comp.in, len, "Wrong input count");
+    zassert_equal(comp.out, _test_gzip_len, "Wrong output count");
+    zassert_equal(count.out, comp.out, "Counted size differs");
+
+    olen = _test_inflate(_test_gzip, _test_gzip_len, _test_plain);
+    zassert_equal(olen, len, "Stream malformed or of wrong length");
+    zassert_mem_equal(_test_plain, _test_data, len, "Stream corrupted");
+
+    compress_stats(&after);
+    zassert_equal(after.streams, before.streams + 2, "Wrong stream total");
+    zassert_equal(after.in, before.in + 2 * len, "Wrong input total");
+    zassert_equal(
+        after.out, before.out + 2 * _test_gzip_len, "Wrong output total"
+    );
+    zassert_true(after.time_ms >= before.time_ms, "Time went backwards");
+}
+
+static void _test_random (uint8_t * data, size_t len, uint32_t seed) {
+    // Fill data with pseudorandom bytes that do not compress.
+    for (size_t i = 0; i < len; i++) {
+        seed = seed * 1103515245 + 12345;
+        data[i] = seed >> 16;
+    }
+}
+
+static void _test_before (void * fixture) {
+    ARG_UNUSED(fixture);
+
+    // Start every test with an output function that does not fail.
+    _test_fail_after = -1;
+}
+
+ZTEST(compress, test_empty) {
+    static const uint8_t expect [] = {  // Known gzip stream of no data.
+        0x1f, 0x8b, 0x08, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0xff,
+        0x03, 0x00,
+        0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00
+    };
+
+    // Empty input is a stream holding only the end of the block.
+    _test_round_trip(0, 1);
+    zassert_equal(_test_gzip_len, sizeof(expect), "Wrong stream length");
+    zassert_mem_equal(_test_gzip, expect, sizeof(expect), "Wrong stream");
+}
+
+ZTEST(compress, test_short) {
+    static const uint8_t expect_a [] = {    // Known gzip stream of "a".
+        0x1f, 0x8b, 0x08, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0xff,
+        0x4b, 0x04, 0x00,
+        0x43, 0xbe, 0xb7, 0xe8, 0x01, 0x00, 0x00, 0x00
+    };
+    static const uint8_t expect_ab [] = {   // Known gzip stream of "ab".
+        0x1f, 0x8b, 0x08, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0xff,
+        0x4b, 0x4c, 0x02, 0x00,
+        0x6d, 0x48, 0x83, 0x9e, 0x02, 0x00, 0x00, 0x00
+    };
+
+    // Input shorter than the shortest match is made up of literals only.
+    memcpy(_test_data, "ab", 2);
+
+    _test_round_trip(1, 1);
+    zassert_equal(_test_gzip_len, sizeof(expect_a), "Wrong stream length");
+    zassert_mem_equal(_test_gzip, expect_a, sizeof(expect_a), "Wrong stream");
+
+    _test_round_trip(2, 1);
+    zassert_equal(_test_gzip_len, sizeof(expect_ab), "Wrong stream length");
+    zassert_mem_equal(
+        _test_gzip, expect_ab, sizeof(expect_ab), "Wrong stream"
+    );
+}
+
+ZTEST(compress, test_run) {
+    // Runs longer than the longest match are split into several back
+    // references, and compress to a small fraction of their size.
+    memset(_test_data, 'x', 1000);
+    _test_round_trip(1000, 1000);
+    zassert_true(
+        _test_gzip_len < TEST_GZIP_HEAD + TEST_GZIP_TAIL + 16,
+        "Run not compressed"
+    );
+
+    // Runs written byte by byte come out the same.
+    _test_round_trip(1000, 1);
+    _test_round_trip(259, 7);
+    _test_round_trip(3 * 258 + 2, 258);
+}
+
+ZTEST(compress, test_window) {
+    // Incompressible input several times the window size slides the window
+    // repeatedly, and includes literals of every code length.
+    _test_random(_test_data, TEST_DATA_MAX, 1);
+    _test_round_trip(TEST_DATA_MAX, TEST_DATA_MAX);
+    _test_round_trip(TEST_DATA_MAX, 100);
+
+    // Repeated data is still found right after the window has slid, in what
+    // has become its older half.
+    for (size_t pos = TEST_REPEAT; pos < TEST_DATA_MAX; pos++) {
+        _test_data[pos] = _test_data[pos - TEST_REPEAT];
+    }
+    _test_round_trip(TEST_DATA_MAX, 333);
+    zassert_true(_test_gzip_len < TEST_DATA_MAX / 4, "Repeats not compressed");
+}
+
+ZTEST(compress, test_batch) {
+    size_t len = 0; // Length of batch.
+    int count = 0;  // Number of frames in batch.
+
+    // Batches of JSON data frames repeat their key names, and compress to
+    // less than half their size, whichever way they are written.
+    _test_data[len++] = '[';
+    while (len < TEST_DATA_MAX - 200) {
+        len += snprintf(
+            (char *)&_test_data[len], TEST_DATA_MAX - len,
+            "%s{\"seq\":%d,\"time\":%d,\"rsrp\":%d,\"rsrq\":%d,"
+            "\"cell\":{\"id\":%d,\"tac\":%d,\"band\":%d}}",
+            count > 0 ? "," : "", 1000 + count, 1700000000 + 10 * count,
+            -80 - count % 37, -10 - count % 7, 0x1234 + count % 3, 0x56, 20
+        );
+        count++;
+    }
+    _test_data[len++] = ']';
+
+    _test_round_trip(len, len);
+    zassert_true(_test_gzip_len < len / 2, "Batch not compressed");
+
+    _test_round_trip(len, 1);
+    _test_round_trip(len, 61);
+}
+
+ZTEST(compress, test_failure) {
+    compress_t comp;            // Compressed stream.
+    compress_stats_t before;    // Statistics before compression.
+    compress_stats_t after;     // Statistics after compression.
+
+    // A failing output function fails the stream, which is not added to the
+    // statistics.
+    _test_random(_test_data, TEST_DATA_MAX, 2);
+    compress_stats(&before);
+
+    _test_gzip_len = 0;
+    _test_fail_after = 1;
+    compress_init(&comp, _test_write, NULL);
+    zassert_equal(
+        compress_write(&comp, _test_data, TEST_DATA_MAX), -1,
+        "Failure not reported"
+    );
+    zassert_equal(compress_finish(&comp), -1, "Failure not reported");
+
+    compress_stats(&after);
+    zassert_equal(after.streams, before.streams, "Failed stream counted");
+    zassert_equal(after.in, before.in, "Failed stream counted");
+    zassert_equal(after.out, before.out, "Failed stream counted");
+}
+
+ZTEST_SUITE(compress, NULL, NULL, _test_before, NULL, NULL);
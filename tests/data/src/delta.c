@@ -0,0 +1,706 @@
+#include <stdbool.h>
+#include <stddef.h>
+#include <stdint.h>
+#include <string.h>
+
+#include <zephyr/kernel.h>
+#include <zephyr/sys/util.h>
+#include <zephyr/ztest.h>
+
+#include "data.h"
+#include "queue.h"
+
+/*
+ * The delta tests encode sequences of data frames in CBOR format, delta-encode
+ * them, and reconstruct them from their deltas the way a database server would,
+ * by applying every delta to the data frame before it. The reconstructed data
+ * frames must be equal to the encoded ones. Batches are also streamed from the
+ * queue after frames have been discarded from it, to check that every batch
+ * starts with a full data frame, and can be reconstructed on its own. The CBOR
+ * decoder below is only as complete as the encoders require.
+ */
+
+// CBOR major types, and additional information values, used in data frames.
+#define TEST_CBOR_UINT      0
+#define TEST_CBOR_NINT      1
+#define TEST_CBOR_BSTR      2
+#define TEST_CBOR_TSTR      3
+#define TEST_CBOR_ARRAY     4
+#define TEST_CBOR_MAP       5
+#define TEST_CBOR_INDEF     31
+#define TEST_CBOR_BREAK     0xff
+
+// Number of data frames in sequences and queued batches.
+#define TEST_SEQ_COUNT      50
+
+// Largest encoded LTE data frame, and largest streamed batch.
+#define TEST_LTE_MAX        DATA_CBOR_MAX(lte_data_frame)
+#define TEST_BATCH_MAX      4096
+
+// Encoded CBOR item.
+typedef struct {
+    const uint8_t * start;  // Start of item.
+    const uint8_t * end;    // End of item.
+    const uint8_t * body;   // Start of item contents, following its head.
+    int major;              // Major type.
+    uint64_t arg;           // Argument of head.
+    bool indef;             // Indefinite length.
+} _test_cbor_t;
+
+// Output buffer of the reconstruction.
+typedef struct {
+    uint8_t buf[TEST_BATCH_MAX];    // Output buffer.
+    size_t used;                    // Number of bytes written.
+} _test_out_t;
+
+// Output of a streamed batch. Frames may be queued while the first piece of
+// the batch is written, so that frames are discarded during streaming.
+typedef struct {
+    uint8_t buf[TEST_BATCH_MAX];    // Streamed batch.
+    size_t used;                    // Number of bytes written.
+    uint32_t push;                  // Number of frames to queue on write.
+} _test_batch_t;
+
+static bool _test_cbor_item (
+    _test_cbor_t * item, const uint8_t * buf, const uint8_t * end
+) {
+    const uint8_t * pos;    // Position within item.
+    size_t size;            // Size of argument.
+    uint64_t count;         // Number of nested items.
+    _test_cbor_t sub;       // Nested item.
+
+    // Parse head of item, and locate end of item by walking its contents.
+
+    if (buf >= end || *buf == TEST_CBOR_BREAK) {
+        return false;
+    }
+
+    item->start = buf;
+    item->major = *buf >> 5;
+    item->arg = *buf & 0x1f;
+    item->indef = item->arg == TEST_CBOR_INDEF;
+    pos = buf + 1;
+
+    if (item->indef) {
+        item->arg = 0;
+    } else if (item->arg >= 24) {
+        size = 1 << (item->arg - 24);
+        if (item->arg > 27 || (size_t)(end - pos) < size) {
+            return false;
+        }
+        item->arg = 0;
+        while (size-- > 0) {
+            item->arg = item->arg << 8 | *pos++;
+        }
+    }
+
+    item->body = pos;
+
+    if (item->major == TEST_CBOR_BSTR || item->major == TEST_CBOR_TSTR) {
+        if (item->indef || (uint64_t)(end - pos) < item->arg) {
+            return false;
+        }
+        pos += item->arg;
+    } else if (item->major == TEST_CBOR_ARRAY || item->major == TEST_CBOR_MAP) {
+        count = item->major == TEST_CBOR_MAP ? 2 * item->arg : item->arg;
+        while (item->indef ? pos < end && *pos != TEST_CBOR_BREAK
+                : count-- > 0) {
+            if (!_test_cbor_item(&sub, pos, end)) {
+                return false;
+            }
+            pos = sub.end;
+        }
+        if (item->indef) {
+            if (pos >= end) {
+                return false;
+            }
+            pos++;
+        }
+    }
+
+    item->end = pos;
+
+    return true;
+}
+
+static bool _test_cbor_next (
+    const _test_cbor_t * map, const uint8_t ** pos, _test_cbor_t * key,
+    _test_cbor_t * value
+) {
+    // Obtain next member of map, which has been walked already.
+    if (*pos >= map->end || **pos == TEST_CBOR_BREAK) {
+        return false;
+    }
+    _test_cbor_item(key, *pos, map->end);
+    _test_cbor_item(value, key->end, map->end);
+    *pos = value->end;
+    return true;
+}
+
+static bool _test_cbor_is_int (const _test_cbor_t * item) {
+    // Check whether item is an integer.
+    return item->major == TEST_CBOR_UINT || item->major == TEST_CBOR_NINT;
+}
+
+static int64_t _test_cbor_int (const _test_cbor_t * item) {
+    // Decode integer value.
+    return item->major == TEST_CBOR_NINT
+        ? -1 - (int64_t)item->arg : (int64_t)item->arg;
+}
+
+static bool _test_cbor_bytes_equal (
+    const _test_cbor_t * a, const _test_cbor_t * b
+) {
+    // Compare encoded items byte by byte.
+    return a->end - a->start == b->end - b->start
+        && memcmp(a->start, b->start, a->end - a->start) == 0;
+}
+
+static bool _test_cbor_lookup (
+    const _test_cbor_t * map, const _test_cbor_t * key, _test_cbor_t * value
+) {
+    const uint8_t * pos = map->body;    // Position within map.
+    _test_cbor_t entry;                 // Key of current member.
+
+    // Find value of given key in map.
+    while (_test_cbor_next(map, &pos, &entry, value)) {
+        if (_test_cbor_bytes_equal(&entry, key)) {
+            return true;
+        }
+    }
+    return false;
+}
+
+static bool _test_cbor_equal (const _test_cbor_t * a, const _test_cbor_t * b) {
+    const uint8_t * pos;    // Position within item.
+    const uint8_t * other;  // Position within other item.
+    _test_cbor_t key;       // Key of current member.
+    _test_cbor_t value;     // Current value.
+    _test_cbor_t match;     // Matching value in other item.
+    size_t count = 0;       // Number of members or elements.
+
+    /*
+     * Compare items by value, so that maps and arrays are equal regardless of
+     * whether they are encoded with a definite or indefinite length, and maps
+     * regardless of the order of their members.
+     */
+
+    if (_test_cbor_is_int(a) && _test_cbor_is_int(b)) {
+        return _test_cbor_int(a) == _test_cbor_int(b);
+    }
+
+    if (a->major != b->major) {
+        return false;
+    }
+
+    if (a->major == TEST_CBOR_MAP) {
+        pos = a->body;
+        while (_test_cbor_next(a, &pos, &key, &value)) {
+            if (
+                !_test_cbor_lookup(b, &key, &match)
+                || !_test_cbor_equal(&value, &match)
+            ) {
+                return false;
+            }
+            count++;
+        }
+        pos = b->body;
+        while (_test_cbor_next(b, &pos, &key, &value)) {
+            count--;
+        }
+        return count == 0;
+    }
+
+    if (a->major == TEST_CBOR_ARRAY) {
+        pos = a->body;
+        other = b->body;
+        while (pos < a->end && *pos != TEST_CBOR_BREAK) {
+            if (
+                other >= b->end || *other == TEST_CBOR_BREAK
+                || !_test_cbor_item(&value, pos, a->end)
+                || !_test_cbor_item(&match, other, b->end)
+                || !_test_cbor_equal(&value, &match)
+            ) {
+                return false;
+            }
+            pos = value.end;
+            other = match.end;
+        }
+        return other >= b->end || *other == TEST_CBOR_BREAK;
+    }
+
+    return _test_cbor_bytes_equal(a, b);
+}
+
+static bool _test_cbor_has_nint (const _test_cbor_t * item) {
+    const uint8_t * pos;    // Position within map.
+    _test_cbor_t key;       // Key of current member.
+    _test_cbor_t value;     // Current value.
+
+    // Check whether any member of a map, or of its nested maps, is negative.
+    if (item->major != TEST_CBOR_MAP) {
+        return item->major == TEST_CBOR_NINT;
+    }
+    pos = item->body;
+    while (_test_cbor_next(item, &pos, &key, &value)) {
+        if (_test_cbor_has_nint(&value)) {
+            return true;
+        }
+    }
+    return false;
+}
+
+static void _test_out_put (_test_out_t * out, const void * data, size_t len) {
+    // Append data to output buffer.
+    zassert_true(len <= sizeof(out->buf) - out->used, "Output overflow");
+    memcpy(&out->buf[out->used], data, len);
+    out->used += len;
+}
+
+static void _test_out_item (_test_out_t * out, const _test_cbor_t * item) {
+    // Append encoded item to output buffer.
+    _test_out_put(out, item->start, item->end - item->start);
+}
+
+static void _test_out_int (_test_out_t * out, int64_t value) {
+    uint8_t head[9];    // Encoded head.
+    uint64_t arg;       // Argument of head.
+
+    // Append integer to output buffer, always with an eight-byte argument, as
+    // integers are compared by value.
+    arg = value < 0 ? (uint64_t)(-1 - value) : (uint64_t)value;
+    head[0] = (value < 0 ? TEST_CBOR_NINT : TEST_CBOR_UINT) << 5 | 27;
+    for (size_t i = 0; i < 8; i++) {
+        head[8 - i] = arg >> (8 * i);
+    }
+    _test_out_put(out, head, sizeof(head));
+}
+
+static void _test_undelta (
+    _test_out_t * out, const _test_cbor_t * prev, const _test_cbor_t * delta
+) {
+    static const uint8_t start = 0xbf;          // Start of map.
+    static const uint8_t brk = TEST_CBOR_BREAK; // End of map.
+    const uint8_t * pos;                        // Position within map.
+    _test_cbor_t key;                           // Key of current member.
+    _test_cbor_t value;                         // Current value.
+    _test_cbor_t change;                        // Change given by delta.
+
+    /*
+     * Reconstruct a map from the previous map and its delta, as described in
+     * data.h. Members missing from the delta are unchanged. Members that are
+     * maps in both are reconstructed in turn, and members that are integers in
+     * both are added up. All other members of the delta replace the previous
+     * ones, and members only found in the delta are added.
+     */
+
+    _test_out_put(out, &start, 1);
+
+    pos = prev->body;
+    while (_test_cbor_next(prev, &pos, &key, &value)) {
+        _test_out_item(out, &key);
+        if (!_test_cbor_lookup(delta, &key, &change)) {
+            _test_out_item(out, &value);
+        } else if (
+            value.major == TEST_CBOR_MAP && change.major == TEST_CBOR_MAP
+        ) {
+            _test_undelta(out, &value, &change);
+        } else if (_test_cbor_is_int(&value) && _test_cbor_is_int(&change)) {
+            _test_out_int(
+                out, _test_cbor_int(&value) + _test_cbor_int(&change)
+            );
+        } else {
+            _test_out_item(out, &change);
+        }
+    }
+
+    pos = delta->body;
+    while (_test_cbor_next(delta, &pos, &key, &change)) {
+        if (!_test_cbor_lookup(prev, &key, &value)) {
+            _test_out_item(out, &key);
+            _test_out_item(out, &change);
+        }
+    }
+
+    _test_out_put(out, &brk, 1);
+}
+
+static int _test_write (void * ctx, const void * data, size_t len) {
+    _test_out_t * out = ctx;    // Output buffer.
+
+    // Append delta to output buffer.
+    _test_out_put(out, data, len);
+    return 0;
+}
+
+static void _test_round_trip (
+    _test_out_t * rec, const uint8_t * prev, size_t plen,
+    const uint8_t * cur, size_t len
+) {
+    static _test_out_t delta;   // Delta of current data frame.
+    _test_cbor_t prev_item;     // Previous data frame.
+    _test_cbor_t cur_item;      // Current data frame.
+    _test_cbor_t delta_item;    // Delta.
+    _test_cbor_t rec_item;      // Reconstructed data frame.
+    int dlen;                   // Length of delta.
+
+    /*
+     * Delta-encode the current data frame against the previous one, which may
+     * itself have been reconstructed, and reconstruct the current data frame
+     * from the delta into the given output buffer. The reconstruction must be
+     * equal to the current data frame.
+     */
+
+    delta.used = 0;
+    dlen = data_cbor_delta(prev, plen, cur, len, _test_write, &delta);
+    zassert_true(dlen >= 0, "Delta encoding failed");
+    zassert_equal(dlen, delta.used, "Delta length mismatch");
+
+    zassert_true(
+        _test_cbor_item(&prev_item, prev, prev + plen), "Malformed frame"
+    );
+    zassert_true(_test_cbor_item(&cur_item, cur, cur + len), "Malformed frame");
+    zassert_true(
+        _test_cbor_item(&delta_item, delta.buf, delta.buf + delta.used)
+        && delta_item.end == delta.buf + delta.used,
+        "Malformed delta"
+    );
+    zassert_equal(delta_item.major, TEST_CBOR_MAP, "Delta not a map");
+
+    rec->used = 0;
+    _test_undelta(rec, &prev_item, &delta_item);
+    zassert_true(
+        _test_cbor_item(&rec_item, rec->buf, rec->buf + rec->used),
+        "Malformed reconstruction"
+    );
+    zassert_true(
+        _test_cbor_equal(&rec_item, &cur_item), "Reconstruction mismatch"
+    );
+}
+
+static void _test_lte (uint32_t i, lte_data_frame_t * frame) {
+    static const char * const modes[] = {   // Network modes.
+        "LTE-M", "NB-IoT", NULL
+    };
+
+    // Fill LTE data frame with values that change from one data frame to the
+    // next in both directions, in nested maps, and between valid and invalid.
+    memset(frame, 0, sizeof(*frame));
+    frame->mode.valid = i % 5 != 0;
+    frame->mode.mode = modes[i / 7 % ARRAY_SIZE(modes)];
+    frame->cell.valid = true;
+    frame->cell.id = (i * 7919) % 268435456;
+    frame->cell.tac = i % 3 == 0 ? 65535 : i % 3;
+    frame->psm.valid = i % 2;
+    frame->edrx.valid = i / 4 % 2;
+    frame->edrx.mode = modes[i % ARRAY_SIZE(modes)];
+#if defined(CONFIG_DATA_LAYOUT_COMPACT)
+    frame->psm.tau = i % 4 == 0 ? 35712000 : i * 60;
+    frame->psm.at = 11160 - i;
+    frame->edrx.edrx = (i * 1280) % 10485761;
+    frame->edrx.ptw = i % 2 ? 40960 : 1280;
+#else
+    frame->psm.tau.day = i % 4 == 0 ? 413 : 0;
+    frame->psm.tau.hour = i % 24;
+    frame->psm.tau.min = 59 - i % 60;
+    frame->psm.tau.sec = i % 2 ? 59 : 0;
+    frame->psm.at.hour = 3 - i % 4;
+    frame->psm.at.min = i % 60;
+    frame->psm.at.sec = 0;
+    frame->edrx.edrx.hour = 0;
+    frame->edrx.edrx.min = i % 3;
+    frame->edrx.edrx.sec = 59 - i % 60;
+    frame->edrx.edrx.msec = i * 37 % 1000;
+    frame->edrx.ptw.sec = i % 2 ? 40 : 1;
+    frame->edrx.ptw.msec = i % 2 ? 960 : 280;
+#endif
+    frame->seq = i;
+}
+
+static int _test_lte_cbor (uint32_t i, uint8_t * buf) {
+    lte_data_frame_t frame; // LTE data frame.
+    int len;                // Encoded length.
+
+    // Encode LTE data frame of given index.
+    _test_lte(i, &frame);
+    len = data_lte_data_frame_to_cbor(&frame, buf, TEST_LTE_MAX);
+    zassert_true(len > 0, "Encoding failed");
+    return len;
+}
+
+ZTEST(data, test_delta_nested) {
+    static uint8_t prev[TEST_LTE_MAX];  // Previous data frame.
+    static uint8_t cur[TEST_LTE_MAX];   // Current data frame.
+    static _test_out_t rec;             // Reconstructed data frame.
+    lte_data_frame_t frame;             // LTE data frame.
+    int plen;                           // Length of previous data frame.
+    int len;                            // Length of current data frame.
+    int dlen;                           // Length of delta.
+
+    // Changes deep within nested maps are reconstructed, and unchanged maps are
+    // left out of the delta.
+    _test_lte(1, &frame);
+    plen = data_lte_data_frame_to_cbor(&frame, prev, sizeof(prev));
+    zassert_true(plen > 0, "Encoding failed");
+
+    frame.cell.tac++;
+    frame.edrx.mode = "NB-IoT";
+#if defined(CONFIG_DATA_LAYOUT_COMPACT)
+    frame.psm.at++;
+#else
+    frame.psm.at.sec++;
+    frame.edrx.ptw.msec++;
+#endif
+    len = data_lte_data_frame_to_cbor(&frame, cur, sizeof(cur));
+    zassert_true(len > 0, "Encoding failed");
+
+    _test_round_trip(&rec, prev, plen, cur, len);
+
+    dlen = data_cbor_delta(prev, plen, cur, len, NULL, NULL);
+    zassert_true(dlen < len / 2, "Delta of few changes not small");
+}
+
+ZTEST(data, test_delta_negative) {
+    static uint8_t prev[DATA_CBOR_MAX(gnss_data_frame)];    // Previous frame.
+    static uint8_t cur[DATA_CBOR_MAX(gnss_data_frame)];     // Current frame.
+    static _test_out_t rec;             // Reconstructed data frame.
+    static _test_out_t delta;           // Delta.
+    gnss_data_frame_t frame = {0};      // GNSS data frame.
+    _test_cbor_t item;                  // Decoded delta.
+    int plen;                           // Length of previous data frame.
+    int len;                            // Length of current data frame.
+
+    // Members that decrease are given as negative differences, including ones
+    // that cross zero or span the whole range of their values.
+    frame.loc.valid = true;
+#if defined(CONFIG_DATA_LAYOUT_COMPACT)
+    frame.loc.lat = 90000000;
+    frame.loc.lon = 1;
+#else
+    frame.loc.lat = (gnss_data_frame_loc_lat_t){"N", 90, 59, 59, 999};
+    frame.loc.lon = (gnss_data_frame_loc_lon_t){"E", 1, 0, 0, 1};
+#endif
+    frame.date = (gnss_data_frame_date_t){true, 65535, 12, 31};
+    frame.time = (gnss_data_frame_time_t){true, 23, 59, 60, 999};
+    frame.seq = INT32_MAX;
+    plen = data_gnss_data_frame_to_cbor(&frame, prev, sizeof(prev));
+    zassert_true(plen > 0, "Encoding failed");
+
+#if defined(CONFIG_DATA_LAYOUT_COMPACT)
+    frame.loc.lat = -90000000;
+    frame.loc.lon = -1;
+#else
+    frame.loc.lat = (gnss_data_frame_loc_lat_t){"S", 0, 0, 0, 0};
+    frame.loc.lon = (gnss_data_frame_loc_lon_t){"W", 0, 0, 0, 0};
+#endif
+    frame.date = (gnss_data_frame_date_t){true, 0, 1, 1};
+    frame.time = (gnss_data_frame_time_t){true, 0, 0, 0, 0};
+    frame.seq = 0;
+    len = data_gnss_data_frame_to_cbor(&frame, cur, sizeof(cur));
+    zassert_true(len > 0, "Encoding failed");
+
+    _test_round_trip(&rec, prev, plen, cur, len);
+
+    delta.used = 0;
+    zassert_true(
+        data_cbor_delta(prev, plen, cur, len, _test_write, &delta) > 0,
+        "Delta encoding failed"
+    );
+    _test_cbor_item(&item, delta.buf, delta.buf + delta.used);
+    zassert_true(_test_cbor_has_nint(&item), "No negative difference");
+
+    // Increasing the members again restores the previous data frame.
+    _test_round_trip(&rec, cur, len, prev, plen);
+}
+
+ZTEST(data, test_delta_sequence) {
+    static uint8_t frames[2][TEST_LTE_MAX]; // Encoded data frames.
+    static _test_out_t rec[2];              // Reconstructed data frames.
+    int len[2];                             // Lengths of data frames.
+    size_t cur;                             // Index of current data frame.
+
+    // A sequence of data frames is reconstructed by applying every delta to
+    // the reconstruction of the data frame before it, as a server would, so
+    // that errors would accumulate.
+    len[0] = _test_lte_cbor(0, frames[0]);
+    memcpy(rec[0].buf, frames[0], len[0]);
+    rec[0].used = len[0];
+
+    for (uint32_t i = 1; i < TEST_SEQ_COUNT; i++) {
+        cur = i % 2;
+        len[cur] = _test_lte_cbor(i, frames[cur]);
+        _test_round_trip(
+            &rec[cur], rec[1 - cur].buf, rec[1 - cur].used,
+            frames[cur], len[cur]
+        );
+    }
+}
+
+static int _test_batch_write (void * ctx, const void * data, size_t len) {
+    _test_batch_t * batch = ctx;        // Streamed batch.
+    uint8_t frame[TEST_LTE_MAX];        // Encoded data frame.
+    uint32_t seq;                       // Sequence number of queued frame.
+    int flen;                           // Length of data frame.
+
+    // Queue further frames on the first write, if requested, as another thread
+    // could while a batch is being uploaded.
+    while (batch->push > 0) {
+        batch->push--;
+        seq = queue_seq();
+        flen = _test_lte_cbor(seq, frame);
+        zassert_ok(
+            queue_push(DATA_TYPE_LTE, seq, (char *)frame, flen), "Push failed"
+        );
+    }
+
+    zassert_true(len <= sizeof(batch->buf) - batch->used, "Batch overflow");
+    memcpy(&batch->buf[batch->used], data, len);
+    batch->used += len;
+    return 0;
+}
+
+static void _test_batch_check (
+    const _test_batch_t * batch, const queue_batch_t * desc
+) {
+    static uint8_t frame[TEST_LTE_MAX];     // Expected data frame.
+    static _test_out_t rec[2];              // Reconstructed data frames.
+    _test_out_t * prev;                     // Previous reconstruction.
+    _test_cbor_t array;                     // Streamed batch.
+    _test_cbor_t item;                      // Element of batch.
+    _test_cbor_t expect;                    // Expected data frame.
+    _test_cbor_t last;                      // Previous data frame.
+    _test_cbor_t result;                    // Reconstructed data frame.
+    const uint8_t * pos;                    // Position within batch.
+    size_t n = 0;                           // Number of elements.
+    int len;                                // Length of data frame.
+
+    /*
+     * Check that the batch is an array whose first element is the full data
+     * frame with the first sequence number of the batch, and whose following
+     * elements reconstruct the data frames with the following sequence
+     * numbers, with nothing needed from before the batch.
+     */
+
+    zassert_true(
+        _test_cbor_item(&array, batch->buf, batch->buf + batch->used)
+        && array.end == batch->buf + batch->used
+        && array.major == TEST_CBOR_ARRAY,
+        "Malformed batch"
+    );
+
+    for (pos = array.body; pos < array.end && *pos != TEST_CBOR_BREAK; n++) {
+        zassert_true(_test_cbor_item(&item, pos, array.end), "Bad element");
+        pos = item.end;
+
+        len = _test_lte_cbor(desc->first + n, frame);
+        _test_cbor_item(&expect, frame, frame + len);
+
+        rec[n % 2].used = 0;
+        if (n == 0) {
+            // First element is given in full.
+            zassert_true(
+                _test_cbor_equal(&item, &expect), "Batch does not start full"
+            );
+            _test_out_item(&rec[0], &item);
+            continue;
+        }
+
+        // Following elements are deltas from the element before them.
+        prev = &rec[(n - 1) % 2];
+        _test_cbor_item(&last, prev->buf, prev->buf + prev->used);
+        _test_undelta(&rec[n % 2], &last, &item);
+        _test_cbor_item(
+            &result, rec[n % 2].buf, rec[n % 2].buf + rec[n % 2].used
+        );
+        zassert_true(
+            _test_cbor_equal(&result, &expect), "Reconstruction mismatch"
+        );
+    }
+
+    zassert_equal(n, desc->count, "Wrong number of frames in batch");
+    zassert_equal(
+        desc->last, desc->first + n - 1, "Wrong sequence number range"
+    );
+}
+
+ZTEST(data, test_delta_batch) {
+    static char frame[2 * TEST_LTE_MAX];    // Frame buffer of queue.
+    static _test_batch_t batch;             // Streamed batch.
+    uint8_t buf[TEST_LTE_MAX];              // Encoded data frame.
+    queue_batch_t desc;                     // Description of batch.
+    queue_batch_t retry;                    // Description of retried batch.
+    uint32_t seq;                           // Sequence number.
+    int len;                                // Length of data frame.
+
+    // Queue more frames than fit, so that the oldest ones are discarded. The
+    // batch starts in full at the oldest remaining frame.
+    zassert_ok(queue_init(), "Initialization failed");
+    for (uint32_t i = 0; i < TEST_SEQ_COUNT; i++) {
+        seq = queue_seq();
+        len = _test_lte_cbor(seq, buf);
+        zassert_ok(
+            queue_push(DATA_TYPE_LTE, seq, (char *)buf, len), "Push failed"
+        );
+    }
+
+    batch.used = 0;
+    batch.push = 0;
+    zassert_ok(
+        queue_stream(
+            DATA_TYPE_LTE, frame, sizeof(frame), TEST_BATCH_MAX,
+            _test_batch_write, &batch, &desc
+        ),
+        "Streaming failed"
+    );
+    zassert_true(desc.first > 0, "No frames discarded");
+    _test_batch_check(&batch, &desc);
+
+    // Frames discarded while the batch is streamed fail the batch. Its retry
+    // starts in full at the new oldest frame, rather than as a delta from a
+    // frame that is gone.
+    batch.used = 0;
+    batch.push = TEST_SEQ_COUNT / 2;
+    zassert_equal(
+        queue_stream(
+            DATA_TYPE_LTE, frame, sizeof(frame), TEST_BATCH_MAX,
+            _test_batch_write, &batch, &retry
+        ),
+        -1, "Streaming succeeded despite discarded frames"
+    );
+
+    batch.used = 0;
+    zassert_ok(
+        queue_stream(
+            DATA_TYPE_LTE, frame, sizeof(frame), TEST_BATCH_MAX,
+            _test_batch_write, &batch, &retry
+        ),
+        "Streaming failed"
+    );
+    zassert_true(retry.first > desc.first, "Discarded frames streamed");
+    _test_batch_check(&batch, &retry);
+
+    // Once released, the next batch starts in full again.
+    queue_release(DATA_TYPE_LTE, &retry);
+    zassert_equal(queue_count(DATA_TYPE_LTE), 0, "Frames left");
+
+    for (uint32_t i = 0; i < 3; i++) {
+        seq = queue_seq();
+        len = _test_lte_cbor(seq, buf);
+        zassert_ok(
+            queue_push(DATA_TYPE_LTE, seq, (char *)buf, len), "Push failed"
+        );
+    }
+
+    batch.used = 0;
+    zassert_ok(
+        queue_stream(
+            DATA_TYPE_LTE, frame, sizeof(frame), TEST_BATCH_MAX,
+            _test_batch_write, &batch, &desc
+        ),
+        "Streaming failed"
+    );
+    zassert_equal(desc.first, retry.last + 1, "Wrong first frame");
+    _test_batch_check(&batch, &desc);
+
+    queue_release(DATA_TYPE_LTE, &desc);
+}
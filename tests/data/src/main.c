@@ -0,0 +1,496 @@
+#include <stdbool.h>
+#include <stddef.h>
+#include <stdint.h>
+#include <string.h>
+
+#include <zephyr/kernel.h>
+#include <zephyr/sys/util.h>
+#include <zephyr/ztest.h>
+
+#include "data.h"
+
+/*
+ * The test suite checks and benchmarks the encoders. Reference data frames
+ * holding edge values are encoded and compared with their expected JSON
+ * encoding. Random data frames within the bounds declared in the schema are
+ * encoded in every supported format and checked against the worst-case encoded
+ * sizes. The reference data frames are encoded repeatedly to measure the
+ * encoded size and processor time per data frame. Logging of the data module
+ * is limited to warnings, so that the results are not skewed by logging.
+ */
+
+// Number of random data frames checked per type, and seed of the generator.
+#define TEST_FUZZ_COUNT     1000
+#define TEST_FUZZ_SEED      1
+
+// Number of encodings per type and format when benchmarking.
+#define TEST_BENCH_COUNT    100
+
+// State of the random data frame generator. Strings are allocated from a pool
+// that is emptied for every data frame.
+typedef struct {
+    uint32_t state;     // State of pseudo-random number generator.
+    size_t used;        // Number of bytes used in string pool.
+    char pool[1024];    // String pool.
+} _test_fuzz_t;
+
+static uint32_t _test_fuzz_rand (_test_fuzz_t * fuzz) {
+    // Advance xorshift generator, which must not be seeded with zero.
+    fuzz->state ^= fuzz->state << 13;
+    fuzz->state ^= fuzz->state >> 17;
+    fuzz->state ^= fuzz->state << 5;
+    return fuzz->state;
+}
+
+static int _test_fuzz_int (_test_fuzz_t * fuzz, int min, int max) {
+    uint64_t span = (int64_t)max - min + 1;   // Number of possible values.
+
+    // Draw integer within range, favoring both ends of it, as these are where
+    // encoders are most likely to go wrong.
+    switch (_test_fuzz_rand(fuzz) % 4) {
+        case 0:
+            return min;
+        case 1:
+            return max;
+        default:
+            return (int)(min + (int64_t)(_test_fuzz_rand(fuzz) % span));
+    }
+}
+
+static const char * _test_fuzz_str (_test_fuzz_t * fuzz, size_t max) {
+    // Characters drawn from, including all that must be escaped in JSON.
+    static const char chars[] = "azAZ09 -_.:/\"\\\b\f\n\r\t";
+    char * str;     // Drawn string.
+    size_t len;     // Length of drawn string.
+
+    // Draw missing string now and then, as these are encoded as empty.
+    if (_test_fuzz_rand(fuzz) % 8 == 0) {
+        return NULL;
+    }
+
+    // Draw string up to given length, favoring the longest one.
+    len = _test_fuzz_rand(fuzz) % 2 ? max : _test_fuzz_rand(fuzz) % (max + 1);
+    if (len + 1 > sizeof(fuzz->pool) - fuzz->used) {
+        return "";
+    }
+
+    str = &fuzz->pool[fuzz->used];
+    for (size_t i = 0; i < len; i++) {
+        str[i] = chars[_test_fuzz_rand(fuzz) % (sizeof(chars) - 1)];
+    }
+    str[len] = '\0';
+    fuzz->used += len + 1;
+
+    return str;
+}
+
+// Random data frame generator of a structure, named after the structure type.
+#define TEST_FUZZ_DEFINE(type, schema)                                         \
+    static void _test_fuzz_##type (_test_fuzz_t * fuzz, type##_t * value) {    \
+        schema(TEST_FUZZ_MEMBER, value)                                        \
+    }
+
+// Random value of a structure member.
+#define TEST_FUZZ_MEMBER(P, KIND, member, name, ...)                           \
+    TEST_FUZZ_##KIND(P, member, __VA_ARGS__);
+
+// Random value of a structure member of each kind.
+#define TEST_FUZZ_BOOL(P, member, ...)                                         \
+    (P)->member = _test_fuzz_rand(fuzz) % 2
+#define TEST_FUZZ_INT(P, member, min, max)                                     \
+    (P)->member = _test_fuzz_int(fuzz, min, max)
+#define TEST_FUZZ_STR(P, member, max)                                          \
+    (P)->member = _test_fuzz_str(fuzz, max)
+#define TEST_FUZZ_OBJ(P, member, sub)                                          \
+    _test_fuzz_##sub(fuzz, &(P)->member)
+#define TEST_FUZZ_ARRAY(P, member, sub, max, count)                            \
+    (P)->count = _test_fuzz_rand(fuzz) % ((max) + 1);                          \
+    for (size_t i = 0; i < (P)->count; i++) {                                  \
+        _test_fuzz_##sub(fuzz, &(P)->member[i]);                               \
+    }
+
+DATA_SCHEMA_ALL(TEST_FUZZ_DEFINE)
+
+// Encoder of a data frame in a given format, returning the encoded length on
+// success, or -1 on failure.
+typedef int (* _test_encode_t) (void * frame, uint8_t * buf, size_t len);
+
+// Data frame type, as checked and benchmarked by the test suite.
+typedef struct {
+    const char * name;              // Type name.
+    void * ref;                     // Reference data frame.
+    const char * ref_json;          // Expected JSON encoding of reference.
+    void (* fuzz) (_test_fuzz_t * fuzz, void * frame);  // Random generator.
+    _test_encode_t json;            // JSON encoder.
+    _test_encode_t cbor;            // CBOR encoder, or NULL.
+    size_t json_max;                // Worst-case JSON encoded size.
+    size_t cbor_max;                // Worst-case CBOR encoded size.
+} _test_type_t;
+
+#if defined(CONFIG_DATA_FORMAT_CBOR)
+// CBOR encoder of a data frame type, as called by the test suite.
+#define TEST_CBOR_DEFINE(type)                                                 \
+    static int _test_cbor_##type (void * frame, uint8_t * buf, size_t len) {   \
+        return data_##type##_to_cbor(frame, buf, len);                         \
+    }
+#define TEST_CBOR(type) _test_cbor_##type
+#else
+#define TEST_CBOR_DEFINE(type)
+#define TEST_CBOR(type) NULL
+#endif
+
+// Wrappers of a data frame type, as called by the test suite.
+#define TEST_TYPE_DEFINE(type)                                                 \
+    static void _test_fuzz_any_##type (_test_fuzz_t * fuzz, void * frame) {    \
+        _test_fuzz_##type(fuzz, frame);                                        \
+    }                                                                          \
+    static int _test_json_##type (void * frame, uint8_t * buf, size_t len) {   \
+        return data_##type##_to_json(frame, (char *)buf, len);                 \
+    }                                                                          \
+    TEST_CBOR_DEFINE(type)
+
+// Entry of a data frame type in the table of the test suite.
+#define TEST_TYPE(label, type, frame)                                          \
+    {                                                                          \
+        .name = label,                                                         \
+        .ref = &frame,                                                         \
+        .ref_json = frame##_json,                                              \
+        .fuzz = _test_fuzz_any_##type,                                         \
+        .json = _test_json_##type,                                             \
+        .cbor = TEST_CBOR(type),                                               \
+        .json_max = DATA_JSON_MAX(type),                                       \
+        .cbor_max = DATA_CBOR_MAX(type)                                        \
+    }
+
+TEST_TYPE_DEFINE(dummy_data_frame)
+TEST_TYPE_DEFINE(lte_data_frame)
+TEST_TYPE_DEFINE(gnss_data_frame)
+TEST_TYPE_DEFINE(perf_data_frame)
+
+// Reference data frames, holding edge values such as empty, missing and
+// escaped strings, invalid parts, negative coordinates, and the largest values
+// of every unit, along with their expected JSON encoding.
+
+static dummy_data_frame_t _test_ref_dummy = {
+    .field1 = "",
+    .field2 = NULL,
+    .field3 = "Quote \" backslash \\ tab \t",
+    .field4 = "Line\nfeed\r",
+    .seq = 0
+};
+static const char _test_ref_dummy_json[] =
+    "{\"field1\":\"\",\"field2\":\"\","
+    "\"field3\":\"Quote \\\" backslash \\\\ tab \\t\","
+    "\"field4\":\"Line\\nfeed\\r\",\"seq\":0}";
+
+static lte_data_frame_t _test_ref_lte = {
+    .mode = {.valid = false, .mode = ""},
+    .cell = {.valid = true, .id = 268435455, .tac = 0},
+#if defined(CONFIG_DATA_LAYOUT_COMPACT)
+    .psm = {.valid = true, .tau = 35712000, .at = 0},
+    .edrx = {.valid = false, .mode = "NB-IoT", .edrx = 59999, .ptw = 40960},
+#else
+    .psm = {
+        .valid = true,
+        .tau = {.day = 413, .hour = 23, .min = 59, .sec = 59},
+        .at = {.hour = 0, .min = 0, .sec = 0}
+    },
+    .edrx = {
+        .valid = false,
+        .mode = "NB-IoT",
+        .edrx = {.hour = 0, .min = 0, .sec = 59, .msec = 999},
+        .ptw = {.sec = 40, .msec = 960}
+    },
+#endif
+    .seq = INT32_MAX
+};
+#if defined(CONFIG_DATA_LAYOUT_COMPACT)
+static const char _test_ref_lte_json[] =
+    "{\"mode\":{\"valid\":false,\"mode\":\"\"},"
+    "\"cell\":{\"valid\":true,\"id\":268435455,\"tac\":0},"
+    "\"psm\":{\"valid\":true,\"tau_s\":35712000,\"at_s\":0},"
+    "\"edrx\":{\"valid\":false,\"mode\":\"NB-IoT\","
+    "\"edrx_ms\":59999,\"ptw_ms\":40960},\"seq\":2147483647}";
+#else
+static const char _test_ref_lte_json[] =
+    "{\"mode\":{\"valid\":false,\"mode\":\"\"},"
+    "\"cell\":{\"valid\":true,\"id\":268435455,\"tac\":0},"
+    "\"psm\":{\"valid\":true,"
+    "\"tau\":{\"days\":413,\"hours\":23,\"minutes\":59,\"seconds\":59},"
+    "\"at\":{\"hours\":0,\"minutes\":0,\"seconds\":0}},"
+    "\"edrx\":{\"valid\":false,\"mode\":\"NB-IoT\","
+    "\"edrx\":{\"hours\":0,\"minutes\":0,\"seconds\":59,"
+    "\"milliseconds\":999},"
+    "\"ptw\":{\"seconds\":40,\"milliseconds\":960}},"
+    "\"seq\":2147483647}";
+#endif
+
+static gnss_data_frame_t _test_ref_gnss = {
+#if defined(CONFIG_DATA_LAYOUT_COMPACT)
+    .loc = {.valid = true, .lat = -1, .lon = -180000000},
+#else
+    .loc = {
+        .valid = true,
+        .lat = {.dir = "S", .deg = 0, .min = 59, .sec = 59, .msec = 999},
+        .lon = {.dir = "W", .deg = 180, .min = 0, .sec = 0, .msec = 0}
+    },
+#endif
+    .date = {.valid = false, .year = 0, .mon = 0, .day = 0},
+    .time = {.valid = true, .hour = 23, .min = 59, .sec = 59, .msec = 999},
+    .seq = 1
+};
+#if defined(CONFIG_DATA_LAYOUT_COMPACT)
+static const char _test_ref_gnss_json[] =
+    "{\"location\":{\"valid\":true,"
+    "\"latitude_udeg\":-1,\"longitude_udeg\":-180000000},"
+    "\"date\":{\"valid\":false,\"year\":0,\"month\":0,\"day\":0},"
+    "\"time\":{\"valid\":true,\"hour\":23,\"minute\":59,\"second\":59,"
+    "\"millisecond\":999},\"seq\":1}";
+#else
+static const char _test_ref_gnss_json[] =
+    "{\"location\":{\"valid\":true,"
+    "\"latitude\":{\"direction\":\"S\",\"degrees\":0,\"minutes\":59,"
+    "\"seconds\":59,\"milliseconds\":999},"
+    "\"longitude\":{\"direction\":\"W\",\"degrees\":180,\"minutes\":0,"
+    "\"seconds\":0,\"milliseconds\":0}},"
+    "\"date\":{\"valid\":false,\"year\":0,\"month\":0,\"day\":0},"
+    "\"time\":{\"valid\":true,\"hour\":23,\"minute\":59,\"second\":59,"
+    "\"millisecond\":999},\"seq\":1}";
+#endif
+
+static perf_data_frame_t _test_ref_perf = {
+    .phases = {
+        {
+            .name = "encode",
+            .count = 1, .min = 0, .max = 0, .p50 = 0, .p95 = 0
+        },
+        {
+            .name = "session",
+            .count = INT32_MAX, .min = INT32_MAX, .max = INT32_MAX,
+            .p50 = INT32_MAX, .p95 = INT32_MAX
+        }
+    },
+    .phase_count = 2,
+    .seq = 0
+};
+static const char _test_ref_perf_json[] =
+    "{\"phases\":["
+    "{\"phase\":\"encode\",\"count\":1,\"min\":0,\"max\":0,"
+    "\"p50\":0,\"p95\":0},"
+    "{\"phase\":\"session\",\"count\":2147483647,\"min\":2147483647,"
+    "\"max\":2147483647,\"p50\":2147483647,\"p95\":2147483647}],"
+    "\"seq\":0}";
+
+// Data frame types checked and benchmarked by the test suite.
+static const _test_type_t _test_types [] = {
+    TEST_TYPE("dummy", dummy_data_frame, _test_ref_dummy),
+    TEST_TYPE("lte", lte_data_frame, _test_ref_lte),
+    TEST_TYPE("gnss", gnss_data_frame, _test_ref_gnss),
+    TEST_TYPE("perf", perf_data_frame, _test_ref_perf)
+};
+
+// Largest worst-case encoded size of any data frame type in any format. JSON
+// is always the larger format, as CBOR never needs more bytes per value.
+#define TEST_BUF_SIZE                                                          \
+    MAX(                                                                       \
+        MAX(DATA_JSON_MAX(dummy_data_frame), DATA_JSON_MAX(lte_data_frame)),   \
+        MAX(DATA_JSON_MAX(gnss_data_frame), DATA_JSON_MAX(perf_data_frame))    \
+    )
+
+// Buffers for encoded data frames, and for the current and previous random
+// data frames. These are static, as they are too large for the test stack.
+static uint8_t _test_buf[2][TEST_BUF_SIZE];
+static union {
+    dummy_data_frame_t dummy;
+    lte_data_frame_t lte;
+    gnss_data_frame_t gnss;
+    perf_data_frame_t perf;
+} _test_frame[2];
+static _test_fuzz_t _test_fuzz[2];
+
+static int _test_count (void * ctx, const void * data, size_t len) {
+    // Count bytes written.
+    *(size_t *)ctx += len;
+    return 0;
+}
+
+static void _test_fuzz_frame (const _test_type_t * type, size_t iter) {
+    size_t cur = iter % 2;  // Index of current data frame.
+    size_t prev = 1 - cur;  // Index of previous data frame.
+    int len;                // Encoded length.
+    int prev_len;           // Encoded length of previous data frame.
+    int delta;              // Length of delta.
+    size_t written = 0;     // Number of bytes of delta written.
+
+    /*
+     * Generate a random data frame, keeping the previous one. Encode it in
+     * every supported format, and check that this succeeds within the
+     * worst-case encoded size. With CBOR, also check that the delta from the
+     * data frame to itself is empty, and that the delta from the previous data
+     * frame has the same length whether or not it is written out.
+     */
+
+    _test_fuzz[cur].state = _test_fuzz[prev].state;
+    _test_fuzz[cur].used = 0;
+    type->fuzz(&_test_fuzz[cur], &_test_frame[cur]);
+
+    len = type->json(&_test_frame[cur], _test_buf[cur], type->json_max);
+    zassert_true(
+        len >= 0, "%s #%u: JSON encoding exceeds %u bytes",
+        type->name, iter, type->json_max
+    );
+
+    if (type->cbor == NULL) {
+        return;
+    }
+
+    len = type->cbor(&_test_frame[cur], _test_buf[cur], type->cbor_max);
+    zassert_true(
+        len >= 0, "%s #%u: CBOR encoding exceeds %u bytes",
+        type->name, iter, type->cbor_max
+    );
+
+    delta = data_cbor_delta(
+        _test_buf[cur], len, _test_buf[cur], len, NULL, NULL
+    );
+    zassert_equal(
+        delta, 2, "%s #%u: delta to itself not empty", type->name, iter
+    );
+
+    if (iter == 0) {
+        return;
+    }
+
+    prev_len = type->cbor(&_test_frame[prev], _test_buf[prev], type->cbor_max);
+    delta = data_cbor_delta(
+        _test_buf[prev], prev_len, _test_buf[cur], len, NULL, NULL
+    );
+    zassert_true(delta >= 0, "%s #%u: delta failed", type->name, iter);
+    zassert_equal(
+        data_cbor_delta(
+            _test_buf[prev], prev_len, _test_buf[cur], len,
+            _test_count, &written
+        ),
+        delta, "%s #%u: delta inconsistent", type->name, iter
+    );
+    zassert_equal(
+        written, delta, "%s #%u: delta inconsistent", type->name, iter
+    );
+}
+
+static void _test_bench_print (
+    const char * name, const char * format, int len, uint64_t cycles,
+    size_t count
+) {
+    // Print encoded size and processor time per data frame.
+    TC_PRINT(
+        "%-6s %-6s %8d %10llu %10llu\n",
+        name, format, len, cycles / count,
+        k_cyc_to_ns_floor64(cycles) / count
+    );
+}
+
+ZTEST(data, test_reference) {
+    const _test_type_t * type;  // Data frame type.
+    int len;                    // Encoded length.
+
+    // Encode every reference data frame in JSON format, and compare it with
+    // its expected encoding.
+
+    for (size_t i = 0; i < ARRAY_SIZE(_test_types); i++) {
+        type = &_test_types[i];
+
+        len = type->json(type->ref, _test_buf[0], TEST_BUF_SIZE);
+
+        zassert_true(len >= 0, "%s: encoding failed", type->name);
+        zassert_equal(
+            len, strlen(type->ref_json), "%s: length mismatch, obtained %.*s",
+            type->name, len, _test_buf[0]
+        );
+        zassert_mem_equal(
+            _test_buf[0], type->ref_json, len, "%s: mismatch, obtained %.*s",
+            type->name, len, _test_buf[0]
+        );
+    }
+}
+
+ZTEST(data, test_fuzz) {
+    const _test_type_t * type;  // Data frame type.
+
+    // Check a fixed number of random data frames of every type, drawn from a
+    // fixed seed, so that failures can be reproduced.
+
+    for (size_t i = 0; i < ARRAY_SIZE(_test_types); i++) {
+        type = &_test_types[i];
+        _test_fuzz[1].state = TEST_FUZZ_SEED;
+
+        for (size_t iter = 0; iter < TEST_FUZZ_COUNT; iter++) {
+            _test_fuzz_frame(type, iter);
+        }
+    }
+}
+
+ZTEST(data, test_bench) {
+    const _test_type_t * type;  // Data frame type.
+    uint32_t start;             // Cycle count at start.
+    uint64_t cycles;            // Cycles spent encoding.
+    int len = 0;                // Encoded length.
+    int ref_len;                // Encoded length of reference frame.
+    int prev_len;               // Encoded length of random frame.
+
+    /*
+     * Encode every reference data frame a fixed number of times in every
+     * supported format, and print the encoded size and the average number of
+     * cycles and nanoseconds per encoding. With CBOR, also delta-encode the
+     * reference data frame against a random data frame of the same type.
+     */
+
+    TC_PRINT(
+        "%-6s %-6s %8s %10s %10s\n", "type", "format", "bytes", "cycles", "ns"
+    );
+
+    for (size_t i = 0; i < ARRAY_SIZE(_test_types); i++) {
+        type = &_test_types[i];
+
+        cycles = 0;
+        for (size_t n = 0; n < TEST_BENCH_COUNT; n++) {
+            start = k_cycle_get_32();
+            len = type->json(type->ref, _test_buf[0], type->json_max);
+            cycles += k_cycle_get_32() - start;
+        }
+        zassert_true(len >= 0, "%s: JSON encoding failed", type->name);
+        _test_bench_print(type->name, "json", len, cycles, TEST_BENCH_COUNT);
+
+        if (type->cbor == NULL) {
+            continue;
+        }
+
+        cycles = 0;
+        for (size_t n = 0; n < TEST_BENCH_COUNT; n++) {
+            start = k_cycle_get_32();
+            len = type->cbor(type->ref, _test_buf[0], type->cbor_max);
+            cycles += k_cycle_get_32() - start;
+        }
+        zassert_true(len >= 0, "%s: CBOR encoding failed", type->name);
+        _test_bench_print(type->name, "cbor", len, cycles, TEST_BENCH_COUNT);
+
+        ref_len = len;
+        _test_fuzz[0].state = TEST_FUZZ_SEED;
+        _test_fuzz[0].used = 0;
+        type->fuzz(&_test_fuzz[0], &_test_frame[0]);
+        prev_len = type->cbor(&_test_frame[0], _test_buf[1], type->cbor_max);
+
+        cycles = 0;
+        for (size_t n = 0; n < TEST_BENCH_COUNT; n++) {
+            start = k_cycle_get_32();
+            len = data_cbor_delta(
+                _test_buf[1], prev_len, _test_buf[0], ref_len, NULL, NULL
+            );
+            cycles += k_cycle_get_32() - start;
+        }
+        zassert_true(len >= 0, "%s: delta encoding failed", type->name);
+        _test_bench_print(type->name, "delta", len, cycles, TEST_BENCH_COUNT);
+    }
+}
+
+ZTEST_SUITE(data, NULL, NULL, NULL, NULL, NULL);
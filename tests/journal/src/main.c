@@ -0,0 +1,272 @@
+#include <stdbool.h>
+#include <stddef.h>
+#include <stdint.h>
+#include <string.h>
+
+#include <zephyr/kernel.h>
+#include <zephyr/device.h>
+#include <zephyr/devicetree.h>
+#include <zephyr/drivers/flash.h>
+#include <zephyr/ztest.h>
+
+#include "data.h"
+#include "journal.h"
+
+// Journal geometry.
+#define TEST_SECTOR_SIZE    CONFIG_JOURNAL_SECTOR_SIZE
+#define TEST_SECTOR_COUNT   (CONFIG_JOURNAL_SIZE / CONFIG_JOURNAL_SECTOR_SIZE)
+
+// Length of frames that fill a sector four at a time, along with the sector
+// header and their frame headers.
+#define TEST_FRAME_LEN      1000
+#define TEST_FRAMES_PER_SECTOR  4
+
+// Number of frames that fill the whole journal.
+#define TEST_FRAMES_PER_JOURNAL (TEST_SECTOR_COUNT * TEST_FRAMES_PER_SECTOR)
+
+// Flash device holding the journal.
+static const struct device * const _test_dev =
+    DEVICE_DT_GET(DT_CHOSEN(logger_journal));
+
+static void _test_frame (uint32_t seq, uint8_t * frame, size_t len) {
+    // Fill frame with contents derived from its sequence number.
+    for (size_t i = 0; i < len; i++) {
+        frame[i] = (uint8_t)(seq * 31 + i);
+    }
+}
+
+static void _test_append (data_type_t type, uint32_t seq, size_t len) {
+    uint8_t frame[TEST_FRAME_LEN];  // Frame contents.
+
+    // Append frame with contents derived from its sequence number.
+    _test_frame(seq, frame, len);
+    zassert_ok(journal_append(type, seq, frame, len), "Append failed");
+}
+
+static void _test_check (data_type_t type, uint32_t first, uint32_t last) {
+    journal_entry_t entry;              // Journal entry.
+    uint8_t frame[TEST_FRAME_LEN];      // Frame contents read.
+    uint8_t expect[TEST_FRAME_LEN];     // Expected frame contents.
+    uint32_t seq = first;               // Expected sequence number.
+    int status;                         // Return status for API calls.
+
+    /*
+     * Check that the unacknowledged frames of the given type are exactly those
+     * with consecutive sequence numbers in the given range, and that their
+     * contents are intact.
+     */
+
+    zassert_equal(
+        journal_count(type), last - first + 1, "Wrong number of frames"
+    );
+
+    for (
+        status = journal_first(type, &entry); status == 0;
+        status = journal_next(type, &entry)
+    ) {
+        zassert_true(seq <= last, "Frame beyond range");
+        zassert_equal(entry.seq, seq, "Wrong sequence number");
+        zassert_ok(journal_read(&entry, frame), "Read failed");
+        _test_frame(seq, expect, entry.len);
+        zassert_mem_equal(frame, expect, entry.len, "Frame corrupted");
+        seq++;
+    }
+
+    zassert_equal(seq, last + 1, "Frames missing");
+}
+
+static void _test_before (void * fixture) {
+    ARG_UNUSED(fixture);
+
+    // Start every test from erased flash and a new journal.
+    zassert_true(device_is_ready(_test_dev), "Flash device not ready");
+    zassert_ok(
+        flash_erase(_test_dev, CONFIG_JOURNAL_OFFSET, CONFIG_JOURNAL_SIZE),
+        "Erase failed"
+    );
+    zassert_ok(journal_init(), "Initialization failed");
+}
+
+ZTEST(journal, test_empty) {
+    journal_entry_t entry;  // Journal entry.
+
+    // A new journal holds no frames and starts sequence numbers at 0.
+    zassert_equal(journal_seq(), 0, "Wrong next sequence number");
+    for (int type = 0; type < DATA_TYPE_COUNT; type++) {
+        zassert_equal(journal_count(type), 0, "Journal not empty");
+        zassert_equal(journal_first(type, &entry), -1, "Frame found");
+    }
+}
+
+ZTEST(journal, test_append) {
+    // Frames of each type are traversed in order, apart from other types.
+    _test_append(DATA_TYPE_DUMMY, 0, 10);
+    _test_append(DATA_TYPE_LTE, 1, 200);
+    _test_append(DATA_TYPE_DUMMY, 2, 1);
+    _test_append(DATA_TYPE_DUMMY, 3, TEST_FRAME_LEN);
+
+    zassert_equal(journal_count(DATA_TYPE_DUMMY), 3, "Wrong dummy count");
+    zassert_equal(journal_count(DATA_TYPE_LTE), 1, "Wrong LTE count");
+    zassert_equal(journal_count(DATA_TYPE_GNSS), 0, "Wrong GNSS count");
+    zassert_equal(journal_seq(), 4, "Wrong next sequence number");
+}
+
+ZTEST(journal, test_oversized) {
+    static uint8_t frame[TEST_SECTOR_SIZE];   // Frame contents.
+
+    // A frame that does not fit in a sector is rejected.
+    zassert_equal(
+        journal_append(DATA_TYPE_DUMMY, 0, frame, sizeof(frame)), -1,
+        "Oversized frame accepted"
+    );
+    zassert_equal(journal_count(DATA_TYPE_DUMMY), 0, "Frame stored");
+}
+
+ZTEST(journal, test_ack) {
+    // Acknowledged frames are no longer traversed.
+    for (uint32_t seq = 0; seq < 6; seq++) {
+        _test_append(DATA_TYPE_DUMMY, seq, 100);
+    }
+
+    zassert_ok(journal_ack(DATA_TYPE_DUMMY, 0, 2), "Acknowledgement failed");
+    _test_check(DATA_TYPE_DUMMY, 3, 5);
+
+    // Acknowledging frames no longer in the journal leaves others in place.
+    zassert_ok(journal_ack(DATA_TYPE_DUMMY, 0, 1), "Acknowledgement failed");
+    _test_check(DATA_TYPE_DUMMY, 3, 5);
+
+    zassert_ok(journal_ack(DATA_TYPE_DUMMY, 3, 5), "Acknowledgement failed");
+    zassert_equal(journal_count(DATA_TYPE_DUMMY), 0, "Frames left");
+}
+
+ZTEST(journal, test_ack_range) {
+    journal_entry_t entry;  // Journal entry.
+
+    // Only frames of the given type within the given range are acknowledged,
+    // even if older frames of the type remain.
+    for (uint32_t seq = 0; seq < 6; seq++) {
+        _test_append(seq % 2 ? DATA_TYPE_LTE : DATA_TYPE_DUMMY, seq, 100);
+    }
+
+    zassert_ok(journal_ack(DATA_TYPE_DUMMY, 2, 3), "Acknowledgement failed");
+    zassert_equal(journal_count(DATA_TYPE_DUMMY), 2, "Wrong dummy count");
+    zassert_equal(journal_count(DATA_TYPE_LTE), 3, "Wrong LTE count");
+
+    zassert_ok(journal_first(DATA_TYPE_DUMMY, &entry), "Frame missing");
+    zassert_equal(entry.seq, 0, "Wrong sequence number");
+    zassert_ok(journal_next(DATA_TYPE_DUMMY, &entry), "Frame missing");
+    zassert_equal(entry.seq, 4, "Wrong sequence number");
+    zassert_equal(journal_next(DATA_TYPE_DUMMY, &entry), -1, "Frame found");
+}
+
+ZTEST(journal, test_wrap) {
+    // Frames acknowledged as they are appended let the journal wrap around
+    // several times without losing frames.
+    for (uint32_t seq = 0; seq < 3 * TEST_FRAMES_PER_JOURNAL; seq++) {
+        _test_append(DATA_TYPE_DUMMY, seq, TEST_FRAME_LEN);
+        _test_check(DATA_TYPE_DUMMY, seq, seq);
+        zassert_ok(
+            journal_ack(DATA_TYPE_DUMMY, seq, seq), "Acknowledgement failed"
+        );
+    }
+
+    zassert_equal(journal_count(DATA_TYPE_DUMMY), 0, "Frames left");
+    zassert_equal(
+        journal_seq(), 3 * TEST_FRAMES_PER_JOURNAL, "Wrong next sequence number"
+    );
+
+    // Unacknowledged frames survive wrapping.
+    for (uint32_t seq = 0; seq < TEST_FRAMES_PER_SECTOR * 2; seq++) {
+        _test_append(
+            DATA_TYPE_DUMMY, 3 * TEST_FRAMES_PER_JOURNAL + seq, TEST_FRAME_LEN
+        );
+    }
+    _test_check(
+        DATA_TYPE_DUMMY, 3 * TEST_FRAMES_PER_JOURNAL,
+        3 * TEST_FRAMES_PER_JOURNAL + TEST_FRAMES_PER_SECTOR * 2 - 1
+    );
+}
+
+ZTEST(journal, test_drop) {
+    journal_entry_t entry;  // Journal entry.
+    uint32_t total;         // Number of frames appended.
+    uint32_t first;         // Sequence number of oldest remaining frame.
+
+    // Once the journal is full, the sector holding the oldest frames is
+    // dropped, and the remaining frames stay consecutive.
+    total = TEST_FRAMES_PER_JOURNAL + TEST_FRAMES_PER_SECTOR + 1;
+    for (uint32_t seq = 0; seq < total; seq++) {
+        _test_append(DATA_TYPE_DUMMY, seq, TEST_FRAME_LEN);
+    }
+
+    zassert_ok(journal_first(DATA_TYPE_DUMMY, &entry), "Frame missing");
+    first = entry.seq;
+    zassert_true(first > 0, "No frames dropped");
+    zassert_equal(
+        first % TEST_FRAMES_PER_SECTOR, 0, "Frames dropped within a sector"
+    );
+    _test_check(DATA_TYPE_DUMMY, first, total - 1);
+    zassert_equal(journal_seq(), total, "Wrong next sequence number");
+
+    // Acknowledging a batch that includes dropped frames acknowledges only
+    // the frames still present, and leaves newer frames in place.
+    zassert_ok(
+        journal_ack(DATA_TYPE_DUMMY, 0, first + 1), "Acknowledgement failed"
+    );
+    _test_check(DATA_TYPE_DUMMY, first + 2, total - 1);
+}
+
+ZTEST(journal, test_recover) {
+    // Unacknowledged frames and their contents survive a reboot.
+    for (uint32_t seq = 0; seq < 10; seq++) {
+        _test_append(seq < 7 ? DATA_TYPE_DUMMY : DATA_TYPE_GNSS, seq, 300);
+    }
+    zassert_ok(journal_ack(DATA_TYPE_DUMMY, 0, 3), "Acknowledgement failed");
+
+    zassert_ok(journal_init(), "Recovery failed");
+
+    _test_check(DATA_TYPE_DUMMY, 4, 6);
+    _test_check(DATA_TYPE_GNSS, 7, 9);
+    zassert_equal(journal_seq(), 10, "Wrong next sequence number");
+
+    // Appending continues after the recovered frames.
+    _test_append(DATA_TYPE_DUMMY, 10, 300);
+    zassert_ok(journal_init(), "Recovery failed");
+    zassert_equal(journal_count(DATA_TYPE_DUMMY), 4, "Wrong dummy count");
+    zassert_equal(journal_seq(), 11, "Wrong next sequence number");
+}
+
+ZTEST(journal, test_recover_acked) {
+    // Frames acknowledged out of order stay acknowledged after a reboot, and
+    // the sequence numbers of acknowledged frames are not reused.
+    for (uint32_t seq = 0; seq < 6; seq++) {
+        _test_append(DATA_TYPE_DUMMY, seq, 100);
+    }
+    zassert_ok(journal_ack(DATA_TYPE_DUMMY, 4, 5), "Acknowledgement failed");
+
+    zassert_ok(journal_init(), "Recovery failed");
+
+    _test_check(DATA_TYPE_DUMMY, 0, 3);
+    zassert_equal(journal_seq(), 6, "Wrong next sequence number");
+}
+
+ZTEST(journal, test_recover_wrapped) {
+    journal_entry_t entry;  // Journal entry.
+    uint32_t total;         // Number of frames appended.
+    uint32_t first;         // Sequence number of oldest remaining frame.
+
+    // The oldest sector is found again after the journal has wrapped around.
+    total = 2 * TEST_FRAMES_PER_JOURNAL + 3;
+    for (uint32_t seq = 0; seq < total; seq++) {
+        _test_append(DATA_TYPE_LTE, seq, TEST_FRAME_LEN);
+    }
+    zassert_ok(journal_first(DATA_TYPE_LTE, &entry), "Frame missing");
+    first = entry.seq;
+
+    zassert_ok(journal_init(), "Recovery failed");
+
+    _test_check(DATA_TYPE_LTE, first, total - 1);
+    zassert_equal(journal_seq(), total, "Wrong next sequence number");
+}
+
+ZTEST_SUITE(journal, NULL, NULL, _test_before, NULL, NULL);